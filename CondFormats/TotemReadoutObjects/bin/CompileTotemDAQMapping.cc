@@ -0,0 +1,127 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingXMLParser.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingBinary.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: totemCompileDAQMapping [option] -o <output file>\n");
+  printf("Compiles DAQ mapping and analysis mask XML files into a binary file, which can be loaded by\n");
+  printf("TotemDAQMappingESSourceXML (parameter binaryFileName) instead of the XML files.\n");
+  printf("The XML files must be given in the same order as in the ESSource configuration. Relative paths\n");
+  printf("that do not exist are looked up like in the ESSource (e.g. CondFormats/TotemReadoutObjects/xml/...).\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -m <file>       add a mapping file\n");
+  printf("    -k <file>       add a mask file\n");
+  printf("    -o <file>       output file\n");
+  printf("    -c              only check whether the output file is up to date\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+string CompleteFileName(const string &fn)
+{
+  if (access(fn.c_str(), R_OK) == 0)
+    return fn;
+
+  edm::FileInPath fip(fn);
+  return fip.fullPath();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  vector<string> mappingFiles, maskFiles;
+  string outputFile;
+  bool checkOnly = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) { mappingFiles.push_back(argv[++i]); continue; }
+    if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) { maskFiles.push_back(argv[++i]); continue; }
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) { outputFile = argv[++i]; continue; }
+    if (strcmp(argv[i], "-c") == 0) { checkOnly = true; continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  if (outputFile.empty() || (mappingFiles.empty() && maskFiles.empty()))
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  try
+  {
+    for (auto &fn : mappingFiles)
+      fn = CompleteFileName(fn);
+    for (auto &fn : maskFiles)
+      fn = CompleteFileName(fn);
+
+    uint64_t sourceHash;
+    if (TotemDAQMappingBinary::ComputeSourceHash(mappingFiles, maskFiles, sourceHash) != 0)
+      return 1;
+
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+
+    if (checkOnly)
+    {
+      const int result = TotemDAQMappingBinary::Load(outputFile, sourceHash, mapping, mask);
+      const bool valid = (result == 0);
+      if (valid)
+        printf("%s: up to date\n", outputFile.c_str());
+      else
+        printf("%s: NOT up to date (%s)\n", outputFile.c_str(), TotemDAQMappingBinary::LoadErrorMessage(result));
+      return (valid) ? 0 : 1;
+    }
+
+    TotemDAQMappingXMLParser parser;
+    parser.Parse(mappingFiles, maskFiles, mapping, mask);
+
+    if (TotemDAQMappingBinary::Save(outputFile, sourceHash, mapping, mask) != 0)
+    {
+      printf("ERROR: cannot save file `%s'.\n", outputFile.c_str());
+      return 1;
+    }
+
+    printf("%s: %lu VFATs, %lu masks, source hash %016llx\n", outputFile.c_str(),
+      (unsigned long) mapping.VFATMapping.size(), (unsigned long) mask.analysisMask.size(),
+      (unsigned long long) sourceHash);
+  }
+  catch (const cms::Exception &e)
+  {
+    printf("ERROR: %s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef CondFormats_TotemReadoutObjects_TotemDAQMappingBinary
+#define CondFormats_TotemReadoutObjects_TotemDAQMappingBinary
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Precompiled binary form of TotemDAQMapping and TotemAnalysisMask.
+ *
+ * Produced from the XML files by totemCompileDAQMapping and loaded by TotemDAQMappingESSourceXML
+ * (parameter binaryFileName), which saves the XML parsing at job start. The file has the following
+ * layout (all numbers in the native byte order):
+ * \verbatim
+ * header:       magic (8 B), version (4 B), VFAT record size (4 B), mask record size (4 B), reserved (4 B),
+ *               source hash (8 B), number of VFAT records (8 B), number of mask records (8 B),
+ *               checksum of the records (8 B)
+ * VFAT records: raw frame position (4 B), symbolic ID (4 B), hardware ID (4 B), subsystem (1 B),
+ *               type (1 B), reserved (2 B)
+ * mask records: symbolic ID (4 B), subsystem (1 B), full mask (1 B), reserved (2 B),
+ *               bitmap of masked channels (8 x 4 B)
+ * \endverbatim
+ * The records are stored in the order of the corresponding maps, so that loading is linear in the
+ * file size. The source hash is calculated from the content of the XML files the binary was compiled
+ * from and lets the loader detect stale files.
+ **/
+class TotemDAQMappingBinary
+{
+  public:
+    /// calculates the hash of the content of the given mapping and mask files, returns 0 on success
+    static int ComputeSourceHash(const std::vector<std::string> &mappingFiles, const std::vector<std::string> &maskFiles,
+      uint64_t &hash);
+
+    /// saves mapping and mask to a binary file, returns 0 on success
+    static int Save(const std::string &fileName, uint64_t sourceHash, const TotemDAQMapping &mapping,
+      const TotemAnalysisMask &mask);
+
+    /// loads mapping and mask from a binary file, returns
+    ///   0 on success,
+    ///   1 if the file cannot be read,
+    ///   2 if the file has an unknown format,
+    ///   3 if the file is stale (its source hash differs from sourceHash),
+    ///   4 if the file is corrupted
+    /// nothing is printed, the caller reports the failure (see LoadErrorMessage)
+    static int Load(const std::string &fileName, uint64_t sourceHash, TotemDAQMapping &mapping,
+      TotemAnalysisMask &mask);
+
+    /// returns a short description of a result code of Load
+    static const char* LoadErrorMessage(int result);
+
+  protected:
+    static const char magic[8];
+    static const uint32_t version;
+
+    struct Header
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t vfatRecordSize;
+      uint32_t maskRecordSize;
+      uint32_t reserved;
+      uint64_t sourceHash;
+      uint64_t nVFATRecords;
+      uint64_t nMaskRecords;
+      uint64_t recordsChecksum;
+    };
+
+    struct VFATRecord
+    {
+      uint32_t rawPosition;
+      uint32_t symbolicID;
+      uint32_t hwID;
+      uint8_t subSystem;
+      uint8_t type;
+      uint16_t reserved;
+    };
+
+    struct MaskRecord
+    {
+      uint32_t symbolicID;
+      uint8_t subSystem;
+      uint8_t fullMask;
+      uint16_t reserved;
+      uint32_t channels[8];
+    };
+
+    static uint64_t Checksum(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL);
+};
+
+#endif
@@ -0,0 +1,183 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef CondFormats_TotemReadoutObjects_TotemDAQMappingSAXParser
+#define CondFormats_TotemReadoutObjects_TotemDAQMappingSAXParser
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemFramePosition.h"
+
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Streaming (SAX2) alternative to TotemDAQMappingXMLParser.
+ *
+ * Builds the same TotemDAQMapping and TotemAnalysisMask in a single pass over each file, without
+ * keeping the document tree in memory. The DOM parser walks every tree three times (RP, T2 and T1
+ * structure); here the three walks are advanced side by side, with the state each recursion level of
+ * the DOM walk keeps (parent type and ID, T1 arm/plane/CSC) stored on a stack of open elements. The
+ * validation rules and error messages are those of TotemDAQMappingXMLParser. Mapping and mask entries
+ * are buffered per walk and inserted in the DOM order (RP, T2, T1) at the end of each file, so that
+ * also the handling of duplicate entries is the same. Tag and attribute names are transcoded once per
+ * Parse call, attribute values only when they are used.
+ *
+ * Not yet used by TotemDAQMappingESSourceXML: it is to be offered there once testTotemDAQMappingSAXParser
+ * and benchmarkDAQMappingParsing have been run with the xerces-c of a release.
+ **/
+class TotemDAQMappingSAXParser : public xercesc::DefaultHandler
+{
+  public:
+    TotemDAQMappingSAXParser();
+    ~TotemDAQMappingSAXParser();
+
+    /// parses the given files (full paths) and adds their content to mapping and mask
+    void Parse(const std::vector<std::string> &mappingFiles, const std::vector<std::string> &maskFiles,
+      TotemDAQMapping &mapping, TotemAnalysisMask &mask);
+
+    /// SAX2 callbacks
+    virtual void startElement(const XMLCh* const uri, const XMLCh* const localname, const XMLCh* const qname,
+      const xercesc::Attributes &attrs) override;
+
+    virtual void endElement(const XMLCh* const uri, const XMLCh* const localname, const XMLCh* const qname) override;
+
+    virtual void fatalError(const xercesc::SAXParseException &) override;
+
+  private:
+    /// enumeration of XML node types, the same as in TotemDAQMappingXMLParser
+    enum NodeType { nUnknown, nTop, nArm, nRPStation, nRPPot, nRPPlane, nChip, nTriggerVFAT,
+      nT2, nT2Half, nT2Det, nT1, nT1Arm, nT1Plane, nT1CSC, nT1ChannelType, nChannel };
+
+    /// whether to parse a mapping of a mask XML
+    enum ParseType { pMapping, pMask };
+
+    /// recognized attributes
+    enum AttributeType { aUnknown, aId, aHwId, aFullMask, aPosition, aArm, aHt, aPl, aPls, aPolarity, aNumberOfAttributes };
+
+    /// tag name (transcoded) --> node type, in the order of TotemDAQMappingXMLParser::GetNodeType
+    std::vector< std::pair<XMLCh*, NodeType> > tags;
+
+    /// attribute names (transcoded), indexed by AttributeType
+    std::vector<XMLCh*> attributeNames;
+
+    /// the channel tag (transcoded)
+    XMLCh *channelTag;
+
+    typedef std::vector< std::pair<TotemFramePosition, TotemVFATInfo> > MappingBuffer;
+    typedef std::vector< std::pair<TotemSymbID, TotemVFATAnalysisMask> > MaskBuffer;
+
+    /// mask entry waiting for the channels of its element
+    struct PendingMask
+    {
+      MaskBuffer *buffer;
+      unsigned int index;
+      bool withChannels;
+    };
+
+    /// the state of an open element
+    struct Frame
+    {
+      /// element name, kept only for the root element (the other names are known from the tag table)
+      std::string rootName;
+
+      /// index in tags, -1 if not determined
+      int tag;
+
+      /// whether the children of this element are visited by the RP, T2 and T1 walk, respectively
+      bool rpActive, t2Active, t1Active;
+
+      /// RP walk: the type of this element and the ID passed to its children
+      NodeType rpParentType;
+      unsigned int rpParentID;
+
+      /// T2 walk: the ID passed to the children
+      unsigned int t2ParentID;
+
+      /// T1 walk: the ID and position passed to the children
+      unsigned int t1ParentID, t1Arm, t1Plane, t1CSC, t1ChannelType;
+
+      /// whether the channel children are collected and for which mask entries
+      bool collectChannels;
+      std::set<unsigned char> channels;
+      std::vector<PendingMask> pendingMasks;
+    };
+
+    /// stack of open elements
+    std::vector<Frame> frames;
+
+    /// number of frames in use (the Frame objects are reused)
+    unsigned int depth;
+
+    /// the file being parsed and its type
+    std::string currentFile;
+    ParseType pType;
+
+    /// whether the root element has been found
+    bool rootFound;
+
+    /// entries found by the individual walks
+    MappingBuffer rpMapping, t2Mapping, t1Mapping;
+    MaskBuffer rpMasks, t2Masks, t1Masks;
+
+    /// parses one file and adds its content to mapping and mask
+    void ParseFile(xercesc::SAX2XMLReader *reader, ParseType, const std::string &file,
+      TotemDAQMapping &, TotemAnalysisMask &);
+
+    /// determines node type, throws for unknown tags
+    NodeType GetNodeType(const XMLCh *name, int &tag);
+
+    /// returns the type of an attribute
+    AttributeType GetAttributeType(const XMLCh *name);
+
+    /// returns the name of the element of the given frame
+    std::string GetName(const Frame &f);
+
+    /// the processing of an element by the individual walks
+    void ProcessRP(Frame &parent, Frame &f, NodeType type, const XMLCh *name, const xercesc::Attributes &attrs);
+    void ProcessT2(Frame &parent, Frame &f, NodeType type, const XMLCh *name, const xercesc::Attributes &attrs);
+    void ProcessT1(Frame &parent, Frame &f, NodeType type, const XMLCh *name, const xercesc::Attributes &attrs);
+
+    /// extracts VFAT's DAQ channel from XML attributes
+    TotemFramePosition ChipFramePosition(const xercesc::Attributes &attrs);
+
+    /// registers a mask entry, which is completed with the channels at the end of the element
+    void AddMask(Frame &f, MaskBuffer &buffer, const TotemSymbID &symbId, bool fullMask, bool withChannels);
+
+    static std::string ToString(const XMLCh *s);
+
+    bool RPNode(NodeType type)
+    {
+      return ((type == nArm)||(type == nRPStation)||(type == nRPPot)||(type == nRPPlane)||(type == nChip)||(type == nTriggerVFAT));
+    }
+
+    bool T2Node(NodeType type)
+    {
+      return ((type==nT2)||(type==nT2Det)|| (type==nT2Half));
+    }
+
+    bool T1Node(NodeType type)
+    {
+      return ((type==nT1)||(type==nT1Arm)|| (type==nT1Plane) || (type==nT1CSC) || (type==nT1ChannelType));
+    }
+
+    bool CommonNode(NodeType type)
+    {
+      return ((type==nChip)||(type==nArm));
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Maciej Wróbel (wroblisko@gmail.com)
+*   Jan Kašpar (jan.kaspar@cern.ch)
+*   Marcin Borratynski (mborratynski@gmail.com)
+*
+****************************************************************************/
+
+#ifndef CondFormats_TotemReadoutObjects_TotemDAQMappingXMLParser
+#define CondFormats_TotemReadoutObjects_TotemDAQMappingXMLParser
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemFramePosition.h"
+
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Builds TotemDAQMapping and TotemAnalysisMask from mapping and mask XML files.
+ *
+ * Used by TotemDAQMappingESSourceXML and by the offline tools (e.g. totemCompileDAQMapping).
+ * Errors in the files are reported by throwing cms::Exception.
+ **/
+class TotemDAQMappingXMLParser
+{
+  public:
+    static const std::string tagVFAT;
+    static const std::string tagChannel;
+    static const std::string tagAnalysisMask;
+
+    /// Common position tags
+    static const std::string tagArm;
+
+    /// RP XML tags
+    static const std::string tagRPStation;
+    static const std::string tagRPPot;
+    static const std::string tagRPPlane;
+
+    /// T2 XML tags
+    static const std::string tagT2;
+    static const std::string tagT2Half;
+    static const std::string tagT2detector;
+
+    /// T1 XML tags
+    static const std::string tagT1;
+    static const std::string tagT1Arm;
+    static const std::string tagT1Plane;
+    static const std::string tagT1CSC;
+    static const std::string tagT1ChannelType;
+
+    /// COMMON Chip XML tags
+    static const std::string tagChip1;
+    static const std::string tagChip2;
+    static const std::string tagTriggerVFAT1;
+
+    /// parses the given files (full paths) and adds their content to mapping and mask
+    void Parse(const std::vector<std::string> &mappingFiles, const std::vector<std::string> &maskFiles,
+      TotemDAQMapping &mapping, TotemAnalysisMask &mask);
+
+  private:
+    /// enumeration of XML node types
+    enum NodeType { nUnknown, nTop, nArm, nRPStation, nRPPot, nRPPlane, nChip, nTriggerVFAT,
+      nT2, nT2Half, nT2Det, nT1, nT1Arm, nT1Plane, nT1CSC, nT1ChannelType, nChannel };
+
+    /// whether to parse a mapping of a mask XML
+    enum ParseType { pMapping, pMask };
+
+    /// parses XML file
+    void ParseXML(ParseType, const std::string &file, TotemDAQMapping &, TotemAnalysisMask &);
+
+    /// recursive method to extract RP-related information from the DOM tree
+    void ParseTreeRP(ParseType, xercesc::DOMNode *, NodeType, unsigned int parentID,
+      TotemDAQMapping &, TotemAnalysisMask &);
+
+    /// recursive method to extract RP-related information from the DOM tree
+    void ParseTreeT1(ParseType, xercesc::DOMNode *, NodeType, unsigned int parentID,
+      TotemDAQMapping &, TotemAnalysisMask &,
+      unsigned int T1Arm, unsigned int T1Plane, unsigned int T1CSC);
+
+    /// recursive method to extract RP-related information from the DOM tree
+    void ParseTreeT2(ParseType, xercesc::DOMNode *, NodeType, unsigned int parentID,
+      TotemDAQMapping &, TotemAnalysisMask &);
+
+    /// returns the top element from an XML file
+    xercesc::DOMDocument* GetDOMDocument(std::string file);
+
+    /// returns true iff the node is of the given name
+    bool Test(xercesc::DOMNode *node, const std::string &name)
+    {
+      return !(name.compare(xercesc::XMLString::transcode(node->getNodeName())));
+    }
+
+    /// determines node type
+    NodeType GetNodeType(xercesc::DOMNode *);
+
+    /// returns the content of the node
+    std::string GetNodeContent(xercesc::DOMNode *parent)
+    {
+      return std::string(xercesc::XMLString::transcode(parent->getTextContent()));
+    }
+
+    /// returns the value of the node
+    std::string GetNodeValue(xercesc::DOMNode *node)
+    {
+      return std::string(xercesc::XMLString::transcode(node->getNodeValue()));
+    }
+
+    /// extracts VFAT's DAQ channel from XML attributes
+    TotemFramePosition ChipFramePosition(xercesc::DOMNode *chipnode);
+
+    void GetChannels(xercesc::DOMNode *n, std::set<unsigned char> &channels);
+
+    bool RPNode(NodeType type)
+    {
+      return ((type == nArm)||(type == nRPStation)||(type == nRPPot)||(type == nRPPlane)||(type == nChip)||(type == nTriggerVFAT));
+    }
+
+    bool T2Node(NodeType type)
+    {
+      return ((type==nT2)||(type==nT2Det)|| (type==nT2Half));
+    }
+
+    bool T1Node(NodeType type)
+    {
+      return ((type==nT1)||(type==nT1Arm)|| (type==nT1Plane) || (type==nT1CSC) || (type==nT1ChannelType));
+    }
+
+    bool CommonNode(NodeType type)
+    {
+      return ((type==nChip)||(type==nArm));
+    }
+};
+
+#endif
@@ -4,5 +4,11 @@ TotemDAQMappingESSourceXML = cms.ESSource("TotemDAQMappingESSourceXML",
   verbosity = cms.untracked.uint32(0),
 
   mappingFileNames = cms.untracked.vstring(),
-  maskFileNames = cms.untracked.vstring()
+  maskFileNames = cms.untracked.vstring(),
+
+  # precompiled mapping, produced by
+  #   totemCompileDAQMapping -m <mapping file> ... -k <mask file> ... -o <binary file>
+  # resolved via FileInPath, like the XML files; it is used instead of the XML files as long as it matches
+  # their content, otherwise a warning is issued and the XML files are parsed
+  binaryFileName = cms.untracked.string("")
 )
@@ -0,0 +1,285 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingBinary.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const char TotemDAQMappingBinary::magic[8] = { 'T', 'O', 'T', 'D', 'A', 'Q', 'M', 'B' };
+
+const uint32_t TotemDAQMappingBinary::version = 1;
+
+//----------------------------------------------------------------------------------------------------
+
+uint64_t TotemDAQMappingBinary::Checksum(const void *data, size_t size, uint64_t seed)
+{
+  // FNV-1a
+  const unsigned char *p = (const unsigned char *) data;
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i)
+    h = (h ^ p[i]) * 1099511628211ULL;
+
+  return h;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int TotemDAQMappingBinary::ComputeSourceHash(const vector<string> &mappingFiles, const vector<string> &maskFiles,
+  uint64_t &hash)
+{
+  hash = Checksum(magic, sizeof(magic));
+
+  vector<char> buffer(64*1024);
+
+  for (unsigned int role = 0; role < 2; ++role)
+  {
+    const vector<string> &files = (role == 0) ? mappingFiles : maskFiles;
+
+    // the role and number of files, so that moving a file between the lists changes the hash
+    const uint64_t tag[2] = { role, files.size() };
+    hash = Checksum(tag, sizeof(tag), hash);
+
+    for (const auto &fn : files)
+    {
+      FILE *f = fopen(fn.c_str(), "r");
+      if (!f)
+      {
+        cerr << "Error in TotemDAQMappingBinary::ComputeSourceHash > " << "Cannot open file " << fn << "." << endl;
+        return 1;
+      }
+
+      uint64_t size = 0;
+      size_t n;
+      while ((n = fread(buffer.data(), 1, buffer.size(), f)) > 0)
+      {
+        hash = Checksum(buffer.data(), n, hash);
+        size += n;
+      }
+
+      const bool failed = ferror(f);
+      fclose(f);
+
+      if (failed)
+      {
+        cerr << "Error in TotemDAQMappingBinary::ComputeSourceHash > " << "Cannot read file " << fn << "." << endl;
+        return 1;
+      }
+
+      // the size separates the content of consecutive files
+      hash = Checksum(&size, sizeof(size), hash);
+    }
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int TotemDAQMappingBinary::Save(const std::string &fileName, uint64_t sourceHash, const TotemDAQMapping &mapping,
+  const TotemAnalysisMask &mask)
+{
+  vector<VFATRecord> vfatRecords;
+  vfatRecords.reserve(mapping.VFATMapping.size());
+  for (const auto &p : mapping.VFATMapping)
+  {
+    VFATRecord r;
+    r.rawPosition = p.first.getRawPosition();
+    r.symbolicID = p.second.symbolicID.symbolicID;
+    r.hwID = p.second.hwID;
+    r.subSystem = p.second.symbolicID.subSystem;
+    r.type = p.second.type;
+    r.reserved = 0;
+    vfatRecords.push_back(r);
+  }
+
+  vector<MaskRecord> maskRecords;
+  maskRecords.reserve(mask.analysisMask.size());
+  for (const auto &p : mask.analysisMask)
+  {
+    MaskRecord r;
+    memset(&r, 0, sizeof(r));
+    r.symbolicID = p.first.symbolicID;
+    r.subSystem = p.first.subSystem;
+    r.fullMask = p.second.fullMask;
+    for (const auto &ch : p.second.maskedChannels)
+      r.channels[ch / 32] |= (1U << (ch % 32));
+    maskRecords.push_back(r);
+  }
+
+  Header h;
+  memcpy(h.magic, magic, sizeof(magic));
+  h.version = version;
+  h.vfatRecordSize = sizeof(VFATRecord);
+  h.maskRecordSize = sizeof(MaskRecord);
+  h.reserved = 0;
+  h.sourceHash = sourceHash;
+  h.nVFATRecords = vfatRecords.size();
+  h.nMaskRecords = maskRecords.size();
+  h.recordsChecksum = Checksum(maskRecords.data(), maskRecords.size() * sizeof(MaskRecord),
+    Checksum(vfatRecords.data(), vfatRecords.size() * sizeof(VFATRecord)));
+
+  // write to a temporary file first, so that concurrent jobs never see a partial file
+  string tmpFileName = fileName + ".tmp";
+  FILE *f = fopen(tmpFileName.c_str(), "w");
+  if (!f)
+  {
+    perror("Error while opening file in TotemDAQMappingBinary::Save");
+    return 1;
+  }
+
+  bool ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+  if (ok && !vfatRecords.empty())
+    ok = (fwrite(vfatRecords.data(), sizeof(VFATRecord), vfatRecords.size(), f) == vfatRecords.size());
+  if (ok && !maskRecords.empty())
+    ok = (fwrite(maskRecords.data(), sizeof(MaskRecord), maskRecords.size(), f) == maskRecords.size());
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok || rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+  {
+    cerr << "Error in TotemDAQMappingBinary::Save > " << "Cannot write file " << fileName << "." << endl;
+    remove(tmpFileName.c_str());
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const char* TotemDAQMappingBinary::LoadErrorMessage(int result)
+{
+  switch (result)
+  {
+    case 0: return "loaded";
+    case 1: return "not readable";
+    case 2: return "unknown format";
+    case 3: return "compiled from different XML files";
+    case 4: return "corrupted";
+    default: return "unknown error";
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int TotemDAQMappingBinary::Load(const std::string &fileName, uint64_t sourceHash, TotemDAQMapping &mapping,
+  TotemAnalysisMask &mask)
+{
+  mapping.VFATMapping.clear();
+  mask.analysisMask.clear();
+
+  FILE *f = fopen(fileName.c_str(), "r");
+  if (!f)
+    return 1;
+
+  Header h;
+  if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != version
+    || h.vfatRecordSize != sizeof(VFATRecord) || h.maskRecordSize != sizeof(MaskRecord))
+  {
+    fclose(f);
+    return 2;
+  }
+
+  if (h.sourceHash != sourceHash)
+  {
+    fclose(f);
+    return 3;
+  }
+
+  // the record counts are validated against the file size before any allocation
+  fseeko(f, 0, SEEK_END);
+  const uint64_t fileSize = ftello(f);
+  fseeko(f, sizeof(h), SEEK_SET);
+
+  bool ok = (h.nVFATRecords <= fileSize / sizeof(VFATRecord) && h.nMaskRecords <= fileSize / sizeof(MaskRecord)
+    && fileSize == sizeof(h) + h.nVFATRecords * sizeof(VFATRecord) + h.nMaskRecords * sizeof(MaskRecord));
+
+  vector<VFATRecord> vfatRecords;
+  vector<MaskRecord> maskRecords;
+  if (ok)
+  {
+    vfatRecords.resize(h.nVFATRecords);
+    maskRecords.resize(h.nMaskRecords);
+
+    ok = (h.nVFATRecords == 0 || fread(vfatRecords.data(), sizeof(VFATRecord), h.nVFATRecords, f) == h.nVFATRecords)
+      && (h.nMaskRecords == 0 || fread(maskRecords.data(), sizeof(MaskRecord), h.nMaskRecords, f) == h.nMaskRecords);
+  }
+
+  fclose(f);
+
+  ok = ok && Checksum(maskRecords.data(), maskRecords.size() * sizeof(MaskRecord),
+    Checksum(vfatRecords.data(), vfatRecords.size() * sizeof(VFATRecord))) == h.recordsChecksum;
+
+  // the records are sorted, each one is inserted at the end of the map in constant time
+  for (unsigned long i = 0; ok && i < vfatRecords.size(); ++i)
+  {
+    const VFATRecord &r = vfatRecords[i];
+    if (r.subSystem > TotemSymbID::T2 || r.type > TotemVFATInfo::CC
+      || (i > 0 && vfatRecords[i - 1].rawPosition >= r.rawPosition))
+    {
+      ok = false;
+      break;
+    }
+
+    TotemVFATInfo vi;
+    vi.type = (r.type == TotemVFATInfo::data) ? TotemVFATInfo::data : TotemVFATInfo::CC;
+    vi.symbolicID.subSystem = (r.subSystem == TotemSymbID::RP) ? TotemSymbID::RP :
+      ((r.subSystem == TotemSymbID::T1) ? TotemSymbID::T1 : TotemSymbID::T2);
+    vi.symbolicID.symbolicID = r.symbolicID;
+    vi.hwID = r.hwID;
+
+    mapping.VFATMapping.emplace_hint(mapping.VFATMapping.end(), TotemFramePosition(r.rawPosition), vi);
+  }
+
+  for (unsigned long i = 0; ok && i < maskRecords.size(); ++i)
+  {
+    const MaskRecord &r = maskRecords[i];
+    if (r.subSystem > TotemSymbID::T2)
+    {
+      ok = false;
+      break;
+    }
+
+    TotemSymbID sid;
+    sid.subSystem = (r.subSystem == TotemSymbID::RP) ? TotemSymbID::RP :
+      ((r.subSystem == TotemSymbID::T1) ? TotemSymbID::T1 : TotemSymbID::T2);
+    sid.symbolicID = r.symbolicID;
+
+    if (!mask.analysisMask.empty() && !(mask.analysisMask.rbegin()->first < sid))
+    {
+      ok = false;
+      break;
+    }
+
+    TotemVFATAnalysisMask vam;
+    vam.fullMask = r.fullMask;
+    for (unsigned int w = 0; w < 8; ++w)
+    {
+      for (uint32_t bits = r.channels[w]; bits; bits &= bits - 1)
+        vam.maskedChannels.insert(vam.maskedChannels.end(), w * 32 + __builtin_ctz(bits));
+    }
+
+    mask.analysisMask.emplace_hint(mask.analysisMask.end(), sid, std::move(vam));
+  }
+
+  if (!ok)
+  {
+    mapping.VFATMapping.clear();
+    mask.analysisMask.clear();
+    return 4;
+  }
+
+  return 0;
+}
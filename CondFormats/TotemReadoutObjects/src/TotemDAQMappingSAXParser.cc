@@ -0,0 +1,787 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingSAXParser.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingXMLParser.h"
+
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+using namespace edm;
+using namespace xercesc;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemDAQMappingSAXParser::TotemDAQMappingSAXParser() :
+  channelTag(NULL), depth(0), pType(pMapping), rootFound(false)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemDAQMappingSAXParser::~TotemDAQMappingSAXParser()
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+string TotemDAQMappingSAXParser::ToString(const XMLCh *s)
+{
+  char buffer[256];
+  if (XMLString::transcode(s, buffer, sizeof(buffer) - 1))
+    return string(buffer);
+
+  // does not fit the buffer
+  char *t = XMLString::transcode(s);
+  string result(t);
+  XMLString::release(&t);
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::Parse(const vector<string> &mappingFiles, const vector<string> &maskFiles,
+  TotemDAQMapping &mapping, TotemAnalysisMask &mask)
+{
+  // initialize Xerces
+  try
+  {
+    XMLPlatformUtils::Initialize();
+  }
+  catch (const XMLException& toCatch)
+  {
+    char* message = XMLString::transcode(toCatch.getMessage());
+    throw cms::Exception("TotemDAQMappingESSourceXML") << "An XMLException caught with message: " << message << ".\n";
+    XMLString::release(&message);
+  }
+
+  // transcode the tag and attribute names
+  typedef TotemDAQMappingXMLParser P;
+  const vector< pair<string, NodeType> > tagList = {
+    { P::tagArm, nArm }, { P::tagChip1, nChip }, { P::tagChip2, nChip }, { P::tagTriggerVFAT1, nTriggerVFAT },
+    { P::tagRPStation, nRPStation }, { P::tagRPPot, nRPPot }, { P::tagRPPlane, nRPPlane },
+    { P::tagT2, nT2 }, { P::tagT2detector, nT2Det }, { P::tagT2Half, nT2Half },
+    { P::tagT1, nT1 }, { P::tagT1Arm, nT1Arm }, { P::tagT1Plane, nT1Plane }, { P::tagT1CSC, nT1CSC },
+    { P::tagT1ChannelType, nT1ChannelType }, { P::tagChannel, nChannel }
+  };
+
+  for (const auto &t : tagList)
+    tags.push_back(make_pair(XMLString::transcode(t.first.c_str()), t.second));
+
+  const char *attributeList[aNumberOfAttributes] = { "", "id", "hw_id", "full_mask", "position", "arm", "ht", "pl", "pls",
+    "polarity" };
+  for (const auto &a : attributeList)
+    attributeNames.push_back(XMLString::transcode(a));
+
+  channelTag = XMLString::transcode("channel");
+
+  SAX2XMLReader *reader = XMLReaderFactory::createXMLReader();
+  reader->setContentHandler(this);
+  reader->setErrorHandler(this);
+
+  // releases everything allocated above
+  auto cleanUp = [&] ()
+  {
+    delete reader;
+
+    for (auto &t : tags)
+      XMLString::release(&t.first);
+    tags.clear();
+
+    for (auto &a : attributeNames)
+      XMLString::release(&a);
+    attributeNames.clear();
+
+    XMLString::release(&channelTag);
+
+    XMLPlatformUtils::Terminate();
+  };
+
+  try
+  {
+    // load mapping files
+    for (unsigned int i = 0; i < mappingFiles.size(); ++i)
+      ParseFile(reader, pMapping, mappingFiles[i], mapping, mask);
+
+    // load mask files
+    for (unsigned int i = 0; i < maskFiles.size(); ++i)
+      ParseFile(reader, pMask, maskFiles[i], mapping, mask);
+  }
+  catch (...)
+  {
+    cleanUp();
+    throw;
+  }
+
+  cleanUp();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::ParseFile(SAX2XMLReader *reader, ParseType _pType, const string &file,
+  TotemDAQMapping &mapping, TotemAnalysisMask &mask)
+{
+  currentFile = file;
+  pType = _pType;
+  depth = 0;
+  rootFound = false;
+
+  rpMapping.clear(); t2Mapping.clear(); t1Mapping.clear();
+  rpMasks.clear(); t2Masks.clear(); t1Masks.clear();
+
+  reader->parse(file.c_str());
+
+  if (!rootFound)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseMappingXML") << "File `" <<
+      file << "' is empty." << endl;
+
+  // the order of the DOM parser: all RP entries, then T2 and T1
+  for (const MappingBuffer *b : { &rpMapping, &t2Mapping, &t1Mapping })
+    for (const auto &p : *b)
+      mapping.insert(p.first, p.second);
+
+  for (const MaskBuffer *b : { &rpMasks, &t2Masks, &t1Masks })
+    for (const auto &p : *b)
+      mask.insert(p.first, p.second);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::fatalError(const SAXParseException &e)
+{
+  throw cms::Exception("TotemDAQMappingESSourceXML::ParseXML") << "Cannot parse file `" << currentFile
+    << "' (line " << e.getLineNumber() << ": " << ToString(e.getMessage()) << ")." << endl;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemDAQMappingSAXParser::NodeType TotemDAQMappingSAXParser::GetNodeType(const XMLCh *name, int &tag)
+{
+  for (unsigned int i = 0; i < tags.size(); ++i)
+  {
+    if (XMLString::equals(name, tags[i].first))
+    {
+      tag = i;
+      return tags[i].second;
+    }
+  }
+
+  throw cms::Exception("TotemDAQMappingESSourceXML::GetNodeType") << "Unknown tag `"
+    << ToString(name) << "'.\n";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemDAQMappingSAXParser::AttributeType TotemDAQMappingSAXParser::GetAttributeType(const XMLCh *name)
+{
+  for (unsigned int i = aId; i < aNumberOfAttributes; ++i)
+  {
+    if (XMLString::equals(name, attributeNames[i]))
+      return (AttributeType) i;
+  }
+
+  return aUnknown;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+string TotemDAQMappingSAXParser::GetName(const Frame &f)
+{
+  return (f.tag < 0) ? f.rootName : ToString(tags[f.tag].first);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::startElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname,
+  const Attributes &attrs)
+{
+  if (frames.size() <= depth)
+    frames.resize(depth + 1);
+
+  Frame &f = frames[depth];
+  f.tag = -1;
+  f.rpActive = f.t2Active = f.t1Active = false;
+  f.collectChannels = false;
+  f.channels.clear();
+  f.pendingMasks.clear();
+
+  // the root element: its children are visited by all walks
+  if (depth == 0)
+  {
+    rootFound = true;
+    f.rootName = ToString(qname);
+    f.rpActive = f.t2Active = f.t1Active = true;
+    f.rpParentType = nTop;
+    f.rpParentID = 0;
+    f.t2ParentID = 0;
+    f.t1ParentID = f.t1Arm = f.t1Plane = f.t1CSC = f.t1ChannelType = 0;
+
+    depth++;
+    return;
+  }
+
+  Frame &parent = frames[depth - 1];
+  depth++;
+
+  // channel of a mask entry
+  if (parent.collectChannels && XMLString::equals(qname, channelTag))
+  {
+    bool idSet = false;
+    for (unsigned int j = 0; j < attrs.getLength(); j++)
+    {
+      if (GetAttributeType(attrs.getQName(j)) == aId)
+      {
+        unsigned int id = 0;
+        sscanf(ToString(attrs.getValue(j)).c_str(), "%u", &id);
+        parent.channels.insert(id);
+        idSet = true;
+        break;
+      }
+    }
+
+    if (!idSet)
+    {
+      throw cms::Exception("TotemDAQMappingESSourceXML::GetChannels") <<
+        "Channel tags must have an `id' attribute.";
+    }
+  }
+
+  if (!parent.rpActive && !parent.t2Active && !parent.t1Active)
+    return;
+
+  NodeType type = GetNodeType(qname, f.tag);
+
+  if (parent.rpActive)
+    ProcessRP(parent, f, type, qname, attrs);
+
+  if (parent.t2Active)
+    ProcessT2(parent, f, type, qname, attrs);
+
+  if (parent.t1Active)
+    ProcessT1(parent, f, type, qname, attrs);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::endElement(const XMLCh* const, const XMLCh* const, const XMLCh* const)
+{
+  Frame &f = frames[depth - 1];
+
+  for (const auto &pm : f.pendingMasks)
+  {
+    if (pm.withChannels)
+      (*pm.buffer)[pm.index].second.maskedChannels = f.channels;
+  }
+
+  depth--;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::AddMask(Frame &f, MaskBuffer &buffer, const TotemSymbID &symbId, bool fullMask,
+  bool withChannels)
+{
+  PendingMask pm;
+  pm.buffer = &buffer;
+  pm.index = buffer.size();
+  pm.withChannels = withChannels;
+  f.pendingMasks.push_back(pm);
+
+  if (withChannels)
+    f.collectChannels = true;
+
+  TotemVFATAnalysisMask am;
+  am.fullMask = fullMask;
+  buffer.push_back(make_pair(symbId, am));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::ProcessRP(Frame &parent, Frame &f, NodeType type, const XMLCh *name,
+  const Attributes &attrs)
+{
+  // structure control
+  if (!RPNode(type))
+    return;
+
+  if ((type != parent.rpParentType + 1)&&(parent.rpParentType != nRPPot || type != nTriggerVFAT))
+  {
+    if (parent.rpParentType == nTop && type == nRPPot)
+    {
+      LogPrint("TotemDAQMappingESSourceXML") << ">> TotemDAQMappingESSourceXML::ParseTreeRP > Warning: tag `"
+        << TotemDAQMappingXMLParser::tagRPPot << "' found in global scope, assuming station ID = 12.";
+      parent.rpParentID = 12;
+    } else {
+      throw cms::Exception("TotemDAQMappingESSourceXML") << "Node " << ToString(name)
+        << " not allowed within " << GetName(parent) << " block.\n";
+    }
+  }
+
+  // parse tag attributes
+  unsigned int id = 0, hw_id = 0;
+  bool id_set = false, hw_id_set = false;
+  bool fullMask = false;
+
+  for (unsigned int j = 0; j < attrs.getLength(); j++)
+  {
+    const AttributeType at = GetAttributeType(attrs.getQName(j));
+
+    if (at == aId)
+    {
+      sscanf(ToString(attrs.getValue(j)).c_str(), "%u", &id);
+      id_set = true;
+    }
+
+    if (at == aHwId)
+    {
+      sscanf(ToString(attrs.getValue(j)).c_str(), "%x", &hw_id);
+      hw_id_set = true;
+    }
+
+    if (at == aFullMask)
+      fullMask = (ToString(attrs.getValue(j)).compare("no") != 0);
+  }
+
+  // content control
+  if (!id_set && type != nTriggerVFAT)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseTreeRP") << "id not given for element `"
+     << ToString(name) << "'" << endl;
+
+  if (!hw_id_set && type == nChip && pType == pMapping)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseTreeRP") << "hw_id not given for element `"
+     << ToString(name) << "'" << endl;
+
+  if (type == nRPPlane && id > 9)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseTreeRP") <<
+      "Plane IDs range from 0 to 9. id = " << id << " is invalid." << endl;
+
+  // store mapping data
+  if (pType == pMapping && (type == nChip || type == nTriggerVFAT))
+  {
+    const TotemFramePosition &framepos = ChipFramePosition(attrs);
+    TotemVFATInfo vfatInfo;
+    vfatInfo.hwID = hw_id;
+    vfatInfo.symbolicID.subSystem = TotemSymbID::RP;
+
+    if (type == nChip)
+    {
+      vfatInfo.symbolicID.symbolicID = parent.rpParentID * 10 + id;
+      vfatInfo.type = TotemVFATInfo::data;
+    }
+
+    if (type == nTriggerVFAT)
+    {
+      vfatInfo.symbolicID.symbolicID = parent.rpParentID;
+      vfatInfo.type = TotemVFATInfo::CC;
+    }
+
+    rpMapping.push_back(make_pair(framepos, vfatInfo));
+
+    return;
+  }
+
+  // store mask data
+  if (pType == pMask && type == nChip)
+  {
+    TotemSymbID symbId;
+    symbId.subSystem = TotemSymbID::RP;
+    symbId.symbolicID = parent.rpParentID * 10 + id;
+
+    AddMask(f, rpMasks, symbId, fullMask, true);
+
+    return;
+  }
+
+  // deeper in the tree
+  f.rpActive = true;
+  f.rpParentType = type;
+  f.rpParentID = parent.rpParentID * 10 + id;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::ProcessT2(Frame &parent, Frame &f, NodeType type, const XMLCh *name,
+  const Attributes &attrs)
+{
+  if ((T2Node(type)==false)&&(CommonNode(type)==false))
+    return;
+
+  // the parent ID as modified by the attributes, see TotemDAQMappingXMLParser::ParseTreeT2
+  unsigned int &parentID = parent.t2ParentID;
+
+  int ID_t2 = 0;
+  unsigned int position_t2 = 0;
+  unsigned int arm=0,ht=0,pl=0,pls=0;
+  bool idSet_t2 = false;
+  int attribcounter_t2planedescript=0;
+  unsigned int toaddForParentID=0;
+  unsigned hw_id = 0;
+  bool hw_id_set = false;
+
+  for (unsigned int j = 0; j < attrs.getLength(); j++) {
+    const AttributeType at = GetAttributeType(attrs.getQName(j));
+    if (at == aUnknown)
+      continue;
+
+    const string value = ToString(attrs.getValue(j));
+
+    if (at == aId) {
+      sscanf(value.c_str(), "%i", &ID_t2);
+      idSet_t2 = true;
+    }
+
+    if (at == aHwId) {
+      sscanf(value.c_str(), "%x", &hw_id);
+      hw_id_set = true;
+    }
+
+    if (at == aPosition) {
+      position_t2 = atoi(value.c_str());
+      if (pType == pMask)
+        toaddForParentID = position_t2;
+    }
+
+    if (type == nArm) {
+      // arm is the top node and should be reset to 0.
+      if (at == aId) {
+        parentID=0;
+        unsigned int id_arm = atoi(value.c_str());
+        toaddForParentID=20*id_arm;
+      }
+    }
+
+    if (type == nT2Half) {
+      if (at == aId) {
+        unsigned int id_half = atoi(value.c_str());
+        toaddForParentID=10*id_half;
+      }
+    }
+
+    // This is needed in principle only for the old formats
+    if(type == nT2Det) {
+      if (at == aArm) {
+        sscanf(value.c_str(), "%u", &arm);
+        attribcounter_t2planedescript++;
+      }
+
+      if (at == aHt) {
+        sscanf(value.c_str(), "%u", &ht);
+        attribcounter_t2planedescript++;
+      }
+
+      if (at == aPl) {
+        sscanf(value.c_str(), "%u", &pl);
+        attribcounter_t2planedescript++;
+      }
+
+      if (at == aPls) {
+        sscanf(value.c_str(), "%u", &pls);
+        attribcounter_t2planedescript++;
+      }
+
+      if (at == aId) {
+        sscanf(value.c_str(), "%i", &ID_t2);
+        attribcounter_t2planedescript++;
+      }
+
+      if (at == aPosition) {
+        sscanf(value.c_str(), "%u", &position_t2);
+        attribcounter_t2planedescript++;
+        attribcounter_t2planedescript=attribcounter_t2planedescript+20;
+      }
+    }
+  }
+
+  // plane ID from the attributes or from the structure, see TotemDAQMappingXMLParser::ParseTreeT2
+  if (pType == pMapping) {
+    if (type == nT2Det) {
+      if (attribcounter_t2planedescript>=(21)) {
+        if (attribcounter_t2planedescript>=25) {
+          edm::LogVerbatim("TotemDAQMappingESSourceXML") << "T2-Plane attribute utilezed for parentID: position+info from parent ";
+          unsigned int test_position_t2=arm*20+ht*10+pl*2+pls;
+          unsigned int testHS=pl*2+pls;
+          if(testHS!=position_t2) {
+            edm::LogPrint("TotemDAQMappingESSourceXML") <<"T2 Xml inconsistence in pl-pls attributes and position. Only 'position attribute' taken ";
+          }
+
+          ID_t2=parentID+position_t2;
+          cout << "attribcounter_t2planedescript>=(25), ID_t2: " << ID_t2 << endl;
+          toaddForParentID=position_t2;
+          if (ID_t2!=(int)test_position_t2)
+            edm::LogPrint("TotemDAQMappingESSourceXML") <<"T2 Xml inconsistence in plane attributes and xml parents structure. Plane attributes ignored";
+
+        } else {
+          edm::LogVerbatim("TotemDAQMappingESSourceXML")<<"T2 Plane have parentID: "<<parentID<<" for its VFATs. Plane Position read: "<<position_t2;
+
+          if (attribcounter_t2planedescript==21) {
+            ID_t2=parentID+position_t2;
+            toaddForParentID=position_t2;
+            idSet_t2=true;
+          }
+        }
+      } else {
+        if (attribcounter_t2planedescript>=1) {
+          if(attribcounter_t2planedescript>=5) {
+            int test_position_t2=arm*20+ht*10+pl*2+pls;
+
+            ID_t2=test_position_t2;
+            cout << "ID_t2=test_position_t2: " << ID_t2 << endl;
+            toaddForParentID=test_position_t2;
+
+            if ((int)parentID!=ID_t2) {
+              edm::LogPrint("TotemDAQMappingESSourceXML") <<"T2 Inconsistence between plane 'id' and position from attributes. Id ignored";
+              edm::LogPrint("TotemDAQMappingESSourceXML") <<" T2-Parent = "<<parentID;
+            }
+          } else {
+            toaddForParentID=ID_t2;
+            edm::LogVerbatim("TotemDAQMappingESSourceXML")<<" Number of T2 plane attributes: "<< attribcounter_t2planedescript<<" T2-Plane attribute utilezed for parentID: plane 'id' only";
+          }
+        } else {
+          edm::LogProblem ("TotemDAQMappingESSourceXML") << "T2 plane not enough specified from its attribute!";
+        }
+      }
+    }
+
+    // content control
+    if (idSet_t2 == false)
+      throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "ID_t2 not given for element `" << ToString(name) << "'" << endl;
+
+    if (type == nChip && !hw_id_set)
+      throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "hw_id not given for VFAT id `" <<
+        ID_t2 << "'" << endl;
+
+    if (type == nT2Det && position_t2 > 39)
+      throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "Plane position_t2 range from 0 to 39. position_t2 = " << position_t2 << " is invalid." << endl;
+  }
+
+  if (type == nChip) {
+    // save mapping data
+    if (pType == pMapping) {
+      unsigned int symId=0;
+      // Check if it is a special chip
+      if (!TotemDAQMappingXMLParser::tagT2detector.compare(GetName(parent)))
+        symId = parentID * 100 + ID_t2; // same conv = symbplaneNumber*100 +iid used in DQM
+      else
+        symId = ID_t2;      // special VFAT, the number is set directly in the XML file
+
+      TotemFramePosition framepos = ChipFramePosition(attrs);
+      TotemVFATInfo vfatInfo;
+      vfatInfo.symbolicID.symbolicID = symId;
+      vfatInfo.hwID = hw_id;
+      vfatInfo.symbolicID.subSystem = TotemSymbID::T2;
+      vfatInfo.type = TotemVFATInfo::data;
+      t2Mapping.push_back(make_pair(framepos, vfatInfo));
+    }
+
+    // save mask data
+    if (pType == pMask) {
+      TotemSymbID symbId;
+      symbId.subSystem = TotemSymbID::T2;
+      symbId.symbolicID = 100*parentID+ID_t2;
+
+      const XMLCh *fullMaskValue = attrs.getValue(attributeNames[aFullMask]);
+      const bool fullMask = (fullMaskValue && !ToString(fullMaskValue).compare("yes"));
+
+      AddMask(f, t2Masks, symbId, fullMask, !fullMask);
+    }
+  } else {
+    // deeper in the tree
+    f.t2Active = true;
+    f.t2ParentID = parentID + toaddForParentID;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemDAQMappingSAXParser::ProcessT1(Frame &parent, Frame &f, NodeType type, const XMLCh *name,
+  const Attributes &attrs)
+{
+  const int ArmMask = 0x0200;
+  const int PlaneMask = 0x01c0;
+  const int CSCMask = 0x0038;
+  const int GenderMask = 0x0004;
+  const int VFnMask = 0x0003;
+
+  if ((T1Node(type)==false)&&(CommonNode(type)==false))
+    return;
+
+  // the position as modified by the attributes, see TotemDAQMappingXMLParser::ParseTreeT1
+  unsigned int &parentID = parent.t1ParentID;
+  unsigned int &T1Arm = parent.t1Arm;
+  unsigned int &T1Plane = parent.t1Plane;
+  unsigned int &T1CSC = parent.t1CSC;
+  unsigned int &T1ChannelType = parent.t1ChannelType;
+
+  unsigned int ID_t1 = 0;
+  unsigned int Gender =0;
+  unsigned int hw_id = 0;
+  bool hw_id_set = false;
+  bool idSet_t1 = false;
+  bool fullMask = false;
+
+  for (unsigned int j = 0; j < attrs.getLength(); j++) {
+    const AttributeType at = GetAttributeType(attrs.getQName(j));
+
+    if (at == aId) {
+      sscanf(ToString(attrs.getValue(j)).c_str(), "%u", &ID_t1);
+      idSet_t1 = true;
+    }
+
+    if (type == nT1Arm) {
+      if (at == aId) {
+        // arm is the top node and parent ID should be reset to 0.
+        parentID=0;
+        unsigned int id_arm = atoi(ToString(attrs.getValue(j)).c_str());
+        T1Arm = id_arm;
+        if (id_arm != 0 && id_arm != 1)
+          throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "T1 id_arm neither 0 nor 1. Problem parsing XML file." << ToString(name) << endl;
+
+        id_arm = id_arm << 9;
+        parentID &= ~ArmMask;
+        parentID |= id_arm;
+      }
+    }
+
+    if (type == nT1Plane) {
+      if (at == aId) {
+        unsigned int id_plane = atoi(ToString(attrs.getValue(j)).c_str());
+        T1Plane = id_plane;
+        id_plane = id_plane << 6;
+        parentID &= ~PlaneMask;
+        parentID |= id_plane;
+      }
+    }
+
+    if (type == nT1CSC) {
+      if (at == aId) {
+        unsigned int id_csc = atoi(ToString(attrs.getValue(j)).c_str());
+        T1CSC = id_csc;
+        id_csc = id_csc << 3;
+        parentID &= ~CSCMask;
+        parentID |= id_csc;
+      }
+    }
+
+    if (type == nT1ChannelType) {
+      if (at == aId)
+        T1ChannelType = atoi(ToString(attrs.getValue(j)).c_str());
+
+      if (at == aFullMask)
+        fullMask = (ToString(attrs.getValue(j)).compare("no") != 0);
+    }
+
+    if (type == nChip) {
+      if (at == aPolarity) {
+        const string value = ToString(attrs.getValue(j));
+        if (value == "a")
+          Gender = 0;
+        else if (value == "c")
+          Gender = 1;
+        else
+          throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "T1: Neither anode nor cathode vfat : " << ToString(name) << endl;
+      }
+
+      if (at == aHwId)
+        sscanf(ToString(attrs.getValue(j)).c_str(), "%x", &hw_id);
+
+      // as in TotemDAQMappingXMLParser::ParseTreeT1, any attribute of a chip marks hw_id as set
+      hw_id_set = true;
+    }
+  }
+
+  // content control
+  if (idSet_t1==false)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "ID_t1 not given for element `" << ToString(name) << "'" << endl;
+
+  if (type == nChip && !hw_id_set)
+    throw cms::Exception("TotemDAQMappingESSourceXML::ParseTreeT1") <<
+      "hw_id not set for T1 VFAT id " << ID_t1 << "." << endl;
+
+  // save mask data
+  if (type == nT1ChannelType && pType == pMask) {
+    TotemSymbID symbId;
+    symbId.subSystem = TotemSymbID::T1;
+    symbId.symbolicID = T1ChannelType + 10 * T1CSC + 100 * T1Plane + 1000 * T1Arm;
+    AddMask(f, t1Masks, symbId, fullMask, true);
+  }
+
+  // save data
+  if (type == nChip) {
+    unsigned int symId=0;
+
+    // Check if it is a special chip
+    if (!TotemDAQMappingXMLParser::tagT1CSC.compare(GetName(parent))) {
+      symId = parentID;
+      Gender = Gender << 2;
+      symId &= ~GenderMask;
+      symId |= Gender;
+      symId &= ~VFnMask;
+      symId |= ID_t1;
+    } else {
+      throw cms::Exception("TotemDAQMappingESSourceXML::ParseTree") << "T1 has no special vfat `" << ToString(name) << "'" << endl;
+    }
+
+    TotemFramePosition framepos = ChipFramePosition(attrs);
+    TotemVFATInfo vfatInfo;
+    vfatInfo.symbolicID.symbolicID = symId;
+    vfatInfo.hwID = hw_id;
+    vfatInfo.symbolicID.subSystem = TotemSymbID::T1;
+    vfatInfo.type = TotemVFATInfo::data;
+    t1Mapping.push_back(make_pair(framepos, vfatInfo));
+  } else {
+    // deeper in the tree
+    f.t1Active = true;
+    f.t1ParentID = parentID;
+    f.t1Arm = T1Arm;
+    f.t1Plane = T1Plane;
+    f.t1CSC = T1CSC;
+    f.t1ChannelType = 0;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemFramePosition TotemDAQMappingSAXParser::ChipFramePosition(const Attributes &attrs)
+{
+  TotemFramePosition fp;
+  unsigned char attributeFlag = 0;
+
+  for (unsigned int j = 0; j < attrs.getLength(); j++)
+  {
+    const string attribute = ToString(attrs.getQName(j));
+    const string value = ToString(attrs.getValue(j));
+    if (fp.setXMLAttribute(attribute, value, attributeFlag) > 1)
+    {
+      throw cms::Exception("TotemDAQMappingESSourceXML") <<
+        "Unrecognized tag `" << attribute <<
+        "' or incompatible value `" << value <<
+        "'." << endl;
+    }
+  }
+
+  if (!fp.checkXMLAttributeFlag(attributeFlag))
+  {
+    throw cms::Exception("TotemDAQMappingESSourceXML") <<
+      "Wrong/incomplete DAQ channel specification (attributeFlag = " << (unsigned int) attributeFlag << ")." << endl;
+  }
+
+  return fp;
+}
@@ -0,0 +1,185 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingXMLParser.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingBinary.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkDAQMappingLoading [option]\n");
+  printf("Compares the time needed by TotemDAQMappingESSourceXML to load the mapping from the XML files\n");
+  printf("and from the precompiled binary file (including the source-hash check)\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of repetitions (default 20)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool Equal(const TotemDAQMapping &m1, const TotemAnalysisMask &a1, const TotemDAQMapping &m2, const TotemAnalysisMask &a2)
+{
+  if (m1.VFATMapping.size() != m2.VFATMapping.size() || a1.analysisMask.size() != a2.analysisMask.size())
+    return false;
+
+  for (auto it1 = m1.VFATMapping.begin(), it2 = m2.VFATMapping.begin(); it1 != m1.VFATMapping.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.type != it2->second.type
+      || !(it1->second.symbolicID == it2->second.symbolicID) || it1->second.hwID != it2->second.hwID)
+      return false;
+  }
+
+  for (auto it1 = a1.analysisMask.begin(), it2 = a2.analysisMask.begin(); it1 != a1.analysisMask.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.fullMask != it2->second.fullMask
+      || it1->second.maskedChannels != it2->second.maskedChannels)
+      return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long FileSize(const string &fn)
+{
+  struct stat st;
+  return (stat(fn.c_str(), &st) == 0) ? st.st_size : 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 20;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const string dir = "CondFormats/TotemReadoutObjects/xml/";
+
+  struct Configuration
+  {
+    string name;
+    vector<string> mappingFiles, maskFiles;
+  };
+
+  const vector<Configuration> configurations = {
+    { "ctpps_210", { dir + "ctpps_210_mapping.xml" }, {} },
+    { "totem_rp_220", { dir + "totem_rp_220_mapping.xml" }, {} },
+    { "totem_rp_210far_220", { dir + "totem_rp_210far_220_mapping.xml" }, {} },
+    { "all + mask", { dir + "totem_rp_210_mapping.xml", dir + "totem_rp_210far_220_mapping.xml" },
+      { dir + "totem_rp_mask_example.xml" } }
+  };
+
+  printf("%20s %10s %10s %8s %8s %12s %12s %12s %8s\n", "configuration", "XML (kB)", "bin (kB)", "VFATs", "masks",
+    "XML (ms)", "hash (ms)", "binary (ms)", "speed-up");
+
+  bool ok = true;
+
+  for (const auto &c : configurations)
+  {
+    vector<string> mappingFiles, maskFiles;
+    unsigned long xmlSize = 0;
+    for (const auto &fn : c.mappingFiles)
+    {
+      mappingFiles.push_back(edm::FileInPath(fn).fullPath());
+      xmlSize += FileSize(mappingFiles.back());
+    }
+    for (const auto &fn : c.maskFiles)
+    {
+      maskFiles.push_back(edm::FileInPath(fn).fullPath());
+      xmlSize += FileSize(maskFiles.back());
+    }
+
+    // XML parsing, as done by the ESSource without a binary file
+    TotemDAQMapping xmlMapping;
+    TotemAnalysisMask xmlMask;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      xmlMapping = TotemDAQMapping();
+      xmlMask = TotemAnalysisMask();
+      TotemDAQMappingXMLParser parser;
+      parser.Parse(mappingFiles, maskFiles, xmlMapping, xmlMask);
+    }
+    const double xmlTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    // compilation
+    char fn[] = "/tmp/benchmarkDAQMappingLoadingXXXXXX";
+    const int fd = mkstemp(fn);
+    if (fd < 0)
+    {
+      perror("ERROR: cannot create temporary file");
+      return 1;
+    }
+    close(fd);
+
+    uint64_t sourceHash;
+    if (TotemDAQMappingBinary::ComputeSourceHash(mappingFiles, maskFiles, sourceHash) != 0
+      || TotemDAQMappingBinary::Save(fn, sourceHash, xmlMapping, xmlMask) != 0)
+      return 1;
+
+    // hash check alone
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      TotemDAQMappingBinary::ComputeSourceHash(mappingFiles, maskFiles, sourceHash);
+    const double hashTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    // binary loading, as done by the ESSource with an up-to-date binary file
+    TotemDAQMapping binMapping;
+    TotemAnalysisMask binMask;
+    bool loaded = true;
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      TotemDAQMappingBinary::ComputeSourceHash(mappingFiles, maskFiles, sourceHash);
+      loaded &= (TotemDAQMappingBinary::Load(fn, sourceHash, binMapping, binMask) == 0);
+    }
+    const double binTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    printf("%20s %10.1f %10.1f %8lu %8lu %12.3f %12.3f %12.3f %8.1f\n", c.name.c_str(), xmlSize / 1E3,
+      FileSize(fn) / 1E3, (unsigned long) xmlMapping.VFATMapping.size(), (unsigned long) xmlMask.analysisMask.size(),
+      xmlTime * 1E3, hashTime * 1E3, binTime * 1E3, xmlTime / binTime);
+
+    if (!loaded || !Equal(xmlMapping, xmlMask, binMapping, binMask))
+    {
+      printf("ERROR: binary and XML content differ.\n");
+      ok = false;
+    }
+
+    unlink(fn);
+  }
+
+  return (ok) ? 0 : 2;
+}
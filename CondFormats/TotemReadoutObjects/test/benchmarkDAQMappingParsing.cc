@@ -0,0 +1,215 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingXMLParser.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingSAXParser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+// heap accounting: all allocations through operator new, including those of Xerces (its default memory
+// manager uses operator new); the figures are only meaningful with the xerces-c of the release
+
+namespace
+{
+  size_t heapCurrent = 0, heapPeak = 0;
+}
+
+void* operator new(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw bad_alloc();
+
+  heapCurrent += malloc_usable_size(p);
+  if (heapCurrent > heapPeak)
+    heapPeak = heapCurrent;
+
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  if (!p)
+    return;
+
+  heapCurrent -= malloc_usable_size(p);
+  free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkDAQMappingParsing [option]\n");
+  printf("Compares the parse time and the peak heap usage of the DOM (TotemDAQMappingXMLParser) and SAX\n");
+  printf("(TotemDAQMappingSAXParser) parsers of the DAQ mapping XML files\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of repetitions (default 20)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long FileSize(const string &fn)
+{
+  struct stat st;
+  return (stat(fn.c_str(), &st) == 0) ? st.st_size : 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+  double time;
+  size_t peak;
+  unsigned long vfats, masks;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+template <class Parser>
+Result Measure(const vector<string> &mappingFiles, const vector<string> &maskFiles, unsigned int n)
+{
+  Result r;
+
+  // peak heap of one parse, above the level before
+  {
+    const size_t base = heapCurrent;
+    heapPeak = base;
+
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+    Parser parser;
+    parser.Parse(mappingFiles, maskFiles, mapping, mask);
+
+    r.peak = heapPeak - base;
+    r.vfats = mapping.VFATMapping.size();
+    r.masks = mask.analysisMask.size();
+  }
+
+  auto start = chrono::steady_clock::now();
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+    Parser parser;
+    parser.Parse(mappingFiles, maskFiles, mapping, mask);
+  }
+  r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 20;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const string dir = "CondFormats/TotemReadoutObjects/xml/";
+
+  struct Configuration
+  {
+    string name;
+    vector<string> mappingFiles, maskFiles;
+  };
+
+  const vector<Configuration> configurations = {
+    { "ctpps_210", { dir + "ctpps_210_mapping.xml" }, {} },
+    { "totem_rp_210", { dir + "totem_rp_210_mapping.xml" }, {} },
+    { "totem_rp_220", { dir + "totem_rp_220_mapping.xml" }, {} },
+    { "totem_rp_210far_220", { dir + "totem_rp_210far_220_mapping.xml" }, {} },
+    { "totem_rp_mask_example", {}, { dir + "totem_rp_mask_example.xml" } },
+    { "all + mask", { dir + "totem_rp_210_mapping.xml", dir + "totem_rp_210far_220_mapping.xml" },
+      { dir + "totem_rp_mask_example.xml" } }
+  };
+
+  printf("%22s %9s %7s %7s %10s %10s %8s %11s %11s %8s\n", "configuration", "XML (kB)", "VFATs", "masks",
+    "DOM (ms)", "SAX (ms)", "speed-up", "DOM (kB)", "SAX (kB)", "ratio");
+
+  bool ok = true;
+
+  for (const auto &c : configurations)
+  {
+    vector<string> mappingFiles, maskFiles;
+    unsigned long xmlSize = 0;
+    for (const auto &fn : c.mappingFiles)
+    {
+      mappingFiles.push_back(edm::FileInPath(fn).fullPath());
+      xmlSize += FileSize(mappingFiles.back());
+    }
+    for (const auto &fn : c.maskFiles)
+    {
+      maskFiles.push_back(edm::FileInPath(fn).fullPath());
+      xmlSize += FileSize(maskFiles.back());
+    }
+
+    const Result dom = Measure<TotemDAQMappingXMLParser>(mappingFiles, maskFiles, n);
+    const Result sax = Measure<TotemDAQMappingSAXParser>(mappingFiles, maskFiles, n);
+
+    printf("%22s %9.1f %7lu %7lu %10.3f %10.3f %8.1f %11.1f %11.1f %8.1f\n", c.name.c_str(), xmlSize / 1E3,
+      dom.vfats, dom.masks, dom.time * 1E3, sax.time * 1E3, dom.time / sax.time, dom.peak / 1E3, sax.peak / 1E3,
+      double(dom.peak) / sax.peak);
+
+    if (dom.vfats != sax.vfats || dom.masks != sax.masks)
+    {
+      printf("ERROR: DOM and SAX results differ, run testTotemDAQMappingSAXParser for details.\n");
+      ok = false;
+    }
+  }
+
+  return (ok) ? 0 : 2;
+}
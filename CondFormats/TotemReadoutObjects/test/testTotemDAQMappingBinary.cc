@@ -0,0 +1,182 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingBinary.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+bool Equal(const TotemDAQMapping &m1, const TotemAnalysisMask &a1, const TotemDAQMapping &m2, const TotemAnalysisMask &a2)
+{
+  if (m1.VFATMapping.size() != m2.VFATMapping.size() || a1.analysisMask.size() != a2.analysisMask.size())
+    return false;
+
+  for (auto it1 = m1.VFATMapping.begin(), it2 = m2.VFATMapping.begin(); it1 != m1.VFATMapping.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.type != it2->second.type
+      || !(it1->second.symbolicID == it2->second.symbolicID) || it1->second.hwID != it2->second.hwID)
+      return false;
+  }
+
+  for (auto it1 = a1.analysisMask.begin(), it2 = a2.analysisMask.begin(); it1 != a1.analysisMask.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.fullMask != it2->second.fullMask
+      || it1->second.maskedChannels != it2->second.maskedChannels)
+      return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+string MakeTemporaryFile(const string &content)
+{
+  char fn[] = "/tmp/testTotemDAQMappingBinaryXXXXXX";
+  const int fd = mkstemp(fn);
+  if (fd >= 0)
+  {
+    if (write(fd, content.data(), content.size()) != (ssize_t) content.size())
+      perror("ERROR: cannot write temporary file");
+    close(fd);
+  }
+
+  return fn;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  int failures = 0;
+
+  // a mapping and a mask with all kinds of entries
+  mt19937 rng(15);
+  TotemDAQMapping mapping;
+  TotemAnalysisMask mask;
+
+  for (unsigned int i = 0; i < 500; ++i)
+  {
+    TotemVFATInfo vi;
+    vi.type = (rng() % 10 == 0) ? TotemVFATInfo::CC : TotemVFATInfo::data;
+    vi.symbolicID.subSystem = (i % 3 == 0) ? TotemSymbID::RP : ((i % 3 == 1) ? TotemSymbID::T1 : TotemSymbID::T2);
+    vi.symbolicID.symbolicID = rng() % 100000;
+    vi.hwID = rng() & 0xFFFF;
+    mapping.VFATMapping[TotemFramePosition(rng() & 0x3FFFF)] = vi;
+
+    if (i % 4 == 0)
+    {
+      TotemVFATAnalysisMask vam;
+      vam.fullMask = (rng() % 5 == 0);
+      for (unsigned int j = rng() % 10; j > 0; --j)
+        vam.maskedChannels.insert(rng() % 256);
+      mask.analysisMask[vi.symbolicID] = vam;
+    }
+  }
+
+  // two "XML" files
+  const string mappingFile = MakeTemporaryFile("<top><vfat id=\"1\"/></top>\n");
+  const string maskFile = MakeTemporaryFile("<top><vfat id=\"1\" full_mask=\"yes\"/></top>\n");
+  const string binaryFile = MakeTemporaryFile("");
+
+  uint64_t hash = 0;
+  if (TotemDAQMappingBinary::ComputeSourceHash({ mappingFile }, { maskFile }, hash) != 0)
+  {
+    printf("ERROR: cannot compute the source hash.\n");
+    failures++;
+  }
+
+  // the hash depends on the role of the files
+  uint64_t hashSwapped = 0;
+  TotemDAQMappingBinary::ComputeSourceHash({ maskFile }, { mappingFile }, hashSwapped);
+  uint64_t hashMerged = 0;
+  TotemDAQMappingBinary::ComputeSourceHash({ mappingFile, maskFile }, {}, hashMerged);
+  if (hash == hashSwapped || hash == hashMerged)
+  {
+    printf("ERROR: source hash does not depend on the file roles.\n");
+    failures++;
+  }
+
+  // round trip
+  if (TotemDAQMappingBinary::Save(binaryFile, hash, mapping, mask) != 0)
+  {
+    printf("ERROR: cannot save the binary file.\n");
+    failures++;
+  }
+
+  TotemDAQMapping loadedMapping;
+  TotemAnalysisMask loadedMask;
+  if (TotemDAQMappingBinary::Load(binaryFile, hash, loadedMapping, loadedMask) != 0
+    || !Equal(mapping, mask, loadedMapping, loadedMask))
+  {
+    printf("ERROR: round trip failed.\n");
+    failures++;
+  }
+
+  // stale file
+  if (TotemDAQMappingBinary::Load(binaryFile, hash + 1, loadedMapping, loadedMask) != 3
+    || !loadedMapping.VFATMapping.empty())
+  {
+    printf("ERROR: stale file not detected.\n");
+    failures++;
+  }
+
+  // corrupted file: flip one byte in the records
+  {
+    FILE *f = fopen(binaryFile.c_str(), "r+");
+    fseek(f, 100, SEEK_SET);
+    const int c = fgetc(f);
+    fseek(f, 100, SEEK_SET);
+    fputc(c ^ 0x10, f);
+    fclose(f);
+
+    if (TotemDAQMappingBinary::Load(binaryFile, hash, loadedMapping, loadedMask) != 4)
+    {
+      printf("ERROR: corrupted file not detected.\n");
+      failures++;
+    }
+  }
+
+  // truncated file
+  if (truncate(binaryFile.c_str(), 200) != 0
+    || TotemDAQMappingBinary::Load(binaryFile, hash, loadedMapping, loadedMask) != 4)
+  {
+    printf("ERROR: truncated file not detected.\n");
+    failures++;
+  }
+
+  // not a binary mapping
+  if (TotemDAQMappingBinary::Load(mappingFile, hash, loadedMapping, loadedMask) != 2)
+  {
+    printf("ERROR: unknown format not detected.\n");
+    failures++;
+  }
+
+  // missing file
+  if (TotemDAQMappingBinary::Load(binaryFile + ".missing", hash, loadedMapping, loadedMask) != 1)
+  {
+    printf("ERROR: missing file not detected.\n");
+    failures++;
+  }
+
+  unlink(mappingFile.c_str());
+  unlink(maskFile.c_str());
+  unlink(binaryFile.c_str());
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingXMLParser.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMappingSAXParser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+bool Equal(const TotemDAQMapping &m1, const TotemAnalysisMask &a1, const TotemDAQMapping &m2, const TotemAnalysisMask &a2)
+{
+  if (m1.VFATMapping.size() != m2.VFATMapping.size() || a1.analysisMask.size() != a2.analysisMask.size())
+    return false;
+
+  for (auto it1 = m1.VFATMapping.begin(), it2 = m2.VFATMapping.begin(); it1 != m1.VFATMapping.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.type != it2->second.type
+      || !(it1->second.symbolicID == it2->second.symbolicID) || it1->second.hwID != it2->second.hwID)
+      return false;
+  }
+
+  for (auto it1 = a1.analysisMask.begin(), it2 = a2.analysisMask.begin(); it1 != a1.analysisMask.end(); ++it1, ++it2)
+  {
+    if (!(it1->first == it2->first) || it1->second.fullMask != it2->second.fullMask
+      || it1->second.maskedChannels != it2->second.maskedChannels)
+      return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+string MakeTemporaryFile(const string &content)
+{
+  char fn[] = "/tmp/testTotemDAQMappingSAXParserXXXXXX";
+  const int fd = mkstemp(fn);
+  if (fd >= 0)
+  {
+    if (write(fd, content.data(), content.size()) != (ssize_t) content.size())
+      perror("ERROR: cannot write temporary file");
+    close(fd);
+  }
+
+  return fn;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// parses the files, returns the exception message or an empty string
+template <class Parser>
+string Parse(const vector<string> &mappingFiles, const vector<string> &maskFiles, TotemDAQMapping &mapping,
+  TotemAnalysisMask &mask)
+{
+  try
+  {
+    Parser parser;
+    parser.Parse(mappingFiles, maskFiles, mapping, mask);
+  }
+  catch (const cms::Exception &e)
+  {
+    return e.what();
+  }
+
+  return "";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// compares the results of the DOM and SAX parsers, returns true if the same
+bool Compare(const string &label, const vector<string> &mappingFiles, const vector<string> &maskFiles,
+  bool expectError = false)
+{
+  TotemDAQMapping domMapping, saxMapping;
+  TotemAnalysisMask domMask, saxMask;
+  const string domError = Parse<TotemDAQMappingXMLParser>(mappingFiles, maskFiles, domMapping, domMask);
+  const string saxError = Parse<TotemDAQMappingSAXParser>(mappingFiles, maskFiles, saxMapping, saxMask);
+
+  bool ok = true;
+
+  if (domError != saxError)
+  {
+    printf("ERROR: %s: different errors:\n    DOM: %s\n    SAX: %s\n", label.c_str(), domError.c_str(), saxError.c_str());
+    ok = false;
+  }
+
+  if (expectError && domError.empty())
+  {
+    printf("ERROR: %s: error expected.\n", label.c_str());
+    ok = false;
+  }
+
+  if (domError.empty() && !Equal(domMapping, domMask, saxMapping, saxMask))
+  {
+    printf("ERROR: %s: different content (DOM: %lu VFATs, %lu masks, SAX: %lu VFATs, %lu masks).\n", label.c_str(),
+      (unsigned long) domMapping.VFATMapping.size(), (unsigned long) domMask.analysisMask.size(),
+      (unsigned long) saxMapping.VFATMapping.size(), (unsigned long) saxMask.analysisMask.size());
+    ok = false;
+  }
+
+  return ok;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// Compares the SAX parser with the DOM one on the production XML files of the package. Both parsers run
+/// on the xerces-c of the release, so run it (scram b runtests) in every release with a new xerces-c version.
+int main()
+{
+  int failures = 0;
+
+  // all XML files of the package, each parsed as mapping and as mask
+  const string someFile = edm::FileInPath("CondFormats/TotemReadoutObjects/xml/ctpps_210_mapping.xml").fullPath();
+  const string dir = someFile.substr(0, someFile.rfind('/') + 1);
+
+  vector<string> files;
+  DIR *dp = opendir(dir.c_str());
+  if (!dp)
+  {
+    printf("ERROR: cannot open directory `%s'.\n", dir.c_str());
+    return 1;
+  }
+  while (struct dirent *de = readdir(dp))
+  {
+    const string name = de->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".xml") == 0)
+      files.push_back(dir + name);
+  }
+  closedir(dp);
+  sort(files.begin(), files.end());
+
+  for (const auto &f : files)
+  {
+    failures += !Compare(f + " (mapping)", { f }, {});
+    failures += !Compare(f + " (mask)", {}, { f });
+  }
+
+  // all mapping files together, all files as masks
+  vector<string> mappingFiles;
+  for (const auto &f : files)
+  {
+    if (f.find("_mapping.xml") != string::npos)
+      mappingFiles.push_back(f);
+  }
+  failures += !Compare("all files", mappingFiles, files);
+
+  // T2 and T1 structures, which the package files do not cover
+  const string t2Mapping = MakeTemporaryFile(
+    "<top>\n"
+    "  <t2_detector_set id=\"0\">\n"
+    "    <arm id=\"1\">\n"
+    "      <t2_half id=\"1\">\n"
+    "        <t2_detector id=\"3\" position=\"3\">\n"
+    "          <vfat id=\"5\" hw_id=\"0xa1\" SubSystemId=\"2\" TOTFEDId=\"1\" OptoRxId=\"0\" GOHId=\"1\" IdxInFiber=\"3\"/>\n"
+    "          <vfat id=\"6\" hw_id=\"0xa2\" SubSystemId=\"2\" TOTFEDId=\"1\" OptoRxId=\"0\" GOHId=\"1\" IdxInFiber=\"4\"/>\n"
+    "        </t2_detector>\n"
+    "        <t2_detector arm=\"1\" ht=\"1\" pl=\"2\" pls=\"1\" id=\"4\">\n"
+    "          <vfat id=\"1\" hw_id=\"0xa3\" SubSystemId=\"2\" TOTFEDId=\"1\" OptoRxId=\"0\" GOHId=\"2\" IdxInFiber=\"0\"/>\n"
+    "        </t2_detector>\n"
+    "      </t2_half>\n"
+    "    </arm>\n"
+    "    <vfat id=\"99\" hw_id=\"0xa4\" SubSystemId=\"2\" TOTFEDId=\"1\" OptoRxId=\"0\" GOHId=\"3\" IdxInFiber=\"0\"/>\n"
+    "  </t2_detector_set>\n"
+    "</top>\n");
+  failures += !Compare("T2 mapping", { t2Mapping }, {});
+
+  const string t2Mask = MakeTemporaryFile(
+    "<top>\n"
+    "  <t2_detector_set>\n"
+    "    <arm id=\"0\">\n"
+    "      <t2_half id=\"0\">\n"
+    "        <t2_detector position=\"7\">\n"
+    "          <vfat id=\"2\" full_mask=\"yes\"><channel id=\"3\"/></vfat>\n"
+    "          <vfat id=\"3\" full_mask=\"no\"><channel id=\"4\"/><channel id=\"100\"/></vfat>\n"
+    "        </t2_detector>\n"
+    "      </t2_half>\n"
+    "    </arm>\n"
+    "  </t2_detector_set>\n"
+    "</top>\n");
+  failures += !Compare("T2 mask", {}, { t2Mask });
+
+  const string t1Mapping = MakeTemporaryFile(
+    "<top>\n"
+    "  <t1_detector_set id=\"0\">\n"
+    "    <t1_arm id=\"1\">\n"
+    "      <t1_plane id=\"3\">\n"
+    "        <t1_csc id=\"2\">\n"
+    "          <vfat id=\"1\" polarity=\"a\" hw_id=\"0xb1\" SubSystemId=\"1\" TOTFEDId=\"2\" OptoRxId=\"1\" GOHId=\"0\" IdxInFiber=\"1\"/>\n"
+    "          <vfat id=\"2\" polarity=\"c\" hw_id=\"0xb2\" SubSystemId=\"1\" TOTFEDId=\"2\" OptoRxId=\"1\" GOHId=\"0\" IdxInFiber=\"2\"/>\n"
+    "        </t1_csc>\n"
+    "        <t1_csc id=\"4\">\n"
+    "          <vfat id=\"3\" polarity=\"a\" hw_id=\"0xb3\" SubSystemId=\"1\" TOTFEDId=\"2\" OptoRxId=\"1\" GOHId=\"1\" IdxInFiber=\"0\"/>\n"
+    "        </t1_csc>\n"
+    "      </t1_plane>\n"
+    "    </t1_arm>\n"
+    "  </t1_detector_set>\n"
+    "</top>\n");
+  failures += !Compare("T1 mapping", { t1Mapping }, {});
+
+  const string t1Mask = MakeTemporaryFile(
+    "<top>\n"
+    "  <t1_detector_set id=\"0\">\n"
+    "    <t1_arm id=\"0\">\n"
+    "      <t1_plane id=\"1\">\n"
+    "        <t1_csc id=\"5\">\n"
+    "          <t1_channel_type id=\"2\" full_mask=\"no\"><channel id=\"7\"/><channel id=\"8\"/></t1_channel_type>\n"
+    "          <t1_channel_type id=\"1\" full_mask=\"yes\"/>\n"
+    "        </t1_csc>\n"
+    "      </t1_plane>\n"
+    "    </t1_arm>\n"
+    "  </t1_detector_set>\n"
+    "</top>\n");
+  failures += !Compare("T1 mask", {}, { t1Mask });
+
+  // invalid content: the same errors are expected
+  const vector< pair<string, string> > invalid = {
+    { "unknown tag", "<top><arm id=\"0\"><foo/></arm></top>\n" },
+    { "wrong structure", "<top><arm id=\"0\"><rp_plane id=\"1\"/></arm></top>\n" },
+    { "missing id", "<top><arm id=\"0\"><station/></arm></top>\n" },
+    { "missing hw_id", "<top><arm id=\"0\"><station id=\"0\"><rp_detector_set id=\"0\"><rp_plane id=\"0\">"
+      "<vfat id=\"0\" SubSystemId=\"4\" TOTFEDId=\"1\" OptoRxId=\"0\" GOHId=\"0\" IdxInFiber=\"0\"/>"
+      "</rp_plane></rp_detector_set></station></arm></top>\n" },
+    { "plane id", "<top><arm id=\"0\"><station id=\"0\"><rp_detector_set id=\"0\"><rp_plane id=\"12\"/>"
+      "</rp_detector_set></station></arm></top>\n" },
+    { "incomplete position", "<top><arm id=\"0\"><station id=\"0\"><rp_detector_set id=\"0\"><rp_plane id=\"0\">"
+      "<vfat id=\"0\" hw_id=\"0x1\" GOHId=\"0\"/></rp_plane></rp_detector_set></station></arm></top>\n" },
+    { "T1 polarity", "<top><t1_detector_set id=\"0\"><t1_arm id=\"0\"><t1_plane id=\"0\"><t1_csc id=\"0\">"
+      "<vfat id=\"0\" polarity=\"x\"/></t1_csc></t1_plane></t1_arm></t1_detector_set></top>\n" },
+    { "T1 arm", "<top><t1_detector_set id=\"0\"><t1_arm id=\"2\"/></t1_detector_set></top>\n" },
+    { "T2 position", "<top><t2_detector_set id=\"0\"><t2_detector position=\"40\"/></t2_detector_set></top>\n" },
+  };
+
+  vector<string> invalidFiles;
+  for (const auto &p : invalid)
+  {
+    invalidFiles.push_back(MakeTemporaryFile(p.second));
+    failures += !Compare(p.first, { invalidFiles.back() }, {}, true);
+  }
+
+  const string maskWithoutChannelId = MakeTemporaryFile("<top><arm id=\"0\"><station id=\"0\"><rp_detector_set id=\"0\">"
+    "<rp_plane id=\"0\"><vfat id=\"0\"><channel/></vfat></rp_plane></rp_detector_set></station></arm></top>\n");
+  failures += !Compare("channel without id", {}, { maskWithoutChannelId }, true);
+
+  const string emptyFile = MakeTemporaryFile("");
+
+  // an empty file is an error for both, the messages differ in the parser details
+  {
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+    if (Parse<TotemDAQMappingSAXParser>({ emptyFile }, {}, mapping, mask).empty())
+    {
+      printf("ERROR: empty file accepted.\n");
+      failures++;
+    }
+  }
+
+  for (const auto &f : { t2Mapping, t2Mask, t1Mapping, t1Mask, maskWithoutChannelId, emptyFile })
+    unlink(f.c_str());
+  for (const auto &f : invalidFiles)
+    unlink(f.c_str());
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -107,9 +107,15 @@ class TotemRPLocalTrack
     TVectorD getParameterVector() const;
     void setParameterVector(const TVectorD & track_params_vector);
 
+    /// sets the parameters from a plain array of dimension elements
+    void setParameterVector(const double *track_params_vector);
+
     TMatrixD getCovarianceMatrix() const;
     void setCovarianceMatrix(const TMatrixD &par_covariance_matrix);
 
+    /// sets the covariance matrix from a plain array of covarianceSize elements, in row-major order
+    void setCovarianceMatrix(const double *par_covariance_matrix);
+
     inline double getChiSquared() const { return chiSquared_; }
     inline void setChiSquared(double & chiSquared) { chiSquared_ = chiSquared; }
 
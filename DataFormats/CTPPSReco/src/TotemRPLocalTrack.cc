@@ -68,6 +68,14 @@ void TotemRPLocalTrack::setParameterVector(const TVectorD & track_params_vector)
 
 //----------------------------------------------------------------------------------------------------
 
+void TotemRPLocalTrack::setParameterVector(const double *track_params_vector)
+{
+  for (int i = 0; i < dimension; ++i)
+    track_params_vector_[i] = track_params_vector[i];
+}
+
+//----------------------------------------------------------------------------------------------------
+
 TMatrixD TotemRPLocalTrack::getCovarianceMatrix() const 
 {
   TMatrixD m(dimension,dimension);
@@ -90,6 +98,14 @@ void TotemRPLocalTrack::setCovarianceMatrix(const TMatrixD &par_covariance_matri
 
 //----------------------------------------------------------------------------------------------------
 
+void TotemRPLocalTrack::setCovarianceMatrix(const double *par_covariance_matrix)
+{
+  for (int i = 0; i < covarianceSize; ++i)
+    par_covariance_matrix_[i] = par_covariance_matrix[i];
+}
+
+//----------------------------------------------------------------------------------------------------
+
 bool operator< (const TotemRPLocalTrack &l, const TotemRPLocalTrack &r)
 {
   if (l.z0_ < r.z0_)
@@ -9,6 +9,8 @@
 #ifndef DataFormats_TotemDigi_TotemFEDInfo
 #define DataFormats_TotemDigi_TotemFEDInfo
 
+#include <cstdint>
+
 /**
  * \brief OptoRx headers and footers.
  **/
@@ -137,6 +137,22 @@ class TotemRPDetId : public DetId
       return i;
     }
 
+    /// number of compact plane indices, see rawToPlaneIndex
+    static const unsigned int numberOfPlaneIndices = (maxArm + 1) * (maxStation + 1) * (maxRP + 1) * (maxDet + 1);
+
+    /// fast conversion Raw ID to compact plane index: |arm|station|RP|det| with radices 2, 3, 6 and 10,
+    /// i.e. from 0 to numberOfPlaneIndices - 1 for valid IDs; suitable for indexing flat per-plane tables
+    /// gives numberOfPlaneIndices for IDs with a field out of range (e.g. det 10-15, RP 6-7 or station 3)
+    static unsigned int rawToPlaneIndex(unsigned int raw)
+    {
+      const unsigned int arm = (raw >> startArmBit) & maskArm, station = (raw >> startStationBit) & maskStation,
+        rp = (raw >> startRPBit) & maskRP, det = (raw >> startDetBit) & maskDet;
+      if (arm > maxArm || station > maxStation || rp > maxRP || det > maxDet)
+        return numberOfPlaneIndices;
+
+      return ((arm * (maxStation + 1) + station) * (maxRP + 1) + rp) * (maxDet + 1) + det;
+    }
+
     /// returns ID of RP for given detector ID ''i''
     static unsigned int rpOfDet(unsigned int i) { return i / 10; }
 
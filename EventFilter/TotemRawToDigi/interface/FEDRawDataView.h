@@ -0,0 +1,54 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_FEDRawDataView
+#define EventFilter_TotemRawToDigi_FEDRawDataView
+
+#include "DataFormats/FEDRawData/interface/FEDRawData.h"
+
+#include <cstddef>
+
+/**
+ * Read-only view of the raw data of one FED, which does not own the memory.
+ *
+ * The data may be held by a FEDRawData (the view converts implicitly) or be a part of a larger buffer,
+ * e.g. an event read from a file. The memory must outlive the view and be aligned to 8 bytes, as the
+ * unpacker reads it as 64-bit words.
+**/
+class FEDRawDataView
+{
+  public:
+    FEDRawDataView() : ptr(NULL), length(0)
+    {
+    }
+
+    FEDRawDataView(const unsigned char *_ptr, size_t _length) : ptr(_ptr), length(_length)
+    {
+    }
+
+    FEDRawDataView(const FEDRawData &data) : ptr((data.size() > 0) ? data.data() : NULL), length(data.size())
+    {
+    }
+
+    const unsigned char* data() const
+    {
+      return ptr;
+    }
+
+    /// in bytes
+    size_t size() const
+    {
+      return length;
+    }
+
+  protected:
+    const unsigned char *ptr;
+    size_t length;
+};
+
+#endif
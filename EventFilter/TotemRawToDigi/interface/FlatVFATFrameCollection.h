@@ -0,0 +1,121 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_FlatVFATFrameCollection
+#define EventFilter_TotemRawToDigi_FlatVFATFrameCollection
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCollection.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * VFAT frame collection stored in dense arrays.
+ *
+ * The frames are organised in blocks of 256 slots, one block per FED (i.e. per value of the raw position
+ * without the GOH and index bits). Within a block, the slot is given by the GOH and index in fiber, and a
+ * bitmap marks the occupied slots. Blocks are allocated when a frame of a new FED is inserted and are kept
+ * by Clear, hence a collection reused from event to event does not allocate any memory after the first
+ * events. Iteration goes through the positions in ascending order, like in SimpleVFATFrameCollection.
+ *
+ * Insert and InsertEmptyFrame have the same semantics as in SimpleVFATFrameCollection: an already
+ * occupied position is not overwritten.
+**/
+class FlatVFATFrameCollection : public VFATFrameCollection
+{
+  protected:
+    static const unsigned int slotBits = 8;
+    static const unsigned int blockSize = 1 << slotBits;
+
+    struct Block
+    {
+      unsigned int id;                    ///< raw position >> slotBits
+      uint64_t valid[blockSize / 64];     ///< occupancy bitmap
+      VFATFrame frames[blockSize];
+    };
+
+    /// allocated blocks, sorted by id
+    std::vector<Block*> blocks;
+
+    /// the number of frames in the collection
+    unsigned int size;
+
+    /// the block of the last insertion (blocks of subsequent insertions usually coincide); only used by
+    /// the non-const insertion methods, the const access is free of side effects (thread safe)
+    unsigned int lastInsertBlockIdx;
+
+    /// returns the index of the block with the given id, blocks.size() if the block is not allocated
+    unsigned int FindBlockIdx(unsigned int id) const;
+
+    /// returns the block with the given id, NULL if the block is not allocated
+    const Block* GetBlock(unsigned int id) const
+    {
+      const unsigned int idx = FindBlockIdx(id);
+      return (idx < blocks.size()) ? blocks[idx] : NULL;
+    }
+
+    /// returns the block with the given id, allocates it if needed
+    Block* GetOrCreateBlock(unsigned int id);
+
+    /// returns the frame at the given position, marks the position occupied if it was free (inserted = true)
+    VFATFrame* Reserve(const TotemFramePosition &index, bool &inserted);
+
+    /// returns the first occupied position at or after the slot `slot' of the block with index `blockIdx'
+    value_type FindValid(unsigned int blockIdx, unsigned int slot) const;
+
+    virtual value_type BeginIterator() const;
+    virtual value_type NextIterator(const value_type&) const;
+    virtual bool IsEndIterator(const value_type&) const;
+
+  public:
+    FlatVFATFrameCollection();
+    ~FlatVFATFrameCollection();
+
+    /// the blocks are owned by the collection, copying is not supported
+    FlatVFATFrameCollection(const FlatVFATFrameCollection&) = delete;
+    FlatVFATFrameCollection& operator= (const FlatVFATFrameCollection&) = delete;
+
+    const VFATFrame* GetFrameByID(unsigned int ID) const;
+    const VFATFrame* GetFrameByIndex(TotemFramePosition index) const;
+
+    virtual unsigned int Size() const
+    {
+      return size;
+    }
+
+    virtual bool Empty() const
+    {
+      return (size == 0);
+    }
+
+    void Insert(const TotemFramePosition &index, const VFATFrame &frame)
+    {
+      bool inserted;
+      VFATFrame *f = Reserve(index, inserted);
+      if (inserted)
+        *f = frame;
+    }
+
+    /// inserts an empty (default) frame to the given position and returns pointer to the frame
+    VFATFrame* InsertEmptyFrame(TotemFramePosition index)
+    {
+      bool inserted;
+      VFATFrame *f = Reserve(index, inserted);
+      if (inserted)
+        *f = VFATFrame();
+      return f;
+    }
+
+    /// inserts all frames of `other', with the same semantics as Insert (occupied positions are kept)
+    void Insert(const FlatVFATFrameCollection &other);
+
+    /// marks all positions as free, the memory is kept for the next use
+    void Clear();
+};
+
+#endif
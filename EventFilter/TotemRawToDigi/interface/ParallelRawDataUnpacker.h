@@ -0,0 +1,63 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_ParallelRawDataUnpacker
+#define EventFilter_TotemRawToDigi_ParallelRawDataUnpacker
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+#include "DataFormats/TotemDigi/interface/TotemFEDInfo.h"
+
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
+
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Unpacks the FEDs of an event concurrently, one TBB task per FED.
+ *
+ * Each task unpacks into its own frame collection, FED-info vector and error counters. The results are
+ * then merged in the order of the FED list, hence the output is identical to unpacking the FEDs one by one
+ * (in the same order) with RawDataUnpacker, independently of the scheduling. The tasks run in the current
+ * TBB task arena, i.e. within the framework's thread pool.
+ *
+ * An instance is not thread safe, each stream needs its own one.
+**/
+class ParallelRawDataUnpacker
+{
+  public:
+    ParallelRawDataUnpacker(const RawDataUnpacker &_unpacker) : unpacker(_unpacker) {}
+
+    /// unpacks the FEDs with non-empty data, the frames are appended to `coll', the FED info to `fedInfo'
+    void Run(const std::vector<unsigned int> &fedIds, const FEDRawDataCollection &rawData,
+      std::vector<TotemFEDInfo> &fedInfo, FlatVFATFrameCollection &coll);
+
+    /// adds the error counts of all tasks to `ec' and resets them
+    void MergeErrorCounters(RawToDigiErrorCounters &ec);
+
+  protected:
+    const RawDataUnpacker &unpacker;
+
+    /// the output buffers of one task, reused from event to event
+    struct Task
+    {
+      FlatVFATFrameCollection frames;
+      std::vector<TotemFEDInfo> fedInfo;
+
+      /// accumulated over events, merged by MergeErrorCounters
+      RawToDigiErrorCounters errorCounters;
+    };
+
+    /// one task per position in the FED list
+    std::vector<std::unique_ptr<Task>> tasks;
+};
+
+#endif
@@ -11,11 +11,14 @@
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
-#include "DataFormats/FEDRawData/interface/FEDRawData.h"
 #include "DataFormats/TotemDigi/interface/TotemFEDInfo.h"
 
+#include "EventFilter/TotemRawToDigi/interface/FEDRawDataView.h"
 #include "EventFilter/TotemRawToDigi/interface/VFATFrameCollection.h"
 #include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/SerialFrameTransposer.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
 
 //----------------------------------------------------------------------------------------------------
 
@@ -28,24 +31,44 @@ class RawDataUnpacker
     /// VFAT transmission modes
     enum { vmCluster = 0x80, vmRaw = 0x90 };
 
-    RawDataUnpacker() {}
+    RawDataUnpacker() : verbosity(0) {}
     
     RawDataUnpacker(const edm::ParameterSet &conf);
 
     /// Unpack data from FED with fedId into `coll' collection.
-    int Run(int fedId, const FEDRawData &data, std::vector<TotemFEDInfo> &fedInfoColl, SimpleVFATFrameCollection &coll) const;
+    /// The data can be given as FEDRawData or as a view into a reader's buffer.
+    /// The collection can be SimpleVFATFrameCollection or FlatVFATFrameCollection.
+    /// Data errors are counted in `ec', if not NULL.
+    template <typename FrameCollection>
+    int Run(int fedId, const FEDRawDataView &data, std::vector<TotemFEDInfo> &fedInfoColl, FrameCollection &coll,
+      RawToDigiErrorCounters *ec = NULL) const;
 
     /// Process one Opto-Rx (or LoneG) frame.
-    int ProcessOptoRxFrame(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, SimpleVFATFrameCollection *fc) const;
+    template <typename FrameCollection>
+    int ProcessOptoRxFrame(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, FrameCollection *fc,
+      RawToDigiErrorCounters *ec = NULL) const;
 
     /// Process one Opto-Rx frame in serial (old) format
-    int ProcessOptoRxFrameSerial(const word *buffer, unsigned int frameSize, SimpleVFATFrameCollection *fc) const;
+    template <typename FrameCollection>
+    int ProcessOptoRxFrameSerial(const word *buffer, unsigned int frameSize, FrameCollection *fc,
+      RawToDigiErrorCounters *ec = NULL) const;
 
     /// Process one Opto-Rx frame in parallel (new) format
-    int ProcessOptoRxFrameParallel(const word *buffer, unsigned int frameSize, TotemFEDInfo &fedInfo, SimpleVFATFrameCollection *fc) const;
+    template <typename FrameCollection>
+    int ProcessOptoRxFrameParallel(const word *buffer, unsigned int frameSize, TotemFEDInfo &fedInfo, FrameCollection *fc,
+      RawToDigiErrorCounters *ec = NULL) const;
 
     /// Process data from one VFAT in parallel (new) format
-    int ProcessVFATDataParallel(const uint16_t *buf, unsigned int OptoRxId, SimpleVFATFrameCollection *fc) const;
+    template <typename FrameCollection>
+    int ProcessVFATDataParallel(const uint16_t *buf, unsigned int OptoRxId, FrameCollection *fc,
+      RawToDigiErrorCounters *ec = NULL) const;
+
+  protected:
+    /// 0: errors are only counted, 1: a message is printed for each error
+    unsigned int verbosity;
+
+    /// rebuilds VFAT frames from the GOH blocks of serial frames
+    SerialFrameTransposer serialTransposer;
 };
 
 #endif
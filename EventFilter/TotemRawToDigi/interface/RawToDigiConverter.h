@@ -13,6 +13,8 @@
 #include "DataFormats/Common/interface/DetSetVector.h"
 
 #include "EventFilter/TotemRawToDigi/interface/VFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/VFATMappingTable.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
 
 #include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
 #include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
@@ -20,6 +22,8 @@
 #include "DataFormats/TotemDigi/interface/TotemRPDigi.h"
 #include "DataFormats/TotemDigi/interface/TotemVFATStatus.h"
 
+#include <sstream>
+
 //----------------------------------------------------------------------------------------------------
 
 /// \brief Collection of code to convert TOTEM raw data into digi.
@@ -28,9 +32,22 @@ class RawToDigiConverter
   public:
     RawToDigiConverter(const edm::ParameterSet &conf);
 
-    /// Creates RP digi.
-    void Run(const VFATFrameCollection &coll, const TotemDAQMapping &mapping, const TotemAnalysisMask &mask,
-      edm::DetSetVector<TotemRPDigi> &digi, edm::DetSetVector<TotemVFATStatus> &status);
+    /// Compiles the DAQ mapping and the analysis mask, to be called whenever they change.
+    void SetMapping(const TotemDAQMapping &mapping, const TotemAnalysisMask &mask);
+
+    /// Creates RP digi, using the mapping and mask given to SetMapping.
+    void Run(const VFATFrameCollection &coll, edm::DetSetVector<TotemRPDigi> &digi,
+      edm::DetSetVector<TotemVFATStatus> &status);
+
+    /// Error counters of the conversion, the unpacker can count its errors here too.
+    /// Missing frames are only added by CompleteErrorCounters.
+    RawToDigiErrorCounters& GetErrorCounters()
+    {
+      return errorCounters;
+    }
+
+    /// Adds the frames missing since the last call (or the last mapping change) to the error counters.
+    void CompleteErrorCounters();
 
     /// Print error summaries.
     void PrintSummaries();
@@ -38,11 +55,21 @@ class RawToDigiConverter
   private:
     struct Record
     {
-      const TotemVFATInfo *info;
       const VFATFrame *frame;
       TotemVFATStatus status;
     };
 
+    /// gives CounterChecker access to the records by frame position
+    struct RecordAccessor
+    {
+      RawToDigiConverter &converter;
+
+      Record& operator[] (const TotemFramePosition &position)
+      {
+        return converter.records[converter.mappingTable.Find(position)];
+      }
+    };
+
     unsigned char verbosity;
     
     unsigned int printErrorSummary;
@@ -65,13 +92,37 @@ class RawToDigiConverter
     /// the minimal required (relative) occupancy of the most frequent counter value to be accepted
     double EC_fraction, BC_fraction;
 
-    /// error summaries
-    std::map<TotemFramePosition, std::map<TotemVFATStatus, unsigned int> > errorSummary;
-    std::map<TotemFramePosition, unsigned int> unknownSummary;
+    /// error counters, replace the former per-VFAT maps of status signatures
+    RawToDigiErrorCounters errorCounters;
+
+    /// event and frame error message buffers, only used if verbosity > 0
+    std::stringstream eventMessages, frameMessages;
+
+    /// the compiled mapping and mask
+    VFATMappingTable mappingTable;
+
+    /// the status of all RP data VFATs as if all frames were missing, copied to the output of each event
+    edm::DetSetVector<TotemVFATStatus> statusTemplate;
+
+    /// for each mapping entry, index of its status within the DetSet (of statusTemplate)
+    std::vector<unsigned int> statusIndices;
+
+    /// mapping entries not belonging to RP
+    std::vector<unsigned int> nonRPEntries;
+
+    /// records of the current event, indexed like the mapping entries, only those in presentEntries are valid
+    std::vector<Record> records;
+
+    /// indices of the mapping entries with a frame in the current event, in the order of frame positions
+    std::vector<unsigned int> presentEntries;
+
+    /// the number of events since the last CompleteErrorCounters call and, per mapping entry, the number of
+    /// these events with a frame; the difference gives the number of "missing" errors
+    unsigned int eventsWithMapping;
+    std::vector<unsigned int> eventsWithFrame;
 
     /// Common processing for all VFAT based sub-systems.
-    void RunCommon(const VFATFrameCollection &input, const TotemDAQMapping &mapping,
-      std::map<TotemFramePosition, Record> &records);
+    void RunCommon(const VFATFrameCollection &input);
 };
 
 #endif
@@ -0,0 +1,156 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_RawToDigiErrorCounters
+#define EventFilter_TotemRawToDigi_RawToDigiErrorCounters
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemFramePosition.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Counters of the errors found by RawDataUnpacker and RawToDigiConverter, per frame position and error type.
+ *
+ * The counters are stored in blocks of 256 positions (one block per FED), a block is allocated with the
+ * first error of its FED. Counting is thus a plain increment, without any allocation or locking: each
+ * stream (thread) is expected to have its own instance. The instances are combined by Merge at the end
+ * of the job.
+ *
+ * Errors concerning a whole OptoRx frame are counted at the position with GOH and index 0.
+**/
+class RawToDigiErrorCounters
+{
+  public:
+    enum ErrorType
+    {
+      // RawDataUnpacker
+      etFEDTooShort = 0,        ///< FED data shorter than header and footer
+      etOptoRxStructure,        ///< wrong OptoRx header or footer
+      etUnknownFOV,             ///< unknown OptoRx format
+      etGOHBlockStructure,      ///< wrong GOH block header or footer (serial format)
+      etHeaderFlag,             ///< unknown VFAT block header flag (parallel format)
+      etTrailerSignature,       ///< wrong VFAT block trailer signature (parallel format)
+      etDAQErrorFlags,          ///< non-zero error flags in VFAT block trailer (parallel format)
+      etTrailerSize,            ///< VFAT block size does not match the trailer (parallel format)
+      etInvalidCluster,         ///< cluster out of the channel range (parallel format)
+
+      // RawToDigiConverter
+      etUnknownFrame,           ///< frame not in the DAQ mapping
+      etMissing,                ///< VFAT in the DAQ mapping without frame
+      etFootprint,
+      etCRC,
+      etIDMismatch,
+      etECProgress,
+      etBCProgress,
+
+      etNumberOfTypes
+    };
+
+    RawToDigiErrorCounters() : events(0) {}
+
+    /// short name of the error type, used in the reports
+    static const char* GetName(ErrorType type);
+
+    void Add(const TotemFramePosition &position, ErrorType type, unsigned int n = 1)
+    {
+      GetCounters(position.getRawPosition())[type] += n;
+    }
+
+    void AddEvent()
+    {
+      events++;
+    }
+
+    unsigned long GetEvents() const
+    {
+      return events;
+    }
+
+    unsigned long Get(const TotemFramePosition &position, ErrorType type) const;
+
+    /// sum over all positions
+    unsigned long GetTotal(ErrorType type) const;
+
+    /// adds the counts (and events) of `other'
+    void Merge(const RawToDigiErrorCounters &other);
+
+    /// sets all counters to zero, the memory is kept
+    void Clear();
+
+    /// prints the positions with errors of the unpacker and the converter (if `errors') and the positions with
+    /// unknown frames (if `unknown')
+    void PrintSummary(std::ostream &os, bool errors, bool unknown) const;
+
+    /// writes a table with one line per position with errors and one column per error type
+    void WriteCSV(std::ostream &os) const;
+
+    /// writes the events, the totals per error type and the non-zero counters per position
+    void WriteJSON(std::ostream &os) const;
+
+  protected:
+    typedef uint32_t counter;
+
+    static const unsigned int slotBits = 8;
+    static const unsigned int blockSize = 1 << slotBits;
+    static const unsigned int blockLength = blockSize * etNumberOfTypes;
+
+    unsigned long events;
+
+    /// block id (raw position >> slotBits) -> offset of the block in `counters', -1 if not allocated
+    std::vector<int> blockOffsets;
+
+    /// blocks of counters, position-major
+    std::vector<counter> counters;
+
+    counter* GetCounters(unsigned int rawPosition)
+    {
+      const unsigned int block = rawPosition >> slotBits;
+      if (block >= blockOffsets.size() || blockOffsets[block] < 0)
+        AllocateBlock(block);
+
+      return &counters[blockOffsets[block] + (rawPosition & (blockSize - 1)) * etNumberOfTypes];
+    }
+
+    const counter* GetCounters(unsigned int rawPosition) const;
+
+    void AllocateBlock(unsigned int block);
+
+    /// calls f(position, counters) for all positions with at least one error, in the order of positions
+    template <typename F>
+    void ForEach(F f) const;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+template <typename F>
+void RawToDigiErrorCounters::ForEach(F f) const
+{
+  for (unsigned int block = 0; block < blockOffsets.size(); ++block)
+  {
+    if (blockOffsets[block] < 0)
+      continue;
+
+    for (unsigned int slot = 0; slot < blockSize; ++slot)
+    {
+      const counter *c = &counters[blockOffsets[block] + slot * etNumberOfTypes];
+
+      bool any = false;
+      for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+        any |= (c[t] != 0);
+
+      if (any)
+        f(TotemFramePosition((block << slotBits) | slot), c);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,75 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_SerialFrameTransposer
+#define EventFilter_TotemRawToDigi_SerialFrameTransposer
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+
+#include <string>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Rebuilds VFAT frames from a GOH block of a serial (FOV = 1) OptoRx frame.
+ *
+ * A GOH block consists of 192 16-bit words (one 16-bit column of 192 consecutive 64-bit OptoRx words).
+ * Bit `idx' of word `i' is bit `15 - i%16' of data word `11 - i/16' of the VFAT frame `idx'. Each
+ * group of 16 words is thus a 16x16 bit matrix which is transposed into one data word of the 16 frames.
+ *
+ * Several implementations are available:
+ * \verbatim
+ * bitwise   bit-by-bit loop (reference)
+ * scalar    4 rows packed in a 64-bit word, transposed with shift/mask steps
+ * sse2      byte-sliced transpose with SSE2 movemask, 1 matrix per step
+ * avx2      byte-sliced transpose with AVX2 movemask, 2 matrices per step
+ * \endverbatim
+ * The SIMD variants are only available on x86 CPUs supporting the instruction set, which is checked
+ * at run time. All implementations OR the result into the frames, i.e. the frames shall be empty.
+ **/
+class SerialFrameTransposer
+{
+  public:
+    enum Implementation { iAuto = 0, iBitwise, iScalar, iSSE2, iAVX2 };
+
+    /// transposes one GOH block: 192 words taken from the 16-bit column `column' of `buf' into `frames[16]'
+    typedef void (*Function)(const uint64_t *buf, unsigned int column, VFATFrame::word * const *frames);
+
+    SerialFrameTransposer(Implementation impl = iAuto);
+
+    /// selects the implementation, iAuto means the fastest available one
+    /// returns false (and keeps the current implementation) if it is not available on this CPU
+    bool SetImplementation(Implementation impl);
+
+    Implementation GetImplementation() const
+    {
+      return implementation;
+    }
+
+    void Transpose(const uint64_t *buf, unsigned int column, VFATFrame::word * const *frames) const
+    {
+      function(buf, column, frames);
+    }
+
+    /// whether the implementation can be used on this CPU
+    static bool IsAvailable(Implementation impl);
+
+    /// returns the fastest implementation available on this CPU
+    static Implementation GetBestImplementation();
+
+    static const char* GetName(Implementation impl);
+
+    /// converts a name (as listed above or "auto") to an implementation, returns false if the name is unknown
+    static bool GetImplementation(const std::string &name, Implementation &impl);
+
+  protected:
+    Implementation implementation;
+    Function function;
+};
+
+#endif
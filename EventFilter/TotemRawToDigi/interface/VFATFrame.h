@@ -32,6 +32,15 @@ class VFATFrame
       numberOfClusters = copy.numberOfClusters;
     }
 
+    VFATFrame& operator= (const VFATFrame& copy)
+    {
+      setData(copy.data);
+      presenceFlags = copy.presenceFlags;
+      daqErrorFlags = copy.daqErrorFlags;
+      numberOfClusters = copy.numberOfClusters;
+      return *this;
+    }
+
     virtual ~VFATFrame() {}
 
     /// Copies a memory block to data buffer.
@@ -42,6 +51,11 @@ class VFATFrame
       return data;
     }
 
+    const VFATFrame::word* getData() const
+    {
+      return data;
+    }
+
     /// Returns Bunch Crossing number (BC<11:0>).
     VFATFrame::word getBC() const
     {
@@ -114,6 +128,12 @@ class VFATFrame
       daqErrorFlags = v;
     }
 
+    /// Returns DAQ error flags.
+    uint8_t getDAQErrorFlags() const
+    {
+      return daqErrorFlags;
+    }
+
     void setNumberOfClusters(uint8_t v)
     {
       numberOfClusters = v;
@@ -133,6 +153,7 @@ class VFATFrame
     /// Checks the validity of frame (CRC and daqErrorFlags).
     /// Returns false if daqErrorFlags is non-zero.
     /// Returns false if the CRC is present and invalid.
+    /// The CRC is calculated with VFATFrameCRC::GetDefault().
     virtual bool checkCRC() const;
 
     /// Checks if channel number 'channel' was active.
@@ -142,10 +163,74 @@ class VFATFrame
       return ( data[1 + (channel / 16)] & (1 << (channel % 16)) ) ? 1 : 0;
     }
 
-    /// Returns list  of active channels.
+    /// Returns list  of active channels, in the order of the channel words (channel 0 first), the channels
+    /// within a 16-bit word in descending order (e.g. 15, ..., 0, 31, ..., 16, ...).
     /// It's more efficient than the channelActive(char) for events with low channel occupancy.
     virtual std::vector<unsigned char> getActiveChannels() const;
 
+    /// Number of words of the channel bitmap.
+    static const unsigned int bitmapWords = 4;
+
+    /// Fills `bitmap' (bitmapWords words) with the channel data: channel ch is bit ch % 32 of word ch / 32.
+    void getActiveChannelBitmap(uint32_t *bitmap) const
+    {
+      for (unsigned int i = 0; i < bitmapWords; i++)
+        bitmap[i] = uint32_t(data[1 + 2*i]) | (uint32_t(data[2 + 2*i]) << 16);
+    }
+
+    /// Sets the channel data from a bitmap in the format of getActiveChannelBitmap.
+    void setActiveChannelBitmap(const uint32_t *bitmap)
+    {
+      for (unsigned int i = 0; i < bitmapWords; i++)
+      {
+        data[1 + 2*i] = bitmap[i] & 0xFFFF;
+        data[2 + 2*i] = bitmap[i] >> 16;
+      }
+    }
+
+    /// Returns the number of active channels.
+    unsigned int getNumberOfActiveChannels() const;
+
+    /// Writes the active channels in the order of getActiveChannels() to `channels', which must have space for
+    /// 128 entries.
+    /// Returns the number of active channels. Unlike the vector version, no memory is allocated.
+    unsigned int getActiveChannels(unsigned char *channels) const;
+
+    /// Calls f(channel) for each channel set in `bitmap' (format of getActiveChannelBitmap), in the order of
+    /// getActiveChannels(): 16-bit words in ascending order, channels within a word in descending order.
+    template <typename F>
+    static void forEachActiveChannel(const uint32_t *bitmap, F f)
+    {
+      for (unsigned int i = 0; i < 2 * bitmapWords; i++)
+      {
+        for (uint32_t w = (bitmap[i / 2] >> (16 * (i % 2))) & 0xFFFF; w; )
+        {
+          const unsigned int b = 31 - __builtin_clz(w);
+          f(16*i + b);
+          w ^= uint32_t(1) << b;
+        }
+      }
+    }
+
+    /// Sets channels chMin to chMax (both included, 0 <= chMin <= chMax <= 127) in `bitmap'.
+    static void setChannelRange(uint32_t *bitmap, unsigned int chMin, unsigned int chMax)
+    {
+      const unsigned int iMin = chMin / 32, iMax = chMax / 32;
+      const uint32_t maskMin = 0xFFFFFFFFu << (chMin % 32);
+      const uint32_t maskMax = 0xFFFFFFFFu >> (31 - chMax % 32);
+
+      if (iMin == iMax)
+      {
+        bitmap[iMin] |= maskMin & maskMax;
+        return;
+      }
+
+      bitmap[iMin] |= maskMin;
+      for (unsigned int i = iMin + 1; i < iMax; i++)
+        bitmap[i] = 0xFFFFFFFFu;
+      bitmap[iMax] |= maskMax;
+    }
+
     /// Prints the frame.
     /// If binary is true, binary format is used.
     void Print(bool binary = false) const;
@@ -179,9 +264,6 @@ class VFATFrame
     /// Number of clusters.
     /// Only available in cluster mode and if the number of clusters exceeds a limit (10).
     uint8_t numberOfClusters;
-
-    /// internaly used to check CRC
-    static word calculateCRC(word crc_in, word dato);
 };                                                                     
 
 #endif
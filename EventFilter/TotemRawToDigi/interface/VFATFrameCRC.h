@@ -0,0 +1,83 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_VFATFrameCRC
+#define EventFilter_TotemRawToDigi_VFATFrameCRC
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCollection.h"
+
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Calculation of the VFAT frame CRC.
+ *
+ * The CRC is the reflected CRC-16 with polynomial 0x8408 (x^16 + x^12 + x^5 + 1) and initial value 0xFFFF,
+ * calculated over the data words 11 ... 1, each word starting with its least significant bit.
+ *
+ * Several implementations are available:
+ * \verbatim
+ * bitwise   bit-by-bit loop (reference)
+ * table     one 256-entry table lookup per byte
+ * slice4    four 256-entry tables, 4 bytes per step
+ * pclmul    the 22 bytes are folded with carry-less multiplications into 8 bytes, which are then
+ *           reduced with the slice4 tables; only available on x86 CPUs supporting PCLMULQDQ
+ * \endverbatim
+ * VFATFrame::checkCRC uses the default instance, i.e. the fastest implementation available.
+ **/
+class VFATFrameCRC
+{
+  public:
+    enum Implementation { iAuto = 0, iBitwise, iTable, iSliceBy4, iPCLMUL };
+
+    /// calculates the CRC of the data words 11 ... 1
+    typedef VFATFrame::word (*Function)(const VFATFrame::word *data);
+
+    VFATFrameCRC(Implementation impl = iAuto);
+
+    /// selects the implementation, iAuto means the fastest available one
+    /// returns false (and keeps the current implementation) if it is not available on this CPU
+    bool SetImplementation(Implementation impl);
+
+    Implementation GetImplementation() const
+    {
+      return implementation;
+    }
+
+    VFATFrame::word Calculate(const VFATFrame::word *data) const
+    {
+      return function(data);
+    }
+
+    /// checks all frames of the collection in the same way as VFATFrame::checkCRC
+    /// returns the number of frames which failed, their positions are appended to `failed' (if not NULL)
+    unsigned int Check(const VFATFrameCollection &coll, std::vector<TotemFramePosition> *failed = NULL) const;
+
+    /// the instance used by VFATFrame::checkCRC
+    static const VFATFrameCRC& GetDefault();
+
+    /// whether the implementation can be used on this CPU
+    static bool IsAvailable(Implementation impl);
+
+    /// returns the fastest implementation available on this CPU
+    static Implementation GetBestImplementation();
+
+    static const char* GetName(Implementation impl);
+
+    /// converts a name (as listed above or "auto") to an implementation, returns false if the name is unknown
+    static bool GetImplementation(const std::string &name, Implementation &impl);
+
+  protected:
+    Implementation implementation;
+    Function function;
+};
+
+#endif
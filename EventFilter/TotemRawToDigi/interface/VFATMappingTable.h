@@ -0,0 +1,107 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_VFATMappingTable
+#define EventFilter_TotemRawToDigi_VFATMappingTable
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * DAQ mapping and analysis mask compiled into a form suitable for the per-event conversion.
+ *
+ * The entries are stored in a vector, in the order of frame positions (i.e. as in the DAQ mapping).
+ * The lookup by frame position is direct-indexed: the position without the GOH and index bits selects
+ * a block of 256 slots, the GOH and index bits select the slot holding the entry index. Hence the
+ * lookup costs two memory accesses, independently of the mapping size.
+ *
+ * The table is meant to be built once per IOV of the mapping and the mask.
+**/
+class VFATMappingTable
+{
+  public:
+    enum MaskType { mtNone, mtPartial, mtFull };
+
+    struct Entry
+    {
+      TotemFramePosition position;
+      TotemVFATInfo info;
+
+      /// whether the VFAT belongs to the RP sub-system
+      bool rp;
+
+      /// RP detector (raw id) and position of the chip within the detector, only set for RP VFATs
+      uint32_t detId;
+      uint8_t chipPosition;
+
+      /// whether an analysis mask is defined for the VFAT and if so, whether it masks the full VFAT
+      MaskType maskType;
+
+      /// bitmap of the channels not masked out (bit ch % 64 of word ch / 64)
+      uint64_t unmaskedChannels[2];
+
+      bool IsChannelUnmasked(unsigned int ch) const
+      {
+        return (unmaskedChannels[ch >> 6] >> (ch & 0x3F)) & 1;
+      }
+    };
+
+    /// special value returned by Find
+    static const int notFound = -1;
+
+    VFATMappingTable() {}
+
+    /// compiles the mapping and the mask, the previous content is discarded
+    void Build(const TotemDAQMapping &mapping, const TotemAnalysisMask &mask);
+
+    /// returns the index of the entry with the given position or notFound
+    int Find(const TotemFramePosition &position) const
+    {
+      const unsigned int raw = position.getRawPosition();
+      const unsigned int block = raw >> slotBits;
+
+      if (block >= blockOffsets.size() || blockOffsets[block] < 0)
+        return notFound;
+
+      return slots[blockOffsets[block] + (raw & (blockSize - 1))];
+    }
+
+    unsigned int Size() const
+    {
+      return entries.size();
+    }
+
+    const Entry& GetEntry(unsigned int idx) const
+    {
+      return entries[idx];
+    }
+
+    const std::vector<Entry>& GetEntries() const
+    {
+      return entries;
+    }
+
+  protected:
+    static const unsigned int slotBits = 8;
+    static const int blockSize = 1 << slotBits;
+
+    std::vector<Entry> entries;
+
+    /// block id (raw position >> slotBits) -> offset of the block in `slots', -1 if the block is empty
+    std::vector<int> blockOffsets;
+
+    /// blocks of slots, each slot contains an entry index or notFound
+    std::vector<int> slots;
+};
+
+#endif
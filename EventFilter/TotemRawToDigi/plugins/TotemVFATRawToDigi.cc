@@ -12,6 +12,8 @@
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESWatcher.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 #include "DataFormats/FEDRawData/interface/FEDRawData.h"
 #include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
@@ -27,22 +29,49 @@
 #include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
 #include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
 
-#include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
 #include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/ParallelRawDataUnpacker.h"
 #include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
 
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 
 //----------------------------------------------------------------------------------------------------
 
-class TotemVFATRawToDigi : public edm::stream::EDProducer<>
+/// error counters merged from all streams, reported at the end of the job
+struct TotemVFATRawToDigiErrorSummary
+{
+  bool printErrorSummary;
+  bool printUnknownFrameSummary;
+
+  /// output files for the machine-readable reports, not written if empty
+  std::string csvFile, jsonFile;
+
+  mutable std::mutex mutex;
+  mutable RawToDigiErrorCounters counters;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+class TotemVFATRawToDigi : public edm::stream::EDProducer< edm::GlobalCache<TotemVFATRawToDigiErrorSummary> >
 {
   public:
-    explicit TotemVFATRawToDigi(const edm::ParameterSet&);
+    explicit TotemVFATRawToDigi(const edm::ParameterSet&, const TotemVFATRawToDigiErrorSummary*);
     ~TotemVFATRawToDigi();
 
+    static std::unique_ptr<TotemVFATRawToDigiErrorSummary> initializeGlobalCache(const edm::ParameterSet&);
+
     virtual void produce(edm::Event&, const edm::EventSetup&) override;
 
+    /// adds the error counters of this stream to the global summary
+    virtual void endStream() override;
+
+    static void globalEndJob(const TotemVFATRawToDigiErrorSummary*);
+
   private:
     std::string subSystem;
 
@@ -53,6 +82,14 @@ class TotemVFATRawToDigi : public edm::stream::EDProducer<>
     RawDataUnpacker rawDataUnpacker;
     RawToDigiConverter rawToDigiConverter;
 
+    /// if set, the FEDs are unpacked concurrently
+    std::unique_ptr<ParallelRawDataUnpacker> parallelUnpacker;
+
+    edm::ESWatcher<TotemReadoutRcd> readoutWatcher;
+
+    /// VFAT frames of the current event, the memory is reused from event to event
+    FlatVFATFrameCollection vfatCollection;
+
     template <typename DigiType>
     void run(edm::Event&, const edm::EventSetup&);
 };
@@ -64,12 +101,15 @@ using namespace std;
 
 //----------------------------------------------------------------------------------------------------
 
-TotemVFATRawToDigi::TotemVFATRawToDigi(const edm::ParameterSet &conf):
+TotemVFATRawToDigi::TotemVFATRawToDigi(const edm::ParameterSet &conf, const TotemVFATRawToDigiErrorSummary*):
   subSystem(conf.getParameter<string>("subSystem")),
   fedIds(conf.getParameter< vector<unsigned int> >("fedIds")),
   rawDataUnpacker(conf.getParameterSet("RawUnpacking")),
   rawToDigiConverter(conf.getParameterSet("RawToDigi"))
 {
+  if (conf.getUntrackedParameter<bool>("parallelUnpacking", false))
+    parallelUnpacker.reset(new ParallelRawDataUnpacker(rawDataUnpacker));
+
   fedDataToken = consumes<FEDRawDataCollection>(conf.getParameter<edm::InputTag>("rawDataTag"));
 
   // validate chosen subSystem
@@ -105,6 +145,21 @@ TotemVFATRawToDigi::~TotemVFATRawToDigi()
 
 //----------------------------------------------------------------------------------------------------
 
+unique_ptr<TotemVFATRawToDigiErrorSummary> TotemVFATRawToDigi::initializeGlobalCache(const edm::ParameterSet &conf)
+{
+  const ParameterSet &ps = conf.getParameterSet("RawToDigi");
+
+  unique_ptr<TotemVFATRawToDigiErrorSummary> summary(new TotemVFATRawToDigiErrorSummary);
+  summary->printErrorSummary = ps.getUntrackedParameter<unsigned int>("printErrorSummary", 1);
+  summary->printUnknownFrameSummary = ps.getUntrackedParameter<unsigned int>("printUnknownFrameSummary", 1);
+  summary->csvFile = ps.getUntrackedParameter<string>("errorReportCSV", "");
+  summary->jsonFile = ps.getUntrackedParameter<string>("errorReportJSON", "");
+
+  return summary;
+}
+
+//----------------------------------------------------------------------------------------------------
+
 void TotemVFATRawToDigi::produce(edm::Event& event, const edm::EventSetup &es)
 {
   if (subSystem == "RP")
@@ -116,13 +171,17 @@ void TotemVFATRawToDigi::produce(edm::Event& event, const edm::EventSetup &es)
 template <typename DigiType>
 void TotemVFATRawToDigi::run(edm::Event& event, const edm::EventSetup &es)
 {
-  // get DAQ mapping
-  ESHandle<TotemDAQMapping> mapping;
-  es.get<TotemReadoutRcd>().get(mapping);
+  // recompile DAQ mapping and analysis mask if they changed
+  if (readoutWatcher.check(es))
+  {
+    ESHandle<TotemDAQMapping> mapping;
+    es.get<TotemReadoutRcd>().get(mapping);
+
+    ESHandle<TotemAnalysisMask> analysisMask;
+    es.get<TotemReadoutRcd>().get(analysisMask);
 
-  // get analysis mask to mask channels
-  ESHandle<TotemAnalysisMask> analysisMask;
-  es.get<TotemReadoutRcd>().get(analysisMask);
+    rawToDigiConverter.SetMapping(*mapping, *analysisMask);
+  }
 
   // raw data handle
   edm::Handle<FEDRawDataCollection> rawData;
@@ -134,16 +193,21 @@ void TotemVFATRawToDigi::run(edm::Event& event, const edm::EventSetup &es)
   DetSetVector<TotemVFATStatus> conversionStatus;
 
   // raw-data unpacking
-  SimpleVFATFrameCollection vfatCollection;
-  for (const auto &fedId : fedIds)
+  vfatCollection.Clear();
+  if (parallelUnpacker)
   {
-    const FEDRawData &data = rawData->FEDData(fedId);
-    if (data.size() > 0)
-      rawDataUnpacker.Run(fedId, data, fedInfo, vfatCollection);
+    parallelUnpacker->Run(fedIds, *rawData, fedInfo, vfatCollection);
+  } else {
+    for (const auto &fedId : fedIds)
+    {
+      const FEDRawData &data = rawData->FEDData(fedId);
+      if (data.size() > 0)
+        rawDataUnpacker.Run(fedId, data, fedInfo, vfatCollection, &rawToDigiConverter.GetErrorCounters());
+    }
   }
 
   // raw-to-digi conversion
-  rawToDigiConverter.Run(vfatCollection, *mapping, *analysisMask, digi, conversionStatus);
+  rawToDigiConverter.Run(vfatCollection, digi, conversionStatus);
 
   // commit products to event
   event.put(make_unique<vector<TotemFEDInfo>>(fedInfo), subSystem);
@@ -153,4 +217,42 @@ void TotemVFATRawToDigi::run(edm::Event& event, const edm::EventSetup &es)
 
 //----------------------------------------------------------------------------------------------------
 
+void TotemVFATRawToDigi::endStream()
+{
+  rawToDigiConverter.CompleteErrorCounters();
+
+  if (parallelUnpacker)
+    parallelUnpacker->MergeErrorCounters(rawToDigiConverter.GetErrorCounters());
+
+  const TotemVFATRawToDigiErrorSummary *summary = globalCache();
+  lock_guard<mutex> lock(summary->mutex);
+  summary->counters.Merge(rawToDigiConverter.GetErrorCounters());
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemVFATRawToDigi::globalEndJob(const TotemVFATRawToDigiErrorSummary *summary)
+{
+  if (summary->printErrorSummary || summary->printUnknownFrameSummary)
+  {
+    stringstream ss;
+    summary->counters.PrintSummary(ss, summary->printErrorSummary, summary->printUnknownFrameSummary);
+    LogVerbatim("Totem") << ss.str();
+  }
+
+  if (!summary->csvFile.empty())
+  {
+    ofstream f(summary->csvFile);
+    summary->counters.WriteCSV(f);
+  }
+
+  if (!summary->jsonFile.empty())
+  {
+    ofstream f(summary->jsonFile);
+    summary->counters.WriteJSON(f);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
 DEFINE_FWK_MODULE(TotemVFATRawToDigi);
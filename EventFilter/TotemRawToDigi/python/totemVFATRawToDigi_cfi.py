@@ -10,7 +10,18 @@ totemVFATRawToDigi = cms.EDProducer("TotemVFATRawToDigi",
   #    DataFormats/FEDRawData/interface/FEDNumbering.h
   fedIds = cms.vuint32(),
 
+  # if True, the FEDs are unpacked concurrently (one task per FED, within the framework's thread pool);
+  # the output is identical to the serial unpacking
+  parallelUnpacking = cms.untracked.bool(False),
+
   RawUnpacking = cms.PSet(
+    # 0: data errors are only counted (see the summaries and reports below)
+    # 1: prints a message for every data error
+    verbosity = cms.untracked.uint32(0),
+
+    # algorithm rebuilding VFAT frames from serial (FOV = 1) OptoRx frames
+    # options: "auto" (fastest available), "bitwise", "scalar", "sse2", "avx2"
+    serialTransposer = cms.untracked.string("auto"),
   ),
 
   RawToDigi = cms.PSet(
@@ -43,5 +54,10 @@ totemVFATRawToDigi = cms.EDProducer("TotemVFATRawToDigi",
     
     # if non-zero, prints a summary of frames found in data, but not in the mapping
     printUnknownFrameSummary = cms.untracked.uint32(0),
+
+    # if not empty, the error counters (per frame position and error type, all streams merged) are written
+    # to these files at the end of the job
+    errorReportCSV = cms.untracked.string(""),
+    errorReportJSON = cms.untracked.string(""),
   )
 )
@@ -0,0 +1,225 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+FlatVFATFrameCollection::FlatVFATFrameCollection() : size(0), lastInsertBlockIdx(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+FlatVFATFrameCollection::~FlatVFATFrameCollection()
+{
+  for (auto b : blocks)
+    delete b;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FlatVFATFrameCollection::Clear()
+{
+  for (auto b : blocks)
+    memset(b->valid, 0, sizeof(b->valid));
+
+  size = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned int FlatVFATFrameCollection::FindBlockIdx(unsigned int id) const
+{
+  // there are only a few blocks (FEDs), linear search is the fastest
+  unsigned int idx = 0;
+  while (idx < blocks.size() && blocks[idx]->id != id)
+    idx++;
+
+  return idx;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+FlatVFATFrameCollection::Block* FlatVFATFrameCollection::GetOrCreateBlock(unsigned int id)
+{
+  if (lastInsertBlockIdx < blocks.size() && blocks[lastInsertBlockIdx]->id == id)
+    return blocks[lastInsertBlockIdx];
+
+  const unsigned int found = FindBlockIdx(id);
+  if (found < blocks.size())
+  {
+    lastInsertBlockIdx = found;
+    return blocks[found];
+  }
+
+  Block *b = new Block;
+  b->id = id;
+  memset(b->valid, 0, sizeof(b->valid));
+
+  // keep the blocks sorted
+  unsigned int idx = 0;
+  while (idx < blocks.size() && blocks[idx]->id < id)
+    idx++;
+
+  blocks.insert(blocks.begin() + idx, b);
+  lastInsertBlockIdx = idx;
+
+  return b;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+VFATFrame* FlatVFATFrameCollection::Reserve(const TotemFramePosition &index, bool &inserted)
+{
+  const unsigned int raw = index.getRawPosition();
+  const unsigned int slot = raw & (blockSize - 1);
+
+  Block *b = GetOrCreateBlock(raw >> slotBits);
+
+  uint64_t &w = b->valid[slot / 64];
+  const uint64_t bit = uint64_t(1) << (slot % 64);
+
+  inserted = !(w & bit);
+  if (inserted)
+  {
+    w |= bit;
+    size++;
+  }
+
+  return &b->frames[slot];
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FlatVFATFrameCollection::Insert(const FlatVFATFrameCollection &other)
+{
+  for (const Block *ob : other.blocks)
+  {
+    // skip blocks without frames, not to allocate a block here
+    uint64_t any = 0;
+    for (unsigned int wi = 0; wi < blockSize / 64; ++wi)
+      any |= ob->valid[wi];
+
+    if (!any)
+      continue;
+
+    Block *b = GetOrCreateBlock(ob->id);
+
+    for (unsigned int wi = 0; wi < blockSize / 64; ++wi)
+    {
+      // frames present in the other collection only
+      uint64_t w = ob->valid[wi] & ~b->valid[wi];
+      b->valid[wi] |= w;
+
+      while (w)
+      {
+        const unsigned int s = wi * 64 + __builtin_ctzll(w);
+        b->frames[s] = ob->frames[s];
+        size++;
+        w &= w - 1;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const VFATFrame* FlatVFATFrameCollection::GetFrameByIndex(TotemFramePosition index) const
+{
+  const unsigned int raw = index.getRawPosition();
+  const unsigned int slot = raw & (blockSize - 1);
+
+  const Block *b = GetBlock(raw >> slotBits);
+  if (!b || !(b->valid[slot / 64] & (uint64_t(1) << (slot % 64))))
+    return NULL;
+
+  return &b->frames[slot];
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const VFATFrame* FlatVFATFrameCollection::GetFrameByID(unsigned int ID) const
+{
+  // first convert ID to 12bit form
+  ID = ID & 0xFFF;
+
+  for (value_type v = BeginIterator(); !IsEndIterator(v); v = NextIterator(v))
+    if (v.second->getChipID() == ID)
+      if (v.second->checkFootprint() && v.second->checkCRC())
+        return v.second;
+
+  return NULL;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+VFATFrameCollection::value_type FlatVFATFrameCollection::FindValid(unsigned int blockIdx, unsigned int slot) const
+{
+  for (; blockIdx < blocks.size(); ++blockIdx, slot = 0)
+  {
+    const Block *b = blocks[blockIdx];
+
+    for (unsigned int wi = slot / 64; wi < blockSize / 64; ++wi)
+    {
+      uint64_t w = b->valid[wi];
+
+      // ignore the slots before the starting one
+      if (wi == slot / 64)
+        w &= ~uint64_t(0) << (slot % 64);
+
+      if (w)
+      {
+        const unsigned int s = wi * 64 + __builtin_ctzll(w);
+        return value_type(TotemFramePosition((b->id << slotBits) | s), &b->frames[s]);
+      }
+    }
+  }
+
+  return value_type(TotemFramePosition(), NULL);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+VFATFrameCollection::value_type FlatVFATFrameCollection::BeginIterator() const
+{
+  return FindValid(0, 0);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+VFATFrameCollection::value_type FlatVFATFrameCollection::NextIterator(const value_type &value) const
+{
+  if (!value.second)
+    return value;
+
+  const unsigned int raw = value.first.getRawPosition();
+  const unsigned int id = raw >> slotBits;
+  const unsigned int slot = raw & (blockSize - 1);
+
+  // find the index of the current block
+  const unsigned int blockIdx = FindBlockIdx(id);
+
+  if (slot + 1 < blockSize)
+    return FindValid(blockIdx, slot + 1);
+  else
+    return FindValid(blockIdx + 1, 0);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool FlatVFATFrameCollection::IsEndIterator(const value_type &value) const
+{
+  return (value.second == NULL);
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/ParallelRawDataUnpacker.h"
+
+#include "tbb/parallel_for.h"
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelRawDataUnpacker::Run(const vector<unsigned int> &fedIds, const FEDRawDataCollection &rawData,
+  vector<TotemFEDInfo> &fedInfo, FlatVFATFrameCollection &coll)
+{
+  while (tasks.size() < fedIds.size())
+    tasks.emplace_back(new Task);
+
+  // unpack each FED into the buffers of its task
+  tbb::parallel_for(size_t(0), fedIds.size(),
+    [&] (size_t i)
+    {
+      Task &task = *tasks[i];
+      task.frames.Clear();
+      task.fedInfo.clear();
+
+      const FEDRawData &data = rawData.FEDData(fedIds[i]);
+      if (data.size() > 0)
+        unpacker.Run(fedIds[i], data, task.fedInfo, task.frames, &task.errorCounters);
+    }
+  );
+
+  // merge in the order of FEDs
+  for (unsigned int i = 0; i < fedIds.size(); ++i)
+  {
+    const Task &task = *tasks[i];
+    fedInfo.insert(fedInfo.end(), task.fedInfo.begin(), task.fedInfo.end());
+    coll.Insert(task.frames);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelRawDataUnpacker::MergeErrorCounters(RawToDigiErrorCounters &ec)
+{
+  for (auto &task : tasks)
+  {
+    ec.Merge(task->errorCounters);
+    task->errorCounters.Clear();
+  }
+}
@@ -9,6 +9,7 @@
 #include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 //----------------------------------------------------------------------------------------------------
 
@@ -17,30 +18,48 @@ using namespace edm;
 
 //----------------------------------------------------------------------------------------------------
 
-RawDataUnpacker::RawDataUnpacker(const edm::ParameterSet &conf)
+RawDataUnpacker::RawDataUnpacker(const edm::ParameterSet &conf) :
+  verbosity(conf.getUntrackedParameter<unsigned int>("verbosity", 0))
 {
+  const string name = conf.getUntrackedParameter<string>("serialTransposer", "auto");
+
+  SerialFrameTransposer::Implementation impl;
+  if (!SerialFrameTransposer::GetImplementation(name, impl))
+    throw cms::Exception("RawDataUnpacker::RawDataUnpacker") << "Unknown serialTransposer `" << name << "'." << endl;
+
+  if (!serialTransposer.SetImplementation(impl))
+    LogInfo("Totem") << "RawDataUnpacker > Transposer `" << name << "' not supported by this CPU, using `"
+      << SerialFrameTransposer::GetName(serialTransposer.GetImplementation()) << "'.";
 }
 
 //----------------------------------------------------------------------------------------------------
 
-int RawDataUnpacker::Run(int fedId, const FEDRawData &data, vector<TotemFEDInfo> &fedInfoColl, SimpleVFATFrameCollection &coll) const
+template <typename FrameCollection>
+int RawDataUnpacker::Run(int fedId, const FEDRawDataView &data, vector<TotemFEDInfo> &fedInfoColl, FrameCollection &coll,
+  RawToDigiErrorCounters *ec) const
 {
   unsigned int size_in_words = data.size() / 8; // bytes -> words
   if (size_in_words < 2)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::Run > " <<
-      "Data in FED " << fedId << " too short (size = " << size_in_words << " words).";
+    if (ec)
+      ec->Add(TotemFramePosition(0, 0, fedId, 0, 0), RawToDigiErrorCounters::etFEDTooShort);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::Run > " <<
+        "Data in FED " << fedId << " too short (size = " << size_in_words << " words).";
     return 1;
   }
 
   fedInfoColl.push_back(TotemFEDInfo(fedId));
 
-  return ProcessOptoRxFrame((const word *) data.data(), size_in_words, fedInfoColl.back(), &coll);
+  return ProcessOptoRxFrame((const word *) data.data(), size_in_words, fedInfoColl.back(), &coll, ec);
 }
 
 //----------------------------------------------------------------------------------------------------
 
-int RawDataUnpacker::ProcessOptoRxFrame(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, SimpleVFATFrameCollection *fc) const
+template <typename FrameCollection>
+int RawDataUnpacker::ProcessOptoRxFrame(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, FrameCollection *fc,
+  RawToDigiErrorCounters *ec) const
 {
   // get OptoRx metadata
   unsigned long long head = buf[0];
@@ -64,10 +83,14 @@ int RawDataUnpacker::ProcessOptoRxFrame(const word *buf, unsigned int frameSize,
   // check header and footer structure
   if (BOE != 5 || H0 != 0 || EOE != 10 || F0 != 0 || FSize != frameSize)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Wrong structure of OptoRx header/footer: "
-      << "BOE=" << BOE << ", H0=" << H0 << ", EOE=" << EOE << ", F0=" << F0
-      << ", size (OptoRx)=" << FSize << ", size (DATE)=" << frameSize
-      << ". OptoRxID=" << OptoRxId << ". Skipping frame." << endl;
+    if (ec)
+      ec->Add(TotemFramePosition(0, 0, OptoRxId, 0, 0), RawToDigiErrorCounters::etOptoRxStructure);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Wrong structure of OptoRx header/footer: "
+        << "BOE=" << BOE << ", H0=" << H0 << ", EOE=" << EOE << ", F0=" << F0
+        << ", size (OptoRx)=" << FSize << ", size (DATE)=" << frameSize
+        << ". OptoRxID=" << OptoRxId << ". Skipping frame." << endl;
     return 0;
   }
 
@@ -78,19 +101,25 @@ int RawDataUnpacker::ProcessOptoRxFrame(const word *buf, unsigned int frameSize,
 
   // parallel or serial transmission?
   if (FOV == 1)
-    return ProcessOptoRxFrameSerial(buf, frameSize, fc);
+    return ProcessOptoRxFrameSerial(buf, frameSize, fc, ec);
 
   if (FOV == 2)
-    return ProcessOptoRxFrameParallel(buf, frameSize, fedInfo, fc);
+    return ProcessOptoRxFrameParallel(buf, frameSize, fedInfo, fc, ec);
 
-  LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Unknown FOV = " << FOV << endl;
+  if (ec)
+    ec->Add(TotemFramePosition(0, 0, OptoRxId, 0, 0), RawToDigiErrorCounters::etUnknownFOV);
+
+  if (verbosity > 0)
+    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Unknown FOV = " << FOV << endl;
 
   return 0;
 }
 
 //----------------------------------------------------------------------------------------------------
 
-int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *buf, unsigned int frameSize, SimpleVFATFrameCollection *fc) const
+template <typename FrameCollection>
+int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *buf, unsigned int frameSize, FrameCollection *fc,
+  RawToDigiErrorCounters *ec) const
 {
   // get OptoRx metadata
   unsigned int OptoRxId = (buf[0] >> 8) & 0xFFF;
@@ -122,29 +151,35 @@ int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *buf, unsigned int fram
       // check structure
       if (head >> 12 != 0x4 || foot >> 12 != 0xB || ((head >> 8) & 0xF) != ((foot >> 8) & 0xF))
       {
-        char ss[500];
-        if (head >> 12 != 0x4)
-          sprintf(ss, "\n\tHeader is not 0x4 as expected (%x).", head);
-        if (foot >> 12 != 0xB)
-          sprintf(ss, "\n\tFooter is not 0xB as expected (%x).", foot);
-        if (((head >> 8) & 0xF) != ((foot >> 8) & 0xF))
-          sprintf(ss, "\n\tIncompatible GOH IDs in header (%x) and footer (%x).", ((head >> 8) & 0xF),
-            ((foot >> 8) & 0xF));
-
-        LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Wrong payload structure (in GOH block row " << r <<
-          " and column " << c << ") in OptoRx frame ID " << OptoRxId << ". GOH block omitted." << ss << endl;
+        if (ec)
+          ec->Add(TotemFramePosition(0, 0, OptoRxId, (head >> 8) & 0xF, 0), RawToDigiErrorCounters::etGOHBlockStructure);
+
+        if (verbosity > 0)
+        {
+          char ss[500];
+          if (head >> 12 != 0x4)
+            sprintf(ss, "\n\tHeader is not 0x4 as expected (%x).", head);
+          if (foot >> 12 != 0xB)
+            sprintf(ss, "\n\tFooter is not 0xB as expected (%x).", foot);
+          if (((head >> 8) & 0xF) != ((foot >> 8) & 0xF))
+            sprintf(ss, "\n\tIncompatible GOH IDs in header (%x) and footer (%x).", ((head >> 8) & 0xF),
+              ((foot >> 8) & 0xF));
+
+          LogProblem("Totem") << "Error in RawDataUnpacker::ProcessOptoRxFrame > " << "Wrong payload structure (in GOH block row " << r <<
+            " and column " << c << ") in OptoRx frame ID " << OptoRxId << ". GOH block omitted." << ss << endl;
+        }
 
         errorCounter++;
         continue;
       }
 
-      // allocate memory for VFAT frames
+      // insert empty VFAT frames
       unsigned int goh = (head >> 8) & 0xF;
-      vector<VFATFrame::word*> dataPtrs;
+      VFATFrame::word *dataPtrs[16];
       for (unsigned int fi = 0; fi < 16; fi++)
       {
         TotemFramePosition fp(0, 0, OptoRxId, goh, fi);
-        dataPtrs.push_back( fc->InsertEmptyFrame(fp)->getData() );
+        dataPtrs[fi] = fc->InsertEmptyFrame(fp)->getData();
       }
 
       #ifdef DEBUG
@@ -152,19 +187,7 @@ int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *buf, unsigned int fram
       #endif
 
       // deserialization
-      for (int i = 0; i < 192; i++)
-      {
-        int iword = 11 - i / 16;  // number of current word (11...0)
-        int ibit = 15 - i % 16;   // number of current bit (15...0)
-        unsigned int w = (buf[i + 2 + 194 * r] >> (16 * c)) & 0xFFFF;
-
-        // Fill the current bit of the current word of all VFAT frames
-        for (int idx = 0; idx < 16; idx++)
-        {
-          if (w & (1 << idx))
-            dataPtrs[idx][iword] |= (1 << ibit);
-        }
-      }
+      serialTransposer.Transpose(buf + 2 + 194 * r, c, dataPtrs);
     }
   }
 
@@ -173,7 +196,9 @@ int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *buf, unsigned int fram
 
 //----------------------------------------------------------------------------------------------------
 
-int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, SimpleVFATFrameCollection *fc) const
+template <typename FrameCollection>
+int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *buf, unsigned int frameSize, TotemFEDInfo &fedInfo, FrameCollection *fc,
+  RawToDigiErrorCounters *ec) const
 {
   // get OptoRx metadata
   unsigned long long head = buf[0];
@@ -193,7 +218,7 @@ int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *buf, unsigned int fr
   // process all VFAT data
   for (unsigned int offset = 0; offset < nWords;)
   {
-    unsigned int wordsProcessed = ProcessVFATDataParallel(payload + offset, OptoRxId, fc);
+    unsigned int wordsProcessed = ProcessVFATDataParallel(payload + offset, OptoRxId, fc, ec);
     offset += wordsProcessed;
   }
 
@@ -202,7 +227,9 @@ int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *buf, unsigned int fr
 
 //----------------------------------------------------------------------------------------------------
 
-int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int OptoRxId, SimpleVFATFrameCollection *fc) const
+template <typename FrameCollection>
+int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int OptoRxId, FrameCollection *fc,
+  RawToDigiErrorCounters *ec) const
 {
   // start counting processed words
   unsigned int wordsProcessed = 1;
@@ -215,8 +242,12 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
   unsigned int hFlag = (buf[0] >> 8) & 0xFF;
   if (hFlag != vmCluster && hFlag != vmRaw)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
-      << "Unknown header flag " << hFlag << ". Skipping this word." << endl;
+    if (ec)
+      ec->Add(TotemFramePosition(0, 0, OptoRxId, 0, 0), RawToDigiErrorCounters::etHeaderFlag);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
+        << "Unknown header flag " << hFlag << ". Skipping this word." << endl;
     return wordsProcessed;
   }
 
@@ -257,14 +288,42 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
   // save offset where channel data start
   unsigned int dataOffset = wordsProcessed;
 
-  // find trailer
+  // cluster mode: decode the clusters directly to a channel bitmap while looking for the trailer,
+  // invalid clusters are only counted here and reported once the trailer has been checked
+  uint32_t bitmap[VFATFrame::bitmapWords] = { 0, 0, 0, 0 };
+  unsigned int invalidClusters = 0;
+
   if (hFlag == vmCluster)
   {
-    unsigned int nCl = 0;
-    while ( (buf[wordsProcessed + nCl] >> 12) != 0xF )
-      nCl++;
+    for (; (buf[wordsProcessed] >> 12) != 0xF; ++wordsProcessed)
+    {
+      const uint16_t &w = buf[wordsProcessed];
+      unsigned int upperBlock = w >> 8;
+      unsigned int clSize = upperBlock & 0x7F;
+      unsigned int clPos = (w >> 0) & 0xFF;
+
+      // special case: upperBlock=0xD0 => numberOfClusters
+      if (upperBlock == 0xD0)
+      {
+        presenceFlags |= 0x10;
+        f.setNumberOfClusters(clPos);
+        continue;
+      }
+
+      // special case: size=0 means chip full
+      if (clSize == 0)
+        clSize = 128;
+
+      // activate channels
+      //  convention - range <pos, pos-size+1>
+      if (clPos > 127 || clSize > clPos + 1)
+      {
+        invalidClusters++;
+        continue;
+      }
 
-    wordsProcessed += nCl;
+      VFATFrame::setChannelRange(bitmap, clPos - clSize + 1, clPos);
+    }
   }
 
   if (hFlag == vmRaw)
@@ -282,17 +341,25 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
 
   if (tSig != 0xF)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
-      << "Wrong trailer signature (" << tSig << ") at "
-      << fp << ". This frame will be skipped." << endl;
+    if (ec)
+      ec->Add(fp, RawToDigiErrorCounters::etTrailerSignature);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
+        << "Wrong trailer signature (" << tSig << ") at "
+        << fp << ". This frame will be skipped." << endl;
     skipFrame = true;
   }
 
   if (tErrFlags != 0)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
-      << "Error flags not zero (" << tErrFlags << ") at "
-      << fp << ". Channel errors will be suppressed." << endl;
+    if (ec)
+      ec->Add(fp, RawToDigiErrorCounters::etDAQErrorFlags);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
+        << "Error flags not zero (" << tErrFlags << ") at "
+        << fp << ". Channel errors will be suppressed." << endl;
     suppressChannelErrors = true;
   }
 
@@ -300,9 +367,13 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
 
   if (tSize != wordsProcessed)
   {
-    LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
-      << "Trailer size (" << tSize << ") does not match with words processed ("
-      << wordsProcessed << ") at " << fp << ". This frame will be skipped." << endl;
+    if (ec)
+      ec->Add(fp, RawToDigiErrorCounters::etTrailerSize);
+
+    if (verbosity > 0)
+      LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
+        << "Trailer size (" << tSize << ") does not match with words processed ("
+        << wordsProcessed << ") at " << fp << ". This frame will be skipped." << endl;
     skipFrame = true;
   }
 
@@ -312,45 +383,37 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
   // get channel data - cluster mode
   if (hFlag == vmCluster)
   {
-    for (unsigned int nCl = 0; (buf[dataOffset + nCl] >> 12) != 0xF; ++nCl)
-    {
-      const uint16_t &w = buf[dataOffset + nCl];
-      unsigned int upperBlock = w >> 8;
-      unsigned int clSize = upperBlock & 0x7F;
-      unsigned int clPos = (w >> 0) & 0xFF;
-
-      // special case: upperBlock=0xD0 => numberOfClusters
-      if (upperBlock == 0xD0)
-      {
-        presenceFlags |= 0x10;
-        f.setNumberOfClusters(clPos);
-        continue;
-      }
-
-      // special case: size=0 means chip full
-      if (clSize == 0)
-        clSize = 128;
-
-      // activate channels
-      //  convention - range <pos, pos-size+1>
-      signed int chMax = clPos;
-      signed int chMin = clPos - clSize + 1;
-      if (chMax < 0 || chMax > 127 || chMin < 0 || chMin > 127 || chMin > chMax)
-      {
-        if (!suppressChannelErrors)
-          LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
-            << "Invalid cluster (pos=" << clPos
-            << ", size=" << clSize << ", min=" << chMin << ", max=" << chMax << ") at " << fp
-            <<". Skipping this cluster." << endl;
+    f.setActiveChannelBitmap(bitmap);
 
-        continue;
-      }
+    if (invalidClusters > 0 && !suppressChannelErrors)
+    {
+      if (ec)
+        ec->Add(fp, RawToDigiErrorCounters::etInvalidCluster, invalidClusters);
 
-      for (signed int ch = chMin; ch <= chMax; ch++)
+      // the details are only collected when they are to be printed
+      if (verbosity > 0)
       {
-        unsigned int wi = ch / 16;
-        unsigned int bi = ch % 16;
-        fd[wi + 1] |= (1 << bi);
+        for (unsigned int nCl = 0; (buf[dataOffset + nCl] >> 12) != 0xF; ++nCl)
+        {
+          const uint16_t &w = buf[dataOffset + nCl];
+          unsigned int upperBlock = w >> 8;
+          signed int clSize = upperBlock & 0x7F;
+          signed int clPos = (w >> 0) & 0xFF;
+
+          if (upperBlock == 0xD0)
+            continue;
+
+          if (clSize == 0)
+            clSize = 128;
+
+          signed int chMax = clPos;
+          signed int chMin = clPos - clSize + 1;
+          if (chMax < 0 || chMax > 127 || chMin < 0 || chMin > 127 || chMin > chMax)
+            LogProblem("Totem") << "Error in RawDataUnpacker::ProcessVFATDataParallel > "
+              << "Invalid cluster (pos=" << clPos
+              << ", size=" << clSize << ", min=" << chMin << ", max=" << chMax << ") at " << fp
+              <<". Skipping this cluster." << endl;
+        }
       }
     }
   }
@@ -372,3 +435,29 @@ int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *buf, unsigned int O
 
   return wordsProcessed;
 }
+
+//----------------------------------------------------------------------------------------------------
+
+// explicit instantiations for the supported frame collections
+
+template int RawDataUnpacker::Run(int, const FEDRawDataView &, vector<TotemFEDInfo> &, SimpleVFATFrameCollection &,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrame(const word *, unsigned int, TotemFEDInfo &, SimpleVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *, unsigned int, SimpleVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *, unsigned int, TotemFEDInfo &, SimpleVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *, unsigned int, SimpleVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+
+template int RawDataUnpacker::Run(int, const FEDRawDataView &, vector<TotemFEDInfo> &, FlatVFATFrameCollection &,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrame(const word *, unsigned int, TotemFEDInfo &, FlatVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrameSerial(const word *, unsigned int, FlatVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessOptoRxFrameParallel(const word *, unsigned int, TotemFEDInfo &, FlatVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
+template int RawDataUnpacker::ProcessVFATDataParallel(const uint16_t *, unsigned int, FlatVFATFrameCollection *,
+  RawToDigiErrorCounters *) const;
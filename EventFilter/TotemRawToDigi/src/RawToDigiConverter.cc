@@ -12,8 +12,6 @@
 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 
-#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
-
 //----------------------------------------------------------------------------------------------------
 
 using namespace std;
@@ -36,51 +34,117 @@ RawToDigiConverter::RawToDigiConverter(const edm::ParameterSet &conf) :
   BC_min(conf.getUntrackedParameter<unsigned int>("BC_min", 10)),
   
   EC_fraction(conf.getUntrackedParameter<double>("EC_fraction", 0.6)),
-  BC_fraction(conf.getUntrackedParameter<double>("BC_fraction", 0.6))
+  BC_fraction(conf.getUntrackedParameter<double>("BC_fraction", 0.6)),
+
+  eventsWithMapping(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiConverter::SetMapping(const TotemDAQMapping &mapping, const TotemAnalysisMask &mask)
+{
+  // account the missing frames seen with the previous mapping
+  CompleteErrorCounters();
+
+  mappingTable.Build(mapping, mask);
+
+  const unsigned int size = mappingTable.Size();
+  records.assign(size, { NULL, TotemVFATStatus() });
+  eventsWithFrame.assign(size, 0);
+  statusIndices.assign(size, 0);
+  nonRPEntries.clear();
+
+  // prepare the status output
+  statusTemplate = DetSetVector<TotemVFATStatus>();
+
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    const VFATMappingTable::Entry &entry = mappingTable.GetEntry(i);
+
+    if (!entry.rp)
+    {
+      nonRPEntries.push_back(i);
+      continue;
+    }
+
+    // RP CC VFATs have no status
+    if (entry.info.type != TotemVFATInfo::data)
+      continue;
+
+    TotemVFATStatus st(entry.chipPosition);
+    st.setMissing(true);
+
+    DetSet<TotemVFATStatus> &ds = statusTemplate.find_or_insert(entry.detId);
+    statusIndices[i] = ds.size();
+    ds.push_back(st);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiConverter::CompleteErrorCounters()
 {
+  for (unsigned int i = 0; i < eventsWithFrame.size(); ++i)
+  {
+    const unsigned int missing = eventsWithMapping - eventsWithFrame[i];
+    if (missing > 0)
+      errorCounters.Add(mappingTable.GetEntry(i).position, RawToDigiErrorCounters::etMissing, missing);
+  }
+
+  eventsWithMapping = 0;
+  for (auto &n : eventsWithFrame)
+    n = 0;
 }
 
 //----------------------------------------------------------------------------------------------------
 
-void RawToDigiConverter::RunCommon(const VFATFrameCollection &input, const TotemDAQMapping &mapping,
-      map<TotemFramePosition, RawToDigiConverter::Record> &records)
+void RawToDigiConverter::RunCommon(const VFATFrameCollection &input)
 {
   // EC and BC checks (wrt. the most frequent value), BC checks per subsystem
   CounterChecker ECChecker(CounterChecker::ECChecker, "EC", EC_min, EC_fraction, verbosity);
   CounterChecker BCChecker(CounterChecker::BCChecker, "BC", BC_min, BC_fraction, verbosity);
 
-  // initialise structure merging vfat frame data with the mapping
-  for (auto &p : mapping.VFATMapping)
+  presentEntries.clear();
+  eventsWithMapping++;
+  errorCounters.AddEvent();
+
+  // event and frame error message buffers
+  stringstream &ees = eventMessages, &fes = frameMessages;
+  if (verbosity > 0)
   {
-    TotemVFATStatus st;
-    st.setMissing(true);
-    records[p.first] = { &p.second, NULL,  st };
+    ees.str("");
+    ees.clear();
   }
 
-  // event error message buffer
-  stringstream ees;
-
   // associate data frames with records
   for (VFATFrameCollection::Iterator fr(&input); !fr.IsEnd(); fr.Next())
   {
-    // frame error message buffer
-    stringstream fes;
+    if (verbosity > 0)
+    {
+      fes.str("");
+      fes.clear();
+    }
 
     bool problemsPresent = false;
     bool stopProcessing = false;
     
     // skip data frames not listed in the DAQ mapping
-    auto records_it = records.find(fr.Position());
-    if (records_it == records.end())
+    const int entryIdx = mappingTable.Find(fr.Position());
+    if (entryIdx == VFATMappingTable::notFound)
     {
-      unknownSummary[fr.Position()]++;
+      errorCounters.Add(fr.Position(), RawToDigiErrorCounters::etUnknownFrame);
       continue;
     }
 
+    presentEntries.push_back(entryIdx);
+    eventsWithFrame[entryIdx]++;
+
     // update record
-    Record &record = records_it->second;
+    const VFATMappingTable::Entry &entry = mappingTable.GetEntry(entryIdx);
+    Record &record = records[entryIdx];
     record.frame = fr.Data();
-    record.status.setMissing(false);
+    record.status = TotemVFATStatus();
     
     record.status.setNumberOfClustersSpecified(record.frame->isNumberOfClustersPresent());
     record.status.setNumberOfClusters(record.frame->getNumberOfClusters());
@@ -116,13 +180,13 @@ void RawToDigiConverter::RunCommon(const VFATFrameCollection &input, const Totem
     }
 
     // check the id mismatch
-    if (testID != tfNoTest && record.frame->isIDPresent() && (record.frame->getChipID() & 0xFFF) != (record.info->hwID & 0xFFF))
+    if (testID != tfNoTest && record.frame->isIDPresent() && (record.frame->getChipID() & 0xFFF) != (entry.info.hwID & 0xFFF))
     {
       problemsPresent = true;
 
       if (verbosity > 0)
         fes << "    ID mismatch (data: 0x" << hex << record.frame->getChipID()
-          << ", mapping: 0x" << record.info->hwID  << dec << ", symbId: " << record.info->symbolicID.symbolicID << ")\n";
+          << ", mapping: 0x" << entry.info.hwID  << dec << ", symbId: " << entry.info.symbolicID.symbolicID << ")\n";
 
       if (testID == tfErr)
       {
@@ -147,28 +211,36 @@ void RawToDigiConverter::RunCommon(const VFATFrameCollection &input, const Totem
     if (stopProcessing)
       continue;
     
-    // fill EC and BC values to the statistics
-    if (fr.Data()->isECPresent())
+    // fill EC and BC values to the statistics (if they are to be analyzed)
+    if (testECMostFrequent != tfNoTest && fr.Data()->isECPresent())
       ECChecker.Fill(fr.Data()->getEC(), fr.Position());
 
-    if (fr.Data()->isBCPresent())
+    if (testBCMostFrequent != tfNoTest && fr.Data()->isBCPresent())
       BCChecker.Fill(fr.Data()->getBC(), fr.Position());
   }
 
   // analyze EC and BC statistics
+  RecordAccessor accessor = { *this };
+
   if (testECMostFrequent != tfNoTest)
-    ECChecker.Analyze(records, (testECMostFrequent == tfErr), ees);
+    ECChecker.Analyze(accessor, (testECMostFrequent == tfErr), ees);
 
   if (testBCMostFrequent != tfNoTest)
-    BCChecker.Analyze(records, (testBCMostFrequent == tfErr), ees);
+    BCChecker.Analyze(accessor, (testBCMostFrequent == tfErr), ees);
 
-  // add error message for missing frames
+  // add error message for missing frames (both the entries and presentEntries are ordered by position)
   if (verbosity > 1)
   {
-    for (const auto &p : records)
+    unsigned int pi = 0;
+    for (unsigned int i = 0; i < mappingTable.Size(); ++i)
     {
-      if (p.second.status.isMissing())
-        ees << "Frame for VFAT " << p.first << " is not present in the data.\n"; 
+      if (pi < presentEntries.size() && presentEntries[pi] == i)
+      {
+        pi++;
+        continue;
+      }
+
+      ees << "Frame for VFAT " << mappingTable.GetEntry(i).position << " is not present in the data.\n"; 
     }
   }
 
@@ -181,93 +253,94 @@ void RawToDigiConverter::RunCommon(const VFATFrameCollection &input, const Totem
       LogProblem("Totem") << "Error in RawToDigiConverter::RunCommon > " << "event contains problems." << endl;
   }
 
-  // increase error counters
-  if (printErrorSummary)
+  // increase error counters, the missing frames are counted in CompleteErrorCounters
+  for (const auto &i : presentEntries)
   {
-    for (const auto &it : records)
-    {
-      if (!it.second.status.isOK())
-      {
-        auto &m = errorSummary[it.first];
-        m[it.second.status]++;
-      }
-    }
+    const TotemVFATStatus &st = records[i].status;
+    if (st.isOK())
+      continue;
+
+    const TotemFramePosition &position = mappingTable.GetEntry(i).position;
+    if (st.isFootprintError())
+      errorCounters.Add(position, RawToDigiErrorCounters::etFootprint);
+    if (st.isCRCError())
+      errorCounters.Add(position, RawToDigiErrorCounters::etCRC);
+    if (st.isIDMismatch())
+      errorCounters.Add(position, RawToDigiErrorCounters::etIDMismatch);
+    if (st.isECProgressError())
+      errorCounters.Add(position, RawToDigiErrorCounters::etECProgress);
+    if (st.isBCProgressError())
+      errorCounters.Add(position, RawToDigiErrorCounters::etBCProgress);
   }
 }
 
 //----------------------------------------------------------------------------------------------------
 
 void RawToDigiConverter::Run(const VFATFrameCollection &input,
-  const TotemDAQMapping &mapping, const TotemAnalysisMask &analysisMask,
   DetSetVector<TotemRPDigi> &rpData, DetSetVector<TotemVFATStatus> &finalStatus)
 {
-  // structure merging vfat frame data with the mapping
-  map<TotemFramePosition, Record> records;
-
   // common processing - frame validation
-  RunCommon(input, mapping, records);
+  RunCommon(input);
 
-  // second loop over data
-  for (auto &p : records)
+  // start with all frames missing, the statuses of the present frames are updated below
+  finalStatus = statusTemplate;
+
+  // check whether the data come from RP VFATs
+  for (const auto &i : nonRPEntries)
   {
-    Record &record = p.second;
+    LogProblem("Totem") << "Error in RawToDigiConverter::Run > "
+      << "VFAT is not from RP. subSystem = " << mappingTable.GetEntry(i).info.symbolicID.subSystem;
+  }
 
-    // check whether the data come from RP VFATs
-    if (record.info->symbolicID.subSystem != TotemSymbID::RP)
-    {
-      LogProblem("Totem") << "Error in RawToDigiConverter::Run > "
-        << "VFAT is not from RP. subSystem = " << record.info->symbolicID.subSystem;
-      continue;
-    }
+  // second loop over data
+  for (const auto &i : presentEntries)
+  {
+    const VFATMappingTable::Entry &entry = mappingTable.GetEntry(i);
+    Record &record = records[i];
 
-    // silently ignore RP CC VFATs
-    if (record.info->type != TotemVFATInfo::data)
+    // silently ignore RP CC VFATs and VFATs reported above
+    if (!entry.rp || entry.info.type != TotemVFATInfo::data)
       continue;
 
-    // calculate ids
-    unsigned short chipId = record.info->symbolicID.symbolicID;
-    det_id_type detId = TotemRPDetId::decToRawId(chipId / 10);
-    uint8_t chipPosition = chipId % 10;
-
     // update chipPosition in status
-    record.status.setChipPosition(chipPosition);
+    record.status.setChipPosition(entry.chipPosition);
 
     // produce digi only for good frames
     if (record.status.isOK())
     {
-      // find analysis mask (needs a default=no mask, if not in present the mapping)
-      TotemVFATAnalysisMask anMa;
-      anMa.fullMask = false;
-  
-      auto analysisIter = analysisMask.analysisMask.find(record.info->symbolicID);
-      if (analysisIter != analysisMask.analysisMask.end())
-      {            
-        // if there is some information about masked channels - save it into conversionStatus
-        anMa = analysisIter->second;
-        if (anMa.fullMask)
-          record.status.setFullyMaskedOut();
-        else
-          record.status.setPartiallyMaskedOut();
-      }
+      // if there is some information about masked channels - save it into conversionStatus
+      if (entry.maskType == VFATMappingTable::mtFull)
+        record.status.setFullyMaskedOut();
+      if (entry.maskType == VFATMappingTable::mtPartial)
+        record.status.setPartiallyMaskedOut();
   
       // create the digi
-      unsigned short offset = chipPosition * 128;
-      const vector<unsigned char> &activeChannels = record.frame->getActiveChannels();
-    
-      for (auto ch : activeChannels)
+      if (entry.maskType != VFATMappingTable::mtFull)
       {
-        // skip masked channels
-        if (!anMa.fullMask && anMa.maskedChannels.find(ch) == anMa.maskedChannels.end())
+        // skip masked channels, word by word
+        uint32_t bitmap[VFATFrame::bitmapWords];
+        record.frame->getActiveChannelBitmap(bitmap);
+
+        bool empty = true;
+        for (unsigned int w = 0; w < VFATFrame::bitmapWords; w++)
         {
-          DetSet<TotemRPDigi> &digiDetSet = rpData.find_or_insert(detId);
-          digiDetSet.push_back(TotemRPDigi(offset + ch));
+          bitmap[w] &= uint32_t(entry.unmaskedChannels[w / 2] >> (32 * (w % 2)));
+          empty &= (bitmap[w] == 0);
+        }
+
+        if (!empty)
+        {
+          const unsigned short offset = entry.chipPosition * 128;
+          DetSet<TotemRPDigi> &digiDetSet = rpData.find_or_insert(entry.detId);
+          VFATFrame::forEachActiveChannel(bitmap, [&] (unsigned int ch) {
+            digiDetSet.push_back(TotemRPDigi(offset + ch));
+          });
         }
       }
     }
 
     // save status
-    DetSet<TotemVFATStatus> &statusDetSet = finalStatus.find_or_insert(detId);
-    statusDetSet.push_back(record.status);
+    finalStatus.find(entry.detId)->data[statusIndices[i]] = record.status;
   }
 }
 
@@ -275,22 +348,12 @@ void RawToDigiConverter::Run(const VFATFrameCollection &input,
 
 void RawToDigiConverter::PrintSummaries()
 {
-  if (printErrorSummary)
-  {
-    LogVerbatim("Totem") << "* Error summary (error signature : number of such events)" << endl;
-    for (const auto &vit : errorSummary)
-    {
-      LogVerbatim("Totem") << vit.first << endl;
-
-      for (const auto &it : vit.second)
-        LogVerbatim("Totem") << "    " << it.first << " : " << it.second << endl;
-    }
-  }
+  CompleteErrorCounters();
 
-  if (printUnknownFrameSummary)
+  if (printErrorSummary || printUnknownFrameSummary)
   {
-    LogVerbatim("Totem") << "* Frames found in data, but not in the mapping (frame position : number of events)" << endl;
-    for (const auto &it : unknownSummary)
-      LogVerbatim("Totem") << "  " << it.first << " : " << it.second << endl;
+    stringstream ss;
+    errorCounters.PrintSummary(ss, printErrorSummary, printUnknownFrameSummary);
+    LogVerbatim("Totem") << ss.str();
   }
 }
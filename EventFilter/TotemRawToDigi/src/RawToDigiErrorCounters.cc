@@ -0,0 +1,207 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const char* RawToDigiErrorCounters::GetName(ErrorType type)
+{
+  switch (type)
+  {
+    case etFEDTooShort: return "fedTooShort";
+    case etOptoRxStructure: return "optoRxStructure";
+    case etUnknownFOV: return "unknownFOV";
+    case etGOHBlockStructure: return "gohBlockStructure";
+    case etHeaderFlag: return "headerFlag";
+    case etTrailerSignature: return "trailerSignature";
+    case etDAQErrorFlags: return "daqErrorFlags";
+    case etTrailerSize: return "trailerSize";
+    case etInvalidCluster: return "invalidCluster";
+    case etUnknownFrame: return "unknownFrame";
+    case etMissing: return "missing";
+    case etFootprint: return "footprint";
+    case etCRC: return "crc";
+    case etIDMismatch: return "idMismatch";
+    case etECProgress: return "ecProgress";
+    case etBCProgress: return "bcProgress";
+    case etNumberOfTypes: break;
+  }
+
+  return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::AllocateBlock(unsigned int block)
+{
+  if (block >= blockOffsets.size())
+    blockOffsets.resize(block + 1, -1);
+
+  blockOffsets[block] = counters.size();
+  counters.resize(counters.size() + blockLength, 0);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const RawToDigiErrorCounters::counter* RawToDigiErrorCounters::GetCounters(unsigned int rawPosition) const
+{
+  const unsigned int block = rawPosition >> slotBits;
+  if (block >= blockOffsets.size() || blockOffsets[block] < 0)
+    return NULL;
+
+  return &counters[blockOffsets[block] + (rawPosition & (blockSize - 1)) * etNumberOfTypes];
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long RawToDigiErrorCounters::Get(const TotemFramePosition &position, ErrorType type) const
+{
+  const counter *c = GetCounters(position.getRawPosition());
+  return (c) ? c[type] : 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long RawToDigiErrorCounters::GetTotal(ErrorType type) const
+{
+  unsigned long total = 0;
+  for (unsigned int i = type; i < counters.size(); i += etNumberOfTypes)
+    total += counters[i];
+
+  return total;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::Merge(const RawToDigiErrorCounters &other)
+{
+  events += other.events;
+
+  for (unsigned int block = 0; block < other.blockOffsets.size(); ++block)
+  {
+    if (other.blockOffsets[block] < 0)
+      continue;
+
+    if (block >= blockOffsets.size() || blockOffsets[block] < 0)
+      AllocateBlock(block);
+
+    counter *dst = &counters[blockOffsets[block]];
+    const counter *src = &other.counters[other.blockOffsets[block]];
+    for (unsigned int i = 0; i < blockLength; ++i)
+      dst[i] += src[i];
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::Clear()
+{
+  events = 0;
+  fill(counters.begin(), counters.end(), 0);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::PrintSummary(ostream &os, bool errors, bool unknown) const
+{
+  if (errors)
+  {
+    os << "* Error summary (frame position : error type = number of occurrences), " << events << " events" << endl;
+    ForEach([&] (const TotemFramePosition &position, const counter *c)
+      {
+        bool first = true;
+        for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+        {
+          if (t == etUnknownFrame || c[t] == 0)
+            continue;
+
+          os << ((first) ? "  " : ", ");
+          if (first)
+            os << position << " : ";
+          os << GetName((ErrorType) t) << " = " << c[t];
+          first = false;
+        }
+
+        if (!first)
+          os << endl;
+      }
+    );
+  }
+
+  if (unknown)
+  {
+    os << "* Frames found in data, but not in the mapping (frame position : number of events)" << endl;
+    ForEach([&] (const TotemFramePosition &position, const counter *c)
+      {
+        if (c[etUnknownFrame] > 0)
+          os << "  " << position << " : " << c[etUnknownFrame] << endl;
+      }
+    );
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::WriteCSV(ostream &os) const
+{
+  os << "fed,goh,idx";
+  for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+    os << "," << GetName((ErrorType) t);
+  os << endl;
+
+  ForEach([&] (const TotemFramePosition &position, const counter *c)
+    {
+      os << position.getFEDId() << "," << position.getGOHId() << "," << position.getIdxInFiber();
+      for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+        os << "," << c[t];
+      os << endl;
+    }
+  );
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawToDigiErrorCounters::WriteJSON(ostream &os) const
+{
+  os << "{" << endl;
+  os << "  \"events\": " << events << "," << endl;
+
+  os << "  \"totals\": {";
+  for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+    os << ((t == 0) ? "" : ", ") << "\"" << GetName((ErrorType) t) << "\": " << GetTotal((ErrorType) t);
+  os << "}," << endl;
+
+  os << "  \"positions\": [";
+  bool firstPosition = true;
+  ForEach([&] (const TotemFramePosition &position, const counter *c)
+    {
+      os << ((firstPosition) ? "" : ",") << endl;
+      os << "    {\"position\": \"" << position << "\", \"fed\": " << position.getFEDId() << ", \"goh\": "
+        << position.getGOHId() << ", \"idx\": " << position.getIdxInFiber();
+
+      for (unsigned int t = 0; t < etNumberOfTypes; ++t)
+      {
+        if (c[t] > 0)
+          os << ", \"" << GetName((ErrorType) t) << "\": " << c[t];
+      }
+
+      os << "}";
+      firstPosition = false;
+    }
+  );
+  os << endl << "  ]" << endl;
+
+  os << "}" << endl;
+}
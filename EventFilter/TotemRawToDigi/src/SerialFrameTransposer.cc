@@ -0,0 +1,288 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/SerialFrameTransposer.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define SERIAL_FRAME_TRANSPOSER_X86 1
+  #include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the original bit-by-bit algorithm
+static void TransposeBitwise(const uint64_t *buf, unsigned int c, VFATFrame::word * const *frames)
+{
+  for (int i = 0; i < 192; i++)
+  {
+    int iword = 11 - i / 16;  // number of current word (11...0)
+    int ibit = 15 - i % 16;   // number of current bit (15...0)
+    unsigned int w = (buf[i] >> (16 * c)) & 0xFFFF;
+
+    // Fill the current bit of the current word of all VFAT frames
+    for (int idx = 0; idx < 16; idx++)
+    {
+      if (w & (1 << idx))
+        frames[idx][iword] |= (1 << ibit);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Row r of the matrix (r = 0 ... 15) is the serial word 15 - r, hence after the transposition, row idx
+ * holds the data word of frame idx. The rows are packed in 4 64-bit words, 4 rows (16 bits each) per word.
+ * The transposition swaps the off-diagonal sub-blocks of size 8, 4, 2 and 1, the first two steps operate
+ * on pairs of words, the other two within one word.
+ **/
+static void TransposeScalar(const uint64_t *buf, unsigned int c, VFATFrame::word * const *frames)
+{
+  const unsigned int shift = 16 * c;
+
+  for (unsigned int k = 0; k < 12; ++k)
+  {
+    const uint64_t *block = buf + 16 * k;
+
+    uint64_t q[4];
+    for (unsigned int g = 0; g < 4; ++g)
+    {
+      q[g] = 0;
+      for (unsigned int l = 0; l < 4; ++l)
+        q[g] |= ((block[15 - 4*g - l] >> shift) & 0xFFFF) << (16 * l);
+    }
+
+    uint64_t t;
+
+    // 8x8 blocks: rows r and r+8
+    for (unsigned int g = 0; g < 2; ++g)
+    {
+      t = ((q[g] >> 8) ^ q[g + 2]) & 0x00FF00FF00FF00FFULL;
+      q[g + 2] ^= t;
+      q[g] ^= t << 8;
+    }
+
+    // 4x4 blocks: rows r and r+4
+    for (unsigned int g = 0; g < 4; g += 2)
+    {
+      t = ((q[g] >> 4) ^ q[g + 1]) & 0x0F0F0F0F0F0F0F0FULL;
+      q[g + 1] ^= t;
+      q[g] ^= t << 4;
+    }
+
+    // 2x2 blocks: rows r and r+2, 32 bits apart
+    // 1x1 blocks: rows r and r+1, 16 bits apart
+    for (unsigned int g = 0; g < 4; ++g)
+    {
+      t = ((q[g] >> 2) ^ (q[g] >> 32)) & 0x0000000033333333ULL;
+      q[g] ^= (t << 32) ^ (t << 2);
+
+      t = ((q[g] >> 1) ^ (q[g] >> 16)) & 0x0000555500005555ULL;
+      q[g] ^= (t << 16) ^ (t << 1);
+    }
+
+    const unsigned int iword = 11 - k;
+    for (unsigned int idx = 0; idx < 16; ++idx)
+      frames[idx][iword] |= (q[idx / 4] >> (16 * (idx % 4))) & 0xFFFF;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+#ifdef SERIAL_FRAME_TRANSPOSER_X86
+
+/**
+ * Byte n of vector `lo' (`hi') holds the lower (upper) byte of the serial word 15 - n. The movemask
+ * instruction collects the most significant bits of all bytes, i.e. one column of the matrix, which is
+ * the data word of one frame. The next column is moved to the most significant position by doubling
+ * the bytes.
+ **/
+__attribute__((target("sse2")))
+static void TransposeSSE2(const uint64_t *buf, unsigned int c, VFATFrame::word * const *frames)
+{
+  const unsigned int shift = 16 * c;
+  const __m128i lowByte = _mm_set1_epi16(0x00FF);
+
+  for (unsigned int k = 0; k < 12; ++k)
+  {
+    const uint64_t *block = buf + 16 * k;
+
+    uint16_t rows[16] __attribute__((aligned(16)));
+    for (unsigned int r = 0; r < 16; ++r)
+      rows[r] = block[15 - r] >> shift;
+
+    __m128i v0 = _mm_load_si128((const __m128i *) rows);
+    __m128i v1 = _mm_load_si128((const __m128i *) (rows + 8));
+
+    __m128i lo = _mm_packus_epi16(_mm_and_si128(v0, lowByte), _mm_and_si128(v1, lowByte));
+    __m128i hi = _mm_packus_epi16(_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8));
+
+    const unsigned int iword = 11 - k;
+    for (int idx = 7; idx >= 0; --idx)
+    {
+      frames[idx][iword] |= _mm_movemask_epi8(lo);
+      frames[idx + 8][iword] |= _mm_movemask_epi8(hi);
+      lo = _mm_add_epi8(lo, lo);
+      hi = _mm_add_epi8(hi, hi);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// as TransposeSSE2, but 2 matrices are processed at once, one per 128-bit lane
+__attribute__((target("avx2")))
+static void TransposeAVX2(const uint64_t *buf, unsigned int c, VFATFrame::word * const *frames)
+{
+  const unsigned int shift = 16 * c;
+  const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+
+  for (unsigned int k = 0; k < 12; k += 2)
+  {
+    const uint64_t *block = buf + 16 * k;
+
+    uint16_t rows[32] __attribute__((aligned(32)));
+    for (unsigned int r = 0; r < 16; ++r)
+    {
+      rows[r] = block[15 - r] >> shift;
+      rows[16 + r] = block[31 - r] >> shift;
+    }
+
+    __m256i v0 = _mm256_load_si256((const __m256i *) rows);
+    __m256i v1 = _mm256_load_si256((const __m256i *) (rows + 16));
+
+    // the pack instruction works per lane, the permutation restores the order: matrix k, matrix k+1
+    __m256i lo = _mm256_packus_epi16(_mm256_and_si256(v0, lowByte), _mm256_and_si256(v1, lowByte));
+    __m256i hi = _mm256_packus_epi16(_mm256_srli_epi16(v0, 8), _mm256_srli_epi16(v1, 8));
+    lo = _mm256_permute4x64_epi64(lo, 0xD8);
+    hi = _mm256_permute4x64_epi64(hi, 0xD8);
+
+    const unsigned int iword = 11 - k;
+    for (int idx = 7; idx >= 0; --idx)
+    {
+      const uint32_t mLo = _mm256_movemask_epi8(lo);
+      const uint32_t mHi = _mm256_movemask_epi8(hi);
+
+      frames[idx][iword] |= mLo & 0xFFFF;
+      frames[idx][iword - 1] |= mLo >> 16;
+      frames[idx + 8][iword] |= mHi & 0xFFFF;
+      frames[idx + 8][iword - 1] |= mHi >> 16;
+
+      lo = _mm256_add_epi8(lo, lo);
+      hi = _mm256_add_epi8(hi, hi);
+    }
+  }
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------
+//----------------------------------------------------------------------------------------------------
+
+SerialFrameTransposer::SerialFrameTransposer(Implementation impl) : implementation(iScalar), function(TransposeScalar)
+{
+  if (!SetImplementation(impl))
+    SetImplementation(iAuto);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool SerialFrameTransposer::SetImplementation(Implementation impl)
+{
+  if (impl == iAuto)
+    impl = GetBestImplementation();
+
+  if (!IsAvailable(impl))
+    return false;
+
+  implementation = impl;
+
+  switch (impl)
+  {
+    case iBitwise: function = TransposeBitwise; break;
+#ifdef SERIAL_FRAME_TRANSPOSER_X86
+    case iSSE2: function = TransposeSSE2; break;
+    case iAVX2: function = TransposeAVX2; break;
+#endif
+    default: function = TransposeScalar; break;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool SerialFrameTransposer::IsAvailable(Implementation impl)
+{
+  switch (impl)
+  {
+    case iAuto:
+    case iBitwise:
+    case iScalar:
+      return true;
+
+#ifdef SERIAL_FRAME_TRANSPOSER_X86
+    case iSSE2:
+      return __builtin_cpu_supports("sse2");
+    case iAVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+
+    default:
+      return false;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+SerialFrameTransposer::Implementation SerialFrameTransposer::GetBestImplementation()
+{
+  if (IsAvailable(iAVX2))
+    return iAVX2;
+
+  if (IsAvailable(iSSE2))
+    return iSSE2;
+
+  return iScalar;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const char* SerialFrameTransposer::GetName(Implementation impl)
+{
+  switch (impl)
+  {
+    case iAuto: return "auto";
+    case iBitwise: return "bitwise";
+    case iScalar: return "scalar";
+    case iSSE2: return "sse2";
+    case iAVX2: return "avx2";
+  }
+
+  return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool SerialFrameTransposer::GetImplementation(const std::string &name, Implementation &impl)
+{
+  for (Implementation i : { iAuto, iBitwise, iScalar, iSSE2, iAVX2 })
+  {
+    if (name == GetName(i))
+    {
+      impl = i;
+      return true;
+    }
+  }
+
+  return false;
+}
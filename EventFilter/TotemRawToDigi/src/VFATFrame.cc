@@ -9,6 +9,7 @@
 ****************************************************************************/
 
 #include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
 
 #include <stdio.h>
 #include <cstring>
@@ -37,25 +38,37 @@ void VFATFrame::setData(const VFATFrame::word *_data)
 
 std::vector<unsigned char> VFATFrame::getActiveChannels() const
 {
-  std::vector<unsigned char> channels;
+  unsigned char buffer[128];
+  const unsigned int n = getActiveChannels(buffer);
 
-  for (int i = 0; i < 8; i++)
-  {
-    // quick check
-    if (!data[1 + i])
-      continue;
-
-    // go throug bits
-    word mask;
-    char offset;
-    for (mask = 1 << 15, offset = 15; mask; mask >>= 1, offset--)
-    {
-      if (data[1 + i] & mask)
-        channels.push_back( i * 16 + offset );
-    }
-  }
+  return std::vector<unsigned char>(buffer, buffer + n);
+}
+
+//----------------------------------------------------------------------------------------------------
 
-  return channels;
+unsigned int VFATFrame::getNumberOfActiveChannels() const
+{
+  uint32_t bitmap[bitmapWords];
+  getActiveChannelBitmap(bitmap);
+
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < bitmapWords; i++)
+    n += __builtin_popcount(bitmap[i]);
+
+  return n;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned int VFATFrame::getActiveChannels(unsigned char *channels) const
+{
+  uint32_t bitmap[bitmapWords];
+  getActiveChannelBitmap(bitmap);
+
+  unsigned int n = 0;
+  forEachActiveChannel(bitmap, [&] (unsigned int ch) { channels[n++] = ch; });
+
+  return n;
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -87,40 +100,7 @@ bool VFATFrame::checkCRC() const
     return true;
 
   // compare CRC
-  word crc_fin = 0xffff;
-
-  for (int i = 11; i >= 1; i--)
-    crc_fin = calculateCRC(crc_fin, data[i]);
-  
-  return (crc_fin == data[0]);
-}
-
-//----------------------------------------------------------------------------------------------------
-
-VFATFrame::word VFATFrame::calculateCRC(VFATFrame::word crc_in, VFATFrame::word dato)
-{
-  word v = 0x0001;
-  word mask = 0x0001;    
-  bool d=0;
-  word crc_temp = crc_in;
-  unsigned char datalen = 16;
-
-  for (int i = 0; i < datalen; i++)
-  {
-    if (dato & v)
-      d = 1;
-    else
-      d = 0;
-      
-    if ((crc_temp & mask)^d)
-      crc_temp = crc_temp>>1 ^ 0x8408;
-    else
-      crc_temp = crc_temp>>1;
-       
-    v <<= 1;
-  }
-
-  return crc_temp;
+  return (VFATFrameCRC::GetDefault().Calculate(data) == data[0]);
 }
 
 //----------------------------------------------------------------------------------------------------
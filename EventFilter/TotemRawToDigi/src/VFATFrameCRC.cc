@@ -0,0 +1,282 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define VFAT_FRAME_CRC_X86 1
+  #include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+typedef VFATFrame::word word;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the reflected polynomial
+static const word polynomial = 0x8408;
+
+/// multiplies the register by x^n, modulo the polynomial
+static word MultiplyByXPower(word r, unsigned int n)
+{
+  for (unsigned int i = 0; i < n; ++i)
+    r = (r & 1) ? (r >> 1) ^ polynomial : (r >> 1);
+
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// lookup tables: t[0] is the standard byte table, t[k][b] is the CRC of byte b followed by k zero bytes
+struct CRCTables
+{
+  word t[4][256];
+
+  CRCTables()
+  {
+    for (unsigned int b = 0; b < 256; ++b)
+      t[0][b] = MultiplyByXPower(b, 8);
+
+    for (unsigned int k = 1; k < 4; ++k)
+      for (unsigned int b = 0; b < 256; ++b)
+        t[k][b] = (t[k-1][b] >> 8) ^ t[0][t[k-1][b] & 0xFF];
+  }
+};
+
+static const CRCTables tables;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the original bit-by-bit algorithm
+static word CalculateBitwise(const word *data)
+{
+  word crc = 0xFFFF;
+
+  for (int i = 11; i >= 1; i--)
+  {
+    const word dato = data[i];
+    for (int b = 0; b < 16; b++)
+    {
+      bool d = (dato >> b) & 1;
+      if ((crc & 1) ^ d)
+        crc = (crc >> 1) ^ polynomial;
+      else
+        crc = crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+static word CalculateTable(const word *data)
+{
+  word crc = 0xFFFF;
+
+  for (int i = 11; i >= 1; i--)
+  {
+    crc = (crc >> 8) ^ tables.t[0][(crc ^ data[i]) & 0xFF];
+    crc = (crc >> 8) ^ tables.t[0][(crc ^ (data[i] >> 8)) & 0xFF];
+  }
+
+  return crc;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// zero-initialised CRC of the 4 bytes of v (least significant first), XOR-ed with the register
+static inline word SliceBy4(uint32_t v)
+{
+  return tables.t[3][v & 0xFF] ^ tables.t[2][(v >> 8) & 0xFF] ^ tables.t[1][(v >> 16) & 0xFF] ^ tables.t[0][v >> 24];
+}
+
+//----------------------------------------------------------------------------------------------------
+
+static word CalculateSliceBy4(const word *data)
+{
+  word crc = 0xFFFF;
+
+  // words 11 ... 2, two per step
+  for (int i = 11; i >= 3; i -= 2)
+    crc = SliceBy4((crc ^ data[i]) | (uint32_t(data[i-1]) << 16));
+
+  // word 1
+  const word v = crc ^ data[1];
+  return tables.t[1][v & 0xFF] ^ tables.t[0][v >> 8];
+}
+
+//----------------------------------------------------------------------------------------------------
+
+#ifdef VFAT_FRAME_CRC_X86
+
+/**
+ * The message (with the initial value XOR-ed into its first word) is split into 3 chunks of 64 bits
+ * a0, a1, a2 (a2 only has 48 bits). In the bit-reflected representation, the CRC is the remainder of
+ *   a0 x^128 + a1 x^64 + a2 = x (a0 x^127 + a1 x^63 + a2 / x)
+ * The bracket is evaluated with the precomputed constants x^127 and x^63 modulo the polynomial, which
+ * gives a value of 79 bits: the upper 15 bits are already reduced, the lower 64 bits are reduced
+ * with the slice-by-4 tables.
+ **/
+__attribute__((target("pclmul,sse2")))
+static word CalculatePCLMUL(const word *data)
+{
+  static const uint64_t k127 = MultiplyByXPower(0x8000, 127);
+  static const uint64_t k63 = MultiplyByXPower(0x8000, 63);
+
+  const uint64_t a0 = uint64_t(data[11] ^ 0xFFFF) | (uint64_t(data[10]) << 16) | (uint64_t(data[9]) << 32)
+    | (uint64_t(data[8]) << 48);
+  const uint64_t a1 = uint64_t(data[7]) | (uint64_t(data[6]) << 16) | (uint64_t(data[5]) << 32)
+    | (uint64_t(data[4]) << 48);
+  const uint64_t a2 = uint64_t(data[3]) | (uint64_t(data[2]) << 16) | (uint64_t(data[1]) << 32);
+
+  const __m128i p0 = _mm_clmulepi64_si128(_mm_set_epi64x(0, a0), _mm_set_epi64x(0, k127), 0x00);
+  const __m128i p1 = _mm_clmulepi64_si128(_mm_set_epi64x(0, a1), _mm_set_epi64x(0, k63), 0x00);
+  const __m128i v = _mm_xor_si128(_mm_xor_si128(p0, p1), _mm_set_epi64x(0, a2 << 16));
+
+  const uint64_t low = _mm_cvtsi128_si64(v);
+  const word high = _mm_cvtsi128_si64(_mm_srli_si128(v, 8));
+
+  word crc = SliceBy4(low);
+  crc = SliceBy4(crc ^ (low >> 32));
+
+  return crc ^ high;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------
+//----------------------------------------------------------------------------------------------------
+
+VFATFrameCRC::VFATFrameCRC(Implementation impl) : implementation(iSliceBy4), function(CalculateSliceBy4)
+{
+  if (!SetImplementation(impl))
+    SetImplementation(iAuto);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool VFATFrameCRC::SetImplementation(Implementation impl)
+{
+  if (impl == iAuto)
+    impl = GetBestImplementation();
+
+  if (!IsAvailable(impl))
+    return false;
+
+  implementation = impl;
+
+  switch (impl)
+  {
+    case iBitwise: function = CalculateBitwise; break;
+    case iTable: function = CalculateTable; break;
+#ifdef VFAT_FRAME_CRC_X86
+    case iPCLMUL: function = CalculatePCLMUL; break;
+#endif
+    default: function = CalculateSliceBy4; break;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned int VFATFrameCRC::Check(const VFATFrameCollection &coll, vector<TotemFramePosition> *failed) const
+{
+  unsigned int failures = 0;
+
+  for (VFATFrameCollection::Iterator fr(&coll); !fr.IsEnd(); fr.Next())
+  {
+    const VFATFrame *f = fr.Data();
+
+    bool ok = (f->getDAQErrorFlags() == 0) && (!f->isCRCPresent() || function(f->getData()) == f->getCRC());
+    if (ok)
+      continue;
+
+    failures++;
+    if (failed)
+      failed->push_back(fr.Position());
+  }
+
+  return failures;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const VFATFrameCRC& VFATFrameCRC::GetDefault()
+{
+  static const VFATFrameCRC instance(iAuto);
+  return instance;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool VFATFrameCRC::IsAvailable(Implementation impl)
+{
+  switch (impl)
+  {
+    case iAuto:
+    case iBitwise:
+    case iTable:
+    case iSliceBy4:
+      return true;
+
+#ifdef VFAT_FRAME_CRC_X86
+    case iPCLMUL:
+      return __builtin_cpu_supports("pclmul");
+#endif
+
+    default:
+      return false;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+VFATFrameCRC::Implementation VFATFrameCRC::GetBestImplementation()
+{
+  if (IsAvailable(iPCLMUL))
+    return iPCLMUL;
+
+  return iSliceBy4;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const char* VFATFrameCRC::GetName(Implementation impl)
+{
+  switch (impl)
+  {
+    case iAuto: return "auto";
+    case iBitwise: return "bitwise";
+    case iTable: return "table";
+    case iSliceBy4: return "slice4";
+    case iPCLMUL: return "pclmul";
+  }
+
+  return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool VFATFrameCRC::GetImplementation(const std::string &name, Implementation &impl)
+{
+  for (Implementation i : { iAuto, iBitwise, iTable, iSliceBy4, iPCLMUL })
+  {
+    if (name == GetName(i))
+    {
+      impl = i;
+      return true;
+    }
+  }
+
+  return false;
+}
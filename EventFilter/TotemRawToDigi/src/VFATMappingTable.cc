@@ -0,0 +1,85 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/VFATMappingTable.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const int VFATMappingTable::notFound;
+
+//----------------------------------------------------------------------------------------------------
+
+void VFATMappingTable::Build(const TotemDAQMapping &mapping, const TotemAnalysisMask &mask)
+{
+  entries.clear();
+  blockOffsets.clear();
+  slots.clear();
+
+  entries.reserve(mapping.VFATMapping.size());
+
+  for (const auto &p : mapping.VFATMapping)
+  {
+    Entry e;
+    e.position = p.first;
+    e.info = p.second;
+    e.rp = (e.info.symbolicID.subSystem == TotemSymbID::RP);
+    e.detId = 0;
+    e.chipPosition = 0;
+
+    if (e.rp)
+    {
+      const unsigned int chipId = e.info.symbolicID.symbolicID;
+      e.detId = TotemRPDetId::decToRawId(chipId / 10);
+      e.chipPosition = chipId % 10;
+    }
+
+    // analysis mask, no mask by default
+    e.maskType = mtNone;
+    e.unmaskedChannels[0] = e.unmaskedChannels[1] = ~uint64_t(0);
+
+    auto mit = mask.analysisMask.find(e.info.symbolicID);
+    if (mit != mask.analysisMask.end())
+    {
+      if (mit->second.fullMask)
+      {
+        e.maskType = mtFull;
+        e.unmaskedChannels[0] = e.unmaskedChannels[1] = 0;
+      } else {
+        e.maskType = mtPartial;
+        for (unsigned char ch : mit->second.maskedChannels)
+        {
+          if (ch < 128)
+            e.unmaskedChannels[ch >> 6] &= ~(uint64_t(1) << (ch & 0x3F));
+        }
+      }
+    }
+
+    // the lookup table
+    const unsigned int raw = e.position.getRawPosition();
+    const unsigned int block = raw >> slotBits;
+
+    if (block >= blockOffsets.size())
+      blockOffsets.resize(block + 1, -1);
+
+    if (blockOffsets[block] < 0)
+    {
+      blockOffsets[block] = slots.size();
+      slots.resize(slots.size() + blockSize, notFound);
+    }
+
+    slots[blockOffsets[block] + (raw & (blockSize - 1))] = entries.size();
+
+    entries.push_back(e);
+  }
+}
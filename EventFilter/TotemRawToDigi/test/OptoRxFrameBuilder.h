@@ -0,0 +1,149 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef EventFilter_TotemRawToDigi_test_OptoRxFrameBuilder
+#define EventFilter_TotemRawToDigi_test_OptoRxFrameBuilder
+
+#include "DataFormats/FEDRawData/interface/FEDRawData.h"
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Builds OptoRx frames with random content for the unpacking tests and benchmarks.
+ **/
+namespace OptoRxFrameBuilder
+{
+  inline void Finish(std::vector<uint64_t> &words, unsigned int OptoRxId, unsigned int FOV, FEDRawData &data)
+  {
+    words.front() = (uint64_t(5) << 60) | (uint64_t(OptoRxId) << 8) | (uint64_t(FOV) << 4);
+    words.push_back((uint64_t(10) << 60) | (uint64_t(words.size() + 1) << 32));
+
+    data.resize(words.size() * 8);
+    memcpy(data.data(), words.data(), words.size() * 8);
+  }
+
+  /// serial (FOV = 1) frame, with the given GOHs active (bit mask over 4 columns x subFrames rows)
+  inline void MakeSerial(unsigned int OptoRxId, unsigned int subFrames, unsigned int activeMask, std::mt19937_64 &rng,
+    FEDRawData &data)
+  {
+    std::vector<uint64_t> words(1 + 194 * subFrames, 0);
+
+    for (unsigned int r = 0; r < subFrames; ++r)
+    {
+      for (unsigned int i = 0; i < 192; ++i)
+        words[2 + 194 * r + i] = rng();
+
+      words[1 + 194 * r] = 0;
+      words[194 + 194 * r] = 0;
+      for (unsigned int c = 0; c < 4; ++c)
+      {
+        unsigned int goh = 4 * r + c;
+        unsigned int active = (activeMask >> goh) & 1;
+        words[1 + 194 * r] |= uint64_t(0x4000 | (goh << 8) | active) << (16 * c);
+        words[194 + 194 * r] |= uint64_t(0xB000 | (goh << 8)) << (16 * c);
+      }
+    }
+
+    Finish(words, OptoRxId, 1, data);
+  }
+
+  /// parallel (FOV = 2) frame, one VFAT block per (GOH, fiber) with probability `fraction'
+  /// a random mixture of raw-mode and cluster-mode blocks is produced
+  /// with probability `corruption', a block is corrupted in one of these ways: DAQ error flags set, wrong size
+  /// in trailer, wrong CRC (raw mode) or an invalid cluster (cluster mode)
+  inline void MakeParallel(unsigned int OptoRxId, double fraction, double occupancy, std::mt19937_64 &rng,
+    FEDRawData &data, double corruption = 0.)
+  {
+    std::uniform_real_distribution<double> uni(0., 1.);
+
+    std::vector<uint16_t> payload;
+    payload.push_back(rng() & 0xFFFF); // orbit counter
+    payload.push_back(rng() & 0xFFFF);
+
+    for (unsigned int goh = 0; goh < 16; ++goh)
+    {
+      for (unsigned int fiber = 0; fiber < 16; ++fiber)
+      {
+        if (uni(rng) > fraction)
+          continue;
+
+        const bool raw = (uni(rng) < 0.5);
+        const unsigned int start = payload.size();
+
+        payload.push_back(((raw ? 0x90 : 0x80) << 8) | (goh << 4) | fiber);
+        payload.push_back(0xA000 | (rng() & 0xFFF));
+        payload.push_back(0xC000 | (rng() & 0xFFF));
+        payload.push_back(0xE000 | (rng() & 0xFFF));
+
+        const int corruptionType = (corruption > 0. && uni(rng) < corruption) ? rng() % 3 : -1;
+
+        if (raw)
+        {
+          VFATFrame::word frame[12] = { 0 };
+          frame[11] = payload[start + 1];
+          frame[10] = payload[start + 2];
+          frame[9] = payload[start + 3];
+
+          for (unsigned int i = 0; i < 8; ++i)
+          {
+            uint16_t w = 0;
+            for (unsigned int b = 0; b < 16; ++b)
+              if (uni(rng) < occupancy)
+                w |= (1 << b);
+            payload.push_back(w);
+            frame[8 - i] = w;
+          }
+
+          VFATFrame::word crc = VFATFrameCRC::GetDefault().Calculate(frame);
+          if (corruptionType == 2)
+            crc ^= 1;
+          payload.push_back(crc);
+        } else {
+          unsigned int pos = 0;
+          while (true)
+          {
+            pos += 1 + unsigned(uni(rng) / occupancy);
+            if (pos > 127)
+              break;
+            unsigned int size = 1 + rng() % std::min(3u, pos + 1);
+            payload.push_back((size << 8) | pos);
+          }
+
+          if (corruptionType == 2)
+            payload.push_back((5 << 8) | 1);
+        }
+
+        unsigned int size = payload.size() - start + 1;
+        if (corruptionType == 1)
+          size++;
+
+        const unsigned int flags = (corruptionType == 0) ? 1 : 0;
+        payload.push_back(0xF000 | (flags << 8) | size);
+      }
+    }
+
+    // padding to whole 64-bit words
+    while (payload.size() % 4 != 0)
+      payload.push_back(0xFFFF);
+
+    std::vector<uint64_t> words(1 + payload.size() / 4);
+    memcpy(words.data() + 1, payload.data(), payload.size() * 2);
+
+    Finish(words, OptoRxId, 2, data);
+  }
+}
+
+#endif
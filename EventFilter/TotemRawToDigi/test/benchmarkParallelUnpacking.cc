@@ -0,0 +1,184 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/ParallelRawDataUnpacker.h"
+
+#include "EventFilter/TotemRawToDigi/test/OptoRxFrameBuilder.h"
+
+#include "tbb/task_arena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// checksum of the unpacked event, sensitive to the order of frames and FED info
+unsigned long Checksum(const FlatVFATFrameCollection &coll, const vector<TotemFEDInfo> &fedInfo)
+{
+  unsigned long sum = 0;
+
+  for (const auto &fi : fedInfo)
+    sum = sum * 31 + fi.getFEDId() * 7 + fi.getOptoRxId() + fi.getOrbitCounter();
+
+  for (VFATFrameCollection::Iterator fr(&coll); !fr.IsEnd(); fr.Next())
+  {
+    sum = sum * 31 + fr.Position().getRawPosition();
+    const VFATFrame::word *d = fr.Data()->getData();
+    for (unsigned int i = 0; i < 12; ++i)
+      sum = sum * 3 + d[i];
+  }
+
+  return sum;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkParallelUnpacking [option]\n");
+  printf("Compares the serial unpacking of all FEDs of an event (RawDataUnpacker) with the per-FED parallel one\n");
+  printf("(ParallelRawDataUnpacker) for 1, 2, 4, ... threads.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -e <number>     number of events (default 5000)\n");
+  printf("    -n <number>     number of FEDs per event (default 16)\n");
+  printf("    -f <fraction>   fraction of (GOH, fiber) channels with a VFAT frame (default 0.5)\n");
+  printf("    -t <number>     maximum number of threads (default: hardware concurrency)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 5000;
+  unsigned int feds = 16;
+  double fraction = 0.5;
+  unsigned int maxThreads = max(1u, thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { feds = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fraction = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) { maxThreads = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // a pool of different events, with a few corrupted blocks
+  mt19937_64 rng(11);
+  vector<unsigned int> fedIds;
+  for (unsigned int i = 0; i < feds; ++i)
+    fedIds.push_back(578 + i);
+
+  const unsigned int poolSize = 50;
+  vector<FEDRawDataCollection> pool(poolSize);
+  for (auto &ev : pool)
+  {
+    for (const auto &fedId : fedIds)
+      OptoRxFrameBuilder::MakeParallel(fedId, fraction, 0.01, rng, ev.FEDData(fedId), 0.001);
+  }
+
+  RawDataUnpacker unpacker;
+
+  // reference: serial unpacking
+  vector<unsigned long> refSums(poolSize);
+  RawToDigiErrorCounters refCounters;
+  double refTime;
+  {
+    FlatVFATFrameCollection coll;
+    vector<TotemFEDInfo> fedInfo;
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int e = 0; e < events; ++e)
+    {
+      const FEDRawDataCollection &ev = pool[e % poolSize];
+      coll.Clear();
+      fedInfo.clear();
+      for (const auto &fedId : fedIds)
+        unpacker.Run(fedId, ev.FEDData(fedId), fedInfo, coll, &refCounters);
+
+      if (e < poolSize)
+        refSums[e] = Checksum(coll, fedInfo);
+    }
+    refTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  printf("%u FEDs per event, %u events\n", feds, events);
+  printf("%-10s %10s %12s %10s\n", "mode", "time (s)", "events/s", "speedup");
+  printf("%-10s %10.3f %12.1f %10.2f\n", "serial", refTime, events / refTime, 1.);
+
+  for (unsigned int threads = 1; ; threads *= 2)
+  {
+    if (threads > maxThreads)
+      threads = maxThreads;
+
+    ParallelRawDataUnpacker parallelUnpacker(unpacker);
+    FlatVFATFrameCollection coll;
+    vector<TotemFEDInfo> fedInfo;
+    bool mismatch = false;
+
+    tbb::task_arena arena(threads);
+    auto start = chrono::steady_clock::now();
+    arena.execute([&] ()
+      {
+        for (unsigned int e = 0; e < events; ++e)
+        {
+          coll.Clear();
+          fedInfo.clear();
+          parallelUnpacker.Run(fedIds, pool[e % poolSize], fedInfo, coll);
+
+          if (e < poolSize && Checksum(coll, fedInfo) != refSums[e])
+            mismatch = true;
+        }
+      }
+    );
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    char label[20];
+    snprintf(label, 20, "%u thr", threads);
+    printf("%-10s %10.3f %12.1f %10.2f\n", label, time, events / time, refTime / time);
+
+    RawToDigiErrorCounters counters;
+    parallelUnpacker.MergeErrorCounters(counters);
+    for (unsigned int t = 0; t < RawToDigiErrorCounters::etNumberOfTypes; ++t)
+    {
+      const auto type = (RawToDigiErrorCounters::ErrorType) t;
+      mismatch |= (counters.GetTotal(type) != refCounters.GetTotal(type));
+    }
+
+    if (mismatch)
+    {
+      printf("ERROR: the parallel unpacking gave different results.\n");
+      return 2;
+    }
+
+    if (threads == maxThreads)
+      break;
+  }
+
+  return 0;
+}
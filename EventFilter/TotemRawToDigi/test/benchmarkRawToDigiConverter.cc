@@ -0,0 +1,281 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * The association of frames with the mapping as done before the mapping was compiled:
+ * a map of records is built from the full mapping in every event and the analysis mask is searched
+ * for every VFAT. Only the footprint and ID checks are done.
+**/
+void RunLegacy(const VFATFrameCollection &input, const TotemDAQMapping &mapping, const TotemAnalysisMask &analysisMask,
+  DetSetVector<TotemRPDigi> &rpData, DetSetVector<TotemVFATStatus> &finalStatus)
+{
+  struct Record
+  {
+    const TotemVFATInfo *info;
+    const VFATFrame *frame;
+    TotemVFATStatus status;
+  };
+
+  map<TotemFramePosition, Record> records;
+  for (auto &p : mapping.VFATMapping)
+  {
+    TotemVFATStatus st;
+    st.setMissing(true);
+    records[p.first] = { &p.second, NULL,  st };
+  }
+
+  for (VFATFrameCollection::Iterator fr(&input); !fr.IsEnd(); fr.Next())
+  {
+    auto records_it = records.find(fr.Position());
+    if (records_it == records.end())
+      continue;
+
+    Record &record = records_it->second;
+    record.frame = fr.Data();
+    record.status.setMissing(false);
+
+    if (!record.frame->checkFootprint())
+      record.status.setFootprintError();
+
+    if (record.frame->isIDPresent() && (record.frame->getChipID() & 0xFFF) != (record.info->hwID & 0xFFF))
+      record.status.setIDMismatch();
+  }
+
+  for (auto &p : records)
+  {
+    Record &record = p.second;
+
+    if (record.info->symbolicID.subSystem != TotemSymbID::RP || record.info->type != TotemVFATInfo::data)
+      continue;
+
+    unsigned short chipId = record.info->symbolicID.symbolicID;
+    det_id_type detId = TotemRPDetId::decToRawId(chipId / 10);
+    uint8_t chipPosition = chipId % 10;
+    record.status.setChipPosition(chipPosition);
+
+    if (record.status.isOK())
+    {
+      TotemVFATAnalysisMask anMa;
+      anMa.fullMask = false;
+
+      auto analysisIter = analysisMask.analysisMask.find(record.info->symbolicID);
+      if (analysisIter != analysisMask.analysisMask.end())
+      {
+        anMa = analysisIter->second;
+        if (anMa.fullMask)
+          record.status.setFullyMaskedOut();
+        else
+          record.status.setPartiallyMaskedOut();
+      }
+
+      unsigned short offset = chipPosition * 128;
+      for (auto ch : record.frame->getActiveChannels())
+      {
+        if (!anMa.fullMask && anMa.maskedChannels.find(ch) == anMa.maskedChannels.end())
+          rpData.find_or_insert(detId).push_back(TotemRPDigi(offset + ch));
+      }
+    }
+
+    finalStatus.find_or_insert(detId).push_back(record.status);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// a mapping of `size' RP VFATs, every 10th VFAT partially masked, every 50th fully masked
+void MakeMapping(unsigned int size, TotemDAQMapping &mapping, TotemAnalysisMask &mask)
+{
+  vector<unsigned int> detectors;
+  for (unsigned int arm = 0; arm < 2; ++arm)
+    for (unsigned int st = 0; st < 3; st += 2)
+      for (unsigned int rp = 0; rp < 6; ++rp)
+        for (unsigned int det = 0; det < 10; ++det)
+          detectors.push_back(1000*arm + 100*st + 10*rp + det);
+
+  for (unsigned int k = 0; k < size; ++k)
+  {
+    TotemFramePosition pos(((578 + k / 256) << 8) | (k % 256));
+
+    TotemVFATInfo info;
+    info.type = TotemVFATInfo::data;
+    info.symbolicID.subSystem = TotemSymbID::RP;
+    info.symbolicID.symbolicID = detectors[(k / 4) % detectors.size()] * 10 + k % 4;
+    info.hwID = k & 0xFFF;
+    mapping.insert(pos, info);
+
+    if (k % 10 == 0 && k < 4 * detectors.size())
+    {
+      TotemVFATAnalysisMask am;
+      am.fullMask = (k % 50 == 0);
+      for (unsigned char ch = 0; ch < 8; ++ch)
+        am.maskedChannels.insert(ch);
+      mask.insert(info.symbolicID, am);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// an event with `frames' frames at random mapped positions, with a few active channels each
+void MakeEvent(unsigned int mappingSize, unsigned int frames, mt19937 &rng, FlatVFATFrameCollection &coll)
+{
+  coll.Clear();
+
+  for (unsigned int i = 0; i < frames && i < mappingSize; ++i)
+  {
+    const unsigned int k = rng() % mappingSize;
+    VFATFrame *f = coll.InsertEmptyFrame(TotemFramePosition(((578 + k / 256) << 8) | (k % 256)));
+
+    VFATFrame::word *d = f->getData();
+    d[11] = 0xA000 | 0x123;
+    d[10] = 0xC000 | 0x45;
+    d[9] = 0xE000 | (k & 0xFFF);
+    for (unsigned int j = 1; j <= 8; ++j)
+      d[j] = (rng() % 4 == 0) ? (1 << (rng() % 16)) : 0;
+    f->setPresenceFlags(0x7);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// to check that both versions give the same output
+unsigned long Digest(const DetSetVector<TotemRPDigi> &digi, const DetSetVector<TotemVFATStatus> &status)
+{
+  unsigned long d = 0;
+
+  for (const auto &ds : digi)
+    for (const auto &dg : ds)
+      d = d * 31 + ds.detId() + dg.getStripNumber();
+
+  for (const auto &ds : status)
+    for (const auto &st : ds)
+      d = d * 31 + ds.detId() + st.getChipPosition() + (st.isOK() << 1) + (st.isMissing() << 2)
+        + (st.isPartiallyMaskedOut() << 3) + (st.isFullyMaskedOut() << 4);
+
+  return d;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkRawToDigiConverter [option]\n");
+  printf("Measures the per-event cost of RawToDigiConverter as a function of the DAQ mapping size\n");
+  printf("and compares it to the former approach (map of all mapped VFATs built in every event).\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -e <number>     number of events per mapping size (default 2000)\n");
+  printf("    -f <number>     number of frames per event (default 100)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 2000;
+  unsigned int frames = 100;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { frames = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  ParameterSet ps;
+  ps.addUntrackedParameter<unsigned int>("verbosity", 0);
+  ps.addUntrackedParameter<unsigned int>("printErrorSummary", 0);
+  ps.addUntrackedParameter<unsigned int>("printUnknownFrameSummary", 0);
+  ps.addParameter<unsigned int>("testFootprint", 2);
+  ps.addParameter<unsigned int>("testCRC", 0);
+  ps.addParameter<unsigned int>("testID", 2);
+  ps.addParameter<unsigned int>("testECMostFrequent", 0);
+  ps.addParameter<unsigned int>("testBCMostFrequent", 0);
+
+  printf("%12s %14s %14s %14s\n", "mapping size", "compile (ms)", "legacy (us/ev)", "compiled (us/ev)");
+
+  bool ok = true;
+
+  for (unsigned int size : { 128, 512, 2048, 8192, 32768 })
+  {
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+    MakeMapping(size, mapping, mask);
+
+    mt19937 rng(size);
+    const unsigned int poolSize = 50;
+    vector<FlatVFATFrameCollection> pool(poolSize);
+    for (auto &coll : pool)
+      MakeEvent(size, frames, rng, coll);
+
+    RawToDigiConverter converter(ps);
+
+    auto start = chrono::steady_clock::now();
+    converter.SetMapping(mapping, mask);
+    const double compileTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // legacy
+    unsigned long legacyDigest = 0;
+    start = chrono::steady_clock::now();
+    for (unsigned int e = 0; e < events; ++e)
+    {
+      DetSetVector<TotemRPDigi> digi;
+      DetSetVector<TotemVFATStatus> status;
+      RunLegacy(pool[e % poolSize], mapping, mask, digi, status);
+      legacyDigest += Digest(digi, status) * (e < poolSize);
+    }
+    const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // compiled
+    unsigned long digest = 0;
+    start = chrono::steady_clock::now();
+    for (unsigned int e = 0; e < events; ++e)
+    {
+      DetSetVector<TotemRPDigi> digi;
+      DetSetVector<TotemVFATStatus> status;
+      converter.Run(pool[e % poolSize], digi, status);
+      digest += Digest(digi, status) * (e < poolSize);
+    }
+    const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%12u %14.3f %14.2f %14.2f\n", size, compileTime * 1E3, legacyTime / events * 1E6, time / events * 1E6);
+
+    if (digest != legacyDigest)
+    {
+      printf("ERROR: different output for mapping size %u.\n", size);
+      ok = false;
+    }
+  }
+
+  return (ok) ? 0 : 2;
+}
@@ -0,0 +1,208 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+
+#include "EventFilter/TotemRawToDigi/test/OptoRxFrameBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+/// DAQ mapping covering all positions of FEDs 578 - 581
+void MakeMapping(TotemDAQMapping &mapping)
+{
+  vector<unsigned int> detectors;
+  for (unsigned int arm = 0; arm < 2; ++arm)
+    for (unsigned int st = 0; st < 3; st += 2)
+      for (unsigned int rp = 0; rp < 6; ++rp)
+        for (unsigned int det = 0; det < 10; ++det)
+          detectors.push_back(1000*arm + 100*st + 10*rp + det);
+
+  for (unsigned int k = 0; k < 4 * 256; ++k)
+  {
+    TotemVFATInfo info;
+    info.type = TotemVFATInfo::data;
+    info.symbolicID.subSystem = TotemSymbID::RP;
+    info.symbolicID.symbolicID = detectors[(k / 4) % detectors.size()] * 10 + k % 4;
+    info.hwID = 0;
+    mapping.insert(TotemFramePosition(((578 + k / 256) << 8) | (k % 256)), info);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+ParameterSet MakeConfig(unsigned int verbosity)
+{
+  ParameterSet ps;
+  ps.addUntrackedParameter<unsigned int>("verbosity", verbosity);
+  ps.addParameter<unsigned int>("testFootprint", 2);
+  ps.addParameter<unsigned int>("testCRC", 2);
+  ps.addParameter<unsigned int>("testID", 0);
+  ps.addParameter<unsigned int>("testECMostFrequent", 0);
+  ps.addParameter<unsigned int>("testBCMostFrequent", 0);
+
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkRawToDigiErrorCounters [option]\n");
+  printf("Measures unpacking and conversion of corrupted data with error counting only (verbosity 0)\n");
+  printf("and with error messages (verbosity 1: a message per unpacking error, a message per event with conversion\n");
+  printf("errors; the messages are formatted, but discarded). Then measures merging of per-stream error counters.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -e <number>     number of events per corruption rate (default 5000)\n");
+  printf("    -j <file>       write the JSON report of the last corruption rate to file\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 5000;
+  string jsonFile;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) { jsonFile = argv[++i]; continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  TotemDAQMapping mapping;
+  MakeMapping(mapping);
+  TotemAnalysisMask mask;
+
+  // message output is discarded
+  stringstream sink;
+  streambuf *cerrBuffer = cerr.rdbuf();
+
+  printf("%12s %10s %14s %14s %14s\n", "corruption", "mode", "events/s", "errors/event", "time (s)");
+
+  RawToDigiErrorCounters lastCounters;
+
+  for (double corruption : { 0., 0.01, 0.1, 0.5 })
+  {
+    mt19937_64 rng(1);
+    const unsigned int poolSize = 50;
+    vector<vector<FEDRawData>> pool(poolSize);
+    for (auto &ev : pool)
+    {
+      for (unsigned int fedId = 578; fedId <= 581; ++fedId)
+      {
+        ev.push_back(FEDRawData());
+        OptoRxFrameBuilder::MakeParallel(fedId, 0.25, 0.01, rng, ev.back(), corruption);
+      }
+    }
+
+    for (unsigned int verbosity : { 0, 1 })
+    {
+      ParameterSet unpackerConfig;
+      unpackerConfig.addUntrackedParameter<unsigned int>("verbosity", verbosity);
+      RawDataUnpacker unpacker(unpackerConfig);
+
+      RawToDigiConverter converter(MakeConfig(verbosity));
+      converter.SetMapping(mapping, mask);
+
+      FlatVFATFrameCollection coll;
+
+      cerr.rdbuf(sink.rdbuf());
+
+      auto start = chrono::steady_clock::now();
+      for (unsigned int e = 0; e < events; ++e)
+      {
+        const vector<FEDRawData> &ev = pool[e % poolSize];
+        vector<TotemFEDInfo> fedInfo;
+        coll.Clear();
+
+        for (unsigned int i = 0; i < ev.size(); ++i)
+          unpacker.Run(578 + i, ev[i], fedInfo, coll, &converter.GetErrorCounters());
+
+        DetSetVector<TotemRPDigi> digi;
+        DetSetVector<TotemVFATStatus> status;
+        converter.Run(coll, digi, status);
+
+        if (sink.tellp() > (1 << 20))
+          sink.str("");
+      }
+      const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      cerr.rdbuf(cerrBuffer);
+      sink.str("");
+
+      // all but missing frames (the mapping is much larger than the events)
+      converter.CompleteErrorCounters();
+      const RawToDigiErrorCounters &counters = converter.GetErrorCounters();
+      unsigned long errors = 0;
+      for (unsigned int t = 0; t < RawToDigiErrorCounters::etNumberOfTypes; ++t)
+      {
+        if (t != RawToDigiErrorCounters::etMissing)
+          errors += counters.GetTotal((RawToDigiErrorCounters::ErrorType) t);
+      }
+
+      printf("%12.2f %10s %14.1f %14.2f %14.3f\n", corruption, (verbosity) ? "messages" : "counters",
+        events / time, double(errors) / events, time);
+
+      if (verbosity == 0)
+        lastCounters = counters;
+    }
+  }
+
+  // merging of per-stream counters
+  const unsigned int streams = 16, repetitions = 1000;
+  RawToDigiErrorCounters merged;
+  auto start = chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repetitions; ++r)
+  {
+    merged.Clear();
+    for (unsigned int s = 0; s < streams; ++s)
+      merged.Merge(lastCounters);
+  }
+  const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("merge of %u streams: %.2f us\n", streams, time / repetitions * 1E6);
+
+  if (merged.GetTotal(RawToDigiErrorCounters::etCRC) != streams * lastCounters.GetTotal(RawToDigiErrorCounters::etCRC))
+  {
+    printf("ERROR: merged counters do not match.\n");
+    return 2;
+  }
+
+  if (!jsonFile.empty())
+  {
+    ofstream f(jsonFile);
+    lastCounters.WriteJSON(f);
+  }
+
+  return 0;
+}
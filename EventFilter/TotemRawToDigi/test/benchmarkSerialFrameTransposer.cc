@@ -0,0 +1,103 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/SerialFrameTransposer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkSerialFrameTransposer [option]\n");
+  printf("Measures the rate of VFAT frames rebuilt from serial OptoRx data by each transposer.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of GOH blocks per repetition (default 10000)\n");
+  printf("    -r <number>     number of repetitions (default 20)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int blocks = 10000;
+  unsigned int repetitions = 20;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { blocks = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) { repetitions = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // random input: each block of 192 words holds 4 GOH blocks (columns)
+  mt19937_64 rng(1);
+  vector<uint64_t> input(192 * blocks);
+  for (auto &w : input)
+    w = rng();
+
+  vector<VFATFrame::word> output(16 * 12 * blocks);
+
+  printf("%-8s %12s %12s %10s\n", "impl", "frames", "time (s)", "Mframes/s");
+
+  for (SerialFrameTransposer::Implementation impl : { SerialFrameTransposer::iBitwise, SerialFrameTransposer::iScalar,
+    SerialFrameTransposer::iSSE2, SerialFrameTransposer::iAVX2 })
+  {
+    const char *name = SerialFrameTransposer::GetName(impl);
+    if (!SerialFrameTransposer::IsAvailable(impl))
+    {
+      printf("%-8s not available\n", name);
+      continue;
+    }
+
+    SerialFrameTransposer transposer(impl);
+
+    uint64_t checksum = 0;
+    auto start = chrono::steady_clock::now();
+
+    for (unsigned int rep = 0; rep < repetitions; ++rep)
+    {
+      memset(output.data(), 0, output.size() * sizeof(VFATFrame::word));
+
+      for (unsigned int b = 0; b < blocks; ++b)
+      {
+        VFATFrame::word *ptrs[16];
+        for (unsigned int idx = 0; idx < 16; ++idx)
+          ptrs[idx] = output.data() + 12 * (16 * b + idx);
+
+        transposer.Transpose(input.data() + 192 * b, rep % 4, ptrs);
+      }
+
+      checksum += output[rep % output.size()];
+    }
+
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double frames = 16. * blocks * repetitions;
+
+    printf("%-8s %12.0f %12.3f %10.2f   (checksum %llu)\n", name, frames, time, frames / time / 1E6,
+      (unsigned long long) checksum);
+  }
+
+  return 0;
+}
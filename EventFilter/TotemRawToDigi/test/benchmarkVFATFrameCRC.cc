@@ -0,0 +1,101 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+#include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkVFATFrameCRC [option]\n");
+  printf("Measures the rate of VFAT frame CRC calculations for each implementation.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of frames (default 100000)\n");
+  printf("    -r <number>     number of repetitions (default 50)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int frames = 100000;
+  unsigned int repetitions = 50;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { frames = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) { repetitions = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  mt19937 rng(1);
+  vector<VFATFrame::word> data(12 * frames);
+  for (auto &w : data)
+    w = rng();
+
+  // a collection of the size of a typical event (all RP VFATs)
+  SimpleVFATFrameCollection coll;
+  for (unsigned int idx = 0; idx < 240 * 4; ++idx)
+    coll.Insert(TotemFramePosition(0, 0, 578 + idx / 256, (idx / 16) % 16, idx % 16), VFATFrame(&data[12 * idx]));
+
+  printf("%-8s %12s %10s %12s %14s\n", "impl", "frames", "time (s)", "Mframes/s", "batch Mframes/s");
+
+  for (VFATFrameCRC::Implementation impl : { VFATFrameCRC::iBitwise, VFATFrameCRC::iTable, VFATFrameCRC::iSliceBy4,
+    VFATFrameCRC::iPCLMUL })
+  {
+    const char *name = VFATFrameCRC::GetName(impl);
+    if (!VFATFrameCRC::IsAvailable(impl))
+    {
+      printf("%-8s not available\n", name);
+      continue;
+    }
+
+    const VFATFrameCRC crc(impl);
+
+    // plain calculation
+    unsigned long long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int rep = 0; rep < repetitions; ++rep)
+      for (unsigned int f = 0; f < frames; ++f)
+        checksum += crc.Calculate(&data[12 * f]);
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // batch check of a collection
+    unsigned int failed = 0;
+    const unsigned int batchRepetitions = max(1u, repetitions * frames / coll.Size() / 10);
+    auto batchStart = chrono::steady_clock::now();
+    for (unsigned int rep = 0; rep < batchRepetitions; ++rep)
+      failed += crc.Check(coll);
+    double batchTime = chrono::duration<double>(chrono::steady_clock::now() - batchStart).count();
+
+    double n = double(frames) * repetitions;
+    printf("%-8s %12.0f %10.3f %12.2f %14.2f   (checksum %llu, failed %u)\n", name, n, time, n / time / 1E6,
+      double(coll.Size()) * batchRepetitions / batchTime / 1E6, checksum, failed);
+  }
+
+  return 0;
+}
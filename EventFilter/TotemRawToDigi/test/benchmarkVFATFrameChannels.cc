@@ -0,0 +1,268 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDRawData.h"
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+
+#include "EventFilter/TotemRawToDigi/test/OptoRxFrameBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former VFATFrame::getActiveChannels: bit by bit, to a new vector
+vector<unsigned char> LegacyActiveChannels(const VFATFrame::word *data)
+{
+  vector<unsigned char> channels;
+
+  for (int i = 0; i < 8; i++)
+  {
+    if (!data[1 + i])
+      continue;
+
+    VFATFrame::word mask;
+    char offset;
+    for (mask = 1 << 15, offset = 15; mask; mask >>= 1, offset--)
+    {
+      if (data[1 + i] & mask)
+        channels.push_back( i * 16 + offset );
+    }
+  }
+
+  return channels;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former cluster decoding in RawDataUnpacker: channel by channel
+void LegacyDecodeClusters(const vector<uint16_t> &clusters, VFATFrame::word *fd)
+{
+  for (const auto &w : clusters)
+  {
+    unsigned int clSize = (w >> 8) & 0x7F;
+    unsigned int clPos = w & 0xFF;
+    if (clSize == 0)
+      clSize = 128;
+
+    signed int chMax = clPos;
+    signed int chMin = clPos - clSize + 1;
+    if (chMax < 0 || chMax > 127 || chMin < 0 || chMin > 127 || chMin > chMax)
+      continue;
+
+    for (signed int ch = chMin; ch <= chMax; ch++)
+      fd[ch / 16 + 1] |= (1 << (ch % 16));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void DecodeClusters(const vector<uint16_t> &clusters, VFATFrame &f)
+{
+  uint32_t bitmap[VFATFrame::bitmapWords] = { 0, 0, 0, 0 };
+
+  for (const auto &w : clusters)
+  {
+    unsigned int clSize = (w >> 8) & 0x7F;
+    unsigned int clPos = w & 0xFF;
+    if (clSize == 0)
+      clSize = 128;
+
+    if (clPos > 127 || clSize > clPos + 1)
+      continue;
+
+    VFATFrame::setChannelRange(bitmap, clPos - clSize + 1, clPos);
+  }
+
+  f.setActiveChannelBitmap(bitmap);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkVFATFrameChannels [option]\n");
+  printf("Compares the bitmap-based active-channel extraction and cluster decoding with the former\n");
+  printf("channel-by-channel loops and measures the unpacking rate of cluster-mode data\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of frames per test (default 1000000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 1000000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  mt19937_64 rng(1);
+  uniform_real_distribution<double> uni(0., 1.);
+  const unsigned int poolSize = 1024;
+
+  bool ok = true;
+
+  // active-channel extraction
+  printf("active channels\n");
+  printf("%10s %16s %16s %16s\n", "occupancy", "legacy (Mfr/s)", "buffer (Mfr/s)", "bitmap (Mfr/s)");
+
+  for (double occupancy : { 0.01, 0.05, 0.2, 0.5 })
+  {
+    vector<VFATFrame> pool(poolSize);
+    for (auto &f : pool)
+    {
+      VFATFrame::word *d = f.getData();
+      for (unsigned int i = 1; i <= 8; ++i)
+        for (unsigned int b = 0; b < 16; ++b)
+          if (uni(rng) < occupancy)
+            d[i] |= (1 << b);
+    }
+
+    unsigned long sumLegacy = 0, sumBuffer = 0, sumBitmap = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      for (auto ch : LegacyActiveChannels(pool[i % poolSize].getData()))
+        sumLegacy += ch;
+    const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    unsigned char buffer[128];
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      const unsigned int nCh = pool[i % poolSize].getActiveChannels(buffer);
+      for (unsigned int j = 0; j < nCh; ++j)
+        sumBuffer += buffer[j];
+    }
+    const double bufferTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      uint32_t bitmap[VFATFrame::bitmapWords];
+      pool[i % poolSize].getActiveChannelBitmap(bitmap);
+      VFATFrame::forEachActiveChannel(bitmap, [&] (unsigned int ch) { sumBitmap += ch; });
+    }
+    const double bitmapTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%10.2f %16.2f %16.2f %16.2f\n", occupancy, n / legacyTime / 1E6, n / bufferTime / 1E6,
+      n / bitmapTime / 1E6);
+
+    if (sumLegacy != sumBuffer || sumLegacy != sumBitmap)
+    {
+      printf("ERROR: different channels found.\n");
+      ok = false;
+    }
+  }
+
+  // cluster decoding
+  printf("\ncluster decoding\n");
+  printf("%10s %10s %16s %16s\n", "clusters", "size", "legacy (Mfr/s)", "bitmap (Mfr/s)");
+
+  for (unsigned int nClusters : { 1, 4, 10 })
+  {
+    for (unsigned int maxSize : { 2, 8, 32 })
+    {
+      vector<vector<uint16_t>> pool(poolSize);
+      for (auto &clusters : pool)
+      {
+        for (unsigned int c = 0; c < nClusters; ++c)
+        {
+          const unsigned int pos = rng() % 128;
+          const unsigned int size = 1 + rng() % min(maxSize, pos + 1);
+          clusters.push_back((size << 8) | pos);
+        }
+      }
+
+      uint64_t digestLegacy = 0, digestBitmap = 0;
+
+      auto start = chrono::steady_clock::now();
+      VFATFrame f;
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        VFATFrame::word *fd = f.getData();
+        memset(fd + 1, 0, 8 * sizeof(VFATFrame::word));
+        LegacyDecodeClusters(pool[i % poolSize], fd);
+        for (unsigned int j = 1; j <= 8; ++j)
+          digestLegacy = digestLegacy * 31 + fd[j];
+      }
+      const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      start = chrono::steady_clock::now();
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        DecodeClusters(pool[i % poolSize], f);
+        const VFATFrame::word *fd = f.getData();
+        for (unsigned int j = 1; j <= 8; ++j)
+          digestBitmap = digestBitmap * 31 + fd[j];
+      }
+      const double bitmapTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      printf("%10u %10u %16.2f %16.2f\n", nClusters, maxSize, n / legacyTime / 1E6, n / bitmapTime / 1E6);
+
+      if (digestLegacy != digestBitmap)
+      {
+        printf("ERROR: different channels decoded.\n");
+        ok = false;
+      }
+    }
+  }
+
+  // unpacking of whole OptoRx frames (parallel format, half of the blocks in cluster mode)
+  printf("\nunpacking\n");
+  printf("%10s %16s\n", "occupancy", "rate (Mfr/s)");
+
+  for (double occupancy : { 0.01, 0.05, 0.2 })
+  {
+    const unsigned int framePoolSize = 16;
+    vector<FEDRawData> framePool(framePoolSize);
+    for (auto &data : framePool)
+      OptoRxFrameBuilder::MakeParallel(0x123, 0.5, occupancy, rng, data);
+
+    RawDataUnpacker unpacker;
+    FlatVFATFrameCollection coll;
+    vector<TotemFEDInfo> fedInfo;
+
+    unsigned long frames = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; frames < n; ++i)
+    {
+      coll.Clear();
+      fedInfo.clear();
+      unpacker.Run(578, framePool[i % framePoolSize], fedInfo, coll);
+      frames += coll.Size();
+    }
+    const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%10.2f %16.2f\n", occupancy, frames / time / 1E6);
+  }
+
+  return (ok) ? 0 : 2;
+}
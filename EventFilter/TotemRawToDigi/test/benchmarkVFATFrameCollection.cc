@@ -0,0 +1,136 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+
+#include "EventFilter/TotemRawToDigi/test/OptoRxFrameBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// what the converter does with the collection: one pass over all frames
+unsigned long Consume(const VFATFrameCollection &coll)
+{
+  unsigned long sum = 0;
+  for (VFATFrameCollection::Iterator fr(&coll); !fr.IsEnd(); fr.Next())
+    sum += fr.Position().getRawPosition() + fr.Data()->getBC();
+
+  return sum;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkVFATFrameCollection [option]\n");
+  printf("Compares SimpleVFATFrameCollection (created for each event) with FlatVFATFrameCollection (reused)\n");
+  printf("on unpacking and iteration of full-detector events (4 FEDs).\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -e <number>     number of events (default 20000)\n");
+  printf("    -f <fraction>   fraction of (GOH, fiber) channels with a VFAT frame, parallel format (default 0.25)\n");
+  printf("    -s              use the serial format (all 12 GOHs active) instead of the parallel one\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 20000;
+  double fraction = 0.25;
+  bool serial = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fraction = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-s") == 0) { serial = true; continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // a pool of different events
+  mt19937_64 rng(7);
+  const unsigned int poolSize = 100;
+  vector<vector<FEDRawData>> pool(poolSize);
+  for (auto &ev : pool)
+  {
+    for (unsigned int fedId = 578; fedId <= 581; ++fedId)
+    {
+      ev.push_back(FEDRawData());
+      if (serial)
+        OptoRxFrameBuilder::MakeSerial(fedId, 3, 0xFFF, rng, ev.back());
+      else
+        OptoRxFrameBuilder::MakeParallel(fedId, fraction, 0.01, rng, ev.back());
+    }
+  }
+
+  RawDataUnpacker unpacker;
+
+  printf("%-8s %10s %12s %10s %12s\n", "coll", "events", "frames/ev", "time (s)", "events/s");
+
+  unsigned long refSum = 0;
+  for (unsigned int m = 0; m < 2; ++m)
+  {
+    unsigned long sum = 0, frames = 0;
+    FlatVFATFrameCollection flat;
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int e = 0; e < events; ++e)
+    {
+      const vector<FEDRawData> &ev = pool[e % poolSize];
+      vector<TotemFEDInfo> fedInfo;
+
+      if (m == 0)
+      {
+        SimpleVFATFrameCollection simple;
+        for (unsigned int i = 0; i < ev.size(); ++i)
+          unpacker.Run(578 + i, ev[i], fedInfo, simple);
+        sum += Consume(simple);
+        frames += simple.Size();
+      } else {
+        flat.Clear();
+        for (unsigned int i = 0; i < ev.size(); ++i)
+          unpacker.Run(578 + i, ev[i], fedInfo, flat);
+        sum += Consume(flat);
+        frames += flat.Size();
+      }
+    }
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%-8s %10u %12.1f %10.3f %12.1f\n", (m == 0) ? "simple" : "flat", events, double(frames) / events, time,
+      events / time);
+
+    if (m == 0)
+      refSum = sum;
+    else if (sum != refSum)
+    {
+      printf("ERROR: the collections gave different results.\n");
+      return 2;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+
+#include "EventFilter/TotemRawToDigi/test/OptoRxFrameBuilder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+bool Equal(const VFATFrame &a, const VFATFrame &b)
+{
+  return memcmp(a.getData(), b.getData(), 12 * sizeof(VFATFrame::word)) == 0
+    && a.isBCPresent() == b.isBCPresent() && a.isECPresent() == b.isECPresent() && a.isIDPresent() == b.isIDPresent()
+    && a.isCRCPresent() == b.isCRCPresent() && a.isNumberOfClustersPresent() == b.isNumberOfClustersPresent()
+    && a.getDAQErrorFlags() == b.getDAQErrorFlags() && a.getNumberOfClusters() == b.getNumberOfClusters();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// compares size, iteration sequence and frame content of the two collections
+bool Compare(const SimpleVFATFrameCollection &s, const FlatVFATFrameCollection &f, const char *test)
+{
+  if (s.Size() != f.Size() || s.Empty() != f.Empty())
+  {
+    printf("ERROR in %s: sizes differ (%u vs %u).\n", test, s.Size(), f.Size());
+    return false;
+  }
+
+  VFATFrameCollection::Iterator si(&s), fi(&f);
+  for (; !si.IsEnd() && !fi.IsEnd(); si.Next(), fi.Next())
+  {
+    if (!(si.Position() == fi.Position()) || !Equal(*si.Data(), *fi.Data()))
+    {
+      printf("ERROR in %s: frames differ at position %x.\n", test, si.Position().getRawPosition());
+      return false;
+    }
+
+    if (f.GetFrameByIndex(si.Position()) != fi.Data())
+    {
+      printf("ERROR in %s: GetFrameByIndex fails at position %x.\n", test, si.Position().getRawPosition());
+      return false;
+    }
+  }
+
+  if (!si.IsEnd() || !fi.IsEnd())
+  {
+    printf("ERROR in %s: iteration lengths differ.\n", test);
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  mt19937_64 rng(99);
+  int failures = 0;
+
+  // one flat collection reused for all tests
+  FlatVFATFrameCollection flat;
+
+  // random insertions, including repeated positions and unusual FED numbers
+  for (unsigned int trial = 0; trial < 200; ++trial)
+  {
+    SimpleVFATFrameCollection simple;
+    flat.Clear();
+
+    const unsigned int n = rng() % 600;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      unsigned int fed = (rng() % 10 == 0) ? rng() % 4096 : 578 + rng() % 4;
+      TotemFramePosition fp(0, 0, fed, rng() % 16, rng() % 16);
+
+      VFATFrame::word d[12];
+      for (auto &w : d)
+        w = rng();
+      VFATFrame fr(d);
+      fr.setPresenceFlags(rng() & 0x1F);
+
+      if (rng() % 2)
+      {
+        simple.Insert(fp, fr);
+        flat.Insert(fp, fr);
+      } else {
+        unsigned int wi = rng() % 12;
+        simple.InsertEmptyFrame(fp)->getData()[wi] |= d[0];
+        flat.InsertEmptyFrame(fp)->getData()[wi] |= d[0];
+      }
+    }
+
+    if (!Compare(simple, flat, "random insertions"))
+      failures++;
+
+    // look-ups of (mostly) absent positions
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+      TotemFramePosition fp(0, 0, 578 + rng() % 4, rng() % 16, rng() % 16);
+      if ((simple.GetFrameByIndex(fp) == NULL) != (flat.GetFrameByIndex(fp) == NULL))
+      {
+        printf("ERROR: GetFrameByIndex differs for position %x.\n", fp.getRawPosition());
+        failures++;
+      }
+    }
+  }
+
+  // unpacking of serial and parallel frames
+  RawDataUnpacker unpacker;
+  for (unsigned int trial = 0; trial < 50; ++trial)
+  {
+    SimpleVFATFrameCollection simple;
+    flat.Clear();
+
+    vector<TotemFEDInfo> simpleInfo, flatInfo;
+
+    for (unsigned int fedId = 578; fedId <= 581; ++fedId)
+    {
+      FEDRawData data;
+      if (fedId % 2 == 0)
+        OptoRxFrameBuilder::MakeSerial(fedId, 3, rng() & 0xFFF, rng, data);
+      else
+        OptoRxFrameBuilder::MakeParallel(fedId, 0.5, 0.02, rng, data);
+
+      unpacker.Run(fedId, data, simpleInfo, simple);
+      unpacker.Run(fedId, data, flatInfo, flat);
+    }
+
+    if (simple.Empty() || !Compare(simple, flat, "unpacking"))
+      failures++;
+  }
+
+  // merging of per-FED collections (as in the parallel unpacking)
+  FlatVFATFrameCollection part;
+  for (unsigned int trial = 0; trial < 50; ++trial)
+  {
+    SimpleVFATFrameCollection simple;
+    flat.Clear();
+
+    for (unsigned int fedId = 578; fedId <= 585; ++fedId)
+    {
+      FEDRawData data;
+      OptoRxFrameBuilder::MakeParallel(fedId, (fedId % 3 == 0) ? 0. : 0.3, 0.02, rng, data);
+
+      vector<TotemFEDInfo> fedInfo;
+      unpacker.Run(fedId, data, fedInfo, simple);
+
+      part.Clear();
+      unpacker.Run(fedId, data, fedInfo, part);
+      flat.Insert(part);
+    }
+
+    if (!Compare(simple, flat, "merging"))
+      failures++;
+  }
+
+  if (failures > 0)
+  {
+    printf("%i failures\n", failures);
+    return 1;
+  }
+
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/SerialFrameTransposer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Compares all implementations available on this CPU with the bitwise (reference) one, on random
+ * GOH blocks of various bit densities, for all 4 columns.
+ **/
+int main()
+{
+  mt19937_64 rng(12345);
+
+  const SerialFrameTransposer reference(SerialFrameTransposer::iBitwise);
+
+  int failures = 0;
+
+  for (SerialFrameTransposer::Implementation impl : { SerialFrameTransposer::iScalar, SerialFrameTransposer::iSSE2,
+    SerialFrameTransposer::iAVX2 })
+  {
+    const char *name = SerialFrameTransposer::GetName(impl);
+
+    if (!SerialFrameTransposer::IsAvailable(impl))
+    {
+      printf("%-8s not available, skipped\n", name);
+      continue;
+    }
+
+    SerialFrameTransposer transposer(impl);
+
+    unsigned int tests = 0;
+    for (unsigned int trial = 0; trial < 2000; ++trial)
+    {
+      // random words, the density changes from trial to trial (all 0, all 1, sparse, dense, ...)
+      uint64_t buf[192];
+      for (unsigned int i = 0; i < 192; ++i)
+      {
+        switch (trial % 5)
+        {
+          case 0: buf[i] = 0; break;
+          case 1: buf[i] = ~0ULL; break;
+          case 2: buf[i] = rng() & rng() & rng(); break;
+          case 3: buf[i] = rng() | rng(); break;
+          default: buf[i] = rng(); break;
+        }
+      }
+
+      for (unsigned int c = 0; c < 4; ++c)
+      {
+        // the frames may already contain data (the same frame position inserted twice)
+        VFATFrame::word refData[16][12], data[16][12];
+        VFATFrame::word *refPtrs[16], *ptrs[16];
+        for (unsigned int idx = 0; idx < 16; ++idx)
+        {
+          for (unsigned int w = 0; w < 12; ++w)
+            refData[idx][w] = data[idx][w] = (trial % 7 == 0) ? rng() : 0;
+
+          refPtrs[idx] = refData[idx];
+          ptrs[idx] = data[idx];
+        }
+
+        reference.Transpose(buf, c, refPtrs);
+        transposer.Transpose(buf, c, ptrs);
+
+        tests++;
+
+        if (memcmp(refData, data, sizeof(data)) != 0)
+        {
+          if (failures < 10)
+            printf("ERROR: %s differs from bitwise (trial %u, column %u).\n", name, trial, c);
+          failures++;
+        }
+      }
+    }
+
+    printf("%-8s %u blocks compared\n", name, tests);
+  }
+
+  if (failures > 0)
+  {
+    printf("%i failures\n", failures);
+    return 1;
+  }
+
+  return 0;
+}
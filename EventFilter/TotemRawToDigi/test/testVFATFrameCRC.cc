@@ -0,0 +1,167 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+#include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
+
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+int failures = 0;
+
+void Fail(const char *impl, const char *test, const VFATFrame::word *data)
+{
+  if (failures < 10)
+  {
+    printf("ERROR: %s, %s: ", impl, test);
+    for (int i = 11; i >= 0; i--)
+      printf("%04x ", data[i]);
+    printf("\n");
+  }
+
+  failures++;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// makes a frame as sent by a VFAT: footprints, counters, ID, a few active channels and a valid CRC
+VFATFrame MakeRealisticFrame(mt19937 &rng)
+{
+  VFATFrame f;
+  VFATFrame::word *d = f.getData();
+
+  d[11] = 0xA000 | (rng() & 0x0FFF);  // BC
+  d[10] = 0xC000 | (rng() & 0x0FFF);  // EC, flags
+  d[9] = 0xE000 | (rng() & 0x0FFF);   // ID
+
+  const unsigned int hits = rng() % 8;
+  for (unsigned int h = 0; h < hits; ++h)
+  {
+    unsigned int ch = rng() % 128;
+    d[1 + ch / 16] |= (1 << (ch % 16));
+  }
+
+  d[0] = VFATFrameCRC(VFATFrameCRC::iBitwise).Calculate(d);
+
+  return f;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  mt19937 rng(4321);
+
+  const VFATFrameCRC reference(VFATFrameCRC::iBitwise);
+
+  for (VFATFrameCRC::Implementation impl : { VFATFrameCRC::iTable, VFATFrameCRC::iSliceBy4, VFATFrameCRC::iPCLMUL })
+  {
+    const char *name = VFATFrameCRC::GetName(impl);
+
+    if (!VFATFrameCRC::IsAvailable(impl))
+    {
+      printf("%-8s not available, skipped\n", name);
+      continue;
+    }
+
+    const VFATFrameCRC crc(impl);
+
+    // random frames
+    for (unsigned int i = 0; i < 100000; ++i)
+    {
+      VFATFrame::word d[12];
+      for (auto &w : d)
+        w = rng();
+
+      if (crc.Calculate(d) != reference.Calculate(d))
+        Fail(name, "random frame", d);
+    }
+
+    // all values of each word, the others zero
+    for (unsigned int wi = 1; wi < 12; ++wi)
+    {
+      for (unsigned int v = 0; v < 0x10000; ++v)
+      {
+        VFATFrame::word d[12] = { 0 };
+        d[wi] = v;
+
+        if (crc.Calculate(d) != reference.Calculate(d))
+          Fail(name, "single word", d);
+      }
+    }
+
+    // realistic frames: valid as made, invalid with any single bit flipped
+    for (unsigned int i = 0; i < 1000; ++i)
+    {
+      VFATFrame f = MakeRealisticFrame(rng);
+      VFATFrame::word *d = f.getData();
+
+      if (crc.Calculate(d) != d[0])
+        Fail(name, "realistic frame", d);
+
+      unsigned int bit = rng() % (12 * 16);
+      d[bit / 16] ^= (1 << (bit % 16));
+
+      if (crc.Calculate(d) == d[0])
+        Fail(name, "realistic frame, bit flip", d);
+    }
+
+    printf("%-8s checked\n", name);
+  }
+
+  // VFATFrame::checkCRC and the batch check
+  SimpleVFATFrameCollection coll;
+  vector<TotemFramePosition> expected;
+  for (unsigned int idx = 0; idx < 1000; ++idx)
+  {
+    TotemFramePosition fp(0, 0, 578 + idx / 256, (idx / 16) % 16, idx % 16);
+    VFATFrame f = MakeRealisticFrame(rng);
+
+    bool corrupt = false;
+    switch (idx % 10)
+    {
+      case 1: f.getData()[3] ^= 0x0100; corrupt = true; break;
+      case 2: f.setDAQErrorFlags(1); corrupt = true; break;
+      case 3: f.getData()[0] ^= 0x0001; f.setPresenceFlags(0x7); break;   // CRC not present, not checked
+    }
+
+    if (f.checkCRC() == corrupt)
+      Fail("default", "checkCRC", f.getData());
+
+    if (corrupt)
+      expected.push_back(fp);
+
+    coll.Insert(fp, f);
+  }
+
+  for (VFATFrameCRC::Implementation impl : { VFATFrameCRC::iBitwise, VFATFrameCRC::iAuto })
+  {
+    vector<TotemFramePosition> failed;
+    unsigned int n = VFATFrameCRC(impl).Check(coll, &failed);
+    if (n != expected.size() || failed != expected)
+    {
+      printf("ERROR: batch check with %s found %u failed frames, %lu expected.\n", VFATFrameCRC::GetName(impl), n,
+        (unsigned long) expected.size());
+      failures++;
+    }
+  }
+
+  printf("default implementation: %s\n", VFATFrameCRC::GetName(VFATFrameCRC::GetDefault().GetImplementation()));
+
+  if (failures > 0)
+  {
+    printf("%i failures\n", failures);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,317 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiErrorCounters.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// active channels as found by the original VFATFrame::getActiveChannels: the channel words in ascending
+/// order, bits within a word from the highest one; the order is kept in the digi collections
+vector<unsigned char> ReferenceChannels(const VFATFrame &f)
+{
+  const VFATFrame::word *data = f.getData();
+  vector<unsigned char> channels;
+
+  for (int i = 0; i < 8; i++)
+  {
+    if (!data[1 + i])
+      continue;
+
+    VFATFrame::word mask;
+    char offset;
+    for (mask = 1 << 15, offset = 15; mask; mask >>= 1, offset--)
+    {
+      if (data[1 + i] & mask)
+        channels.push_back( i * 16 + offset );
+    }
+  }
+
+  return channels;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// compares all ways of getting the active channels with the reference
+bool TestFrame(const VFATFrame &f)
+{
+  const vector<unsigned char> reference = ReferenceChannels(f);
+
+  if (f.getActiveChannels() != reference)
+    return false;
+
+  unsigned char buffer[128];
+  const unsigned int n = f.getActiveChannels(buffer);
+  if (vector<unsigned char>(buffer, buffer + n) != reference)
+    return false;
+
+  if (f.getNumberOfActiveChannels() != reference.size())
+    return false;
+
+  uint32_t bitmap[VFATFrame::bitmapWords];
+  f.getActiveChannelBitmap(bitmap);
+
+  vector<unsigned char> fromBitmap;
+  VFATFrame::forEachActiveChannel(bitmap, [&] (unsigned int ch) { fromBitmap.push_back(ch); });
+  if (fromBitmap != reference)
+    return false;
+
+  // round trip
+  VFATFrame g;
+  g.setActiveChannelBitmap(bitmap);
+  if (memcmp(g.getData() + 1, f.getData() + 1, 8 * sizeof(VFATFrame::word)) != 0)
+    return false;
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  mt19937_64 rng(14);
+  uniform_real_distribution<double> uni(0., 1.);
+  int failures = 0;
+
+  // frames with different occupancies, including empty and full ones
+  for (unsigned int trial = 0; trial < 5000; ++trial)
+  {
+    const double occupancy = (trial % 10) / 9.;
+
+    VFATFrame f;
+    VFATFrame::word *d = f.getData();
+    for (unsigned int i = 0; i < 12; ++i)
+      d[i] = rng();
+    for (unsigned int i = 1; i <= 8; ++i)
+    {
+      d[i] = 0;
+      for (unsigned int b = 0; b < 16; ++b)
+        if (uni(rng) < occupancy)
+          d[i] |= (1 << b);
+    }
+
+    if (!TestFrame(f))
+    {
+      printf("ERROR: active channels differ in trial %u.\n", trial);
+      failures++;
+      break;
+    }
+  }
+
+  // all channel ranges
+  for (unsigned int chMin = 0; chMin < 128; ++chMin)
+  {
+    for (unsigned int chMax = chMin; chMax < 128; ++chMax)
+    {
+      uint32_t bitmap[VFATFrame::bitmapWords] = { 0, 0, 0, 0 };
+      VFATFrame::setChannelRange(bitmap, chMin, chMax);
+
+      for (unsigned int ch = 0; ch < 128; ++ch)
+      {
+        const bool expected = (ch >= chMin && ch <= chMax);
+        if (((bitmap[ch / 32] >> (ch % 32)) & 1) != expected)
+        {
+          printf("ERROR: setChannelRange(%u, %u) wrong at channel %u.\n", chMin, chMax, ch);
+          failures++;
+          chMin = chMax = 128;
+          break;
+        }
+      }
+    }
+  }
+
+  // cluster-mode blocks: random clusters, including full-chip, overlapping, invalid and number-of-clusters words
+  RawDataUnpacker unpacker;
+  FlatVFATFrameCollection frames;
+  RawToDigiErrorCounters counters;
+  unsigned long expectedInvalid = 0;
+
+  for (unsigned int trial = 0; trial < 5000; ++trial)
+  {
+    vector<uint16_t> block;
+    block.push_back((RawDataUnpacker::vmCluster << 8) | (trial % 256));
+    block.push_back(0xA000 | (rng() & 0xFFF));
+    block.push_back(0xC000 | (rng() & 0xFFF));
+    block.push_back(0xE000 | (rng() & 0xFFF));
+
+    bool expected[128] = { false };
+    unsigned int nClusters = rng() % 12;
+    for (unsigned int c = 0; c < nClusters; ++c)
+    {
+      const unsigned int type = rng() % 20;
+
+      if (type == 0)
+      {
+        block.push_back(0xD000 | (rng() % 0x100));
+        continue;
+      }
+
+      unsigned int pos = rng() % 128;
+      unsigned int size = 1 + rng() % 8;
+      if (type == 1)
+        size = 0;
+      if (type == 2)
+        pos = 128 + rng() % 112;
+
+      block.push_back((size << 8) | pos);
+
+      const unsigned int effSize = (size == 0) ? 128 : size;
+      if (pos > 127 || effSize > pos + 1)
+      {
+        expectedInvalid++;
+        continue;
+      }
+
+      for (unsigned int ch = pos + 1 - effSize; ch <= pos; ++ch)
+        expected[ch] = true;
+    }
+
+    block.push_back(0xF000 | (block.size() + 1));
+
+    frames.Clear();
+    unpacker.ProcessVFATDataParallel(block.data(), 0x123, &frames, &counters);
+
+    const VFATFrame *f = frames.GetFrameByIndex(TotemFramePosition(0, 0, 0x123, (trial % 256) >> 4, trial % 16));
+    if (!f)
+    {
+      printf("ERROR: cluster-mode frame not unpacked in trial %u.\n", trial);
+      failures++;
+      break;
+    }
+
+    bool match = TestFrame(*f);
+    for (unsigned int ch = 0; ch < 128; ++ch)
+      match &= (f->channelActive(ch) == expected[ch]);
+
+    if (!match)
+    {
+      printf("ERROR: cluster-mode channels differ in trial %u.\n", trial);
+      failures++;
+      break;
+    }
+  }
+
+  if (counters.GetTotal(RawToDigiErrorCounters::etInvalidCluster) != expectedInvalid)
+  {
+    printf("ERROR: %lu invalid clusters counted, %lu expected.\n",
+      counters.GetTotal(RawToDigiErrorCounters::etInvalidCluster), expectedInvalid);
+    failures++;
+  }
+
+  // digi order: RawToDigiConverter must give the digis of a chip in the order of the reference channels,
+  // with the masked channels left out; every VFAT is mapped to a different detector
+  {
+    edm::ParameterSet ps;
+    ps.addUntrackedParameter<unsigned int>("verbosity", 0);
+    ps.addUntrackedParameter<unsigned int>("printErrorSummary", 0);
+    ps.addUntrackedParameter<unsigned int>("printUnknownFrameSummary", 0);
+    ps.addParameter<unsigned int>("testFootprint", 2);
+    ps.addParameter<unsigned int>("testCRC", 0);
+    ps.addParameter<unsigned int>("testID", 2);
+    ps.addParameter<unsigned int>("testECMostFrequent", 0);
+    ps.addParameter<unsigned int>("testBCMostFrequent", 0);
+
+    const unsigned int nVFATs = 40;
+
+    TotemDAQMapping mapping;
+    TotemAnalysisMask mask;
+    for (unsigned int k = 0; k < nVFATs; ++k)
+    {
+      TotemVFATInfo info;
+      info.type = TotemVFATInfo::data;
+      info.symbolicID.subSystem = TotemSymbID::RP;
+      info.symbolicID.symbolicID = (1200 + k) * 10 + k % 4;
+      info.hwID = 0x100 + k;
+      mapping.insert(TotemFramePosition((578 << 8) | k), info);
+
+      // every 3rd VFAT partially masked
+      if (k % 3 == 0)
+      {
+        TotemVFATAnalysisMask am;
+        am.fullMask = false;
+        for (unsigned char ch = k; ch < 128; ch += 7)
+          am.maskedChannels.insert(ch);
+        mask.insert(info.symbolicID, am);
+      }
+    }
+
+    RawToDigiConverter converter(ps);
+    converter.SetMapping(mapping, mask);
+
+    bool orderOK = true;
+    for (unsigned int trial = 0; trial < 200 && orderOK; ++trial)
+    {
+      const double occupancy = (trial % 10) / 9.;
+
+      frames.Clear();
+      for (unsigned int k = 0; k < nVFATs; ++k)
+      {
+        VFATFrame *f = frames.InsertEmptyFrame(TotemFramePosition((578 << 8) | k));
+        VFATFrame::word *d = f->getData();
+        d[11] = 0xA000 | 0x123;
+        d[10] = 0xC000 | 0x45;
+        d[9] = 0xE000 | (0x100 + k);
+        for (unsigned int i = 1; i <= 8; ++i)
+        {
+          d[i] = 0;
+          for (unsigned int b = 0; b < 16; ++b)
+            if (uni(rng) < occupancy)
+              d[i] |= (1 << b);
+        }
+        f->setPresenceFlags(0x7);
+      }
+
+      edm::DetSetVector<TotemRPDigi> digi;
+      edm::DetSetVector<TotemVFATStatus> status;
+      converter.Run(frames, digi, status);
+
+      for (unsigned int k = 0; k < nVFATs; ++k)
+      {
+        const TotemSymbID &symbId = mapping.VFATMapping[TotemFramePosition((578 << 8) | k)].symbolicID;
+        const auto maskIt = mask.analysisMask.find(symbId);
+        const unsigned short offset = (k % 4) * 128;
+
+        vector<unsigned short> expected;
+        for (auto ch : ReferenceChannels(*frames.GetFrameByIndex(TotemFramePosition((578 << 8) | k))))
+          if (maskIt == mask.analysisMask.end() || maskIt->second.maskedChannels.count(ch) == 0)
+            expected.push_back(offset + ch);
+
+        vector<unsigned short> found;
+        auto dsIt = digi.find(TotemRPDetId::decToRawId(1200 + k));
+        if (dsIt != digi.end())
+          for (const auto &dg : *dsIt)
+            found.push_back(dg.getStripNumber());
+
+        if (found != expected)
+        {
+          printf("ERROR: digi order differs from the reference in trial %u, VFAT %u.\n", trial, k);
+          failures++;
+          orderOK = false;
+          break;
+        }
+      }
+    }
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
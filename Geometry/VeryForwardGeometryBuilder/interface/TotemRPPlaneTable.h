@@ -0,0 +1,91 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef Geometry_VeryForwardGeometryBuilder_TotemRPPlaneTable
+#define Geometry_VeryForwardGeometryBuilder_TotemRPPlaneTable
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include <vector>
+
+class TotemRPGeometry;
+
+/**
+ * \ingroup TotemRPGeometry
+ * \brief Flat table of the (global) plane data needed by the local reconstruction.
+ *
+ * Contiguous arrays of planes and RPs, indexed by the compact indices from TotemRPDetId::rawToPlaneIndex and
+ * rpIndex below. Built once per geometry IOV from TotemRPGeometry (produced by TotemRPGeometryESModule in
+ * the same record) and shared, read only, by all streams.
+ **/
+class TotemRPPlaneTable
+{
+  public:
+    struct Plane
+    {
+      double cx, cy, cz;    ///< centre in global coordinates, mm
+      double dx, dy;        ///< transverse part of the global readout direction, unit vector
+      double u0;            ///< -(d . c): the readout coordinate of the global origin, in mm
+      double s;             ///< centre projected to the (not normalised) transverse readout direction, in mm
+      bool available;       ///< whether the plane is in the geometry
+
+      Plane() : cx(0.), cy(0.), cz(0.), dx(0.), dy(0.), u0(0.), s(0.), available(false) {}
+    };
+
+    /// number of compact RP indices, see rpIndex
+    static const unsigned int numberOfRPIndices = TotemRPDetId::numberOfPlaneIndices / (TotemRPDetId::maxDet + 1);
+
+    /// conversion decimal RP ID (|arm|station|RP|) to compact RP index, gives numberOfRPIndices for invalid IDs
+    static unsigned int rpIndex(unsigned int rpDecId)
+    {
+      const unsigned int arm = rpDecId / 100, station = (rpDecId / 10) % 10, rp = rpDecId % 10;
+      if (arm > TotemRPDetId::maxArm || station > TotemRPDetId::maxStation || rp > TotemRPDetId::maxRP)
+        return numberOfRPIndices;
+
+      return (arm * (TotemRPDetId::maxStation + 1) + station) * (TotemRPDetId::maxRP + 1) + rp;
+    }
+
+    /// makes an empty table
+    TotemRPPlaneTable();
+
+    /// makes the table of all planes and RPs in the geometry
+    TotemRPPlaneTable(const TotemRPGeometry &geometry);
+
+    /// sets data of a plane, raw ID expected; the readout direction (dx, dy) needs not be normalised
+    void setPlane(unsigned int rawId, double cx, double cy, double cz, double dx, double dy);
+
+    /// sets the z position of a RP (of its box), decimal RP ID expected
+    void setRPZ0(unsigned int rpDecId, double z0);
+
+    /// returns the plane data, NULL if the plane is not available, raw ID expected
+    const Plane* getPlane(unsigned int rawId) const
+    {
+      const unsigned int idx = TotemRPDetId::rawToPlaneIndex(rawId);
+      return (idx < planes.size() && planes[idx].available) ? &planes[idx] : NULL;
+    }
+
+    /// returns the z position of a RP, decimal RP ID expected, throws if the RP is not available
+    double getRPZ0(unsigned int rpDecId) const;
+
+    /// memory taken by the table, in bytes
+    unsigned int size() const
+    {
+      return sizeof(*this) + planes.capacity() * sizeof(Plane) + rpZ0.capacity() * sizeof(double)
+        + rpAvailable.capacity() * sizeof(char);
+    }
+
+  protected:
+    /// plane data, indexed by compact plane index
+    std::vector<Plane> planes;
+
+    /// RP box z positions, indexed by compact RP index
+    std::vector<double> rpZ0;
+    std::vector<char> rpAvailable;
+};
+
+#endif
@@ -33,6 +33,7 @@
 #include "CondFormats/AlignmentRecord/interface/RPMisalignedAlignmentRecord.h"
 #include "Geometry/VeryForwardGeometryBuilder/interface/DetGeomDesc.h"
 #include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
 #include "DataFormats/CTPPSAlignment/interface/RPAlignmentCorrectionsData.h"
 #include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
 #include "Geometry/VeryForwardGeometryBuilder/interface/DDDTotemRPConstruction.h"
@@ -49,6 +50,8 @@
  * it applies alignment corrections (RPAlignmentCorrections) found in corresponding ...GeometryRecord.
  *
  * Second, it creates TotemRPGeometry from DetGeoDesc tree.
+ *
+ * Third, it creates the flat TotemRPPlaneTable from TotemRPGeometry.
  **/
 class  TotemRPGeometryESModule : public edm::ESProducer
 {
@@ -60,12 +63,15 @@ class  TotemRPGeometryESModule : public edm::ESProducer
 
     std::unique_ptr<DetGeomDesc> produceMeasuredGD(const VeryForwardMeasuredGeometryRecord &);
     std::unique_ptr<TotemRPGeometry> produceMeasuredTG(const VeryForwardMeasuredGeometryRecord &);
+    std::unique_ptr<TotemRPPlaneTable> produceMeasuredPT(const VeryForwardMeasuredGeometryRecord &);
 
     std::unique_ptr<DetGeomDesc> produceRealGD(const VeryForwardRealGeometryRecord &);
     std::unique_ptr<TotemRPGeometry> produceRealTG(const VeryForwardRealGeometryRecord &);
+    std::unique_ptr<TotemRPPlaneTable> produceRealPT(const VeryForwardRealGeometryRecord &);
 
     std::unique_ptr<DetGeomDesc> produceMisalignedGD(const VeryForwardMisalignedGeometryRecord &);
     std::unique_ptr<TotemRPGeometry> produceMisalignedTG(const VeryForwardMisalignedGeometryRecord &);
+    std::unique_ptr<TotemRPPlaneTable> produceMisalignedPT(const VeryForwardMisalignedGeometryRecord &);
 
   protected:
     unsigned int verbosity;
@@ -88,12 +94,15 @@ TotemRPGeometryESModule::TotemRPGeometryESModule(const edm::ParameterSet &p)
   setWhatProduced(this, &TotemRPGeometryESModule::produceMeasuredDDCV);
   setWhatProduced(this, &TotemRPGeometryESModule::produceMeasuredGD);
   setWhatProduced(this, &TotemRPGeometryESModule::produceMeasuredTG);
+  setWhatProduced(this, &TotemRPGeometryESModule::produceMeasuredPT);
 
   setWhatProduced(this, &TotemRPGeometryESModule::produceRealGD);
   setWhatProduced(this, &TotemRPGeometryESModule::produceRealTG);
+  setWhatProduced(this, &TotemRPGeometryESModule::produceRealPT);
 
   setWhatProduced(this, &TotemRPGeometryESModule::produceMisalignedGD);
   setWhatProduced(this, &TotemRPGeometryESModule::produceMisalignedTG);
+  setWhatProduced(this, &TotemRPGeometryESModule::produceMisalignedPT);
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -539,4 +548,34 @@ std::unique_ptr<TotemRPGeometry> TotemRPGeometryESModule::produceMisalignedTG(co
   return std::make_unique<TotemRPGeometry>( gD.product());
 }
 
+//----------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TotemRPPlaneTable> TotemRPGeometryESModule::produceMeasuredPT(const VeryForwardMeasuredGeometryRecord &iRecord)
+{
+  edm::ESHandle<TotemRPGeometry> geometry;
+  iRecord.get(geometry);
+
+  return std::make_unique<TotemRPPlaneTable>(*geometry);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TotemRPPlaneTable> TotemRPGeometryESModule::produceRealPT(const VeryForwardRealGeometryRecord &iRecord)
+{
+  edm::ESHandle<TotemRPGeometry> geometry;
+  iRecord.get(geometry);
+
+  return std::make_unique<TotemRPPlaneTable>(*geometry);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TotemRPPlaneTable> TotemRPGeometryESModule::produceMisalignedPT(const VeryForwardMisalignedGeometryRecord &iRecord)
+{
+  edm::ESHandle<TotemRPGeometry> geometry;
+  iRecord.get(geometry);
+
+  return std::make_unique<TotemRPPlaneTable>(*geometry);
+}
+
 DEFINE_FWK_EVENTSETUP_MODULE(TotemRPGeometryESModule);
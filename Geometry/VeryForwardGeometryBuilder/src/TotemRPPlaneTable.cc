@@ -0,0 +1,88 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPPlaneTable::TotemRPPlaneTable() :
+  planes(TotemRPDetId::numberOfPlaneIndices), rpZ0(numberOfRPIndices, 0.), rpAvailable(numberOfRPIndices, 0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPPlaneTable::TotemRPPlaneTable(const TotemRPGeometry &geometry) : TotemRPPlaneTable()
+{
+  for (auto it = geometry.beginDet(); it != geometry.endDet(); ++it)
+  {
+    const unsigned int rawId = it->first;
+
+    // the strip readout axis is the local y axis (see RPTopology)
+    double dx, dy;
+    geometry.GetReadoutDirection(rawId, dx, dy);
+
+    const CLHEP::Hep3Vector c = geometry.GetDetTranslation(rawId);
+
+    setPlane(rawId, c.x(), c.y(), c.z(), dx, dy);
+  }
+
+  for (auto it = geometry.beginRP(); it != geometry.endRP(); ++it)
+    setRPZ0(it->first, it->second->translation().z());
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPPlaneTable::setPlane(unsigned int rawId, double cx, double cy, double cz, double dx, double dy)
+{
+  const unsigned int idx = TotemRPDetId::rawToPlaneIndex(rawId);
+  if (idx >= planes.size())
+    throw cms::Exception("TotemRPPlaneTable") << "Invalid detector id " << rawId << ".";
+
+  Plane &p = planes[idx];
+  p.cx = cx;
+  p.cy = cy;
+  p.cz = cz;
+
+  const double n = sqrt(dx*dx + dy*dy);
+  p.dx = dx / n;
+  p.dy = dy / n;
+
+  p.u0 = - (p.dx * cx + p.dy * cy);
+  p.s = dx * cx + dy * cy;
+
+  p.available = true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPPlaneTable::setRPZ0(unsigned int rpDecId, double z0)
+{
+  const unsigned int idx = rpIndex(rpDecId);
+  if (idx >= rpZ0.size())
+    throw cms::Exception("TotemRPPlaneTable") << "Invalid RP id " << rpDecId << ".";
+
+  rpZ0[idx] = z0;
+  rpAvailable[idx] = 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+double TotemRPPlaneTable::getRPZ0(unsigned int rpDecId) const
+{
+  const unsigned int idx = rpIndex(rpDecId);
+  if (idx >= rpZ0.size() || !rpAvailable[idx])
+    throw cms::Exception("TotemRPPlaneTable") << "RP with ID " << rpDecId << " not found.";
+
+  return rpZ0[idx];
+}
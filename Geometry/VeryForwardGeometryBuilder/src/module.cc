@@ -10,8 +10,10 @@
 
 #include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
 #include "Geometry/VeryForwardGeometryBuilder/interface/DetGeomDesc.h"
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
 
 #include "DataFormats/DetId/interface/DetId.h"
 
 TYPELOOKUP_DATA_REG(TotemRPGeometry);
 TYPELOOKUP_DATA_REG(DetGeomDesc);
+TYPELOOKUP_DATA_REG(TotemRPPlaneTable);
@@ -12,13 +12,20 @@
 #include "DataFormats/Common/interface/DetSet.h"
 #include "DataFormats/Common/interface/DetSetVector.h"
 
-#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPRecHit.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPUVPattern.h"
 
+#include <limits>
+#include <vector>
+
 
 /**
  * \brief Class performing optimized hough transform to recognize lines.
+ *
+ * The points are kept as a structure of arrays, sorted by z. Points of a recognized line are masked, not
+ * searched for. The clusters of intersections are indexed by their centre in a, hence the cluster matching
+ * an intersection is found by binary search.
 **/
 
 class FastLineRecognition
@@ -26,17 +33,21 @@ class FastLineRecognition
   public:
     FastLineRecognition(double cw_a = 0., double cw_b = 0.);
 
-    ~FastLineRecognition();
+    virtual ~FastLineRecognition();
 
-    void resetGeometry(const TotemRPGeometry *_g)
-    {
-      geometry = _g;
-      geometryMap.clear();
-    }
+    /// sets the plane data (z and s of the planes) to use, to be called at every geometry change
+    void resetGeometry(const TotemRPPlaneTable *_t);
 
+    /// input of the recognition: DetSets (one per plane) of a hit collection, not copied
+    typedef std::vector<const edm::DetSet<TotemRPRecHit> *> InputView;
+
+    /// runs the recognition on all hits of the collection
     void getPatterns(const edm::DetSetVector<TotemRPRecHit> &input, double _z0, double threshold,
       edm::DetSet<TotemRPUVPattern> &patterns);
 
+    virtual void getPatterns(const InputView &input, double _z0, double threshold,
+      edm::DetSet<TotemRPUVPattern> &patterns);
+
   protected:
     /// the uncertainty of 1-hit cluster, in mm
     static const double sigma0;
@@ -50,33 +61,43 @@ class FastLineRecognition
     /// weight threshold for accepting pattern candidates (clusters)
     double threshold;
 
-    /// pointer to the geometry
-    const TotemRPGeometry* geometry;
+    /// pointer to the plane data
+    const TotemRPPlaneTable* planeTable;
 
-    struct GeomData
+    /// a hit from the input collection
+    struct Hit
     {
-      double z;   ///< z position of a sensor (wrt. IP)
-      double s;   ///< sensor's centre projected to its read-out direction
+      unsigned int detId;       ///< raw detector id
+      const TotemRPRecHit* hit; ///< pointer to original reco hit
     };
 
-    /// map: raw detector id --> GeomData
-    std::map<unsigned int, GeomData> geometryMap;
-
-    /// expects raw detector id
-    GeomData getGeomData(unsigned int id);
+    /// hits of the current input, in input order
+    std::vector<Hit> hits;
 
-    struct Point
+    /// points in the global coordinate system, sorted by z
+    struct Points
     {
-      unsigned int detId;       ///< raw detector id
-      const TotemRPRecHit* hit; ///< pointer to original reco hit
-      double h;                 ///< hit position in global coordinate system
-      double z;                 ///< z position with respect to z0
-      double w;                 ///< weight
-      bool usable;              ///< whether the point can still be used
-      Point(unsigned int _d=0, const TotemRPRecHit* _hit=NULL, double _h=0., double _z=0., double _w=0.) :
-        detId(_d), hit(_hit), h(_h), z(_z), w(_w), usable(true) {}
+      std::vector<double> z;              ///< z position with respect to z0
+      std::vector<double> h;              ///< hit position in global coordinate system
+      std::vector<double> w;              ///< weight
+      std::vector<unsigned char> used;    ///< whether the point has been assigned to a pattern
+      std::vector<unsigned int> hit;      ///< index of the originating hit in hits
+
+      unsigned int size() const { return z.size(); }
+
+      void clear()
+      {
+        z.clear(); h.clear(); w.clear(); used.clear(); hit.clear();
+      }
+
+      void push_back(double _z, double _h, double _w, unsigned int _hit)
+      {
+        z.push_back(_z); h.push_back(_h); w.push_back(_w); used.push_back(0); hit.push_back(_hit);
+      }
     };
-    
+
+    Points points;
+
     /// cluster of intersection points
     struct Cluster
     {
@@ -84,11 +105,18 @@ class FastLineRecognition
       double weight;
       double min_a, max_a, min_b, max_b;
 
-      std::vector<const Point *> contents;
-      
-      Cluster() : Saw(0.), Sbw(0.), Sw(0.), S1(0.), weight(0.) {}
-      
-      void add(const Point *p1, const Point *p2, double a, double b, double w);
+      /// cluster centre, Saw/Sw and Sbw/Sw
+      double c_a, c_b;
+
+      /// indices of the contributing points
+      std::vector<unsigned int> contents;
+
+      Cluster() : Saw(0.), Sbw(0.), Sw(0.), S1(0.), weight(0.),
+        min_a(std::numeric_limits<double>::max()), max_a(-std::numeric_limits<double>::max()),
+        min_b(std::numeric_limits<double>::max()), max_b(-std::numeric_limits<double>::max()),
+        c_a(0.), c_b(0.) {}
+
+      void add(unsigned int p1, unsigned int p2, double a, double b, double w);
 
       bool operator<(const Cluster &c) const
       {
@@ -96,10 +124,29 @@ class FastLineRecognition
       }
     };
 
+    /// clusters of the current search and their indices ordered by the cluster centre in a
+    std::vector<Cluster> clusters;
+    std::vector<unsigned int> clusterOrder;
+
+    /// buffer for the view of a full collection
+    InputView inputView;
+
+    /// builds collection of points in the global coordinate system
+    void getPoints(const InputView &input, double _z0);
+
+    /// converts cluster to pattern
+    void makePattern(const Cluster &c, TotemRPUVPattern &pattern) const;
+
+    /// finds the first (created) cluster compatible with intersection (a, b)
+    /// returns its position in clusterOrder, or -1
+    int findCluster(double a, double b) const;
+
+    /// moves the cluster at position pos in clusterOrder, after its update, to its new place
+    void updateClusterOrder(unsigned int pos);
+
     /// gets the most significant pattern in the (remaining) points
     /// returns true when a pattern was found
-    bool getOneLine(const std::vector<Point> &points, double threshold, Cluster &result);
+    bool getOneLine(double threshold, Cluster &result);
 };
 
 #endif
-
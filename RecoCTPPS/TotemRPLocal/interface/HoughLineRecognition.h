@@ -0,0 +1,84 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef RecoCTPPS_TotemRPLocal_HoughLineRecognition
+#define RecoCTPPS_TotemRPLocal_HoughLineRecognition
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
+
+#include <vector>
+
+/**
+ * \brief Line recognition with a binned Hough accumulator.
+ *
+ * Each point votes, for every bin in slope a, for the intercept b = h - z*a. The accumulator peak (the 2x2
+ * bin window with the highest weight) is refined by the weighted centroid of the window and, optionally,
+ * by re-binning a window around it with finer bins (zoomSteps times, zoomFactor finer each time). The
+ * points compatible with the peak line form a pattern, their votes are withdrawn and the next peak is
+ * processed. The pattern a, b and weight are calculated from the point pairs exactly as in
+ * FastLineRecognition and the patterns are ordered as there (decreasing weight), hence for well-separated
+ * tracks the two engines give identical output.
+ *
+ * The accumulator is filled once per call, (points x bins in a), and searched once per line, (bins in a x
+ * bins in b), instead of (points^2 x clusters) per line. Lines with |a| > max_a or |b| > max_b are not found.
+**/
+class HoughLineRecognition : public FastLineRecognition
+{
+  public:
+    HoughLineRecognition(double cw_a, double cw_b, const edm::ParameterSet &ps);
+
+    virtual ~HoughLineRecognition();
+
+    using FastLineRecognition::getPatterns;
+
+    virtual void getPatterns(const InputView &input, double _z0, double threshold,
+      edm::DetSet<TotemRPUVPattern> &patterns) override;
+
+  protected:
+    /// accumulator half ranges in a (rad) and b (mm)
+    double max_a, max_b;
+
+    /// (coarse) bin sizes in a (rad) and b (mm)
+    double bin_a, bin_b;
+
+    /// number of zoom iterations and the bin size reduction factor per iteration
+    unsigned int zoomSteps, zoomFactor;
+
+    struct Grid
+    {
+      double min_a, min_b;    ///< lower edges
+      double bin_a, bin_b;    ///< bin sizes
+      unsigned int n_a, n_b;  ///< numbers of bins
+    };
+
+    /// the coarse grid covering the full range
+    Grid coarseGrid;
+
+    /// accumulator contents, indexed by i_a * n_b + i_b, for the coarse and the zoom grids
+    std::vector<double> accumulator, zoomAccumulator;
+
+    /// adds the votes of point i, with the given weight
+    void vote(const Grid &g, unsigned int i, double w, std::vector<double> &acc) const;
+
+    /// fills the accumulator with the votes of the unused points
+    void fill(const Grid &g, std::vector<double> &acc) const;
+
+    /// finds the highest 2x2 window (lower bin indices i_a, i_b), returns its weight and sets the centroid (a, b)
+    double findPeak(const Grid &g, const std::vector<double> &acc, unsigned int &i_a, unsigned int &i_b,
+      double &a, double &b) const;
+
+    /// selects the unused points compatible with line (a, b), returns false unless they span 2 or more z
+    bool selectPoints(double a, double b, std::vector<unsigned int> &selected) const;
+
+    /// sums over the pairs of the selected points, as FastLineRecognition does for a cluster; returns its weight
+    double makeCluster(const std::vector<unsigned int> &selected, Cluster &c) const;
+};
+
+#endif
@@ -11,31 +11,56 @@
 #define RecoCTPPS_TotemRPLocal_TotemRPClusterProducerAlgorithm
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
-#include "SimDataFormats/TrackingHit/interface/PSimHit.h"
 
 #include "DataFormats/TotemDigi/interface/TotemRPDigi.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPCluster.h"
 
+#include <cstdint>
 #include <vector>
-#include <set>
 
+/**
+ * Merges neighbouring active strips of one plane into clusters.
+ *
+ * The strips are marked in a fixed bitmap of 512 bits and the clusters are read out as runs of set
+ * bits, 64 strips at a time with count-trailing-zeros. No memory is allocated per event. Up to
+ * maxGap inactive strips are allowed inside a cluster (0 = only contiguous strips). Clusters wider
+ * than maxWidth strips (0 = no limit) are split into consecutive pieces of at most maxWidth strips.
+ **/
 class TotemRPClusterProducerAlgorithm
 {
   public:
     TotemRPClusterProducerAlgorithm(const edm::ParameterSet& param);
 
     ~TotemRPClusterProducerAlgorithm();
-    
+
+    /// fills clusters (previous content is removed), returns the number of clusters
     int buildClusters(unsigned int detId, const std::vector<TotemRPDigi> &digi, std::vector<TotemRPCluster> &clusters);
-    
+
+    /// number of strips of an RP plane
+    static const unsigned int stripsPerPlane = 512;
+
   private:
-    typedef std::set<TotemRPDigi> TotemRPDigiSet;
+    static const unsigned int bitmapWords = stripsPerPlane / 64;
 
-    TotemRPDigiSet strip_digi_set_;  ///< input digi set, strip by strip
+    /// active strips
+    uint64_t bitmap_[bitmapWords];
 
     const edm::ParameterSet &param_;
 
     int verbosity_;
+
+    /// maximum number of inactive strips inside a cluster
+    unsigned int maxGap_;
+
+    /// maximum cluster width in strips, 0 = no limit
+    unsigned int maxWidth_;
+
+    /// finds the first strip >= from which is active (active = true) or inactive (active = false),
+    /// returns stripsPerPlane if there is none
+    unsigned int findNext(unsigned int from, bool active) const;
+
+    /// adds cluster [beg, end], split according to maxWidth_
+    void addCluster(unsigned int beg, unsigned int end, std::vector<TotemRPCluster> &clusters) const;
 };
 
 #endif
@@ -16,18 +16,21 @@
 #include "DataFormats/CTPPSReco/interface/TotemRPRecHit.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPLocalTrack.h"
 
-#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
-#include "Geometry/VeryForwardRPTopology/interface/RPTopology.h"
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
 
-#include "TVector3.h"
-#include "TVector2.h"
-
-#include <unordered_map>
+#include <vector>
 
 //----------------------------------------------------------------------------------------------------
 
 /**
  *\brief Algorithm for fitting tracks through a single RP.
+ *
+ * Two equivalent methods are available: "matrix" solves the least-squares problem with ROOT matrices,
+ * "cholesky" accumulates the 4x4 normal equations in fixed-size arrays and solves them by Cholesky
+ * decomposition, without any memory allocation.
+ *
+ * The plane data (centres, readout directions) are taken from TotemRPPlaneTable, the algorithm itself keeps no
+ * geometry cache.
  **/
 class TotemRPLocalTrackFitterAlgorithm
 {
@@ -35,39 +38,34 @@ class TotemRPLocalTrackFitterAlgorithm
     TotemRPLocalTrackFitterAlgorithm(const edm::ParameterSet &conf);
 
     /// performs the track fit, returns true if successful
-    bool fitTrack(const edm::DetSetVector<TotemRPRecHit> &hits, double z_0, const TotemRPGeometry &tot_geom, TotemRPLocalTrack &fitted_track);
-
-    /// Resets the reconstruction-data cache.
-    void reset();
+    bool fitTrack(const edm::DetSetVector<TotemRPRecHit> &hits, double z_0, const TotemRPPlaneTable &planes,
+      TotemRPLocalTrack &fitted_track);
 
   private:
-    struct RPDetCoordinateAlgebraObjs
+    enum FitMethod { fmMatrix, fmCholesky };
+
+    /// the method used by fitTrack
+    FitMethod fit_method_;
+
+    /// a hit bound with its plane data
+    struct HitWithPlane
     {
-      TVector3 centre_of_det_global_position_;
-      double rec_u_0_;              ///< in mm, position of det. centre projected on readout direction
-      TVector2 readout_direction_;  ///< non paralell projection and rot_cor included
-      bool available_;              ///< if det should be included in the reconstruction
+      unsigned int detId;
+      const TotemRPRecHit *hit;
+      const TotemRPPlaneTable::Plane *plane;
     };
 
-    /// A cache of reconstruction data. Must be reset every time the geometry chagnges.
-    unordered_map<unsigned int, RPDetCoordinateAlgebraObjs> det_data_map_;
-
-    RPTopology rp_topology_;
+    /// hits of the current fit, kept to reuse the memory
+    std::vector<HitWithPlane> applicable_hits_;
 
-    /// Returns the reconstruction data for the chosen detector from the cache DetReconstructionDataMap.
-    /// If it is not yet in the cache, calls PrepareReconstAlgebraData to make it.
-    RPDetCoordinateAlgebraObjs *getDetAlgebraData(unsigned int det_id, const TotemRPGeometry &tot_rp_geom);
+    /// Fits applicable_hits_ with ROOT matrices.
+    bool fitMatrix(double z_0, TotemRPLocalTrack &fitted_track);
 
-    /// Build the reconstruction data.
-    RPDetCoordinateAlgebraObjs prepareReconstAlgebraData(unsigned int det_id, const TotemRPGeometry &tot_rp_geom);
+    /// Fits applicable_hits_ via the Cholesky decomposition of the normal equations.
+    bool fitCholesky(double z_0, TotemRPLocalTrack &fitted_track);
 
     /// A matrix multiplication shorthand.
     void multiplyByDiagonalInPlace(TMatrixD &mt, const TVectorD &diag);
-    
-    static TVector3 convert3vector(const CLHEP::Hep3Vector & v)
-    {
-      return TVector3(v.x(),v.y(),v.z()) ;
-    }
 };
 
 #endif
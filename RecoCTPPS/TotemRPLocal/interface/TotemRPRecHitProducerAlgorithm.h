@@ -13,22 +13,57 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "DataFormats/Common/interface/DetSet.h"
+#include "DataFormats/Common/interface/DetSetVector.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPCluster.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPRecHit.h"
 
 #include "Geometry/VeryForwardRPTopology/interface/RPTopology.h"
 
+#include <map>
+#include <vector>
+
+/**
+ * Converts clusters to hits: position in mm and its uncertainty.
+ *
+ * The positions are read from a table indexed by (first strip + last strip) of the cluster, i.e. by twice
+ * the cluster centre. The table depends only on RPTopology, which is common to all planes and does not
+ * depend on the geometry conditions, hence it is built once, in the constructor.
+ *
+ * The uncertainty depends on the cluster size: clusterSizeSigmas[size - 1], the last entry applies to all
+ * larger clusters. Individual planes can have their own values (planeClusterSizeSigmas). With no values
+ * given, all hits get the nominal pitch/sqrt(12).
+ **/
 class TotemRPRecHitProducerAlgorithm
 {
   public:
-    TotemRPRecHitProducerAlgorithm(const edm::ParameterSet& conf)
-    {
-    }
+    TotemRPRecHitProducerAlgorithm(const edm::ParameterSet& conf);
 
+    /// builds the hits of one plane
     void buildRecoHits(const edm::DetSet<TotemRPCluster>& input, edm::DetSet<TotemRPRecHit>& output);
 
+    /// builds the hits of all planes
+    void buildRecoHits(const edm::DetSetVector<TotemRPCluster>& input, edm::DetSetVector<TotemRPRecHit>& output);
+
+    /// the uncertainty used when none is configured, in mm
+    static constexpr double nominalSigma = 0.0191;
+
   private:
     RPTopology rp_topology_;
+
+    /// hit position (mm) as a function of first strip + last strip
+    std::vector<double> positionTable_;
+
+    /// uncertainty (mm) as a function of cluster size - 1
+    std::vector<double> sigmas_;
+
+    /// plane-specific uncertainties: raw detector id --> uncertainty as a function of cluster size - 1
+    std::map<unsigned int, std::vector<double> > planeSigmas_;
+
+    /// returns the uncertainty table for the given plane
+    const std::vector<double>& getSigmas(unsigned int detId) const;
+
+    /// converts n clusters to n hits
+    void convert(const std::vector<double> &sigmas, const TotemRPCluster *clusters, unsigned int n, TotemRPRecHit *hits) const;
 };
 
 #endif
@@ -0,0 +1,99 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef RecoCTPPS_TotemRPLocal_TotemRPUVPatternCombiner
+#define RecoCTPPS_TotemRPLocal_TotemRPUVPatternCombiner
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/Common/interface/DetSet.h"
+#include "DataFormats/CTPPSReco/interface/TotemRPUVPattern.h"
+#include "DataFormats/CTPPSReco/interface/TotemRPLocalTrack.h"
+
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
+
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ *\brief Combines U and V patterns of a single RP into tracks.
+ *
+ * Algorithms:
+ * \li "unique": a track is fitted only if there is exactly one U and one V pattern (both fittable)
+ * \li "greedy": all fittable U-V pairs are fitted and ranked by chi^2/ndf; pairs are accepted from the best one,
+ *   each pattern used at most once
+ * \li "global": among all assignments (each pattern used at most once), the one with most tracks and then with
+ *   the lowest sum of chi^2/ndf is taken
+ *
+ * In the latter two, pairs whose mean U and V positions fall outside the sensitive area are discarded
+ * (requireSensitiveArea), as well as pairs with chi^2/ndf above maxChiSquaredOverNDF. Pots with more than
+ * maxPatternsPerProjection fittable patterns in a projection are skipped. The chi^2/ndf is that of
+ * TotemRPLocalTrack::getChiSquaredOverNDF, i.e. ndf = number of planes with hits - 4.
+ *
+ * Note that with strictly perpendicular U and V planes, the chi^2 of a pair is the sum of U and V chi^2's,
+ * independently of the pairing. The chi^2 thus only discriminates through the plane tilts, and the
+ * sensitive-area veto removes only few wrong pairs. Wrong pairs are therefore NOT reliably rejected: in
+ * validateTotemRPUVPatternCombiner, with two protons in a pot, only 52-56 % of the tracks are correct and
+ * there are 0.87-0.96 fake tracks per event (the veto improves these by 2-6 %); "global" is slightly better
+ * than "greedy".
+ **/
+class TotemRPUVPatternCombiner
+{
+  public:
+    TotemRPUVPatternCombiner(const std::string &algorithm, const edm::ParameterSet &settings);
+
+    /// combines the patterns of one RP and appends the resulting tracks
+    void combine(const edm::DetSet<TotemRPUVPattern> &patterns, double z0, const TotemRPPlaneTable &planes,
+      TotemRPLocalTrackFitterAlgorithm &fitter, std::vector<TotemRPLocalTrack> &tracks);
+
+  private:
+    enum Algorithm { aUnique, aGreedy, aGlobal };
+
+    Algorithm algorithm_;
+
+    unsigned int maxPatternsPerProjection_;
+    double maxChiSquaredOverNDF_;
+    bool requireSensitiveArea_;
+
+    /// a fitted U-V pair
+    struct Candidate
+    {
+      unsigned int u, v;          ///< indices in the lists of fittable U and V patterns
+      double chiSquaredOverNDF;
+      TotemRPLocalTrack track;
+    };
+
+    /// fittable patterns and pair candidates of the current RP
+    std::vector<const TotemRPUVPattern *> patterns_U_, patterns_V_;
+    std::vector<Candidate> candidates_;
+
+    /// fits the pair of patterns, returns true if successful
+    static bool fitPair(const TotemRPUVPattern &pu, const TotemRPUVPattern &pv, double z0,
+      const TotemRPPlaneTable &planes, TotemRPLocalTrackFitterAlgorithm &fitter, TotemRPLocalTrack &track);
+
+    /// mean of the hit positions (in the local readout coordinate)
+    static double meanPosition(const TotemRPUVPattern &p);
+
+    /// builds the list of candidates
+    void makeCandidates(double z0, const TotemRPPlaneTable &planes, TotemRPLocalTrackFitterAlgorithm &fitter);
+
+    /// returns indices of the accepted candidates
+    void selectGreedy(std::vector<unsigned int> &selection) const;
+    void selectGlobal(std::vector<unsigned int> &selection) const;
+
+    /// recursive step of selectGlobal, over the U patterns from index u
+    void searchGlobal(unsigned int u, const std::vector< std::vector<unsigned int> > &candidatesOfU,
+      std::vector<char> &usedV, std::vector<unsigned int> &current, double currentSum,
+      std::vector<unsigned int> &best, double &bestSum) const;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef RecoCTPPS_TotemRPLocal_TotemRPUVPatternFinderAlgorithm
+#define RecoCTPPS_TotemRPLocal_TotemRPUVPatternFinderAlgorithm
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/Common/interface/DetSet.h"
+#include "DataFormats/Common/interface/DetSetVector.h"
+#include "DataFormats/CTPPSReco/interface/TotemRPRecHit.h"
+#include "DataFormats/CTPPSReco/interface/TotemRPUVPattern.h"
+
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * \brief Recognizes U and V patterns in all RPs of an event.
+ *
+ * The hits are split per RP and projection into views (pointers to the DetSets of the input collection),
+ * without copying. The line recognition of each (RP, projection) pair is independent. With
+ * parallelRecognition, they run as TBB tasks in the current task arena, each with its own line-recognition
+ * instance and output buffer. The output is merged in the order of RPs, U before V, hence it is identical to
+ * the serial execution.
+ *
+ * An instance is not thread safe, each stream needs its own one.
+**/
+class TotemRPUVPatternFinderAlgorithm
+{
+  public:
+    TotemRPUVPatternFinderAlgorithm(const edm::ParameterSet &conf);
+
+    /// sets the plane data to use, to be called at every geometry change
+    void resetGeometry(const TotemRPPlaneTable *_t);
+
+    /// recognizes patterns in the input, the output is filled with one DetSet per RP (decimal RP id)
+    void run(const edm::DetSetVector<TotemRPRecHit> &input, edm::DetSetVector<TotemRPUVPattern> &output);
+
+  protected:
+    unsigned int verbosity;
+
+    /// minimal required number of active planes per projection to even start track recognition
+    unsigned char minPlanesPerProjectionToSearch;
+
+    /// minimal required number of active planes per projection to mark track candidate as fittable
+    unsigned char minPlanesPerProjectionToFit;
+
+    /// above this limit, planes are considered noisy
+    unsigned int maxHitsPerPlaneToSearch;
+
+    /// the line recognition algorithm: point pairs ("fast") or binned accumulator ("hough")
+    std::string lineRecognitionAlgorithm;
+    double clusterSize_a, clusterSize_b;
+    edm::ParameterSet houghSettings;
+
+    /// minimal weight of (Hough) cluster to accept it as candidate
+    double threshold;
+
+    /// maximal angle (in any projection) to mark candidate as fittable - controls track parallelity
+    double max_a_toFit;
+
+    /// block of (exceptional) settings for 1 RP
+    struct RPSettings
+    {
+      unsigned char minPlanesPerProjectionToFit_U, minPlanesPerProjectionToFit_V;
+      double threshold_U, threshold_V;
+    };
+
+    /// exceptional settings: RP Id --> settings
+    std::map<unsigned int, RPSettings> exceptionalSettings;
+
+    /// whether the (RP, projection) pairs are processed in parallel
+    bool parallelRecognition;
+
+    /// pointer to the plane data
+    const TotemRPPlaneTable *planeTable;
+
+    /// one line recognition, i.e. one (RP, projection) pair
+    struct Task
+    {
+      TotemRPUVPattern::ProjectionType proj;
+      double z0;
+      double threshold;
+      unsigned int planesRequired;
+
+      /// the hits of the projection
+      FastLineRecognition::InputView hits;
+
+      /// output buffer
+      edm::DetSet<TotemRPUVPattern> patterns;
+    };
+
+    /// RPs with enough planes for the recognition (decimal ids), the tasks of the i-th RP are tasks[2*i] (U)
+    /// and tasks[2*i + 1] (V)
+    std::vector<unsigned int> rpIds;
+
+    /// task buffers reused from event to event, only the first 2*rpIds.size() entries are valid
+    std::vector<Task> tasks;
+
+    /// line-recognition instances, one per task in the parallel mode, only the first one used otherwise
+    std::vector<std::unique_ptr<FastLineRecognition>> recognizers;
+
+    /// makes sure there are n recognizers
+    void makeRecognizers(unsigned int n);
+
+    /// splits the input per RP and projection, prepares the tasks
+    void prepareTasks(const edm::DetSetVector<TotemRPRecHit> &input);
+
+    /// executes line recognition in a projection
+    void recognizeAndSelect(FastLineRecognition &lrcgn, Task &task) const;
+};
+
+#endif
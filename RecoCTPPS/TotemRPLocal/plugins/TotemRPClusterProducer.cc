@@ -74,20 +74,22 @@ void TotemRPClusterProducer::produce(edm::Event& e, const edm::EventSetup& es)
   e.getByToken(digiInputTagToken_, input);
 
   // prepare output
-  DetSetVector<TotemRPCluster> output;
+  auto output = make_unique<DetSetVector<TotemRPCluster>>();
   
   // run clusterisation
   if (input->size())
-    run(*input, output);
+    run(*input, *output);
 
   // save output to event
-  e.put(make_unique<DetSetVector<TotemRPCluster>>(output));
+  e.put(std::move(output));
 }
 
 //----------------------------------------------------------------------------------------------------
 
 void TotemRPClusterProducer::run(const edm::DetSetVector<TotemRPDigi>& input, edm::DetSetVector<TotemRPCluster> &output)
 {
+  output.reserve(input.size());
+
   for (const auto &ds_digi : input)
   {
     edm::DetSet<TotemRPCluster> &ds_cluster = output.find_or_insert(ds_digi.id);
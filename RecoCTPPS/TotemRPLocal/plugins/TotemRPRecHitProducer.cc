@@ -71,17 +71,13 @@ void TotemRPRecHitProducer::produce(edm::Event& e, const edm::EventSetup& es)
   e.getByToken(tokenCluster_, input);
  
   // prepare output
-  DetSetVector<TotemRPRecHit> output;
+  auto output = make_unique<DetSetVector<TotemRPRecHit>>();
 
   // build reco hits
-  for (auto &ids : *input)
-  {
-    DetSet<TotemRPRecHit> &ods = output.find_or_insert(ids.detId());
-    algorithm_.buildRecoHits(ids, ods);
-  }
+  algorithm_.buildRecoHits(*input, *output);
    
   // save output
-  e.put(make_unique<DetSetVector<TotemRPRecHit>>(output));
+  e.put(std::move(output));
 }
 
 //----------------------------------------------------------------------------------------------------
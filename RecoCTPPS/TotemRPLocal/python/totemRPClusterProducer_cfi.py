@@ -2,5 +2,11 @@ import FWCore.ParameterSet.Config as cms
 
 totemRPClusterProducer = cms.EDProducer("TotemRPClusterProducer",
     verbosity = cms.int32(0),
-    tagDigi = cms.InputTag("totemRPRawToDigi", "RP")
+    tagDigi = cms.InputTag("totemRPRawToDigi", "RP"),
+
+    # maximum number of inactive strips inside a cluster (0 = only contiguous strips)
+    maxGap = cms.uint32(0),
+
+    # wider clusters are split into pieces of at most maxWidth strips (0 = no limit)
+    maxWidth = cms.uint32(0)
 )
@@ -3,5 +3,30 @@ import FWCore.ParameterSet.Config as cms
 totemRPLocalTrackFitter = cms.EDProducer("TotemRPLocalTrackFitter",
     verbosity = cms.int32(0),
 
-    tagUVPattern = cms.InputTag("totemRPUVPatternFinder")
+    tagUVPattern = cms.InputTag("totemRPUVPatternFinder"),
+
+    # least-squares solver
+    #   "matrix": ROOT matrix algebra
+    #   "cholesky": closed-form solution of the 4x4 normal equations, no memory allocation,
+    #               results equal to "matrix" up to rounding
+    fitMethod = cms.string("matrix"),
+
+    # combination of U and V patterns into tracks
+    #   "unique": one track only if there is exactly one U and one V pattern
+    #   "greedy": all fittable U-V pairs are fitted and accepted in the order of chi^2/ndf, each pattern used once
+    #   "global": the assignment with most tracks, then with the lowest sum of chi^2/ndf
+    combinationAlgorithm = cms.string("unique"),
+
+    # settings of the "greedy" and "global" algorithms
+    combinationSettings = cms.PSet(
+        # RPs with more fittable patterns in a projection are skipped
+        maxPatternsPerProjection = cms.uint32(5),
+
+        # pairs with worse fits are discarded; ndf = number of planes with hits - 4, as in
+        # TotemRPLocalTrack::getChiSquaredOverNDF
+        maxChiSquaredOverNDF = cms.double(10.),
+
+        # discard pairs whose mean U and V positions do not cross in the sensitive area
+        requireSensitiveArea = cms.bool(True)
+    )
 )
@@ -2,5 +2,14 @@ import FWCore.ParameterSet.Config as cms
 
 totemRPRecHitProducer = cms.EDProducer("TotemRPRecHitProducer",
     verbosity = cms.int32(0),
-    tagCluster = cms.InputTag("totemRPClusterProducer")
+    tagCluster = cms.InputTag("totemRPClusterProducer"),
+
+    # hit position uncertainty (mm) per cluster size: [size 1, size 2, ...], the last value applies to all larger
+    # clusters; if empty, the nominal pitch/sqrt(12) = 0.0191 mm is used
+    clusterSizeSigmas = cms.vdouble(),
+
+    # plane-specific uncertainties, e.g.
+    #   cms.PSet(planes = cms.vuint32(1200, 1201), clusterSizeSigmas = cms.vdouble(0.016, 0.010, 0.025))
+    # planes are given by decimal ids
+    planeClusterSizeSigmas = cms.VPSet()
 )
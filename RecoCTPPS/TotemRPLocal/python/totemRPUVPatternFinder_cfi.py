@@ -5,6 +5,9 @@ totemRPUVPatternFinder = cms.EDProducer("TotemRPUVPatternFinder",
     tagRecHit = cms.InputTag("totemRPRecHitProducer"),
 
     verbosity = cms.untracked.uint32(0),
+
+    # whether the RPs and projections are processed in parallel (as TBB tasks), the output is the same
+    parallelRecognition = cms.untracked.bool(False),
     
     # if a plane has more hits than this parameter, it is considered as dirty
     maxHitsPerPlaneToSearch = cms.uint32(5),
@@ -13,6 +16,27 @@ totemRPUVPatternFinder = cms.EDProducer("TotemRPUVPatternFinder",
     # to start the pattern search
     minPlanesPerProjectionToSearch = cms.uint32(3),
 
+    # line recognition algorithm
+    #   "fast": clusters of the intersections of all point pairs
+    #   "hough": binned accumulator in slope-intercept space, faster for many hits,
+    #            gives the same patterns as "fast" for well-separated tracks
+    lineRecognitionAlgorithm = cms.string("fast"),
+
+    # accumulator of the "hough" algorithm
+    houghSettings = cms.PSet(
+        # half ranges, lines outside are not found
+        max_a = cms.double(0.1),      # rad
+        max_b = cms.double(50.),      # mm
+
+        # bin sizes, the spread of a line's votes (~ z range * binSize_a / 2) shall stay below binSize_b
+        binSize_a = cms.double(0.01), # rad
+        binSize_b = cms.double(0.3),  # mm
+
+        # number of coarse-to-fine iterations around the peak and bin size reduction per iteration
+        zoomSteps = cms.uint32(0),
+        zoomFactor = cms.uint32(4)
+    ),
+
     # (full) cluster size in slope-intercept space
     clusterSize_a = cms.double(0.02), # rad
     clusterSize_b = cms.double(0.3),  # mm
@@ -8,11 +8,12 @@
 
 #include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
 
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
 #include "DataFormats/CTPPSReco/interface/TotemRPRecHit.h"
 
-#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPGeometry.h"
 
-#include <map>
 #include <cmath>
 #include <cstdio>
 #include <algorithm>
@@ -28,19 +29,19 @@ const double FastLineRecognition::sigma0 = 66E-3/sqrt(12.);
 
 //----------------------------------------------------------------------------------------------------
 
-void FastLineRecognition::Cluster::add(const Point *p1, const Point *p2, double a, double b, double w)
+void FastLineRecognition::Cluster::add(unsigned int p1, unsigned int p2, double a, double b, double w)
 {
   // which points to be added to contents?
   bool add1 = true, add2 = true;
-  for (vector<const Point *>::const_iterator it = contents.begin(); it != contents.end() && (add1 || add2); ++it)
+  for (vector<unsigned int>::const_iterator it = contents.begin(); it != contents.end() && (add1 || add2); ++it)
   {
-    if ((*it)->hit == p1->hit)
+    if (*it == p1)
       add1 = false;
 
-    if ((*it)->hit == p2->hit)
+    if (*it == p2)
       add2 = false;
   }
-  
+
   // add the points
   if (add1)
     contents.push_back(p1);
@@ -57,13 +58,16 @@ void FastLineRecognition::Cluster::add(const Point *p1, const Point *p2, double
   min_b = min(b, min_b);
   max_a = max(a, max_a);
   max_b = max(b, max_b);
+
+  c_a = Saw/Sw;
+  c_b = Sbw/Sw;
 }
 
 //----------------------------------------------------------------------------------------------------
 //----------------------------------------------------------------------------------------------------
 
 FastLineRecognition::FastLineRecognition(double cw_a, double cw_b) :
-  chw_a(cw_a/2.), chw_b(cw_b/2.), geometry(NULL)
+  chw_a(cw_a/2.), chw_b(cw_b/2.), planeTable(NULL)
 {
 }
 
@@ -75,49 +79,108 @@ FastLineRecognition::~FastLineRecognition()
 
 //----------------------------------------------------------------------------------------------------
 
-FastLineRecognition::GeomData FastLineRecognition::getGeomData(unsigned int id)
+void FastLineRecognition::resetGeometry(const TotemRPPlaneTable *_t)
 {
-  // result already buffered?
-  map<unsigned int, GeomData>::iterator it = geometryMap.find(id);
-  if (it != geometryMap.end())
-    return it->second;
-
-  // calculate it
-  CLHEP::Hep3Vector d = geometry->LocalToGlobalDirection(id, CLHEP::Hep3Vector(0., 1., 0.));
-  DDTranslation c = geometry->GetDetector(id)->translation();
-  GeomData gd;
-  gd.z = c.z();
-  gd.s = d.x()*c.x() + d.y()*c.y();
-
-  geometryMap[id] = gd;
-
-  return gd;
+  planeTable = _t;
 }
 
 //----------------------------------------------------------------------------------------------------
 
-void FastLineRecognition::getPatterns(const DetSetVector<TotemRPRecHit> &input, double z0,
-  double threshold, DetSet<TotemRPUVPattern> &patterns)
+void FastLineRecognition::getPoints(const InputView &input, double z0)
 {
-  // build collection of points in the global coordinate system
-  std::vector<Point> points;
-  for (auto &ds : input)
+  hits.clear();
+  points.clear();
+
+  // collect hits, plane by plane
+  struct Plane
   {
+    double z, s;
+    unsigned int begin, end;
+  };
+
+  vector<Plane> planes;
+  planes.reserve(input.size());
+
+  for (const auto &dsp : input)
+  {
+    const DetSet<TotemRPRecHit> &ds = *dsp;
     unsigned int detId = ds.detId();
+    const TotemRPPlaneTable::Plane *gd = planeTable->getPlane(detId);
+    if (gd == NULL)
+      throw cms::Exception("FastLineRecognition") << "Invalid detector id " << detId << ".";
+
+    Plane plane;
+    plane.z = gd->cz - z0;
+    plane.s = gd->s;
+    plane.begin = hits.size();
 
     for (auto &h : ds)
     {
-      const TotemRPRecHit *hit = &h;
-      const GeomData &gd = getGeomData(detId);
-  
-      double p = hit->getPosition() + gd.s;
-      double z = gd.z - z0;
-      double w = sigma0 / hit->getSigma();
-  
-      points.push_back(Point(detId, hit, p, z, w));
+      Hit hit;
+      hit.detId = detId;
+      hit.hit = &h;
+      hits.push_back(hit);
     }
+
+    plane.end = hits.size();
+    planes.push_back(plane);
   }
 
+  // build points in the global coordinate system, sorted by z
+  stable_sort(planes.begin(), planes.end(), [] (const Plane &l, const Plane &r) { return l.z < r.z; });
+
+  for (const auto &plane : planes)
+  {
+    for (unsigned int i = plane.begin; i < plane.end; ++i)
+    {
+      const TotemRPRecHit *hit = hits[i].hit;
+      points.push_back(plane.z, hit->getPosition() + plane.s, sigma0 / hit->getSigma(), i);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FastLineRecognition::makePattern(const Cluster &c, TotemRPUVPattern &pattern) const
+{
+  pattern.setA(c.Saw/c.Sw);
+  pattern.setB(c.Sbw/c.Sw);
+  pattern.setW(c.weight);
+
+#if CTPPS_DEBUG > 0
+  printf("\tpoints of the selected cluster: %lu\n", c.contents.size());
+#endif
+
+  for (auto &i : c.contents)
+  {
+#if CTPPS_DEBUG > 0
+    printf("\t\t%.1f\n", points.z[i]);
+#endif
+    const Hit &hit = hits[points.hit[i]];
+    pattern.addHit(hit.detId, *(hit.hit));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FastLineRecognition::getPatterns(const DetSetVector<TotemRPRecHit> &input, double z0,
+  double threshold, DetSet<TotemRPUVPattern> &patterns)
+{
+  inputView.clear();
+  for (const auto &ds : input)
+    inputView.push_back(&ds);
+
+  getPatterns(inputView, z0, threshold, patterns);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FastLineRecognition::getPatterns(const InputView &input, double z0,
+  double threshold, DetSet<TotemRPUVPattern> &patterns)
+{
+  // build collection of points in the global coordinate system
+  getPoints(input, z0);
+
 #if CTPPS_DEBUG > 0
   printf(">> FastLineRecognition::getPatterns(z0 = %E)\n", z0);
   printf(">>>>>>>>>>>>>>>>>>>\n");
@@ -127,55 +190,21 @@ void FastLineRecognition::getPatterns(const DetSetVector<TotemRPRecHit> &input,
   patterns.clear();
 
   Cluster c;
-  while (getOneLine(points, threshold, c))
+  while (getOneLine(threshold, c))
   {
     // convert cluster to pattern and save it
     TotemRPUVPattern pattern;
-    pattern.setA(c.Saw/c.Sw);
-    pattern.setB(c.Sbw/c.Sw);
-    pattern.setW(c.weight);
-
-#if CTPPS_DEBUG > 0
-    printf("\tpoints of the selected cluster: %lu\n", c.contents.size());
-#endif
-
-    for (auto &pit : c.contents)
-    { 
-#if CTPPS_DEBUG > 0
-      printf("\t\t%.1f\n", pit->z);
-#endif
-      pattern.addHit(pit->detId, *(pit->hit));
-    }
-
+    makePattern(c, pattern);
     patterns.push_back(pattern);
 
-#if CTPPS_DEBUG > 0
-    unsigned int u_points_b = 0;
-    for (vector<Point>::iterator dit = points.begin(); dit != points.end(); ++dit)
-      if (dit->usable)
-        u_points_b++;
-    printf("\tusable points before: %u\n", u_points_b);
-#endif
-
     // remove points belonging to the recognized line
-    for (vector<const Point *>::iterator hit = c.contents.begin(); hit != c.contents.end(); ++hit)
-    {
-      for (vector<Point>::iterator dit = points.begin(); dit != points.end(); ++dit)
-      {
-        //printf("\t\t1: %.2f, %p vs. 2: %.2f, %p\n", (*hit)->z, (*hit)->hit, dit->z, dit->hit);
-        if ((*hit)->hit == dit->hit)
-        {
-          dit->usable = false;
-          //points.erase(dit);
-          break;
-        }
-      }
-    }
+    for (const auto &i : c.contents)
+      points.used[i] = 1;
 
 #if CTPPS_DEBUG > 0
     unsigned int u_points_a = 0;
-    for (vector<Point>::iterator dit = points.begin(); dit != points.end(); ++dit)
-      if (dit->usable)
+    for (unsigned int i = 0; i < points.size(); ++i)
+      if (!points.used[i])
         u_points_a++;
     printf("\tusable points after: %u\n", u_points_a);
 #endif
@@ -189,40 +218,82 @@ void FastLineRecognition::getPatterns(const DetSetVector<TotemRPRecHit> &input,
 
 //----------------------------------------------------------------------------------------------------
 
-bool FastLineRecognition::getOneLine(const vector<FastLineRecognition::Point> &points,
-  double threshold, FastLineRecognition::Cluster &result)
+int FastLineRecognition::findCluster(double a, double b) const
+{
+  // candidates: centre within the window in a (with a margin, the exact test follows)
+  auto it = lower_bound(clusterOrder.begin(), clusterOrder.end(), a - 2.*chw_a,
+    [this] (unsigned int k, double v) { return clusters[k].c_a < v; });
+
+  int result = -1;
+  unsigned int first = clusters.size();
+  for (; it != clusterOrder.end() && clusters[*it].c_a <= a + 2.*chw_a; ++it)
+  {
+    const Cluster &c = clusters[*it];
+    if (*it < first && (std::abs(a - c.c_a) < chw_a) && (std::abs(b - c.c_b) < chw_b))
+    {
+      first = *it;
+      result = it - clusterOrder.begin();
+    }
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void FastLineRecognition::updateClusterOrder(unsigned int pos)
+{
+  const double c_a = clusters[clusterOrder[pos]].c_a;
+
+  while (pos > 0 && clusters[clusterOrder[pos - 1]].c_a > c_a)
+  {
+    swap(clusterOrder[pos], clusterOrder[pos - 1]);
+    pos--;
+  }
+
+  while (pos + 1 < clusterOrder.size() && clusters[clusterOrder[pos + 1]].c_a < c_a)
+  {
+    swap(clusterOrder[pos], clusterOrder[pos + 1]);
+    pos++;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool FastLineRecognition::getOneLine(double threshold, FastLineRecognition::Cluster &result)
 {
 #if CTPPS_DEBUG > 0
   printf("\tFastLineRecognition::getOneLine\n");
 #endif
 
-  if (points.size() < 2)
-        return false;
-  
-  vector<Cluster> clusters;
+  const unsigned int n = points.size();
+  if (n < 2)
+    return false;
+
+  clusters.clear();
+  clusterOrder.clear();
 
   // go through all the combinations of measured points
-  for (vector<Point>::const_iterator it1 = points.begin(); it1 != points.end(); ++it1)
+  for (unsigned int i1 = 0; i1 < n; ++i1)
   {
-    if (!it1->usable)
+    if (points.used[i1])
       continue;
 
-    for (vector<Point>::const_iterator it2 = it1; it2 != points.end(); ++it2)
-    {
-      if (!it2->usable)
-        continue;
+    const double &z1 = points.z[i1];
+    const double &p1 = points.h[i1];
+    const double &w1 = points.w[i1];
 
-      const double &z1 = it1->z;
-      const double &z2 = it2->z;
+    // points are sorted by z, those with the same z do not make a pair
+    const unsigned int i2_begin = upper_bound(points.z.begin() + i1, points.z.end(), z1) - points.z.begin();
 
-      if (z1 == z2)
+    for (unsigned int i2 = i2_begin; i2 < n; ++i2)
+    {
+      if (points.used[i2])
         continue;
 
-      const double &p1 = it1->h;
-      const double &p2 = it2->h;
-      
-      const double &w1 = it1->w;
-      const double &w2 = it2->w;
+      const double &z2 = points.z[i2];
+      const double &p2 = points.h[i2];
+      const double &w2 = points.w[i2];
 
       // calculate intersection
       double a = (p2 - p1) / (z2 - z1);
@@ -234,39 +305,29 @@ bool FastLineRecognition::getOneLine(const vector<FastLineRecognition::Point> &p
 #endif
 
       // add it to the appropriate cluster
-      bool newCluster = true;
-      for (unsigned int k = 0; k < clusters.size(); k++)
+      const int pos = findCluster(a, b);
+      if (pos >= 0)
       {
-        Cluster &c = clusters[k];
-        if (c.S1 < 1. || c.Sw <= 0.)
-          continue;
-
 #if CTPPS_DEBUG > 0
-        if (k < 10)
-          printf("\t\t\t\ttest cluster %u at a=%+6.3f, b=%+6.3f : %+6.3f, %+6.3f : %i, %i\n", k, c.Saw/c.Sw, c.Sbw/c.Sw, 
-            chw_a, chw_b,
-            (std::abs(a - c.Saw/c.Sw) < chw_a), (std::abs(b - c.Sbw/c.Sw) < chw_b));
+        printf("\t\t\t\t--> cluster %u\n", clusterOrder[pos]);
 #endif
-
-        if ((std::abs(a - c.Saw/c.Sw) < chw_a) && (std::abs(b - c.Sbw/c.Sw) < chw_b))
-        {
-          newCluster = false;
-          clusters[k].add(& (*it1), & (*it2), a, b, w);
-#if CTPPS_DEBUG > 0
-          printf("\t\t\t\t--> cluster %u\n", k);
-#endif
-          break;
-        }
-      }
-
-      // make new cluster
-      if (newCluster)
-      {
+        clusters[clusterOrder[pos]].add(i1, i2, a, b, w);
+        updateClusterOrder(pos);
+      } else {
+        // make new cluster
 #if CTPPS_DEBUG > 0
         printf("\t\t\t\t--> new cluster %lu\n", clusters.size());
 #endif
         clusters.push_back(Cluster());
-        clusters.back().add(& (*it1), & (*it2), a, b, w);
+        Cluster &c = clusters.back();
+        c.add(i1, i2, a, b, w);
+
+        if (c.Sw > 0.)
+        {
+          auto it = upper_bound(clusterOrder.begin(), clusterOrder.end(), c.c_a,
+            [this] (double v, unsigned int k) { return v < clusters[k].c_a; });
+          clusterOrder.insert(it, clusters.size() - 1);
+        }
       }
     }
   }
@@ -281,8 +342,8 @@ bool FastLineRecognition::getOneLine(const vector<FastLineRecognition::Point> &p
   for (unsigned int k = 0; k < clusters.size(); k++)
   {
     double w = 0;
-    for (vector<const Point *>::iterator it = clusters[k].contents.begin(); it != clusters[k].contents.end(); ++it)
-      w += (*it)->w;
+    for (const auto &i : clusters[k].contents)
+      w += points.w[i];
     clusters[k].weight = w;
 
     if (w > mw)
@@ -305,4 +366,3 @@ bool FastLineRecognition::getOneLine(const vector<FastLineRecognition::Point> &p
   } else
     return false;
 }
-
@@ -0,0 +1,277 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/HoughLineRecognition.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+HoughLineRecognition::HoughLineRecognition(double cw_a, double cw_b, const edm::ParameterSet &ps) :
+  FastLineRecognition(cw_a, cw_b),
+  max_a(ps.getParameter<double>("max_a")),
+  max_b(ps.getParameter<double>("max_b")),
+  bin_a(ps.getParameter<double>("binSize_a")),
+  bin_b(ps.getParameter<double>("binSize_b")),
+  zoomSteps(ps.getParameter<unsigned int>("zoomSteps")),
+  zoomFactor(ps.getParameter<unsigned int>("zoomFactor"))
+{
+  if (max_a <= 0. || max_b <= 0. || bin_a <= 0. || bin_b <= 0.)
+    throw cms::Exception("HoughLineRecognition") << "Ranges and bin sizes must be positive.";
+
+  if (zoomSteps > 0 && zoomFactor < 2)
+    throw cms::Exception("HoughLineRecognition") << "zoomFactor must be at least 2.";
+
+  coarseGrid.n_a = max(2, int(ceil(2. * max_a / bin_a)));
+  coarseGrid.n_b = max(2, int(ceil(2. * max_b / bin_b)));
+  coarseGrid.bin_a = bin_a;
+  coarseGrid.bin_b = bin_b;
+  coarseGrid.min_a = -0.5 * coarseGrid.n_a * bin_a;
+  coarseGrid.min_b = -0.5 * coarseGrid.n_b * bin_b;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+HoughLineRecognition::~HoughLineRecognition()
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void HoughLineRecognition::vote(const Grid &g, unsigned int i, double w, vector<double> &acc) const
+{
+  const double h = points.h[i], z = points.z[i];
+
+  for (unsigned int i_a = 0; i_a < g.n_a; ++i_a)
+  {
+    const double a = g.min_a + (i_a + 0.5) * g.bin_a;
+    const double x = (h - z * a - g.min_b) / g.bin_b;
+    if (x < 0. || x >= g.n_b)
+      continue;
+
+    acc[i_a * g.n_b + (unsigned int) x] += w;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void HoughLineRecognition::fill(const Grid &g, vector<double> &acc) const
+{
+  acc.assign(g.n_a * g.n_b, 0.);
+
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    if (!points.used[i])
+      vote(g, i, points.w[i], acc);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+double HoughLineRecognition::findPeak(const Grid &g, const vector<double> &acc, unsigned int &i_a, unsigned int &i_b,
+  double &a, double &b) const
+{
+  double peak = -1.;
+  for (unsigned int j_a = 0; j_a + 1 < g.n_a; ++j_a)
+  {
+    const double *r1 = &acc[j_a * g.n_b];
+    const double *r2 = r1 + g.n_b;
+
+    for (unsigned int j_b = 0; j_b + 1 < g.n_b; ++j_b)
+    {
+      const double s = r1[j_b] + r1[j_b + 1] + r2[j_b] + r2[j_b + 1];
+      if (s > peak)
+      {
+        peak = s;
+        i_a = j_a;
+        i_b = j_b;
+      }
+    }
+  }
+
+  // sub-bin refinement: weighted centroid of the window
+  double Sa = 0., Sb = 0., Sw = 0.;
+  for (unsigned int k_a = i_a; k_a < i_a + 2; ++k_a)
+  {
+    for (unsigned int k_b = i_b; k_b < i_b + 2; ++k_b)
+    {
+      const double w = acc[k_a * g.n_b + k_b];
+      Sa += w * (g.min_a + (k_a + 0.5) * g.bin_a);
+      Sb += w * (g.min_b + (k_b + 0.5) * g.bin_b);
+      Sw += w;
+    }
+  }
+
+  a = (Sw > 0.) ? Sa / Sw : g.min_a + (i_a + 1) * g.bin_a;
+  b = (Sw > 0.) ? Sb / Sw : g.min_b + (i_b + 1) * g.bin_b;
+
+  return peak;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool HoughLineRecognition::selectPoints(double a, double b, vector<unsigned int> &selected) const
+{
+  // the peak position is known to within the cluster size, so is the line at a given z
+  double S0 = 0., Sz = 0., Szz = 0., Sh = 0., Szh = 0.;
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    const double h = points.h[i], z = points.z[i];
+    if (points.used[i] || std::abs(h - z * a - b) >= chw_b + chw_a * std::abs(z))
+      continue;
+
+    const double w = points.w[i] * points.w[i];
+    S0 += w;
+    Sz += w * z;
+    Szz += w * z * z;
+    Sh += w * h;
+    Szh += w * z * h;
+  }
+
+  // refit the line to the compatible points and select again, with the tight tolerance
+  const double det = S0 * Szz - Sz * Sz;
+  if (det <= 0.)
+    return false;
+
+  const double a_fit = (S0 * Szh - Sz * Sh) / det;
+  const double b_fit = (Szz * Sh - Sz * Szh) / det;
+
+  selected.clear();
+  bool differentZ = false;
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    if (points.used[i] || std::abs(points.h[i] - points.z[i] * a_fit - b_fit) >= chw_b)
+      continue;
+
+    if (!selected.empty() && points.z[i] != points.z[selected.front()])
+      differentZ = true;
+
+    selected.push_back(i);
+  }
+
+  return differentZ;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+double HoughLineRecognition::makeCluster(const vector<unsigned int> &selected, Cluster &c) const
+{
+  c = Cluster();
+
+  for (unsigned int i = 0; i < selected.size(); ++i)
+  {
+    const unsigned int i1 = selected[i];
+
+    for (unsigned int j = i + 1; j < selected.size(); ++j)
+    {
+      const unsigned int i2 = selected[j];
+
+      if (points.z[i1] == points.z[i2])
+        continue;
+
+      const double a = (points.h[i2] - points.h[i1]) / (points.z[i2] - points.z[i1]);
+      const double b = points.h[i1] - points.z[i1] * a;
+      c.add(i1, i2, a, b, points.w[i1] + points.w[i2]);
+    }
+  }
+
+  c.weight = 0.;
+  for (const auto &i : c.contents)
+    c.weight += points.w[i];
+
+  return c.weight;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void HoughLineRecognition::getPatterns(const InputView &input, double z0, double threshold,
+  edm::DetSet<TotemRPUVPattern> &patterns)
+{
+  getPoints(input, z0);
+
+  patterns.clear();
+
+  if (points.size() < 2)
+    return;
+
+  fill(coarseGrid, accumulator);
+
+  // extract lines peak by peak, each point can contribute to one line only
+  vector<Cluster> lines;
+  vector<unsigned int> selected;
+
+  while (true)
+  {
+    unsigned int i_a = 0, i_b = 0;
+    double a = 0., b = 0.;
+    const double peak = findPeak(coarseGrid, accumulator, i_a, i_b, a, b);
+    if (peak <= 0. || peak < threshold)
+      break;
+
+    // coarse-to-fine: re-bin the neighbourhood of the peak
+    Grid g = coarseGrid;
+    for (unsigned int step = 0; step < zoomSteps; ++step)
+    {
+      Grid z;
+      z.n_a = z.n_b = 2 * zoomFactor;
+      z.bin_a = g.bin_a / zoomFactor;
+      z.bin_b = g.bin_b / zoomFactor;
+      z.min_a = a - g.bin_a;
+      z.min_b = b - g.bin_b;
+
+      fill(z, zoomAccumulator);
+
+      unsigned int j_a = 0, j_b = 0;
+      findPeak(z, zoomAccumulator, j_a, j_b, a, b);
+
+      g = z;
+    }
+
+    Cluster c;
+    if (selectPoints(a, b, selected) && makeCluster(selected, c) >= threshold)
+    {
+      // withdraw the votes of the line points
+      for (const auto &i : c.contents)
+      {
+        points.used[i] = 1;
+        vote(coarseGrid, i, -points.w[i], accumulator);
+      }
+
+      lines.push_back(c);
+      continue;
+    }
+
+    // no acceptable line at this peak: suppress it
+    for (unsigned int k_a = i_a; k_a < i_a + 2; ++k_a)
+      for (unsigned int k_b = i_b; k_b < i_b + 2; ++k_b)
+        accumulator[k_a * coarseGrid.n_b + k_b] = 0.;
+  }
+
+  // order of FastLineRecognition: decreasing weight, then order of the first point pair
+  sort(lines.begin(), lines.end(), [] (const Cluster &l, const Cluster &r)
+    {
+      if (l.weight != r.weight)
+        return l.weight > r.weight;
+      if (l.contents[0] != r.contents[0])
+        return l.contents[0] < r.contents[0];
+      return l.contents[1] < r.contents[1];
+    }
+  );
+
+  for (const auto &c : lines)
+  {
+    TotemRPUVPattern pattern;
+    makePattern(c, pattern);
+    patterns.push_back(pattern);
+  }
+}
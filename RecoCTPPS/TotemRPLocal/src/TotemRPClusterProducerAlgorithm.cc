@@ -7,9 +7,11 @@
 *
 ****************************************************************************/
 
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
 #include "RecoCTPPS/TotemRPLocal/interface/TotemRPClusterProducerAlgorithm.h"
 
-#include <iostream>
+#include <cstring>
 
 //----------------------------------------------------------------------------------------------------
 
@@ -17,6 +19,8 @@ TotemRPClusterProducerAlgorithm::TotemRPClusterProducerAlgorithm(const edm::Para
  :param_(param)
 {
   verbosity_ = param_.getParameter<int>("verbosity");
+  maxGap_ = param_.getParameter<unsigned int>("maxGap");
+  maxWidth_ = param_.getParameter<unsigned int>("maxWidth");
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -27,48 +31,87 @@ TotemRPClusterProducerAlgorithm::~TotemRPClusterProducerAlgorithm()
 
 //----------------------------------------------------------------------------------------------------
 
+unsigned int TotemRPClusterProducerAlgorithm::findNext(unsigned int from, bool active) const
+{
+  if (from >= stripsPerPlane)
+    return stripsPerPlane;
+
+  const uint64_t flip = (active) ? 0 : ~uint64_t(0);
+
+  unsigned int i = from / 64;
+  uint64_t w = (bitmap_[i] ^ flip) & (~uint64_t(0) << (from % 64));
+
+  while (w == 0)
+  {
+    if (++i == bitmapWords)
+      return stripsPerPlane;
+
+    w = bitmap_[i] ^ flip;
+  }
+
+  return 64*i + __builtin_ctzll(w);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPClusterProducerAlgorithm::addCluster(unsigned int beg, unsigned int end, std::vector<TotemRPCluster> &clusters) const
+{
+  if (maxWidth_ > 0)
+  {
+    for (; end - beg + 1 > maxWidth_; beg += maxWidth_)
+      clusters.push_back(TotemRPCluster((uint16_t) beg, (uint16_t) (beg + maxWidth_ - 1)));
+  }
+
+  clusters.push_back(TotemRPCluster((uint16_t) beg, (uint16_t) end));
+}
+
+//----------------------------------------------------------------------------------------------------
+
 int TotemRPClusterProducerAlgorithm::buildClusters(unsigned int detId, const std::vector<TotemRPDigi> &digi, std::vector<TotemRPCluster> &clusters)
 {
   clusters.clear();
 
-  strip_digi_set_.clear();
-  strip_digi_set_.insert(digi.begin(), digi.end());
+  if (digi.empty())
+    return 0;
 
-  if (strip_digi_set_.size() == 0)
+  // mark active strips
+  memset(bitmap_, 0, sizeof(bitmap_));
+
+  unsigned int outOfRange = 0;
+  for (const auto &d : digi)
+  {
+    const unsigned int strip = d.getStripNumber();
+    if (strip < stripsPerPlane)
+      bitmap_[strip / 64] |= uint64_t(1) << (strip % 64);
+    else
+      outOfRange++;
+  }
+
+  if (outOfRange > 0)
+    edm::LogProblem("TotemRPClusterProducerAlgorithm") << "Plane " << detId << ": " << outOfRange
+      << " digi(s) with strip number >= " << stripsPerPlane << " ignored.";
+
+  // read out runs of active strips, merge those separated by at most maxGap_ inactive strips
+  unsigned int cluster_beg = findNext(0, true);
+  if (cluster_beg == stripsPerPlane)
     return 0;
-    
-  bool iter_beg=true;
-  int cluster_beg=-16;
-  int cluster_end;
-  int prev_strip=-16;
-  int cur_strip;
-  
-  for (TotemRPDigiSet::const_iterator i=strip_digi_set_.begin(); i!=strip_digi_set_.end(); ++i)
+
+  unsigned int cluster_end = findNext(cluster_beg, false) - 1;
+
+  for (unsigned int beg = findNext(cluster_end + 1, true); beg < stripsPerPlane; beg = findNext(cluster_end + 1, true))
   {
-    cur_strip = i->getStripNumber();
-    bool non_continuity = (cur_strip!=prev_strip+1);
-    
-    if (iter_beg)
-    {
-      cluster_beg=cur_strip;
-      iter_beg=false;
-    }
-    else if (non_continuity)
+    const unsigned int end = findNext(beg, false) - 1;
+
+    if (beg - cluster_end - 1 > maxGap_)
     {
-      cluster_end=prev_strip;
-      clusters.push_back(TotemRPCluster((uint16_t)cluster_beg, (uint16_t) cluster_end));
-      
-      cluster_beg=cur_strip;
+      addCluster(cluster_beg, cluster_end, clusters);
+      cluster_beg = beg;
     }
-    
-    prev_strip=cur_strip;
-  }
-  
-  if (!iter_beg)
-  {
-    cluster_end=prev_strip;
-    clusters.push_back(TotemRPCluster((uint16_t)cluster_beg, (uint16_t) cluster_end));
+
+    cluster_end = end;
   }
-    
+
+  addCluster(cluster_beg, cluster_end, clusters);
+
   return clusters.size();
 }
@@ -10,9 +10,12 @@
 #include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 #include "TMatrixD.h"
 
+#include <cmath>
+
 //----------------------------------------------------------------------------------------------------
 
 using namespace std;
@@ -20,92 +23,54 @@ using namespace edm;
 
 //----------------------------------------------------------------------------------------------------
 
-TotemRPLocalTrackFitterAlgorithm::TotemRPLocalTrackFitterAlgorithm(const edm::ParameterSet &)
-{
-}
-
-//----------------------------------------------------------------------------------------------------
-
-
-void TotemRPLocalTrackFitterAlgorithm::reset()
-{
-  det_data_map_.clear();
-}
-
-//----------------------------------------------------------------------------------------------------
-
-TotemRPLocalTrackFitterAlgorithm::RPDetCoordinateAlgebraObjs
-TotemRPLocalTrackFitterAlgorithm::prepareReconstAlgebraData(unsigned int det_id, const TotemRPGeometry& tot_rp_geom)
+TotemRPLocalTrackFitterAlgorithm::TotemRPLocalTrackFitterAlgorithm(const edm::ParameterSet &conf)
 {
-  RPDetCoordinateAlgebraObjs det_algebra_obj;
-
-  det_algebra_obj.centre_of_det_global_position_ = convert3vector(tot_rp_geom.GetDetTranslation(det_id));
- 
-  HepMC::ThreeVector rp_topology_stripaxis = rp_topology_.GetStripReadoutAxisDir();
-  CLHEP::Hep3Vector rp_topology_stripaxis_clhep;
-  
-  rp_topology_stripaxis_clhep.setX(rp_topology_stripaxis.x());
-  rp_topology_stripaxis_clhep.setY(rp_topology_stripaxis.y());
-  rp_topology_stripaxis_clhep.setZ(rp_topology_stripaxis.z());
- 
-  TVector3 rd_dir = convert3vector( tot_rp_geom.LocalToGlobalDirection(det_id, rp_topology_stripaxis_clhep ) );
-  
-  TVector2 v(rd_dir.X(), rd_dir.Y());
-  det_algebra_obj.readout_direction_ = v.Unit();
-  det_algebra_obj.rec_u_0_ = 0.0;
-  det_algebra_obj.available_ = true;
-  det_algebra_obj.rec_u_0_ = - (det_algebra_obj.readout_direction_ * det_algebra_obj.centre_of_det_global_position_.XYvector());
-  
-  return det_algebra_obj;
-}
-
-//----------------------------------------------------------------------------------------------------
-
-TotemRPLocalTrackFitterAlgorithm::RPDetCoordinateAlgebraObjs*
-TotemRPLocalTrackFitterAlgorithm::getDetAlgebraData(unsigned int det_id, const TotemRPGeometry& tot_rp_geom)
-{
-  auto it = det_data_map_.find(det_id);
-  if (it != det_data_map_.end())
-  {
-    return &(it->second);
-  } else {
-    det_data_map_[det_id] = prepareReconstAlgebraData(det_id, tot_rp_geom);
-    return &det_data_map_[det_id];
-  }
+  const string &method = conf.getParameter<string>("fitMethod");
+  if (method == "matrix")
+    fit_method_ = fmMatrix;
+  else if (method == "cholesky")
+    fit_method_ = fmCholesky;
+  else
+    throw cms::Exception("TotemRPLocalTrackFitterAlgorithm") << "Unknown fitMethod `" << method << "'.";
 }
 
 //----------------------------------------------------------------------------------------------------
 
 bool TotemRPLocalTrackFitterAlgorithm::fitTrack(const edm::DetSetVector<TotemRPRecHit> &hits, double z_0,
-    const TotemRPGeometry &tot_geom, TotemRPLocalTrack &fitted_track)
+    const TotemRPPlaneTable &planes, TotemRPLocalTrack &fitted_track)
 {
   fitted_track.setValid(false);
 
-  // bind hits with their algebra objects
-  struct HitWithAlg
-  {
-    unsigned int detId;
-    const TotemRPRecHit *hit;
-    RPDetCoordinateAlgebraObjs *alg;
-  };
-  
-  vector<HitWithAlg> applicable_hits;
+  // bind hits with their plane data
+  applicable_hits_.clear();
 
   for (auto &ds : hits)
   {
     unsigned int detId = ds.detId();
 
+    const TotemRPPlaneTable::Plane *plane = planes.getPlane(detId);
+    if (plane == NULL)
+      continue;
+
     for (auto &h : ds)
-    {
-      RPDetCoordinateAlgebraObjs * alg = getDetAlgebraData(detId, tot_geom);
-      if (alg->available_)
-        applicable_hits.push_back({ detId, &h, alg});
-    }
+      applicable_hits_.push_back({ detId, &h, plane });
   }
   
-  if (applicable_hits.size() < 5)
+  if (applicable_hits_.size() < 5)
     return false;
-  
+
+  if (fit_method_ == fmCholesky)
+    return fitCholesky(z_0, fitted_track);
+  else
+    return fitMatrix(z_0, fitted_track);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool TotemRPLocalTrackFitterAlgorithm::fitMatrix(double z_0, TotemRPLocalTrack &fitted_track)
+{
+  const vector<HitWithPlane> &applicable_hits = applicable_hits_;
+
   TMatrixD H(applicable_hits.size(), 4);
   TVectorD V(applicable_hits.size());
   TVectorD V_inv(applicable_hits.size());
@@ -113,18 +78,18 @@ bool TotemRPLocalTrackFitterAlgorithm::fitTrack(const edm::DetSetVector<TotemRPR
   
   for(unsigned int i = 0;  i < applicable_hits.size(); ++i)
   {
-    RPDetCoordinateAlgebraObjs *alg_obj = applicable_hits[i].alg;
+    const TotemRPPlaneTable::Plane *plane = applicable_hits[i].plane;
 
-    H(i,0) = alg_obj->readout_direction_.X();
-    H(i,1) = alg_obj->readout_direction_.Y();
-    double delta_z = alg_obj->centre_of_det_global_position_.Z()-z_0;
-    H(i,2) = alg_obj->readout_direction_.X()*delta_z;
-    H(i,3) = alg_obj->readout_direction_.Y()*delta_z;
+    H(i,0) = plane->dx;
+    H(i,1) = plane->dy;
+    double delta_z = plane->cz-z_0;
+    H(i,2) = plane->dx*delta_z;
+    H(i,3) = plane->dy*delta_z;
     double var = applicable_hits[i].hit->getSigma();
     var*=var;
     V[i] = var;
     V_inv[i] = 1.0/var;
-    U[i] = applicable_hits[i].hit->getPosition() - alg_obj->rec_u_0_;
+    U[i] = applicable_hits[i].hit->getPosition() - plane->u0;
   }
 
   TMatrixD H_T_V_inv(TMatrixD::kTransposed, H);
@@ -153,13 +118,13 @@ bool TotemRPLocalTrackFitterAlgorithm::fitTrack(const edm::DetSetVector<TotemRPR
   double Chi_2 = 0;
   for(unsigned int i=0; i<applicable_hits.size(); ++i)
   {
-    RPDetCoordinateAlgebraObjs *alg_obj = applicable_hits[i].alg;
-    TVector2 readout_dir = alg_obj->readout_direction_;
-    double det_z = alg_obj->centre_of_det_global_position_.Z();
+    const TotemRPPlaneTable::Plane *plane = applicable_hits[i].plane;
+    TVector2 readout_dir(plane->dx, plane->dy);
+    double det_z = plane->cz;
     double sigma_str = applicable_hits[i].hit->getSigma();
     double sigma_str_2 = sigma_str*sigma_str;
     TVector2 fited_det_xy_point = fitted_track.getTrackPoint(det_z);
-    double U_readout = applicable_hits[i].hit->getPosition() - alg_obj->rec_u_0_;
+    double U_readout = applicable_hits[i].hit->getPosition() - plane->u0;
     double U_fited = (readout_dir*=fited_det_xy_point);
     double residual = U_fited - U_readout;
     TMatrixD V_T_Cov_X_Y(1,2);
@@ -184,6 +149,140 @@ bool TotemRPLocalTrackFitterAlgorithm::fitTrack(const edm::DetSetVector<TotemRPR
 
 //----------------------------------------------------------------------------------------------------
 
+bool TotemRPLocalTrackFitterAlgorithm::fitCholesky(double z_0, TotemRPLocalTrack &fitted_track)
+{
+  const int dim = TotemRPLocalTrack::dimension;
+
+  // normal equations A a = r, with A = sum h h^T / var and r = sum h U / var,
+  // h = (d_x, d_y, d_x dz, d_y dz) being the projection of track parameters on the readout direction d
+  double A[dim][dim] = {}, r[dim] = {};
+
+  for (const auto &ah : applicable_hits_)
+  {
+    const TotemRPPlaneTable::Plane *plane = ah.plane;
+
+    const double delta_z = plane->cz - z_0;
+    const double h[dim] = { plane->dx, plane->dy, plane->dx * delta_z, plane->dy * delta_z };
+
+    const double sigma = ah.hit->getSigma();
+    const double w = 1. / (sigma * sigma);
+    const double U = ah.hit->getPosition() - plane->u0;
+
+    for (int i = 0; i < dim; ++i)
+    {
+      const double wh = w * h[i];
+      r[i] += wh * U;
+      for (int j = 0; j <= i; ++j)
+        A[i][j] += wh * h[j];
+    }
+  }
+
+  // Cholesky decomposition A = L L^T (lower triangle of A used only)
+  double L[dim][dim] = {};
+  for (int j = 0; j < dim; ++j)
+  {
+    double d = A[j][j];
+    for (int k = 0; k < j; ++k)
+      d -= L[j][k] * L[j][k];
+
+    if (!(d > 1E-12 * A[j][j]))
+    {
+      LogError("TotemRPLocalTrackFitterAlgorithm") << "Error in TotemRPLocalTrackFitterAlgorithm::fitTrack > "
+        << "Fit matrix is singular. Skipping.";
+      return false;
+    }
+
+    L[j][j] = sqrt(d);
+
+    for (int i = j + 1; i < dim; ++i)
+    {
+      double s = A[i][j];
+      for (int k = 0; k < j; ++k)
+        s -= L[i][k] * L[j][k];
+      L[i][j] = s / L[j][j];
+    }
+  }
+
+  // inverse of L, lower triangular as well
+  double L_inv[dim][dim] = {};
+  for (int j = 0; j < dim; ++j)
+  {
+    L_inv[j][j] = 1. / L[j][j];
+    for (int i = j + 1; i < dim; ++i)
+    {
+      double s = 0.;
+      for (int k = j; k < i; ++k)
+        s -= L[i][k] * L_inv[k][j];
+      L_inv[i][j] = s / L[i][i];
+    }
+  }
+
+  // covariance matrix V_a = A^-1 = L_inv^T L_inv and parameters a = V_a r
+  double V_a[dim * dim], a[dim];
+  for (int i = 0; i < dim; ++i)
+  {
+    for (int j = 0; j <= i; ++j)
+    {
+      double s = 0.;
+      for (int k = i; k < dim; ++k)
+        s += L_inv[k][i] * L_inv[k][j];
+      V_a[i*dim + j] = V_a[j*dim + i] = s;
+    }
+  }
+
+  for (int i = 0; i < dim; ++i)
+  {
+    a[i] = 0.;
+    for (int j = 0; j < dim; ++j)
+      a[i] += V_a[i*dim + j] * r[j];
+  }
+
+  fitted_track.setZ0(z_0);
+  fitted_track.setParameterVector(a);
+  fitted_track.setCovarianceMatrix(V_a);
+
+  // residuals, pulls and chi^2
+  double Chi_2 = 0;
+  for (const auto &ah : applicable_hits_)
+  {
+    const TotemRPPlaneTable::Plane *plane = ah.plane;
+
+    const double det_z = plane->cz;
+    const double delta_z = det_z - z_0;
+    const double h[dim] = { plane->dx, plane->dy, plane->dx * delta_z, plane->dy * delta_z };
+
+    const double x = a[0] + a[2] * delta_z, y = a[1] + a[3] * delta_z;
+    const double U_readout = ah.hit->getPosition() - plane->u0;
+    const double U_fited = h[0] * x + h[1] * y;
+    const double residual = U_fited - U_readout;
+
+    // variance of the fitted position along the readout direction: h^T V_a h
+    double fit_strip_var = 0.;
+    for (int i = 0; i < dim; ++i)
+    {
+      double s = 0.;
+      for (int j = 0; j < dim; ++j)
+        s += V_a[i*dim + j] * h[j];
+      fit_strip_var += h[i] * s;
+    }
+
+    const double sigma_str = ah.hit->getSigma();
+    const double sigma_str_2 = sigma_str*sigma_str;
+    const double pull = residual / sqrt(sigma_str_2 - fit_strip_var);
+
+    Chi_2 += residual*residual / sigma_str_2;
+
+    TotemRPLocalTrack::FittedRecHit hit_point(*(ah.hit), TVector3(x, y, det_z), residual, pull);
+    fitted_track.addHit(ah.detId, hit_point);
+  }
+
+  fitted_track.setChiSquared(Chi_2);
+  fitted_track.setValid(true);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
 void TotemRPLocalTrackFitterAlgorithm::multiplyByDiagonalInPlace(TMatrixD &mt, const TVectorD &diag)
 {
   for(int i=0; i<mt.GetNrows(); ++i)
@@ -7,16 +7,98 @@
 *
 ****************************************************************************/
 
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
 #include "RecoCTPPS/TotemRPLocal/interface/TotemRPRecHitProducerAlgorithm.h"
 
+#include <algorithm>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+constexpr double TotemRPRecHitProducerAlgorithm::nominalSigma;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPRecHitProducerAlgorithm::TotemRPRecHitProducerAlgorithm(const edm::ParameterSet& conf)
+{
+  // position table
+  const unsigned int strips = RPTopology::no_of_strips_;
+  positionTable_.resize(2*strips - 1);
+  for (unsigned int i = 0; i < positionTable_.size(); ++i)
+    positionTable_[i] = rp_topology_.GetHitPositionInReadoutDirection(i / 2.);
+
+  // resolution model
+  sigmas_ = conf.getParameter< vector<double> >("clusterSizeSigmas");
+  if (sigmas_.empty())
+    sigmas_.push_back(nominalSigma);
+
+  for (const auto &ps : conf.getParameter< vector<edm::ParameterSet> >("planeClusterSizeSigmas"))
+  {
+    const vector<double> &sigmas = ps.getParameter< vector<double> >("clusterSizeSigmas");
+    if (sigmas.empty())
+      throw cms::Exception("TotemRPRecHitProducerAlgorithm") << "Empty clusterSizeSigmas in planeClusterSizeSigmas.";
+
+    for (const auto &plane : ps.getParameter< vector<unsigned int> >("planes"))
+      planeSigmas_[TotemRPDetId::decToRawId(plane)] = sigmas;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const vector<double>& TotemRPRecHitProducerAlgorithm::getSigmas(unsigned int detId) const
+{
+  if (planeSigmas_.empty())
+    return sigmas_;
+
+  auto it = planeSigmas_.find(detId);
+  return (it == planeSigmas_.end()) ? sigmas_ : it->second;
+}
+
 //----------------------------------------------------------------------------------------------------
 
-void TotemRPRecHitProducerAlgorithm::buildRecoHits(const edm::DetSet<TotemRPCluster>& input, 
+void TotemRPRecHitProducerAlgorithm::convert(const vector<double> &sigmas, const TotemRPCluster *clusters, unsigned int n,
+  TotemRPRecHit *hits) const
+{
+  const unsigned int maxSizeIndex = sigmas.size() - 1;
+  const unsigned int tableSize = positionTable_.size();
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    const unsigned int sum = clusters[i].getStripBegin() + clusters[i].getStripEnd();
+    const unsigned int sizeIndex = min<unsigned int>(clusters[i].getNumberOfStrips() - 1, maxSizeIndex);
+
+    const double position = (sum < tableSize) ? positionTable_[sum] :
+      rp_topology_.GetHitPositionInReadoutDirection(clusters[i].getCenterStripPosition());
+
+    hits[i] = TotemRPRecHit(position, sigmas[sizeIndex]);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPRecHitProducerAlgorithm::buildRecoHits(const edm::DetSet<TotemRPCluster>& input,
     edm::DetSet<TotemRPRecHit>& output)
 {
-  for (edm::DetSet<TotemRPCluster>::const_iterator it = input.begin(); it!=input.end(); ++it)
+  const unsigned int offset = output.data.size();
+  output.data.resize(offset + input.data.size());
+
+  convert(getSigmas(input.detId()), input.data.data(), input.data.size(), output.data.data() + offset);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPRecHitProducerAlgorithm::buildRecoHits(const edm::DetSetVector<TotemRPCluster>& input,
+    edm::DetSetVector<TotemRPRecHit>& output)
+{
+  output.reserve(input.size());
+
+  for (const auto &ids : input)
   {
-    constexpr double nominal_sigma = 0.0191;
-    output.push_back(TotemRPRecHit(rp_topology_.GetHitPositionInReadoutDirection(it->getCenterStripPosition()), nominal_sigma));
-  }  
+    edm::DetSet<TotemRPRecHit> &ods = output.find_or_insert(ids.detId());
+    buildRecoHits(ids, ods);
+  }
 }
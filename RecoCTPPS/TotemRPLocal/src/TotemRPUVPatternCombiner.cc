@@ -0,0 +1,282 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPUVPatternCombiner.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/Common/interface/DetSetVector.h"
+
+#include "Geometry/VeryForwardRPTopology/interface/RPTopology.h"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPUVPatternCombiner::TotemRPUVPatternCombiner(const string &algorithm, const ParameterSet &settings)
+{
+  if (algorithm == "unique")
+    algorithm_ = aUnique;
+  else if (algorithm == "greedy")
+    algorithm_ = aGreedy;
+  else if (algorithm == "global")
+    algorithm_ = aGlobal;
+  else
+    throw cms::Exception("TotemRPUVPatternCombiner") << "Unknown combinationAlgorithm `" << algorithm << "'.";
+
+  if (algorithm_ != aUnique)
+  {
+    maxPatternsPerProjection_ = settings.getParameter<unsigned int>("maxPatternsPerProjection");
+    maxChiSquaredOverNDF_ = settings.getParameter<double>("maxChiSquaredOverNDF");
+    requireSensitiveArea_ = settings.getParameter<bool>("requireSensitiveArea");
+  } else {
+    maxPatternsPerProjection_ = 1;
+    maxChiSquaredOverNDF_ = 0.;
+    requireSensitiveArea_ = false;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool TotemRPUVPatternCombiner::fitPair(const TotemRPUVPattern &pu, const TotemRPUVPattern &pv, double z0,
+  const TotemRPPlaneTable &planes, TotemRPLocalTrackFitterAlgorithm &fitter, TotemRPLocalTrack &track)
+{
+  // combine U and V hits
+  DetSetVector<TotemRPRecHit> hits;
+  for (auto &ids : pu.getHits())
+  {
+    auto &ods = hits.find_or_insert(ids.detId());
+    for (auto &h : ids)
+      ods.push_back(h);
+  }
+
+  for (auto &ids : pv.getHits())
+  {
+    auto &ods = hits.find_or_insert(ids.detId());
+    for (auto &h : ids)
+      ods.push_back(h);
+  }
+
+  return fitter.fitTrack(hits, z0, planes, track);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+double TotemRPUVPatternCombiner::meanPosition(const TotemRPUVPattern &p)
+{
+  double S = 0.;
+  unsigned int N = 0;
+  for (auto &ds : p.getHits())
+  {
+    for (auto &h : ds)
+    {
+      S += h.getPosition();
+      N++;
+    }
+  }
+
+  return (N > 0) ? S / N : 0.;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternCombiner::makeCandidates(double z0, const TotemRPPlaneTable &planes,
+  TotemRPLocalTrackFitterAlgorithm &fitter)
+{
+  candidates_.clear();
+
+  vector<double> mean_V(patterns_V_.size());
+  for (unsigned int j = 0; j < patterns_V_.size(); ++j)
+    mean_V[j] = meanPosition(*patterns_V_[j]);
+
+  for (unsigned int i = 0; i < patterns_U_.size(); ++i)
+  {
+    const double mean_U = meanPosition(*patterns_U_[i]);
+
+    for (unsigned int j = 0; j < patterns_V_.size(); ++j)
+    {
+      // can the U-V crossing be in the sensitive area?
+      if (requireSensitiveArea_ && !RPTopology::IsHit(mean_U, mean_V[j]))
+        continue;
+
+      Candidate c;
+      c.u = i;
+      c.v = j;
+      if (!fitPair(*patterns_U_[i], *patterns_V_[j], z0, planes, fitter, c.track) || !c.track.isValid())
+        continue;
+
+      c.chiSquaredOverNDF = c.track.getChiSquaredOverNDF();
+      if (c.chiSquaredOverNDF > maxChiSquaredOverNDF_)
+        continue;
+
+      candidates_.push_back(c);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternCombiner::selectGreedy(vector<unsigned int> &selection) const
+{
+  vector<unsigned int> order(candidates_.size());
+  for (unsigned int k = 0; k < order.size(); ++k)
+    order[k] = k;
+
+  stable_sort(order.begin(), order.end(), [this] (unsigned int l, unsigned int r) {
+    return candidates_[l].chiSquaredOverNDF < candidates_[r].chiSquaredOverNDF; });
+
+  vector<char> usedU(patterns_U_.size(), 0), usedV(patterns_V_.size(), 0);
+  for (const auto &k : order)
+  {
+    const Candidate &c = candidates_[k];
+    if (usedU[c.u] || usedV[c.v])
+      continue;
+
+    usedU[c.u] = usedV[c.v] = 1;
+    selection.push_back(k);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternCombiner::searchGlobal(unsigned int u, const vector< vector<unsigned int> > &candidatesOfU,
+  vector<char> &usedV, vector<unsigned int> &current, double currentSum,
+  vector<unsigned int> &best, double &bestSum) const
+{
+  if (u == candidatesOfU.size())
+  {
+    if (current.size() > best.size() || (current.size() == best.size() && currentSum < bestSum))
+    {
+      best = current;
+      bestSum = currentSum;
+    }
+    return;
+  }
+
+  // not enough U patterns left to beat the best assignment
+  if (current.size() + (candidatesOfU.size() - u) < best.size())
+    return;
+
+  for (const auto &k : candidatesOfU[u])
+  {
+    const Candidate &c = candidates_[k];
+    if (usedV[c.v])
+      continue;
+
+    usedV[c.v] = 1;
+    current.push_back(k);
+    searchGlobal(u + 1, candidatesOfU, usedV, current, currentSum + c.chiSquaredOverNDF, best, bestSum);
+    current.pop_back();
+    usedV[c.v] = 0;
+  }
+
+  // U pattern u left unpaired
+  searchGlobal(u + 1, candidatesOfU, usedV, current, currentSum, best, bestSum);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternCombiner::selectGlobal(vector<unsigned int> &selection) const
+{
+  vector< vector<unsigned int> > candidatesOfU(patterns_U_.size());
+  for (unsigned int k = 0; k < candidates_.size(); ++k)
+    candidatesOfU[candidates_[k].u].push_back(k);
+
+  vector<char> usedV(patterns_V_.size(), 0);
+  vector<unsigned int> current;
+  double bestSum = 0.;
+  searchGlobal(0, candidatesOfU, usedV, current, 0., selection, bestSum);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternCombiner::combine(const DetSet<TotemRPUVPattern> &patterns, double z0,
+  const TotemRPPlaneTable &planes, TotemRPLocalTrackFitterAlgorithm &fitter, vector<TotemRPLocalTrack> &tracks)
+{
+  if (algorithm_ == aUnique)
+  {
+    // is U-V association unique?
+    // to keep the logic equivalent to version 7_0_4, non-fittable patterns are counted as well
+    const TotemRPUVPattern *pu = NULL, *pv = NULL;
+    unsigned int n_U = 0, n_V = 0;
+    for (const auto &p : patterns)
+    {
+      switch (p.getProjection())
+      {
+        case TotemRPUVPattern::projU:
+          n_U++;
+          pu = &p;
+          break;
+
+        case TotemRPUVPattern::projV:
+          n_V++;
+          pv = &p;
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    if (n_U != 1 || n_V != 1)
+      return;
+
+    // again, to follow the logic from version 7_0_4, skip the non-fittable patterns here
+    if (!pu->getFittable() || !pv->getFittable())
+      return;
+
+    // the track is saved even if the fit fails
+    TotemRPLocalTrack track;
+    fitPair(*pu, *pv, z0, planes, fitter, track);
+    tracks.push_back(track);
+
+    return;
+  }
+
+  // collect fittable patterns
+  patterns_U_.clear();
+  patterns_V_.clear();
+  for (const auto &p : patterns)
+  {
+    if (!p.getFittable())
+      continue;
+
+    if (p.getProjection() == TotemRPUVPattern::projU)
+      patterns_U_.push_back(&p);
+
+    if (p.getProjection() == TotemRPUVPattern::projV)
+      patterns_V_.push_back(&p);
+  }
+
+  if (patterns_U_.empty() || patterns_V_.empty())
+    return;
+
+  // limit combinatorics
+  if (patterns_U_.size() > maxPatternsPerProjection_ || patterns_V_.size() > maxPatternsPerProjection_)
+    return;
+
+  makeCandidates(z0, planes, fitter);
+
+  vector<unsigned int> selection;
+  if (algorithm_ == aGreedy)
+    selectGreedy(selection);
+  else
+    selectGlobal(selection);
+
+  // save tracks ordered by their U pattern
+  sort(selection.begin(), selection.end(), [this] (unsigned int l, unsigned int r) {
+    return candidates_[l].u < candidates_[r].u; });
+
+  for (const auto &k : selection)
+    tracks.push_back(candidates_[k].track);
+}
@@ -0,0 +1,260 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPUVPatternFinderAlgorithm.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/HoughLineRecognition.h"
+
+#include "tbb/parallel_for.h"
+
+#include <cmath>
+#include <set>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPUVPatternFinderAlgorithm::TotemRPUVPatternFinderAlgorithm(const edm::ParameterSet &conf) :
+  verbosity(conf.getUntrackedParameter<unsigned int>("verbosity", 0)),
+  minPlanesPerProjectionToSearch(conf.getParameter<unsigned int>("minPlanesPerProjectionToSearch")),
+  minPlanesPerProjectionToFit(conf.getParameter<unsigned int>("minPlanesPerProjectionToFit")),
+  maxHitsPerPlaneToSearch(conf.getParameter<unsigned int>("maxHitsPerPlaneToSearch")),
+  lineRecognitionAlgorithm(conf.getParameter<string>("lineRecognitionAlgorithm")),
+  clusterSize_a(conf.getParameter<double>("clusterSize_a")),
+  clusterSize_b(conf.getParameter<double>("clusterSize_b")),
+  threshold(conf.getParameter<double>("threshold")),
+  max_a_toFit(conf.getParameter<double>("max_a_toFit")),
+  parallelRecognition(conf.getUntrackedParameter<bool>("parallelRecognition", false)),
+  planeTable(NULL)
+{
+  if (lineRecognitionAlgorithm == "hough")
+    houghSettings = conf.getParameter<ParameterSet>("houghSettings");
+  else if (lineRecognitionAlgorithm != "fast")
+    throw cms::Exception("TotemRPUVPatternFinder") << "Unknown lineRecognitionAlgorithm `"
+      << lineRecognitionAlgorithm << "'.";
+
+  for (const auto &ps : conf.getParameter< vector<ParameterSet> >("exceptionalSettings"))
+  {
+    unsigned int rpId = ps.getParameter<unsigned int>("rpId");
+
+    RPSettings settings;
+    settings.minPlanesPerProjectionToFit_U = ps.getParameter<unsigned int>("minPlanesPerProjectionToFit_U");
+    settings.minPlanesPerProjectionToFit_V = ps.getParameter<unsigned int>("minPlanesPerProjectionToFit_V");
+    settings.threshold_U = ps.getParameter<double>("threshold_U");
+    settings.threshold_V = ps.getParameter<double>("threshold_V");
+
+    exceptionalSettings[rpId] = settings;
+  }
+
+  makeRecognizers(1);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternFinderAlgorithm::makeRecognizers(unsigned int n)
+{
+  while (recognizers.size() < n)
+  {
+    FastLineRecognition *lrcgn = NULL;
+    if (lineRecognitionAlgorithm == "hough")
+      lrcgn = new HoughLineRecognition(clusterSize_a, clusterSize_b, houghSettings);
+    else
+      lrcgn = new FastLineRecognition(clusterSize_a, clusterSize_b);
+
+    lrcgn->resetGeometry(planeTable);
+
+    recognizers.emplace_back(lrcgn);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternFinderAlgorithm::resetGeometry(const TotemRPPlaneTable *_t)
+{
+  planeTable = _t;
+
+  for (auto &lrcgn : recognizers)
+    lrcgn->resetGeometry(planeTable);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternFinderAlgorithm::recognizeAndSelect(FastLineRecognition &lrcgn, Task &task) const
+{
+  // run recognition
+  lrcgn.getPatterns(task.hits, task.z0, task.threshold, task.patterns);
+
+  // set pattern properties
+  for (auto &p : task.patterns)
+  {
+    p.setProjection(task.proj);
+
+    p.setFittable(true);
+
+    set<unsigned int> planes;
+    for (const auto &ds : p.getHits())
+        planes.insert(TotemRPDetId::rawToDecId(ds.detId()) % 10);
+
+    if (planes.size() < task.planesRequired)
+      p.setFittable(false);
+
+    if (fabs(p.getA()) > max_a_toFit)
+      p.setFittable(false);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternFinderAlgorithm::prepareTasks(const DetSetVector<TotemRPRecHit> &input)
+{
+  // split input per RP and per U/V projection
+  // the DetSets are sorted by raw id, thus those of a RP are contiguous and the RPs come in the order
+  // of their decimal id
+  rpIds.clear();
+  unsigned int uPlanes = 0, vPlanes = 0;
+
+  auto closeRP = [&] ()
+  {
+    if (rpIds.empty())
+      return;
+
+    if (verbosity > 5)
+      LogVerbatim("TotemRPUVPatternFinder") << "\tRP " << rpIds.back()
+        << "\n\t\tplanes with clean data: u = " << uPlanes << ", v = " << vPlanes;
+
+    // discard RPs with too few reasonable planes
+    if (uPlanes < minPlanesPerProjectionToSearch || vPlanes < minPlanesPerProjectionToSearch)
+      rpIds.pop_back();
+  };
+
+  for (const auto &ids : input)
+  {
+    // planes without hits are not considered
+    if (ids.empty())
+      continue;
+
+    unsigned int detId = TotemRPDetId::rawToDecId(ids.detId());
+    unsigned int rpId = TotemRPDetId::rpOfDet(detId);
+    bool uDir = TotemRPDetId::isStripsCoordinateUDirection(detId);
+
+    if (rpIds.empty() || rpIds.back() != rpId)
+    {
+      closeRP();
+
+      rpIds.push_back(rpId);
+      if (tasks.size() < 2*rpIds.size())
+        tasks.resize(2*rpIds.size());
+
+      tasks[2*rpIds.size() - 2].hits.clear();
+      tasks[2*rpIds.size() - 1].hits.clear();
+      uPlanes = vPlanes = 0;
+    }
+
+    // count planes with clean data (no showers, noise, ...)
+    const bool clean = (ids.size() <= maxHitsPerPlaneToSearch);
+
+    if (uDir)
+    {
+      tasks[2*rpIds.size() - 2].hits.push_back(&ids);
+      uPlanes += clean;
+    } else {
+      tasks[2*rpIds.size() - 1].hits.push_back(&ids);
+      vPlanes += clean;
+    }
+  }
+
+  closeRP();
+
+  // task settings
+  for (unsigned int i = 0; i < rpIds.size(); ++i)
+  {
+    const unsigned int rpId = rpIds[i];
+    Task &task_U = tasks[2*i], &task_V = tasks[2*i + 1];
+
+    task_U.proj = TotemRPUVPattern::projU;
+    task_V.proj = TotemRPUVPattern::projV;
+
+    // merge default and exceptional settings (if available)
+    task_U.planesRequired = task_V.planesRequired = minPlanesPerProjectionToFit;
+    task_U.threshold = task_V.threshold = threshold;
+
+    auto setIt = exceptionalSettings.find(rpId);
+    if (setIt != exceptionalSettings.end())
+    {
+      task_U.planesRequired = setIt->second.minPlanesPerProjectionToFit_U;
+      task_V.planesRequired = setIt->second.minPlanesPerProjectionToFit_V;
+      task_U.threshold = setIt->second.threshold_U;
+      task_V.threshold = setIt->second.threshold_V;
+    }
+
+    // "typical" z0 for the RP
+    task_U.z0 = task_V.z0 = planeTable->getRPZ0(rpId);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRPUVPatternFinderAlgorithm::run(const DetSetVector<TotemRPRecHit> &input,
+  DetSetVector<TotemRPUVPattern> &output)
+{
+  prepareTasks(input);
+
+  const unsigned int n_tasks = 2*rpIds.size();
+
+  if (parallelRecognition && n_tasks > 1)
+  {
+    makeRecognizers(n_tasks);
+
+    tbb::parallel_for(size_t(0), size_t(n_tasks),
+      [&] (size_t i)
+      {
+        recognizeAndSelect(*recognizers[i], tasks[i]);
+      }
+    );
+  } else {
+    for (unsigned int i = 0; i < n_tasks; ++i)
+      recognizeAndSelect(*recognizers[0], tasks[i]);
+  }
+
+  // merge in the order of RPs, U then V
+  for (unsigned int i = 0; i < rpIds.size(); ++i)
+  {
+    DetSet<TotemRPUVPattern> &patterns = output.find_or_insert(rpIds[i]);
+
+    for (unsigned int j = 2*i; j < 2*i + 2; ++j)
+      for (const auto &p : tasks[j].patterns)
+        patterns.push_back(p);
+
+    if (verbosity > 5)
+    {
+      LogVerbatim("TotemRPUVPatternFinder") << "\tRP " << rpIds[i] << ", patterns:";
+      for (const auto &p : patterns)
+      {
+        unsigned int n_hits = 0;
+        for (auto &hds : p.getHits())
+          n_hits += hds.size();
+
+        LogVerbatim("TotemRPUVPatternFinder")
+          << "\t\t\tproj = " << ((p.getProjection() == TotemRPUVPattern::projU) ? "U" : "V")
+          << ", a = " << p.getA()
+          << ", b = " << p.getB()
+          << ", w = " << p.getW()
+          << ", fittable = " << p.getFittable()
+          << ", hits = " << n_hits;
+      }
+    }
+  }
+}
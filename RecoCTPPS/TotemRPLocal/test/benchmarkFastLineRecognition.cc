@@ -0,0 +1,360 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former FastLineRecognition: geometry map, array of point structs, linear cluster search and nested
+/// search for the points to remove
+class LegacyLineRecognition
+{
+  public:
+    LegacyLineRecognition(double cw_a, double cw_b) : chw_a(cw_a/2.), chw_b(cw_b/2.) {}
+
+    void setGeometry(unsigned int detId, double z, double s)
+    {
+      geometryMap[detId] = { z, s };
+    }
+
+    void getPatterns(const edm::DetSetVector<TotemRPRecHit> &input, double z0, double threshold,
+      edm::DetSet<TotemRPUVPattern> &patterns);
+
+  private:
+    static constexpr double sigma0 = 66E-3/3.4641016151377544;
+
+    double chw_a, chw_b;
+
+    struct GeomData
+    {
+      double z, s;
+    };
+
+    map<unsigned int, GeomData> geometryMap;
+
+    struct Point
+    {
+      unsigned int detId;
+      const TotemRPRecHit* hit;
+      double h, z, w;
+      bool usable;
+      Point(unsigned int _d, const TotemRPRecHit* _hit, double _h, double _z, double _w) :
+        detId(_d), hit(_hit), h(_h), z(_z), w(_w), usable(true) {}
+    };
+
+    struct Cluster
+    {
+      double Saw = 0., Sbw = 0., Sw = 0., S1 = 0.;
+      double weight = 0.;
+      vector<const Point *> contents;
+
+      void add(const Point *p1, const Point *p2, double a, double b, double w)
+      {
+        bool add1 = true, add2 = true;
+        for (auto it = contents.begin(); it != contents.end() && (add1 || add2); ++it)
+        {
+          if ((*it)->hit == p1->hit)
+            add1 = false;
+          if ((*it)->hit == p2->hit)
+            add2 = false;
+        }
+
+        if (add1)
+          contents.push_back(p1);
+        if (add2)
+          contents.push_back(p2);
+
+        Saw += a*w;
+        Sbw += b*w;
+        Sw += w;
+        S1 += 1.;
+      }
+    };
+
+    bool getOneLine(const vector<Point> &points, double threshold, Cluster &result);
+};
+
+//----------------------------------------------------------------------------------------------------
+
+void LegacyLineRecognition::getPatterns(const edm::DetSetVector<TotemRPRecHit> &input, double z0, double threshold,
+  edm::DetSet<TotemRPUVPattern> &patterns)
+{
+  vector<Point> points;
+  for (auto &ds : input)
+  {
+    const GeomData &gd = geometryMap.find(ds.detId())->second;
+    for (auto &h : ds)
+      points.push_back(Point(ds.detId(), &h, h.getPosition() + gd.s, gd.z - z0, sigma0 / h.getSigma()));
+  }
+
+  patterns.clear();
+
+  Cluster c;
+  while (getOneLine(points, threshold, c))
+  {
+    TotemRPUVPattern pattern;
+    pattern.setA(c.Saw/c.Sw);
+    pattern.setB(c.Sbw/c.Sw);
+    pattern.setW(c.weight);
+    for (auto &pit : c.contents)
+      pattern.addHit(pit->detId, *(pit->hit));
+    patterns.push_back(pattern);
+
+    for (auto hit = c.contents.begin(); hit != c.contents.end(); ++hit)
+    {
+      for (auto dit = points.begin(); dit != points.end(); ++dit)
+      {
+        if ((*hit)->hit == dit->hit)
+        {
+          dit->usable = false;
+          break;
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool LegacyLineRecognition::getOneLine(const vector<Point> &points, double threshold, Cluster &result)
+{
+  if (points.size() < 2)
+    return false;
+
+  vector<Cluster> clusters;
+
+  for (auto it1 = points.begin(); it1 != points.end(); ++it1)
+  {
+    if (!it1->usable)
+      continue;
+
+    for (auto it2 = it1; it2 != points.end(); ++it2)
+    {
+      if (!it2->usable || it1->z == it2->z)
+        continue;
+
+      double a = (it2->h - it1->h) / (it2->z - it1->z);
+      double b = it1->h - it1->z * a;
+      double w = it1->w + it2->w;
+
+      bool newCluster = true;
+      for (auto &c : clusters)
+      {
+        if (c.S1 < 1. || c.Sw <= 0.)
+          continue;
+
+        if ((std::abs(a - c.Saw/c.Sw) < chw_a) && (std::abs(b - c.Sbw/c.Sw) < chw_b))
+        {
+          newCluster = false;
+          c.add(& (*it1), & (*it2), a, b, w);
+          break;
+        }
+      }
+
+      if (newCluster)
+      {
+        clusters.push_back(Cluster());
+        clusters.back().add(& (*it1), & (*it2), a, b, w);
+      }
+    }
+  }
+
+  unsigned int mk = 0;
+  double mw = -1.;
+  for (unsigned int k = 0; k < clusters.size(); k++)
+  {
+    double w = 0;
+    for (auto &p : clusters[k].contents)
+      w += p->w;
+    clusters[k].weight = w;
+
+    if (w > mw)
+    {
+      mw = w;
+      mk = k;
+    }
+  }
+
+  if (mw >= threshold)
+  {
+    result = clusters[mk];
+    return true;
+  } else
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// line recognition with the plane data given by hand
+class BenchmarkLineRecognition : public FastLineRecognition
+{
+  public:
+    using FastLineRecognition::FastLineRecognition;
+
+    /// the readout direction is along x, hence s is the x position of the centre
+    void setGeometry(unsigned int detId, double z, double s)
+    {
+      planes.setPlane(detId, s, 0., z, 1., 0.);
+      resetGeometry(&planes);
+    }
+
+  private:
+    TotemRPPlaneTable planes;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+bool SamePatterns(const edm::DetSet<TotemRPUVPattern> &p1, const edm::DetSet<TotemRPUVPattern> &p2)
+{
+  if (p1.size() != p2.size())
+    return false;
+
+  for (unsigned int i = 0; i < p1.size(); ++i)
+  {
+    const TotemRPUVPattern &l = p1.data[i], &r = p2.data[i];
+    if (l.getA() != r.getA() || l.getB() != r.getB() || l.getW() != r.getW())
+      return false;
+
+    if (l.getHits().size() != r.getHits().size())
+      return false;
+
+    for (auto lit = l.getHits().begin(), rit = r.getHits().begin(); lit != l.getHits().end(); ++lit, ++rit)
+    {
+      if (lit->detId() != rit->detId() || lit->data.size() != rit->data.size())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkFastLineRecognition [option]\n");
+  printf("Compares the per-event (one projection of one RP) time of the former and the current implementation\n");
+  printf("of FastLineRecognition as a function of the number of hits. Half of the hits come from tracks, half is\n");
+  printf("noise. The planes are ordered by z, so that both implementations shall give identical patterns.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of events per multiplicity (default 20)\n");
+  printf("    -m <number>     maximum multiplicity (default 200)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 20;
+  unsigned int maxMultiplicity = 200;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) { maxMultiplicity = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // U planes of one RP
+  vector<unsigned int> detIds;
+  vector<double> zs;
+  for (unsigned int plane = 0; plane < 10; plane += 2)
+  {
+    detIds.push_back(TotemRPDetId::decToRawId(1200 + plane));
+    zs.push_back((plane - 4.5) * 4.5);
+  }
+
+  LegacyLineRecognition legacy(0.02, 0.3);
+  BenchmarkLineRecognition current(0.02, 0.3);
+
+  for (unsigned int i = 0; i < detIds.size(); ++i)
+  {
+    legacy.setGeometry(detIds[i], zs[i], 1.5 * i);
+    current.setGeometry(detIds[i], zs[i], 1.5 * i);
+  }
+
+  printf("%6s %14s %14s %8s %10s %10s\n", "hits", "legacy (ms)", "current (ms)", "speed-up", "patterns", "different");
+
+  mt19937 rng(20);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., 0.01);
+
+  unsigned int differences = 0;
+
+  for (const unsigned int m : { 5, 10, 20, 50, 100, 200, 500 })
+  {
+    if (m > maxMultiplicity)
+      break;
+
+    vector< edm::DetSetVector<TotemRPRecHit> > events(n);
+    for (auto &hits : events)
+    {
+      for (unsigned int t = 0; t < max(1u, m / 10); ++t)
+      {
+        const double a = (flat(rng) - 0.5) * 0.01, b = (flat(rng) - 0.5) * 60.;
+        for (unsigned int i = 0; i < detIds.size(); ++i)
+          hits.find_or_insert(detIds[i]).push_back(TotemRPRecHit(a * zs[i] + b + gauss(rng), 0.0191));
+      }
+
+      for (unsigned int j = 5 * max(1u, m / 10); j < m; ++j)
+        hits.find_or_insert(detIds[rng() % detIds.size()]).push_back(TotemRPRecHit((flat(rng) - 0.5) * 60., 0.0191));
+    }
+
+    vector< edm::DetSet<TotemRPUVPattern> > legacyPatterns(n), currentPatterns(n);
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      legacy.getPatterns(events[i], 0., 2.99, legacyPatterns[i]);
+    const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      current.getPatterns(events[i], 0., 2.99, currentPatterns[i]);
+    const double currentTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    unsigned int patterns = 0, different = 0;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      patterns += currentPatterns[i].size();
+      if (!SamePatterns(legacyPatterns[i], currentPatterns[i]))
+        different++;
+    }
+
+    differences += different;
+
+    printf("%6u %14.3f %14.3f %8.1f %10u %10u\n", m, legacyTime * 1E3, currentTime * 1E3, legacyTime / currentTime,
+      patterns, different);
+  }
+
+  if (differences > 0)
+    printf("ERROR: the implementations differ in %u events.\n", differences);
+
+  return (differences == 0) ? 0 : 2;
+}
@@ -0,0 +1,165 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
+#include "RecoCTPPS/TotemRPLocal/interface/HoughLineRecognition.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// line recognition with the plane data given by hand
+template <class T>
+class BenchmarkLineRecognition : public T
+{
+  public:
+    using T::T;
+
+    /// the readout direction is along x, hence s is the x position of the centre
+    void setGeometry(unsigned int detId, double z, double s)
+    {
+      planes.setPlane(detId, s, 0., z, 1., 0.);
+      this->resetGeometry(&planes);
+    }
+
+  private:
+    TotemRPPlaneTable planes;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkHoughLineRecognition [option]\n");
+  printf("Compares the per-projection time of the pair-based (fast) and the accumulator-based (hough) line\n");
+  printf("recognition as a function of the number of hits. Half of the hits come from tracks, half is noise.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of events per multiplicity (default 20)\n");
+  printf("    -f <number>     maximum multiplicity for the fast algorithm (default 200)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 20;
+  unsigned int maxFast = 200;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { maxFast = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // U planes of one RP
+  vector<unsigned int> detIds;
+  vector<double> zs;
+  for (unsigned int plane = 0; plane < 10; plane += 2)
+  {
+    detIds.push_back(TotemRPDetId::decToRawId(1200 + plane));
+    zs.push_back((plane - 4.5) * 4.5);
+  }
+
+  edm::ParameterSet houghSettings;
+  houghSettings.addParameter<double>("max_a", 0.1);
+  houghSettings.addParameter<double>("max_b", 50.);
+  houghSettings.addParameter<double>("binSize_a", 0.01);
+  houghSettings.addParameter<double>("binSize_b", 0.3);
+  houghSettings.addParameter<unsigned int>("zoomSteps", 0);
+  houghSettings.addParameter<unsigned int>("zoomFactor", 4);
+
+  edm::ParameterSet houghZoomSettings(houghSettings);
+  houghZoomSettings.addParameter<unsigned int>("zoomSteps", 2);
+
+  BenchmarkLineRecognition<FastLineRecognition> fast(0.02, 0.3);
+  BenchmarkLineRecognition<HoughLineRecognition> hough(0.02, 0.3, houghSettings);
+  BenchmarkLineRecognition<HoughLineRecognition> houghZoom(0.02, 0.3, houghZoomSettings);
+
+  for (unsigned int i = 0; i < detIds.size(); ++i)
+  {
+    fast.setGeometry(detIds[i], zs[i], 0.);
+    hough.setGeometry(detIds[i], zs[i], 0.);
+    houghZoom.setGeometry(detIds[i], zs[i], 0.);
+  }
+
+  const vector<unsigned int> multiplicities = { 10, 20, 50, 100, 200, 500 };
+
+  printf("%6s %14s %14s %14s %8s %16s\n", "hits", "fast (ms)", "hough (ms)", "h. zoom (ms)", "speed-up",
+    "patterns f/h/hz");
+
+  mt19937 rng(19);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., 0.01);
+
+  for (const auto &m : multiplicities)
+  {
+    // events
+    vector< edm::DetSetVector<TotemRPRecHit> > events(n);
+    for (auto &hits : events)
+    {
+      for (unsigned int t = 0; t < m / 10; ++t)
+      {
+        const double a = (flat(rng) - 0.5) * 0.01, b = (flat(rng) - 0.5) * 60.;
+        for (unsigned int i = 0; i < detIds.size(); ++i)
+          hits.find_or_insert(detIds[i]).push_back(TotemRPRecHit(a * zs[i] + b + gauss(rng), 0.0191));
+      }
+
+      for (unsigned int j = 5 * (m / 10); j < m; ++j)
+        hits.find_or_insert(detIds[rng() % detIds.size()]).push_back(TotemRPRecHit((flat(rng) - 0.5) * 60., 0.0191));
+    }
+
+    // timing
+    auto run = [&] (FastLineRecognition &lrcgn, unsigned long &patterns)
+    {
+      patterns = 0;
+      auto start = chrono::steady_clock::now();
+      for (const auto &hits : events)
+      {
+        edm::DetSet<TotemRPUVPattern> output;
+        lrcgn.getPatterns(hits, 0., 2.99, output);
+        patterns += output.size();
+      }
+      return chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+    };
+
+    unsigned long p_fast = 0, p_hough = 0, p_houghZoom = 0;
+    const double t_fast = (m <= maxFast) ? run(fast, p_fast) : 0.;
+    const double t_hough = run(hough, p_hough);
+    const double t_houghZoom = run(houghZoom, p_houghZoom);
+
+    if (m <= maxFast)
+      printf("%6u %14.3f %14.3f %14.3f %8.1f %6lu/%lu/%lu\n", m, t_fast * 1E3, t_hough * 1E3, t_houghZoom * 1E3,
+        t_fast / t_hough, p_fast, p_hough, p_houghZoom);
+    else
+      printf("%6u %14s %14.3f %14.3f %8s %6s/%lu/%lu\n", m, "-", t_hough * 1E3, t_houghZoom * 1E3, "-", "-",
+        p_hough, p_houghZoom);
+  }
+
+  return 0;
+}
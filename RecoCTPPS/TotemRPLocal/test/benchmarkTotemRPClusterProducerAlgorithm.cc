@@ -0,0 +1,168 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPClusterProducerAlgorithm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former TotemRPClusterProducerAlgorithm::buildClusters: sorted through a set, contiguous strips only
+void LegacyClusters(const vector<TotemRPDigi> &digi, set<TotemRPDigi> &strip_digi_set, vector<TotemRPCluster> &clusters)
+{
+  clusters.clear();
+
+  strip_digi_set.clear();
+  strip_digi_set.insert(digi.begin(), digi.end());
+
+  bool iter_beg = true;
+  int cluster_beg = -16, cluster_end, prev_strip = -16;
+
+  for (const auto &d : strip_digi_set)
+  {
+    const int cur_strip = d.getStripNumber();
+
+    if (iter_beg)
+    {
+      cluster_beg = cur_strip;
+      iter_beg = false;
+    } else if (cur_strip != prev_strip + 1)
+    {
+      cluster_end = prev_strip;
+      clusters.push_back(TotemRPCluster(cluster_beg, cluster_end));
+      cluster_beg = cur_strip;
+    }
+
+    prev_strip = cur_strip;
+  }
+
+  if (!iter_beg)
+  {
+    cluster_end = prev_strip;
+    clusters.push_back(TotemRPCluster(cluster_beg, cluster_end));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPClusterProducerAlgorithm [option]\n");
+  printf("Compares the per-plane clustering time of the former (set-based) and the bitmap algorithm\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of planes per configuration (default 1000000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 1000000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  edm::ParameterSet ps;
+  ps.addParameter<int>("verbosity", 0);
+  ps.addParameter<unsigned int>("maxGap", 0);
+  ps.addParameter<unsigned int>("maxWidth", 0);
+  TotemRPClusterProducerAlgorithm algorithm(ps);
+
+  // occupancy configurations: number of clusters per plane and cluster size
+  struct Configuration
+  {
+    unsigned int clusters, size;
+  };
+
+  const vector<Configuration> configurations = { {1, 1}, {1, 3}, {3, 2}, {10, 2}, {30, 3}, {100, 2} };
+
+  // a pool of planes, the strips in the order of the VFAT readout (ascending per chip, chips in any order)
+  const unsigned int poolSize = 1000;
+  mt19937 rng(17);
+
+  printf("%9s %6s %8s %14s %14s %8s\n", "clusters", "size", "digis", "legacy (ns)", "bitmap (ns)", "speed-up");
+
+  bool ok = true;
+
+  for (const auto &c : configurations)
+  {
+    vector< vector<TotemRPDigi> > pool(poolSize);
+    unsigned long digis = 0;
+    for (auto &digi : pool)
+    {
+      set<unsigned int> strips;
+      for (unsigned int i = 0; i < c.clusters; ++i)
+      {
+        const unsigned int beg = rng() % (512 - c.size);
+        for (unsigned int s = beg; s < beg + c.size; ++s)
+          strips.insert(s);
+      }
+
+      for (const auto &s : strips)
+        digi.push_back(s);
+      rotate(digi.begin(), digi.begin() + digi.size() / 2, digi.end());
+
+      digis += digi.size();
+    }
+
+    vector<TotemRPCluster> clusters, legacyClusters;
+    set<TotemRPDigi> strip_digi_set;
+
+    unsigned long checksumLegacy = 0, checksumBitmap = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      LegacyClusters(pool[i % poolSize], strip_digi_set, legacyClusters);
+      checksumLegacy += legacyClusters.size();
+    }
+    const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      algorithm.buildClusters(0, pool[i % poolSize], clusters);
+      checksumBitmap += clusters.size();
+    }
+    const double bitmapTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    printf("%9u %6u %8.1f %14.1f %14.1f %8.1f\n", c.clusters, c.size, double(digis) / poolSize, legacyTime * 1E9,
+      bitmapTime * 1E9, legacyTime / bitmapTime);
+
+    if (checksumLegacy != checksumBitmap)
+    {
+      printf("ERROR: different numbers of clusters.\n");
+      ok = false;
+    }
+  }
+
+  return (ok) ? 0 : 2;
+}
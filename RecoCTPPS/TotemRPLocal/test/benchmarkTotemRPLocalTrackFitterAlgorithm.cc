@@ -0,0 +1,144 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPLocalTrackFitterAlgorithm [option]\n");
+  printf("Compares the fit rate of the \"matrix\" and \"cholesky\" methods of TotemRPLocalTrackFitterAlgorithm,\n");
+  printf("as a function of the number of hits per track (10 planes, 1 or more hits per plane).\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of tracks per configuration (default 100000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 100000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const double z_0 = 203827.;
+  const double sigma = 66E-3 / sqrt(12.);
+
+  // planes of one RP: U (odd) and V (even) planes, 4.5 mm apart
+  vector<unsigned int> detIds;
+  vector<TVector3> centres;
+  vector<TVector2> readoutDirections;
+
+  edm::ParameterSet ps_matrix, ps_cholesky;
+  ps_matrix.addParameter<string>("fitMethod", "matrix");
+  ps_cholesky.addParameter<string>("fitMethod", "cholesky");
+
+  TotemRPLocalTrackFitterAlgorithm matrix(ps_matrix), cholesky(ps_cholesky);
+
+  // the geometry given by hand, instead of TotemRPGeometry
+  TotemRPPlaneTable geometry;
+
+  for (unsigned int det = 0; det < 10; ++det)
+  {
+    const double phi = ((det % 2) ? M_PI/4. : 3.*M_PI/4.) + 1E-3 * (det - 4.5);
+
+    detIds.push_back(TotemRPDetId::decToRawId(1200 + det));
+    centres.push_back(TVector3(1.2, -7.3, z_0 + (det - 4.5) * 4.5));
+    readoutDirections.push_back(TVector2(cos(phi), sin(phi)));
+
+    geometry.setPlane(detIds.back(), centres.back().X(), centres.back().Y(), centres.back().Z(),
+      readoutDirections.back().X(), readoutDirections.back().Y());
+  }
+
+  mt19937 rng(21);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., sigma);
+
+  printf("%6s %18s %18s %8s %12s\n", "hits", "matrix (tracks/s)", "chol. (tracks/s)", "speed-up", "max |da|/sig");
+
+  for (const unsigned int hitsPerPlane : { 1, 2, 5 })
+  {
+    // tracks, a few different ones repeated
+    vector< edm::DetSetVector<TotemRPRecHit> > tracks(100);
+    for (auto &hits : tracks)
+    {
+      const double x0 = (flat(rng) - 0.5) * 20., y0 = (flat(rng) - 0.5) * 20.;
+      const double tx = (flat(rng) - 0.5) * 2E-3, ty = (flat(rng) - 0.5) * 2E-3;
+
+      for (unsigned int i = 0; i < detIds.size(); ++i)
+      {
+        const double dz = centres[i].Z() - z_0;
+        const TVector2 point(x0 + tx * dz - centres[i].X(), y0 + ty * dz - centres[i].Y());
+        for (unsigned int j = 0; j < hitsPerPlane; ++j)
+          hits.find_or_insert(detIds[i]).push_back(TotemRPRecHit(readoutDirections[i] * point + gauss(rng), sigma));
+      }
+    }
+
+    auto run = [&] (TotemRPLocalTrackFitterAlgorithm &fitter)
+    {
+      auto start = chrono::steady_clock::now();
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        TotemRPLocalTrack track;
+        fitter.fitTrack(tracks[i % tracks.size()], z_0, geometry, track);
+      }
+      return n / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    const double r_matrix = run(matrix);
+    const double r_cholesky = run(cholesky);
+
+    // agreement
+    double maxDiff = 0.;
+    for (const auto &hits : tracks)
+    {
+      TotemRPLocalTrack t_matrix, t_cholesky;
+      matrix.fitTrack(hits, z_0, geometry, t_matrix);
+      cholesky.fitTrack(hits, z_0, geometry, t_cholesky);
+
+      const TVectorD p_m = t_matrix.getParameterVector(), p_c = t_cholesky.getParameterVector();
+      const TMatrixD V_m = t_matrix.getCovarianceMatrix();
+      for (int k = 0; k < TotemRPLocalTrack::dimension; ++k)
+        maxDiff = max(maxDiff, fabs(p_m[k] - p_c[k]) / sqrt(V_m(k, k)));
+    }
+
+    printf("%6u %18.0f %18.0f %8.1f %12.1E\n", hitsPerPlane * (unsigned int) detIds.size(), r_matrix, r_cholesky,
+      r_cholesky / r_matrix, maxDiff);
+  }
+
+  return 0;
+}
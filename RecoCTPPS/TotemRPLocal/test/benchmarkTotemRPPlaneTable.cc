@@ -0,0 +1,219 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "Geometry/VeryForwardGeometryBuilder/interface/TotemRPPlaneTable.h"
+
+#include "TVector2.h"
+#include "TVector3.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// allocator counting the allocated bytes
+size_t allocatedBytes = 0;
+
+template <class T>
+struct CountingAllocator
+{
+  typedef T value_type;
+
+  CountingAllocator() {}
+  template <class U> CountingAllocator(const CountingAllocator<U> &) {}
+
+  T* allocate(size_t n)
+  {
+    allocatedBytes += n * sizeof(T);
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_t n)
+  {
+    allocatedBytes -= n * sizeof(T);
+    ::operator delete(p);
+  }
+
+  template <class U> bool operator==(const CountingAllocator<U> &) const { return true; }
+  template <class U> bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former per-detector cache of TotemRPLocalTrackFitterAlgorithm
+struct RPDetCoordinateAlgebraObjs
+{
+  TVector3 centre_of_det_global_position_;
+  double rec_u_0_;
+  TVector2 readout_direction_;
+  bool available_;
+};
+
+typedef unordered_map<unsigned int, RPDetCoordinateAlgebraObjs, hash<unsigned int>, equal_to<unsigned int>,
+  CountingAllocator< pair<const unsigned int, RPDetCoordinateAlgebraObjs> > > LegacyMap;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPPlaneTable [option]\n");
+  printf("Compares the per-plane data lookup in the former hash map (keyed by raw ID) with the flat\n");
+  printf("TotemRPPlaneTable (indexed by compact plane index) and reports the memory footprint of both.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of lookups (default 10000000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 10000000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // 12 RPs (2 arms x 2 stations x 3 RPs), 10 planes each
+  vector<unsigned int> detIds;
+  for (unsigned int arm = 0; arm < 2; ++arm)
+    for (unsigned int station : { 0, 2 })
+      for (unsigned int rp = 0; rp < 3; ++rp)
+        for (unsigned int det = 0; det < 10; ++det)
+          detIds.push_back(TotemRPDetId::decToRawId(arm*1000 + station*100 + rp*10 + det));
+
+  mt19937 rng(24);
+  uniform_real_distribution<double> flat(0., 1.);
+
+  LegacyMap legacy;
+  TotemRPPlaneTable table;
+
+  for (const auto &detId : detIds)
+  {
+    const double phi = flat(rng) * 2. * M_PI;
+    const double cx = flat(rng), cy = flat(rng), cz = 2E5 * flat(rng);
+
+    RPDetCoordinateAlgebraObjs &alg = legacy[detId];
+    alg.centre_of_det_global_position_ = TVector3(cx, cy, cz);
+    alg.readout_direction_ = TVector2(cos(phi), sin(phi));
+    alg.rec_u_0_ = - (alg.readout_direction_ * alg.centre_of_det_global_position_.XYvector());
+    alg.available_ = true;
+
+    table.setPlane(detId, cx, cy, cz, cos(phi), sin(phi));
+  }
+
+  // IDs with a field out of range (det 10-15, RP 6-7, station 3) must not alias a valid plane
+  const unsigned int base = TotemRPDetId::decToRawId(1229);
+  vector<unsigned int> invalidIds;
+  for (unsigned int det = TotemRPDetId::maxDet + 1; det <= TotemRPDetId::maskDet; ++det)
+    invalidIds.push_back((base & ~(TotemRPDetId::maskDet << TotemRPDetId::startDetBit))
+      | (det << TotemRPDetId::startDetBit));
+  for (unsigned int rp = TotemRPDetId::maxRP + 1; rp <= TotemRPDetId::maskRP; ++rp)
+    invalidIds.push_back((base & ~(TotemRPDetId::maskRP << TotemRPDetId::startRPBit))
+      | (rp << TotemRPDetId::startRPBit));
+  for (unsigned int station = TotemRPDetId::maxStation + 1; station <= TotemRPDetId::maskStation; ++station)
+    invalidIds.push_back((base & ~(TotemRPDetId::maskStation << TotemRPDetId::startStationBit))
+      | (station << TotemRPDetId::startStationBit));
+
+  for (const auto &id : invalidIds)
+  {
+    bool rejected = false;
+    try
+    {
+      table.setPlane(id, 0., 0., 0., 1., 0.);
+    }
+    catch (const cms::Exception &)
+    {
+      rejected = true;
+    }
+
+    if (TotemRPDetId::rawToPlaneIndex(id) != TotemRPDetId::numberOfPlaneIndices || table.getPlane(id) || !rejected)
+    {
+      printf("ERROR: invalid ID %08x accepted as plane index %u.\n", id, TotemRPDetId::rawToPlaneIndex(id));
+      return 2;
+    }
+  }
+
+  // a sequence of hits: planes of a random RP, in the order of the DetSetVector
+  vector<unsigned int> sequence;
+  while (sequence.size() < 100000)
+  {
+    const unsigned int rp = rng() % 12;
+    for (unsigned int det = 0; det < 10; ++det)
+      sequence.push_back(detIds[rp*10 + det]);
+  }
+
+  auto run = [&] (const char *label, double &result, auto lookup)
+  {
+    double sum = 0.;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      sum += lookup(sequence[i % sequence.size()]);
+    const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%-28s %12.2f\n", label, time / n * 1E9);
+    result = sum;
+    return time;
+  };
+
+  printf("%-28s %12s\n", "lookup", "ns/lookup");
+
+  double r_legacy = 0., r_table = 0.;
+  const double t_legacy = run("hash map (raw ID)", r_legacy, [&] (unsigned int id)
+    {
+      const RPDetCoordinateAlgebraObjs &alg = legacy.find(id)->second;
+      return alg.readout_direction_.X() + alg.centre_of_det_global_position_.Z() + alg.rec_u_0_;
+    }
+  );
+
+  const double t_table = run("plane table (plane index)", r_table, [&] (unsigned int id)
+    {
+      const TotemRPPlaneTable::Plane *p = table.getPlane(id);
+      return p->dx + p->cz + p->u0;
+    }
+  );
+
+  printf("speed-up: %.2f\n", t_legacy / t_table);
+
+  printf("\n%-28s %12s %12s\n", "memory", "bytes", "bytes/plane");
+  const size_t m_legacy = sizeof(legacy) + allocatedBytes;
+  printf("%-28s %12lu %12.1f\n", "hash map, 120 planes", m_legacy, double(m_legacy) / detIds.size());
+  printf("%-28s %12u %12.1f\n", "plane table, all planes", table.size(),
+    double(table.size()) / TotemRPDetId::numberOfPlaneIndices);
+  printf("(the hash map was built per fitter, i.e. per stream, the table is shared by all streams)\n");
+
+  if (fabs(r_legacy - r_table) > 1E-6 * fabs(r_legacy))
+  {
+    printf("ERROR: the lookups gave different results.\n");
+    return 2;
+  }
+
+  return 0;
+}
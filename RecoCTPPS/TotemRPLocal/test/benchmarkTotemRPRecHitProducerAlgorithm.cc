@@ -0,0 +1,137 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPRecHitProducerAlgorithm.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former TotemRPRecHitProducer: topology call per cluster, hits copied into the event afterwards
+void LegacyRecoHits(const RPTopology &topology, const edm::DetSetVector<TotemRPCluster> &input,
+  edm::DetSetVector<TotemRPRecHit> &result)
+{
+  edm::DetSetVector<TotemRPRecHit> output;
+
+  for (const auto &ids : input)
+  {
+    edm::DetSet<TotemRPRecHit> &ods = output.find_or_insert(ids.detId());
+    for (const auto &cl : ids.data)
+    {
+      constexpr double nominal_sigma = 0.0191;
+      ods.push_back(TotemRPRecHit(topology.GetHitPositionInReadoutDirection(cl.getCenterStripPosition()), nominal_sigma));
+    }
+  }
+
+  result = output;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPRecHitProducerAlgorithm [option]\n");
+  printf("Compares the per-event time of the former (per-cluster) and the table-based, batched hit production\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of events per configuration (default 100000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 100000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  RPTopology topology;
+
+  edm::ParameterSet ps;
+  ps.addParameter< vector<double> >("clusterSizeSigmas", { 0.016, 0.010, 0.025 });
+  ps.addParameter("planeClusterSizeSigmas", vector<edm::ParameterSet>());
+  TotemRPRecHitProducerAlgorithm algorithm(ps);
+
+  // configurations: number of planes with clusters and clusters per plane
+  struct Configuration
+  {
+    unsigned int planes, clusters;
+  };
+
+  const vector<Configuration> configurations = { {20, 1}, {120, 1}, {120, 3}, {120, 10} };
+
+  printf("%7s %9s %14s %14s %8s\n", "planes", "clusters", "legacy (us)", "batched (us)", "speed-up");
+
+  mt19937 rng(18);
+  bool ok = true;
+
+  for (const auto &c : configurations)
+  {
+    edm::DetSetVector<TotemRPCluster> input;
+    for (unsigned int p = 0; p < c.planes; ++p)
+    {
+      const unsigned int dec = (p / 60) * 1000 + ((p / 30) % 2) * 100 + ((p / 10) % 3) * 10 + p % 10;
+      edm::DetSet<TotemRPCluster> &ds = input.find_or_insert(TotemRPDetId::decToRawId(dec));
+      for (unsigned int i = 0; i < c.clusters; ++i)
+      {
+        const unsigned int beg = rng() % 510;
+        ds.data.push_back(TotemRPCluster(beg, beg + rng() % 3));
+      }
+    }
+
+    edm::DetSetVector<TotemRPRecHit> legacyOutput;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+      LegacyRecoHits(topology, input, legacyOutput);
+    const double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    unsigned long count = 0;
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      edm::DetSetVector<TotemRPRecHit> output;
+      algorithm.buildRecoHits(input, output);
+      count += output.size();
+    }
+    const double batchedTime = chrono::duration<double>(chrono::steady_clock::now() - start).count() / n;
+
+    printf("%7u %9u %14.3f %14.3f %8.1f\n", c.planes, c.clusters, legacyTime * 1E6, batchedTime * 1E6,
+      legacyTime / batchedTime);
+
+    if (count != (unsigned long) n * legacyOutput.size())
+    {
+      printf("ERROR: different number of planes.\n");
+      ok = false;
+    }
+  }
+
+  return (ok) ? 0 : 2;
+}
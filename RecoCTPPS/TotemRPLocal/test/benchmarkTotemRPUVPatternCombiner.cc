@@ -0,0 +1,155 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPUVPatternCombiner.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPUVPatternCombiner [option]\n");
+  printf("Measures the per-RP time of the greedy and global U-V pattern combination as a function of the\n");
+  printf("number of patterns per projection (one U and one V pattern per track, 5 hits each).\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of RPs per multiplicity (default 2000)\n");
+  printf("    -f <method>     fit method, matrix or cholesky (default cholesky)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 2000;
+  string fitMethod = "cholesky";
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fitMethod = argv[++i]; continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const double z0 = 203827.;
+  const double sigma = 66E-3 / sqrt(12.);
+
+  // planes of one RP
+  vector<unsigned int> detIds;
+  vector<TVector3> centres;
+  vector<TVector2> readoutDirections;
+
+  edm::ParameterSet ps_fitter;
+  ps_fitter.addParameter<string>("fitMethod", fitMethod);
+  TotemRPLocalTrackFitterAlgorithm fitter(ps_fitter);
+
+  // the geometry given by hand, instead of TotemRPGeometry
+  TotemRPPlaneTable geometry;
+
+  for (unsigned int det = 0; det < 10; ++det)
+  {
+    const double phi = ((det % 2) ? M_PI/4. : 3.*M_PI/4.) + 1E-3 * (det - 4.5);
+
+    detIds.push_back(TotemRPDetId::decToRawId(1200 + det));
+    centres.push_back(TVector3(0., 0., z0 + (det - 4.5) * 4.5));
+    readoutDirections.push_back(TVector2(cos(phi), sin(phi)));
+
+    geometry.setPlane(detIds.back(), centres.back().X(), centres.back().Y(), centres.back().Z(),
+      readoutDirections.back().X(), readoutDirections.back().Y());
+  }
+
+  // combiners
+  edm::ParameterSet settings;
+  settings.addParameter<unsigned int>("maxPatternsPerProjection", 10);
+  settings.addParameter<double>("maxChiSquaredOverNDF", 10.);
+  settings.addParameter<bool>("requireSensitiveArea", true);
+
+  TotemRPUVPatternCombiner greedy("greedy", settings), global("global", settings);
+
+  mt19937 rng(22);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., sigma);
+
+  printf("%9s %7s %16s %16s %16s\n", "patterns", "pairs", "greedy (RP/s)", "global (RP/s)", "tracks g/gl");
+
+  for (unsigned int m = 1; m <= 6; ++m)
+  {
+    // RPs with m tracks, a few different ones repeated
+    vector< edm::DetSet<TotemRPUVPattern> > rps(50);
+    for (auto &patterns : rps)
+    {
+      for (unsigned int t = 0; t < m; ++t)
+      {
+        const double x0 = (flat(rng) - 0.5) * 10., y0 = (flat(rng) - 0.5) * 10. + 8.;
+
+        TotemRPUVPattern pu, pv;
+        pu.setProjection(TotemRPUVPattern::projU);
+        pv.setProjection(TotemRPUVPattern::projV);
+        pu.setFittable(true);
+        pv.setFittable(true);
+
+        for (unsigned int i = 0; i < detIds.size(); ++i)
+        {
+          const TVector2 point(x0 - centres[i].X(), y0 - centres[i].Y());
+          const TotemRPRecHit hit(readoutDirections[i] * point + gauss(rng), sigma);
+          if (i % 2)
+            pu.addHit(detIds[i], hit);
+          else
+            pv.addHit(detIds[i], hit);
+        }
+
+        patterns.push_back(pu);
+        patterns.push_back(pv);
+      }
+    }
+
+    auto run = [&] (TotemRPUVPatternCombiner &combiner, unsigned long &tracks)
+    {
+      tracks = 0;
+      auto start = chrono::steady_clock::now();
+      for (unsigned int i = 0; i < n; ++i)
+      {
+        vector<TotemRPLocalTrack> output;
+        combiner.combine(rps[i % rps.size()], z0, geometry, fitter, output);
+        tracks += output.size();
+      }
+      return n / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    unsigned long t_greedy = 0, t_global = 0;
+    const double r_greedy = run(greedy, t_greedy);
+    const double r_global = run(global, t_global);
+
+    printf("%9u %7u %16.0f %16.0f %7lu/%lu\n", m, m * m, r_greedy, r_global, t_greedy, t_global);
+  }
+
+  return 0;
+}
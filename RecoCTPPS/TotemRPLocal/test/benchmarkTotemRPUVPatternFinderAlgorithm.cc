@@ -0,0 +1,276 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPUVPatternFinderAlgorithm.h"
+
+#include "tbb/task_arena.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+edm::ParameterSet MakeConfiguration(const string &algorithm, bool parallel)
+{
+  edm::ParameterSet ps;
+  ps.addUntrackedParameter<unsigned int>("verbosity", 0);
+  ps.addUntrackedParameter<bool>("parallelRecognition", parallel);
+  ps.addParameter<unsigned int>("maxHitsPerPlaneToSearch", 5);
+  ps.addParameter<unsigned int>("minPlanesPerProjectionToSearch", 3);
+  ps.addParameter<unsigned int>("minPlanesPerProjectionToFit", 3);
+  ps.addParameter<string>("lineRecognitionAlgorithm", algorithm);
+  ps.addParameter<double>("clusterSize_a", 0.02);
+  ps.addParameter<double>("clusterSize_b", 0.3);
+  ps.addParameter<double>("threshold", 2.99);
+  ps.addParameter<double>("max_a_toFit", 10.);
+  ps.addParameter< vector<edm::ParameterSet> >("exceptionalSettings", vector<edm::ParameterSet>());
+
+  edm::ParameterSet hs;
+  hs.addParameter<double>("max_a", 0.1);
+  hs.addParameter<double>("max_b", 50.);
+  hs.addParameter<double>("binSize_a", 0.01);
+  hs.addParameter<double>("binSize_b", 0.3);
+  hs.addParameter<unsigned int>("zoomSteps", 0);
+  hs.addParameter<unsigned int>("zoomFactor", 4);
+  ps.addParameter<edm::ParameterSet>("houghSettings", hs);
+
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// checksum of the output, sensitive to the order of RPs and patterns
+double Checksum(const edm::DetSetVector<TotemRPUVPattern> &output)
+{
+  double sum = 0.;
+  for (const auto &ds : output)
+  {
+    sum = sum * 1.1 + ds.detId();
+    for (const auto &p : ds)
+    {
+      sum = sum * 1.1 + p.getProjection() + p.getA() + p.getB() + p.getW() + p.getFittable();
+      for (const auto &hds : p.getHits())
+        for (const auto &h : hds)
+          sum = sum * 1.01 + hds.detId() + h.getPosition();
+    }
+  }
+  return sum;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkTotemRPUVPatternFinderAlgorithm [option]\n");
+  printf("Compares the serial pattern recognition of all RPs of an event with the parallel one (one task per RP\n");
+  printf("and projection) for 1, 2, 4, ... threads. Events with 12 RPs, each with several tracks and noise.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -e <number>     number of events (default 500)\n");
+  printf("    -k <number>     number of tracks per RP (default 3)\n");
+  printf("    -a <algorithm>  line recognition algorithm, fast or hough (default fast)\n");
+  printf("    -t <number>     maximum number of threads (default: hardware concurrency)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 500;
+  unsigned int tracks = 3;
+  string algorithm = "fast";
+  unsigned int maxThreads = max(1u, thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) { tracks = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) { algorithm = argv[++i]; continue; }
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) { maxThreads = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // 12 RPs: 2 arms x 2 stations x 3 RPs, 10 planes each, 4.5 mm apart
+  struct Plane
+  {
+    unsigned int detId;
+    bool uDir;
+    double z;
+  };
+
+  struct RP
+  {
+    unsigned int id;
+    double z0;
+    vector<Plane> planes;
+  };
+
+  vector<RP> rps;
+  for (unsigned int arm = 0; arm < 2; ++arm)
+  {
+    for (unsigned int station : { 0, 2 })
+    {
+      for (unsigned int rp = 0; rp < 3; ++rp)
+      {
+        RP r;
+        r.id = arm*100 + station*10 + rp;
+        r.z0 = ((arm == 0) ? 1. : -1.) * (203000. + station * 6000. + rp * 500.);
+
+        for (unsigned int det = 0; det < 10; ++det)
+        {
+          const unsigned int decId = r.id * 10 + det;
+          r.planes.push_back({ TotemRPDetId::decToRawId(decId), TotemRPDetId::isStripsCoordinateUDirection(decId),
+            r.z0 + (det - 4.5) * 4.5 });
+        }
+
+        rps.push_back(r);
+      }
+    }
+  }
+
+  // the geometry given by hand, instead of TotemRPGeometry; the readout direction is irrelevant for the
+  // line recognition, only the z positions matter
+  TotemRPPlaneTable geometry;
+  for (const auto &r : rps)
+  {
+    geometry.setRPZ0(r.id, r.z0);
+    for (const auto &pl : r.planes)
+      geometry.setPlane(pl.detId, 0., 0., pl.z, 1., 0.);
+  }
+
+  // a pool of events: in each RP and projection, a few lines and 1 noise hit per plane on average
+  mt19937 rng(23);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., 0.0191);
+
+  const unsigned int poolSize = 50;
+  vector< edm::DetSetVector<TotemRPRecHit> > pool(poolSize);
+  unsigned long hits = 0;
+  for (auto &ev : pool)
+  {
+    for (const auto &r : rps)
+    {
+      for (unsigned int proj = 0; proj < 2; ++proj)
+      {
+        for (unsigned int t = 0; t < tracks; ++t)
+        {
+          const double a = (flat(rng) - 0.5) * 0.02, b = (flat(rng) - 0.5) * 30.;
+          for (const auto &pl : r.planes)
+          {
+            if (pl.uDir != (proj == 0) || flat(rng) < 0.05)
+              continue;
+
+            ev.find_or_insert(pl.detId).push_back(TotemRPRecHit(a * (pl.z - r.z0) + b + gauss(rng), 0.0191));
+            hits++;
+          }
+        }
+      }
+
+      for (const auto &pl : r.planes)
+      {
+        if (flat(rng) < 0.5)
+          continue;
+
+        ev.find_or_insert(pl.detId).push_back(TotemRPRecHit((flat(rng) - 0.5) * 60., 0.0191));
+        hits++;
+      }
+    }
+  }
+
+  // reference: serial recognition
+  TotemRPUVPatternFinderAlgorithm serialFinder(MakeConfiguration(algorithm, false));
+  serialFinder.resetGeometry(&geometry);
+
+  vector<double> refSums(poolSize);
+  unsigned long patterns = 0;
+  double refTime;
+  {
+    auto start = chrono::steady_clock::now();
+    for (unsigned int e = 0; e < events; ++e)
+    {
+      edm::DetSetVector<TotemRPUVPattern> output;
+      serialFinder.run(pool[e % poolSize], output);
+
+      if (e < poolSize)
+      {
+        refSums[e] = Checksum(output);
+        for (const auto &ds : output)
+          patterns += ds.size();
+      }
+    }
+    refTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  printf("%lu RPs per event, %.1f hits and %.1f patterns per event, %u events, algorithm %s\n", rps.size(),
+    double(hits) / poolSize, double(patterns) / min(events, poolSize), events, algorithm.c_str());
+  printf("%-10s %10s %14s %12s %10s\n", "mode", "time (s)", "latency (ms)", "events/s", "speedup");
+  printf("%-10s %10.3f %14.3f %12.1f %10.2f\n", "serial", refTime, refTime / events * 1E3, events / refTime, 1.);
+
+  for (unsigned int threads = 1; ; threads *= 2)
+  {
+    if (threads > maxThreads)
+      threads = maxThreads;
+
+    TotemRPUVPatternFinderAlgorithm parallelFinder(MakeConfiguration(algorithm, true));
+    parallelFinder.resetGeometry(&geometry);
+
+    bool mismatch = false;
+
+    tbb::task_arena arena(threads);
+    auto start = chrono::steady_clock::now();
+    arena.execute([&] ()
+      {
+        for (unsigned int e = 0; e < events; ++e)
+        {
+          edm::DetSetVector<TotemRPUVPattern> output;
+          parallelFinder.run(pool[e % poolSize], output);
+
+          if (e < poolSize && Checksum(output) != refSums[e])
+            mismatch = true;
+        }
+      }
+    );
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    char label[20];
+    snprintf(label, 20, "%u thr", threads);
+    printf("%-10s %10.3f %14.3f %12.1f %10.2f\n", label, time, time / events * 1E3, events / time, refTime / time);
+
+    if (mismatch)
+    {
+      printf("ERROR: the parallel recognition gave different results.\n");
+      return 2;
+    }
+
+    if (threads == maxThreads)
+      break;
+  }
+
+  return 0;
+}
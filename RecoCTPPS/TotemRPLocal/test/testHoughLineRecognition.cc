@@ -0,0 +1,215 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/FastLineRecognition.h"
+#include "RecoCTPPS/TotemRPLocal/interface/HoughLineRecognition.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// line recognition with the plane data given by hand
+template <class T>
+class TestLineRecognition : public T
+{
+  public:
+    using T::T;
+
+    /// the readout direction is along x, hence s is the x position of the centre
+    void setGeometry(unsigned int detId, double z, double s)
+    {
+      planes.setPlane(detId, s, 0., z, 1., 0.);
+      this->resetGeometry(&planes);
+    }
+
+  private:
+    TotemRPPlaneTable planes;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+edm::ParameterSet MakeHoughSettings(unsigned int zoomSteps)
+{
+  edm::ParameterSet ps;
+  ps.addParameter<double>("max_a", 0.1);
+  ps.addParameter<double>("max_b", 50.);
+  ps.addParameter<double>("binSize_a", 0.01);
+  ps.addParameter<double>("binSize_b", 0.3);
+  ps.addParameter<unsigned int>("zoomSteps", zoomSteps);
+  ps.addParameter<unsigned int>("zoomFactor", 4);
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool SamePatterns(const edm::DetSet<TotemRPUVPattern> &p1, const edm::DetSet<TotemRPUVPattern> &p2)
+{
+  if (p1.size() != p2.size())
+    return false;
+
+  for (unsigned int i = 0; i < p1.size(); ++i)
+  {
+    const TotemRPUVPattern &l = p1.data[i], &r = p2.data[i];
+    if (l.getA() != r.getA() || l.getB() != r.getB() || l.getW() != r.getW())
+      return false;
+
+    if (l.getHits().size() != r.getHits().size())
+      return false;
+
+    for (auto lit = l.getHits().begin(), rit = r.getHits().begin(); lit != l.getHits().end(); ++lit, ++rit)
+    {
+      if (lit->detId() != rit->detId() || lit->data.size() != rit->data.size())
+        return false;
+
+      for (unsigned int j = 0; j < lit->data.size(); ++j)
+        if (lit->data[j].getPosition() != rit->data[j].getPosition())
+          return false;
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  int failures = 0;
+
+  // U planes of one RP, 9 mm apart
+  const double z0 = 0.;
+  vector<unsigned int> detIds;
+  vector<double> zs;
+  for (unsigned int plane = 0; plane < 10; plane += 2)
+  {
+    detIds.push_back(TotemRPDetId::decToRawId(1200 + plane));
+    zs.push_back((plane - 4.5) * 4.5);
+  }
+
+  TestLineRecognition<FastLineRecognition> fast(0.02, 0.3);
+  TestLineRecognition<HoughLineRecognition> hough(0.02, 0.3, MakeHoughSettings(0));
+  TestLineRecognition<HoughLineRecognition> houghZoom(0.02, 0.3, MakeHoughSettings(2));
+
+  for (unsigned int i = 0; i < detIds.size(); ++i)
+  {
+    const double s = 3.7 * i - 8.;
+    fast.setGeometry(detIds[i], zs[i], s);
+    hough.setGeometry(detIds[i], zs[i], s);
+    houghZoom.setGeometry(detIds[i], zs[i], s);
+  }
+
+  // events with well-separated tracks (at least 1 mm apart in every plane), some inefficiency and noise hits
+  mt19937 rng(19);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., 0.01);
+
+  const double sigma = 0.0191;
+  unsigned int events = 0, patterns = 0;
+
+  for (unsigned int ev = 0; ev < 2000; ++ev)
+  {
+    const unsigned int n_tracks = 1 + rng() % 4;
+
+    struct Line { double a, b; };
+    vector<Line> lines;
+    while (lines.size() < n_tracks)
+    {
+      const Line l = { (flat(rng) - 0.5) * 0.01, (flat(rng) - 0.5) * 30. };
+
+      bool separated = true;
+      for (const auto &o : lines)
+        for (const auto &z : zs)
+          separated &= (fabs(l.a * z + l.b - o.a * z - o.b) > 1.);
+
+      if (separated)
+        lines.push_back(l);
+    }
+
+    edm::DetSetVector<TotemRPRecHit> hits;
+    for (unsigned int i = 0; i < detIds.size(); ++i)
+    {
+      const double s = 3.7 * i - 8.;
+      for (const auto &l : lines)
+      {
+        if (flat(rng) < 0.1)
+          continue;
+
+        const double h = l.a * zs[i] + l.b + gauss(rng);
+        hits.find_or_insert(detIds[i]).push_back(TotemRPRecHit(h - s, sigma));
+      }
+
+      if (flat(rng) < 0.2)
+      {
+        const double h = (flat(rng) - 0.5) * 30.;
+
+        bool separated = true;
+        for (const auto &l : lines)
+          separated &= (fabs(l.a * zs[i] + l.b - h) > 1.);
+
+        if (separated)
+          hits.find_or_insert(detIds[i]).push_back(TotemRPRecHit(h - s, sigma));
+      }
+    }
+
+    edm::DetSet<TotemRPUVPattern> p_fast, p_hough, p_houghZoom;
+    fast.getPatterns(hits, z0, 2.99, p_fast);
+    hough.getPatterns(hits, z0, 2.99, p_hough);
+    houghZoom.getPatterns(hits, z0, 2.99, p_houghZoom);
+
+    // the accumulator range does not contain steep (combinatorial) lines
+    edm::DetSet<TotemRPUVPattern> p_fastInRange;
+    for (const auto &p : p_fast)
+      if (fabs(p.getA()) < 0.1)
+        p_fastInRange.push_back(p);
+
+    events++;
+    patterns += p_fastInRange.size();
+
+    if (!SamePatterns(p_fastInRange, p_hough) || !SamePatterns(p_fastInRange, p_houghZoom))
+    {
+      printf("ERROR: event %u: patterns differ (fast %lu, hough %lu, hough with zoom %lu).\n", ev,
+        (unsigned long) p_fastInRange.size(), (unsigned long) p_hough.size(), (unsigned long) p_houghZoom.size());
+      failures++;
+    }
+  }
+
+  if (patterns == 0)
+  {
+    printf("ERROR: no patterns found in %u events.\n", events);
+    failures++;
+  }
+
+  // no pattern from too few hits
+  {
+    edm::DetSetVector<TotemRPRecHit> hits;
+    hits.find_or_insert(detIds[0]).push_back(TotemRPRecHit(1., sigma));
+    hits.find_or_insert(detIds[1]).push_back(TotemRPRecHit(1., sigma));
+
+    edm::DetSet<TotemRPUVPattern> p_hough;
+    hough.getPatterns(hits, z0, 2.99, p_hough);
+    if (!p_hough.data.empty())
+    {
+      printf("ERROR: pattern from 2 hits.\n");
+      failures++;
+    }
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPClusterProducerAlgorithm.h"
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// the former TotemRPClusterProducerAlgorithm::buildClusters: sorted through a set, contiguous strips only
+void LegacyClusters(const vector<TotemRPDigi> &digi, vector<TotemRPCluster> &clusters)
+{
+  clusters.clear();
+
+  set<TotemRPDigi> strip_digi_set(digi.begin(), digi.end());
+
+  bool iter_beg = true;
+  int cluster_beg = -16, cluster_end, prev_strip = -16;
+
+  for (const auto &d : strip_digi_set)
+  {
+    const int cur_strip = d.getStripNumber();
+
+    if (iter_beg)
+    {
+      cluster_beg = cur_strip;
+      iter_beg = false;
+    } else if (cur_strip != prev_strip + 1)
+    {
+      cluster_end = prev_strip;
+      clusters.push_back(TotemRPCluster(cluster_beg, cluster_end));
+      cluster_beg = cur_strip;
+    }
+
+    prev_strip = cur_strip;
+  }
+
+  if (!iter_beg)
+  {
+    cluster_end = prev_strip;
+    clusters.push_back(TotemRPCluster(cluster_beg, cluster_end));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// strip-by-strip reference with gap tolerance and width limit
+void ReferenceClusters(const vector<TotemRPDigi> &digi, unsigned int maxGap, unsigned int maxWidth,
+  vector<TotemRPCluster> &clusters)
+{
+  clusters.clear();
+
+  set<unsigned int> strips;
+  for (const auto &d : digi)
+    strips.insert(d.getStripNumber());
+
+  vector< pair<unsigned int, unsigned int> > runs;
+  for (const auto &s : strips)
+  {
+    if (!runs.empty() && s - runs.back().second - 1 <= maxGap)
+      runs.back().second = s;
+    else
+      runs.push_back({s, s});
+  }
+
+  for (const auto &r : runs)
+  {
+    unsigned int beg = r.first;
+    while (maxWidth > 0 && r.second - beg + 1 > maxWidth)
+    {
+      clusters.push_back(TotemRPCluster(beg, beg + maxWidth - 1));
+      beg += maxWidth;
+    }
+    clusters.push_back(TotemRPCluster(beg, r.second));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool Equal(const vector<TotemRPCluster> &c1, const vector<TotemRPCluster> &c2)
+{
+  if (c1.size() != c2.size())
+    return false;
+
+  for (unsigned int i = 0; i < c1.size(); ++i)
+  {
+    if (c1[i].getStripBegin() != c2[i].getStripBegin() || c1[i].getStripEnd() != c2[i].getStripEnd())
+      return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void Print(const char *label, const vector<TotemRPCluster> &clusters)
+{
+  printf("    %s:", label);
+  for (const auto &c : clusters)
+    printf(" [%u, %u]", c.getStripBegin(), c.getStripEnd());
+  printf("\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRPClusterProducerAlgorithm* MakeAlgorithm(edm::ParameterSet &ps, unsigned int maxGap, unsigned int maxWidth)
+{
+  ps.addParameter<int>("verbosity", 0);
+  ps.addParameter<unsigned int>("maxGap", maxGap);
+  ps.addParameter<unsigned int>("maxWidth", maxWidth);
+  return new TotemRPClusterProducerAlgorithm(ps);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  int failures = 0;
+
+  mt19937 rng(17);
+
+  // default configuration against the former algorithm
+  {
+    edm::ParameterSet ps;
+    TotemRPClusterProducerAlgorithm *algorithm = MakeAlgorithm(ps, 0, 0);
+
+    vector<TotemRPCluster> clusters, legacyClusters;
+
+    // special cases: empty plane, first and last strip, word boundaries, full plane
+    vector< vector<TotemRPDigi> > inputs = { {}, {0}, {511}, {0, 511}, {63, 64}, {62, 63, 65}, {127, 128, 129, 191, 192},
+      {5, 5, 4, 4, 3} };
+
+    vector<TotemRPDigi> full;
+    for (unsigned int s = 0; s < 512; ++s)
+      full.push_back(511 - s);
+    inputs.push_back(full);
+
+    // random planes with various occupancies, unsorted and with duplicates
+    for (unsigned int i = 0; i < 20000; ++i)
+    {
+      const unsigned int n = rng() % ((i % 10 == 0) ? 512 : 40);
+      vector<TotemRPDigi> digi;
+      for (unsigned int j = 0; j < n; ++j)
+        digi.push_back(rng() % 512);
+      inputs.push_back(digi);
+    }
+
+    for (const auto &digi : inputs)
+    {
+      const int n = algorithm->buildClusters(0, digi, clusters);
+      LegacyClusters(digi, legacyClusters);
+
+      if (!Equal(clusters, legacyClusters) || n != (int) legacyClusters.size())
+      {
+        printf("ERROR: results differ from the former algorithm (%lu digis).\n", (unsigned long) digi.size());
+        Print("legacy", legacyClusters);
+        Print("bitmap", clusters);
+        failures++;
+        break;
+      }
+    }
+
+    delete algorithm;
+  }
+
+  // gap tolerance and width limit against the strip-by-strip reference
+  for (unsigned int maxGap : { 0, 1, 2, 5, 70 })
+  {
+    for (unsigned int maxWidth : { 0, 1, 3, 8, 100 })
+    {
+      edm::ParameterSet ps;
+      TotemRPClusterProducerAlgorithm *algorithm = MakeAlgorithm(ps, maxGap, maxWidth);
+
+      vector<TotemRPCluster> clusters, referenceClusters;
+
+      for (unsigned int i = 0; i < 2000; ++i)
+      {
+        const unsigned int n = rng() % ((i % 10 == 0) ? 512 : 60);
+        vector<TotemRPDigi> digi;
+        for (unsigned int j = 0; j < n; ++j)
+          digi.push_back(rng() % 512);
+
+        algorithm->buildClusters(0, digi, clusters);
+        ReferenceClusters(digi, maxGap, maxWidth, referenceClusters);
+
+        if (!Equal(clusters, referenceClusters))
+        {
+          printf("ERROR: maxGap = %u, maxWidth = %u: results differ from the reference.\n", maxGap, maxWidth);
+          Print("reference", referenceClusters);
+          Print("bitmap", clusters);
+          failures++;
+          break;
+        }
+      }
+
+      delete algorithm;
+    }
+  }
+
+  // explicit example: gap of 1 strip merged, gap of 2 not; width limit 3
+  {
+    edm::ParameterSet ps;
+    TotemRPClusterProducerAlgorithm *algorithm = MakeAlgorithm(ps, 1, 3);
+
+    vector<TotemRPCluster> clusters;
+    algorithm->buildClusters(0, { 10, 12, 13, 14, 17, 63, 64 }, clusters);
+
+    const vector<TotemRPCluster> expected = { {10, 12}, {13, 14}, {17, 17}, {63, 64} };
+    if (!Equal(clusters, expected))
+    {
+      printf("ERROR: gap/width example.\n");
+      Print("expected", expected);
+      Print("bitmap", clusters);
+      failures++;
+    }
+
+    delete algorithm;
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
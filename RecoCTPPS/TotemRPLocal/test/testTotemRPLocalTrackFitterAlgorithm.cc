@@ -0,0 +1,212 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+edm::ParameterSet MakeConfig(const string &method)
+{
+  edm::ParameterSet ps;
+  ps.addParameter<string>("fitMethod", method);
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// planes of one RP: U (odd) and V (even) planes, 4.5 mm apart, slightly rotated and shifted
+struct Plane
+{
+  unsigned int detId;
+  TVector3 centre;
+  TVector2 readoutDirection;
+};
+
+vector<Plane> MakePlanes(double z_0)
+{
+  vector<Plane> planes;
+  for (unsigned int det = 0; det < 10; ++det)
+  {
+    const double phi = ((det % 2) ? M_PI/4. : 3.*M_PI/4.) + 1E-3 * (det - 4.5);
+
+    Plane p;
+    p.detId = TotemRPDetId::decToRawId(1200 + det);
+    p.centre = TVector3(1.2 + 0.01 * det, -7.3 + 0.02 * det, z_0 + (det - 4.5) * 4.5);
+    p.readoutDirection = TVector2(cos(phi), sin(phi));
+    planes.push_back(p);
+  }
+
+  return planes;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// maximal deviations between the two methods, in units of the respective uncertainties
+struct Deviations
+{
+  double par = 0., cov = 0., chi2 = 0., residual = 0., pull = 0.;
+
+  void update(const TotemRPLocalTrack &m, const TotemRPLocalTrack &c, double sigma)
+  {
+    const TVectorD p_m = m.getParameterVector(), p_c = c.getParameterVector();
+    const TMatrixD V_m = m.getCovarianceMatrix(), V_c = c.getCovarianceMatrix();
+
+    for (int i = 0; i < TotemRPLocalTrack::dimension; ++i)
+    {
+      par = max(par, fabs(p_m[i] - p_c[i]) / sqrt(V_m(i, i)));
+
+      for (int j = 0; j < TotemRPLocalTrack::dimension; ++j)
+        cov = max(cov, fabs(V_m(i, j) - V_c(i, j)) / sqrt(V_m(i, i) * V_m(j, j)));
+    }
+
+    chi2 = max(chi2, fabs(m.getChiSquared() - c.getChiSquared()) / max(1., m.getChiSquared()));
+
+    for (auto mit = m.getHits().begin(), cit = c.getHits().begin(); mit != m.getHits().end(); ++mit, ++cit)
+    {
+      for (unsigned int k = 0; k < mit->data.size(); ++k)
+      {
+        residual = max(residual, fabs(mit->data[k].getResidual() - cit->data[k].getResidual()) / sigma);
+        pull = max(pull, fabs(mit->data[k].getPull() - cit->data[k].getPull()));
+      }
+    }
+  }
+};
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  int failures = 0;
+
+  const double z_0 = 203827.;
+  const double sigma = 66E-3 / sqrt(12.);
+
+  const vector<Plane> planes = MakePlanes(z_0);
+
+  TotemRPLocalTrackFitterAlgorithm matrix(MakeConfig("matrix")), cholesky(MakeConfig("cholesky"));
+
+  // the geometry given by hand, instead of TotemRPGeometry
+  TotemRPPlaneTable geometry;
+  for (const auto &p : planes)
+    geometry.setPlane(p.detId, p.centre.X(), p.centre.Y(), p.centre.Z(), p.readoutDirection.X(),
+      p.readoutDirection.Y());
+
+  // random tracks with plane inefficiency, at least 5 hits and both projections
+  mt19937 rng(21);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., sigma);
+
+  Deviations dev;
+  unsigned int tracks = 0;
+
+  for (unsigned int ev = 0; ev < 10000; ++ev)
+  {
+    const double x0 = (flat(rng) - 0.5) * 20., y0 = (flat(rng) - 0.5) * 20.;
+    const double tx = (flat(rng) - 0.5) * 2E-3, ty = (flat(rng) - 0.5) * 2E-3;
+
+    edm::DetSetVector<TotemRPRecHit> hits;
+    unsigned int n_U = 0, n_V = 0;
+    for (const auto &p : planes)
+    {
+      if (flat(rng) < 0.15)
+        continue;
+
+      const double dz = p.centre.Z() - z_0;
+      const TVector2 point(x0 + tx * dz - p.centre.X(), y0 + ty * dz - p.centre.Y());
+      hits.find_or_insert(p.detId).push_back(TotemRPRecHit(p.readoutDirection * point + gauss(rng), sigma));
+
+      if (TotemRPDetId::isStripsCoordinateUDirection(TotemRPDetId::rawToDecId(p.detId) % 10))
+        n_U++;
+      else
+        n_V++;
+    }
+
+    if (n_U < 3 || n_V < 3)
+      continue;
+
+    TotemRPLocalTrack t_matrix, t_cholesky;
+    const bool r_matrix = matrix.fitTrack(hits, z_0, geometry, t_matrix);
+    const bool r_cholesky = cholesky.fitTrack(hits, z_0, geometry, t_cholesky);
+
+    if (!r_matrix || !r_cholesky || !t_matrix.isValid() || !t_cholesky.isValid()
+      || t_matrix.getHits().size() != t_cholesky.getHits().size())
+    {
+      printf("ERROR: event %u: fit failed or hits differ (matrix %i, cholesky %i).\n", ev, r_matrix, r_cholesky);
+      failures++;
+      continue;
+    }
+
+    tracks++;
+    dev.update(t_matrix, t_cholesky, sigma);
+  }
+
+  printf("tracks compared: %u\n", tracks);
+  printf("maximal deviation (cholesky - matrix):\n");
+  printf("    parameters: %.2E sigma\n", dev.par);
+  printf("    covariance: %.2E (correlation units)\n", dev.cov);
+  printf("    chi^2: %.2E (relative)\n", dev.chi2);
+  printf("    residuals: %.2E sigma\n", dev.residual);
+  printf("    pulls: %.2E\n", dev.pull);
+
+  if (tracks == 0 || dev.par > 1E-6 || dev.cov > 1E-9 || dev.chi2 > 1E-9 || dev.residual > 1E-6 || dev.pull > 1E-6)
+  {
+    printf("ERROR: the methods are not equivalent.\n");
+    failures++;
+  }
+
+  // only parallel readout directions: the cholesky method rejects the singular problem
+  {
+    TotemRPPlaneTable parallelGeometry;
+
+    edm::DetSetVector<TotemRPRecHit> hits;
+    for (const auto &p : planes)
+    {
+      parallelGeometry.setPlane(p.detId, p.centre.X(), p.centre.Y(), p.centre.Z(), 1., 1.);
+      hits.find_or_insert(p.detId).push_back(TotemRPRecHit(1., sigma));
+    }
+
+    TotemRPLocalTrack track;
+    if (cholesky.fitTrack(hits, z_0, parallelGeometry, track) || track.isValid())
+    {
+      printf("ERROR: track fitted from a single projection.\n");
+      failures++;
+    }
+  }
+
+  // too few hits
+  {
+    edm::DetSetVector<TotemRPRecHit> hits;
+    for (unsigned int i = 0; i < 4; ++i)
+      hits.find_or_insert(planes[i].detId).push_back(TotemRPRecHit(1., sigma));
+
+    TotemRPLocalTrack track;
+    if (cholesky.fitTrack(hits, z_0, geometry, track) || matrix.fitTrack(hits, z_0, geometry, track))
+    {
+      printf("ERROR: track fitted from 4 hits.\n");
+      failures++;
+    }
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPRecHitProducerAlgorithm.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+edm::ParameterSet MakeParameters(const vector<double> &sigmas, const vector<unsigned int> &planes = {},
+  const vector<double> &planeSigmas = {})
+{
+  edm::ParameterSet ps;
+  ps.addParameter< vector<double> >("clusterSizeSigmas", sigmas);
+
+  vector<edm::ParameterSet> vps;
+  if (!planes.empty())
+  {
+    edm::ParameterSet p;
+    p.addParameter< vector<unsigned int> >("planes", planes);
+    p.addParameter< vector<double> >("clusterSizeSigmas", planeSigmas);
+    vps.push_back(p);
+  }
+  ps.addParameter("planeClusterSizeSigmas", vps);
+
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  int failures = 0;
+
+  mt19937 rng(18);
+  RPTopology topology;
+
+  // random clusters in a few planes
+  const vector<unsigned int> planes = { 21, 1200, 1203, 1209 };
+  edm::DetSetVector<TotemRPCluster> input;
+  for (const auto &plane : planes)
+  {
+    edm::DetSet<TotemRPCluster> &ds = input.find_or_insert(TotemRPDetId::decToRawId(plane));
+    for (unsigned int i = 0; i < 500; ++i)
+    {
+      const unsigned int beg = rng() % 512;
+      const unsigned int end = min<unsigned int>(beg + rng() % 6, 511);
+      ds.data.push_back(TotemRPCluster(beg, end));
+    }
+  }
+
+  // default configuration: the former positions and nominal uncertainty
+  {
+    TotemRPRecHitProducerAlgorithm algorithm(MakeParameters({}));
+
+    edm::DetSetVector<TotemRPRecHit> output;
+    algorithm.buildRecoHits(input, output);
+
+    bool ok = (output.size() == input.size());
+    auto oit = output.begin();
+    for (auto iit = input.begin(); ok && iit != input.end(); ++iit, ++oit)
+    {
+      ok &= (iit->detId() == oit->detId() && iit->data.size() == oit->data.size());
+      for (unsigned int i = 0; ok && i < iit->data.size(); ++i)
+      {
+        const double position = topology.GetHitPositionInReadoutDirection(iit->data[i].getCenterStripPosition());
+        ok &= (oit->data[i].getPosition() == position && oit->data[i].getSigma() == 0.0191);
+      }
+    }
+
+    if (!ok)
+    {
+      printf("ERROR: default configuration differs from the former algorithm.\n");
+      failures++;
+    }
+  }
+
+  // cluster-size dependent uncertainties, one plane with its own values
+  {
+    const vector<double> sigmas = { 0.016, 0.010, 0.025 };
+    const vector<double> planeSigmas = { 0.030 };
+    TotemRPRecHitProducerAlgorithm algorithm(MakeParameters(sigmas, { 1203 }, planeSigmas));
+
+    edm::DetSetVector<TotemRPRecHit> output;
+    algorithm.buildRecoHits(input, output);
+
+    bool ok = true;
+    auto oit = output.begin();
+    for (auto iit = input.begin(); iit != input.end(); ++iit, ++oit)
+    {
+      const bool special = (iit->detId() == TotemRPDetId::decToRawId(1203));
+      for (unsigned int i = 0; i < iit->data.size(); ++i)
+      {
+        const unsigned int size = iit->data[i].getNumberOfStrips();
+        const double expected = (special) ? planeSigmas[0] : sigmas[min<unsigned int>(size, sigmas.size()) - 1];
+        ok &= (oit->data[i].getSigma() == expected);
+      }
+    }
+
+    if (!ok)
+    {
+      printf("ERROR: wrong cluster-size or plane dependent uncertainties.\n");
+      failures++;
+    }
+
+    // the per-plane interface gives the same
+    for (const auto &ids : input)
+    {
+      edm::DetSet<TotemRPRecHit> ods(ids.detId());
+      algorithm.buildRecoHits(ids, ods);
+
+      const auto &ref = *output.find(ids.detId());
+      bool same = (ods.data.size() == ref.data.size());
+      for (unsigned int i = 0; same && i < ods.data.size(); ++i)
+        same &= (ods.data[i].getPosition() == ref.data[i].getPosition() && ods.data[i].getSigma() == ref.data[i].getSigma());
+
+      if (!same)
+      {
+        printf("ERROR: per-plane and collection interfaces differ.\n");
+        failures++;
+        break;
+      }
+    }
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
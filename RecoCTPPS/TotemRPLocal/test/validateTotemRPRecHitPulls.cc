@@ -0,0 +1,219 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPClusterProducerAlgorithm.h"
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPRecHitProducerAlgorithm.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: validateTotemRPRecHitPulls [option]\n");
+  printf("Simulates tracks crossing an RP plane (charge diffusion + strip threshold), reconstructs\n");
+  printf("clusters and hits and compares the pull distributions of the nominal (pitch/sqrt(12)) and the\n");
+  printf("cluster-size dependent uncertainties. The latter are calibrated on the first half of the tracks\n");
+  printf("and tested on the second half.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of tracks (default 200000)\n");
+  printf("    -d <value>      charge diffusion sigma in strips (default 0.25)\n");
+  printf("    -t <value>      strip threshold as a fraction of the total charge (default 0.15)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// simulated track and its (single) cluster
+struct Track
+{
+  double truePosition;
+  TotemRPCluster cluster;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+struct PullStat
+{
+  unsigned long n = 0;
+  double s1 = 0., s2 = 0.;
+
+  void Fill(double x) { n++; s1 += x; s2 += x*x; }
+  double Mean() const { return (n > 0) ? s1 / n : 0.; }
+  double RMS() const { return (n > 0) ? sqrt(s2 / n) : 0.; }
+};
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 200000;
+  double diffusion = 0.25;
+  double threshold = 0.15;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) { diffusion = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) { threshold = atof(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const unsigned int detId = TotemRPDetId::decToRawId(1200);
+  const unsigned int maxSize = 4;
+
+  edm::ParameterSet clusterParameters;
+  clusterParameters.addParameter<int>("verbosity", 0);
+  clusterParameters.addParameter<unsigned int>("maxGap", 0);
+  clusterParameters.addParameter<unsigned int>("maxWidth", 0);
+  TotemRPClusterProducerAlgorithm clusterAlgorithm(clusterParameters);
+
+  RPTopology topology;
+
+  // simulation: tracks with a single cluster
+  mt19937 rng(18);
+  uniform_real_distribution<double> position(20., 490.);
+
+  auto simulate = [&] (unsigned int count, vector<Track> &tracks)
+  {
+    tracks.clear();
+
+    vector<TotemRPDigi> digis;
+    vector<TotemRPCluster> clusters;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      // track position in strip units
+      const double s = position(rng);
+
+      // strips with charge fraction above threshold
+      digis.clear();
+      for (int strip = int(s) - 3; strip <= int(s) + 4; ++strip)
+      {
+        const double fraction = 0.5 * (erf((strip + 0.5 - s) / diffusion / sqrt(2.)) - erf((strip - 0.5 - s) / diffusion / sqrt(2.)));
+        if (fraction > threshold)
+          digis.push_back(TotemRPDigi(strip));
+      }
+
+      clusterAlgorithm.buildClusters(detId, digis, clusters);
+      if (clusters.size() == 1)
+        tracks.push_back({ topology.GetHitPositionInReadoutDirection(s), clusters[0] });
+    }
+  };
+
+  // reconstruction: hit residuals and pulls per cluster size
+  auto reconstruct = [&] (TotemRPRecHitProducerAlgorithm &algorithm, const vector<Track> &tracks, vector<PullStat> &residuals,
+    vector<PullStat> &pulls, PullStat &allPulls)
+  {
+    residuals.assign(maxSize, PullStat());
+    pulls.assign(maxSize, PullStat());
+    allPulls = PullStat();
+
+    edm::DetSetVector<TotemRPCluster> clusters;
+    edm::DetSet<TotemRPCluster> &clusterSet = clusters.find_or_insert(detId);
+    for (const auto &t : tracks)
+      clusterSet.data.push_back(t.cluster);
+
+    edm::DetSetVector<TotemRPRecHit> hits;
+    algorithm.buildRecoHits(clusters, hits);
+    const auto &hitSet = *hits.find(detId);
+
+    for (unsigned int i = 0; i < tracks.size(); ++i)
+    {
+      const unsigned int idx = min<unsigned int>(tracks[i].cluster.getNumberOfStrips(), maxSize) - 1;
+      const double residual = hitSet.data[i].getPosition() - tracks[i].truePosition;
+      const double pull = residual / hitSet.data[i].getSigma();
+
+      residuals[idx].Fill(residual);
+      pulls[idx].Fill(pull);
+      allPulls.Fill(pull);
+    }
+  };
+
+  edm::ParameterSet nominalParameters;
+  nominalParameters.addParameter< vector<double> >("clusterSizeSigmas", {});
+  nominalParameters.addParameter("planeClusterSizeSigmas", vector<edm::ParameterSet>());
+  TotemRPRecHitProducerAlgorithm nominalAlgorithm(nominalParameters);
+
+  // calibration sample: residual RMS per cluster size
+  vector<Track> tracks;
+  simulate(n / 2, tracks);
+
+  vector<PullStat> residuals, nominalPulls, calibratedPulls;
+  PullStat nominalAll, calibratedAll;
+  reconstruct(nominalAlgorithm, tracks, residuals, nominalPulls, nominalAll);
+
+  // sizes with too few clusters: the value of the smaller size, or the nominal one
+  vector<double> sigmas;
+  for (unsigned int i = 0; i < maxSize; ++i)
+  {
+    if (residuals[i].n >= 100)
+      sigmas.push_back(residuals[i].RMS());
+    else
+      sigmas.push_back((i > 0) ? sigmas.back() : TotemRPRecHitProducerAlgorithm::nominalSigma);
+  }
+
+  edm::ParameterSet calibratedParameters;
+  calibratedParameters.addParameter< vector<double> >("clusterSizeSigmas", sigmas);
+  calibratedParameters.addParameter("planeClusterSizeSigmas", vector<edm::ParameterSet>());
+  TotemRPRecHitProducerAlgorithm calibratedAlgorithm(calibratedParameters);
+
+  // test sample
+  simulate(n - n / 2, tracks);
+  reconstruct(nominalAlgorithm, tracks, residuals, nominalPulls, nominalAll);
+  reconstruct(calibratedAlgorithm, tracks, residuals, calibratedPulls, calibratedAll);
+
+  printf("diffusion = %.3f strips, threshold = %.3f, %lu single-cluster tracks in the test sample\n\n", diffusion, threshold,
+    (unsigned long) tracks.size());
+
+  printf("%6s %9s %14s %12s %14s %14s %14s\n", "size", "fraction", "residual (um)", "sigma (um)", "nominal pull",
+    "calibr. pull", "calibr. mean");
+
+  bool ok = true;
+
+  for (unsigned int i = 0; i < maxSize; ++i)
+  {
+    if (residuals[i].n == 0)
+      continue;
+
+    const double sigma = sigmas[min<unsigned int>(i, sigmas.size() - 1)];
+    printf("%5u%s %9.3f %14.2f %12.2f %14.3f %14.3f %14.3f\n", i + 1, (i + 1 == maxSize) ? "+" : " ",
+      double(residuals[i].n) / tracks.size(), residuals[i].RMS() * 1E3, sigma * 1E3, nominalPulls[i].RMS(),
+      calibratedPulls[i].RMS(), calibratedPulls[i].Mean());
+
+    if (calibratedPulls[i].n >= 1000 && fabs(calibratedPulls[i].RMS() - 1.) > 0.05)
+      ok = false;
+  }
+
+  printf("%6s %9.3f %14s %12s %14.3f %14.3f %14.3f\n", "all", 1., "", "", nominalAll.RMS(), calibratedAll.RMS(),
+    calibratedAll.Mean());
+
+  if (!ok)
+    printf("ERROR: calibrated pulls do not have unit width.\n");
+
+  return (ok) ? 0 : 1;
+}
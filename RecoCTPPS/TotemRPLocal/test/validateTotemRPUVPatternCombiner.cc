@@ -0,0 +1,253 @@
+/****************************************************************************
+*
+* This is a part of TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "Geometry/VeryForwardRPTopology/interface/RPTopology.h"
+
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPLocalTrackFitterAlgorithm.h"
+#include "RecoCTPPS/TotemRPLocal/interface/TotemRPUVPatternCombiner.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+edm::ParameterSet MakeSettings(bool requireSensitiveArea)
+{
+  edm::ParameterSet ps;
+  ps.addParameter<unsigned int>("maxPatternsPerProjection", 5);
+  ps.addParameter<double>("maxChiSquaredOverNDF", 10.);
+  ps.addParameter<bool>("requireSensitiveArea", requireSensitiveArea);
+  return ps;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: validateTotemRPUVPatternCombiner [option]\n");
+  printf("Simulates events with 1 to 3 protons in one RP (one U and one V pattern per proton, 5%% plane\n");
+  printf("inefficiency) and reports the efficiency and the fake rate of the U-V combination algorithms.\n");
+  printf("The efficiency is relative to the protons with fittable patterns in both projections.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -n <number>     number of events per proton multiplicity (default 10000)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int n = 10000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { n = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const double z0 = 203827.;
+  const double sigma = 66E-3 / sqrt(12.);
+
+  // planes of one RP: U (odd) and V (even) planes, 4.5 mm apart, slightly tilted, centred at (0, 0)
+  struct Plane
+  {
+    unsigned int detId;
+    bool uDir;
+    TVector3 centre;
+    TVector2 readoutDirection;
+  };
+
+  vector<Plane> planes;
+  for (unsigned int det = 0; det < 10; ++det)
+  {
+    const bool uDir = TotemRPDetId::isStripsCoordinateUDirection(det);
+    const double phi = (uDir ? M_PI/4. : 3.*M_PI/4.) + 1E-3 * (det - 4.5);
+    planes.push_back({ TotemRPDetId::decToRawId(1200 + det), uDir, TVector3(0., 0., z0 + (det - 4.5) * 4.5),
+      TVector2(cos(phi), sin(phi)) });
+  }
+
+  const TVector2 d_U(cos(M_PI/4.), sin(M_PI/4.)), d_V(cos(3.*M_PI/4.), sin(3.*M_PI/4.));
+
+  // algorithms
+  struct Configuration
+  {
+    string label;
+    string algorithm;
+    bool requireSensitiveArea;
+  };
+
+  const vector<Configuration> configurations = {
+    { "unique", "unique", false },
+    { "greedy, no area veto", "greedy", false },
+    { "greedy", "greedy", true },
+    { "global", "global", true },
+  };
+
+  edm::ParameterSet ps_fitter;
+  ps_fitter.addParameter<string>("fitMethod", "cholesky");
+  TotemRPLocalTrackFitterAlgorithm fitter(ps_fitter);
+
+  // the geometry given by hand, instead of TotemRPGeometry
+  TotemRPPlaneTable geometry;
+  for (const auto &p : planes)
+    geometry.setPlane(p.detId, p.centre.X(), p.centre.Y(), p.centre.Z(), p.readoutDirection.X(),
+      p.readoutDirection.Y());
+
+  vector<TotemRPUVPatternCombiner> combiners;
+  for (const auto &c : configurations)
+    combiners.push_back(TotemRPUVPatternCombiner(c.algorithm, MakeSettings(c.requireSensitiveArea)));
+
+  mt19937 rng(22);
+  uniform_real_distribution<double> flat(0., 1.);
+  normal_distribution<double> gauss(0., sigma);
+
+  int failures = 0;
+
+  printf("%8s %22s %12s %12s\n", "protons", "algorithm", "efficiency", "fakes/event");
+
+  for (unsigned int n_protons = 1; n_protons <= 3; ++n_protons)
+  {
+    vector<unsigned long> matched(configurations.size(), 0), fakes(configurations.size(), 0);
+    unsigned long reconstructible = 0;
+
+    for (unsigned int ev = 0; ev < n; ++ev)
+    {
+      // protons within the sensitive area
+      struct Proton { double x0, y0, tx, ty; bool reconstructible; };
+      vector<Proton> protons;
+      while (protons.size() < n_protons)
+      {
+        Proton p;
+        p.x0 = (flat(rng) - 0.5) * 40.;
+        p.y0 = (flat(rng) - 0.5) * 40.;
+        p.tx = (flat(rng) - 0.5) * 2E-4;
+        p.ty = (flat(rng) - 0.5) * 2E-4;
+
+        const TVector2 xy(p.x0, p.y0);
+        if (RPTopology::IsHit(d_U * xy, d_V * xy, 0.5))
+          protons.push_back(p);
+      }
+
+      // one U and one V pattern per proton
+      edm::DetSet<TotemRPUVPattern> patterns;
+      for (auto &p : protons)
+      {
+        TotemRPUVPattern pu, pv;
+        pu.setProjection(TotemRPUVPattern::projU);
+        pv.setProjection(TotemRPUVPattern::projV);
+
+        unsigned int planes_U = 0, planes_V = 0;
+        for (const auto &pl : planes)
+        {
+          if (flat(rng) < 0.05)
+            continue;
+
+          const double dz = pl.centre.Z() - z0;
+          const TVector2 point(p.x0 + p.tx * dz - pl.centre.X(), p.y0 + p.ty * dz - pl.centre.Y());
+          const TotemRPRecHit hit(pl.readoutDirection * point + gauss(rng), sigma);
+
+          if (pl.uDir)
+          {
+            pu.addHit(pl.detId, hit);
+            planes_U++;
+          } else {
+            pv.addHit(pl.detId, hit);
+            planes_V++;
+          }
+        }
+
+        pu.setFittable(planes_U >= 3);
+        pv.setFittable(planes_V >= 3);
+
+        p.reconstructible = pu.getFittable() && pv.getFittable();
+        if (p.reconstructible)
+          reconstructible++;
+
+        patterns.push_back(pu);
+        patterns.push_back(pv);
+      }
+
+      // combine and compare
+      for (unsigned int ci = 0; ci < combiners.size(); ++ci)
+      {
+        vector<TotemRPLocalTrack> tracks;
+        combiners[ci].combine(patterns, z0, geometry, fitter, tracks);
+
+        vector<char> found(protons.size(), 0);
+        for (const auto &t : tracks)
+        {
+          if (!t.isValid())
+            continue;
+
+          bool match = false;
+          for (unsigned int pi = 0; pi < protons.size(); ++pi)
+          {
+            if (protons[pi].reconstructible && fabs(t.getX0() - protons[pi].x0) < 0.2
+              && fabs(t.getY0() - protons[pi].y0) < 0.2)
+            {
+              match = true;
+              found[pi] = 1;
+            }
+          }
+
+          if (!match)
+            fakes[ci]++;
+        }
+
+        for (const auto &f : found)
+          matched[ci] += f;
+      }
+    }
+
+    for (unsigned int ci = 0; ci < configurations.size(); ++ci)
+    {
+      const double efficiency = (reconstructible > 0) ? double(matched[ci]) / reconstructible : 0.;
+      const double fakeRate = double(fakes[ci]) / n;
+      printf("%8u %22s %12.3f %12.3f\n", n_protons, configurations[ci].label.c_str(), efficiency, fakeRate);
+
+      // single proton: all algorithms shall reconstruct it, without fakes
+      if (n_protons == 1 && (efficiency < 0.99 || fakes[ci] > 0))
+      {
+        printf("ERROR: single-proton efficiency or fake rate of `%s' out of expectation.\n",
+          configurations[ci].label.c_str());
+        failures++;
+      }
+
+      // multiple protons: only the unique combination shall give nothing
+      if (n_protons > 1 && configurations[ci].algorithm == "unique" && matched[ci] + fakes[ci] > 0)
+      {
+        printf("ERROR: unique combination gives tracks with %u protons.\n", n_protons);
+        failures++;
+      }
+    }
+  }
+
+  if (failures == 0)
+    printf("OK\n");
+
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Generators_RawDataGenerator
+#define TotemRawData_Generators_RawDataGenerator
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "EventFilter/TotemRawToDigi/interface/VFATFrame.h"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Generates synthetic OptoRx frames for all VFATs of a DAQ mapping, together with the truth.
+ *
+ * Every VFAT of the mapping gets a frame in every event, with random clusters of active channels. The
+ * frames can be corrupted in a controlled way: the EC or BC may differ from the event's value, the CRC
+ * may be wrong and the frame may be missing. In the serial format (FOV = 1) a missing frame is sent as an
+ * all-zero frame (a GOH block has always 16 frames), in the parallel format (FOV = 2) its VFAT block is
+ * not sent at all. In the parallel format, the blocks are randomly in raw or cluster mode; the latter
+ * carries no CRC and can thus not be CRC-corrupted.
+ *
+ * One FEDRawData is produced per FED present in the mapping. NB: the OptoRx footer holds the frame size
+ * in 10 bits, the unpacker thus rejects frames longer than 1023 64-bit words (which the parallel format
+ * can reach at very high occupancies).
+**/
+class RawDataGenerator
+{
+  public:
+    struct Parameters
+    {
+      /// OptoRx format: 1 = serial, 2 = parallel
+      unsigned int fov = 2;
+
+      /// parallel format only: fraction of VFAT blocks sent in raw mode, the rest is sent in cluster mode
+      double rawModeFraction = 0.5;
+
+      /// mean number of clusters per VFAT and event (Poisson distributed)
+      double clustersPerVFAT = 0.5;
+
+      /// mean cluster size, the size is distributed as 1 + Poisson(clusterSizeMean - 1), cut at clusterSizeMax
+      double clusterSizeMean = 2.;
+      unsigned int clusterSizeMax = 8;
+
+      /// probabilities (per VFAT and event) that the EC or BC differ from the event's value
+      double ecJitterRate = 0.;
+      double bcJitterRate = 0.;
+
+      /// probability (per VFAT and event) of a wrong CRC
+      double crcCorruptionRate = 0.;
+
+      /// probability (per VFAT and event) that the frame is missing
+      double missingRate = 0.;
+
+      unsigned long seed = 1;
+    };
+
+    /// what has been generated for one VFAT
+    struct VFATTruth
+    {
+      TotemFramePosition position;
+
+      /// active channels: bit ch % 64 of word ch / 64
+      uint64_t channels[2];
+
+      bool missing;
+      bool crcCorrupted;
+      bool ecJitter, bcJitter;
+
+      /// parallel format only: the block was sent in cluster mode
+      bool clusterMode;
+
+      bool IsChannelActive(unsigned int ch) const
+      {
+        return (channels[ch >> 6] >> (ch & 0x3F)) & 1;
+      }
+    };
+
+    struct EventTruth
+    {
+      unsigned long eventNumber;
+      unsigned int ec, bc;
+
+      /// in the order of the mapping
+      std::vector<VFATTruth> vfats;
+
+      /// one line for the event, then one line per VFAT with its position, flags and active channels
+      void Write(std::ostream &os) const;
+    };
+
+    RawDataGenerator(const TotemDAQMapping &mapping, const Parameters &parameters);
+
+    /// the FEDs present in the mapping, ordered
+    const std::vector<unsigned int>& GetFEDIds() const
+    {
+      return fedIds;
+    }
+
+    /// generates the next event, the FEDRawData of the mapped FEDs are overwritten
+    void Generate(FEDRawDataCollection &rawData, EventTruth &truth);
+
+    /// Builds an RP mapping with the structure of the 2015 XML mappings: 3 pots per FED, 3 GOHs per pot
+    /// (16 + 16 + 8 data VFATs and a trigger VFAT). Up to 12 FEDs get distinct pots, the pot IDs repeat
+    /// beyond that.
+    static void MakeRPMapping(const std::vector<unsigned int> &fedIds, TotemDAQMapping &mapping);
+
+  protected:
+    Parameters parameters;
+
+    /// the mapped VFATs grouped by FED, in the order of the mapping
+    std::vector<unsigned int> fedIds;
+    std::vector<std::vector<std::pair<TotemFramePosition, unsigned int>>> vfatsPerFED;
+
+    unsigned long eventNumber;
+
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> uniform;
+    std::poisson_distribution<unsigned int> clusterCount;
+    std::poisson_distribution<unsigned int> clusterSize;
+
+    /// frames of the current FED
+    std::vector<VFATFrame> frames;
+
+    /// buffer of 64-bit OptoRx words
+    std::vector<uint64_t> words;
+
+    /// buffer of 16-bit words of the parallel payload
+    std::vector<uint16_t> payload;
+
+    /// generates the content of one VFAT and its (complete) frame
+    void GenerateVFAT(unsigned int hwID, unsigned int ec, unsigned int bc, VFATTruth &truth, VFATFrame &frame);
+
+    /// fills `words' with a serial frame of the `n' VFATs starting at `truth'
+    void MakeSerial(const VFATTruth *truth, unsigned int n);
+
+    /// fills `words' with a parallel frame of the `n' VFATs starting at `truth'
+    void MakeParallel(const VFATTruth *truth, unsigned int n);
+
+    /// adds the OptoRx header and footer and stores the words in `data'
+    void Finish(unsigned int fedId, unsigned int bc, FEDRawData &data);
+};
+
+#endif
@@ -0,0 +1,62 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Generators_SRSFileWriter
+#define TotemRawData_Generators_SRSFileWriter
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Writes raw-data files in SRS format, as read by SRSFileReader.
+ *
+ * Each event is written as a DATE physics super-event (GDC) with one sub-event (LDC), which holds one
+ * OptoRx equipment per FED. As in the files from the DAQ, each payload is preceded by the 32-bit word
+ * 0xFAFAFAFA, which aligns the OptoRx frames to 8 bytes.
+ **/
+class SRSFileWriter
+{
+  public:
+    SRSFileWriter();
+
+    ~SRSFileWriter();
+
+    /// returns 0 on success
+    int Open(const std::string &fn, unsigned int runNumber = 0);
+
+    void Close();
+
+    /// writes the FEDs from `fedIds' with non-empty data, returns 0 on success
+    int WriteEvent(uint32_t eventNumber, uint32_t timestamp, const FEDRawDataCollection &rawData,
+      const std::vector<unsigned int> &fedIds);
+
+    unsigned long long GetBytesWritten() const
+    {
+      return bytesWritten;
+    }
+
+  protected:
+    static const uint32_t paddingWord;
+
+    FILE *outfile;
+
+    unsigned int runNumber;
+
+    unsigned long long bytesWritten;
+
+    /// the event being written, the memory is reused
+    std::vector<char> buffer;
+};
+
+#endif
@@ -0,0 +1,149 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESWatcher.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "CondFormats/DataRecord/interface/TotemReadoutRcd.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Writes synthetic raw data (SRS format) for all VFATs of the DAQ mapping, one raw event per framework
+ * event. Optionally, the generator truth is written to a text file.
+**/
+class TotemRawDataGenerator : public edm::one::EDAnalyzer<>
+{
+  public:
+    explicit TotemRawDataGenerator(const edm::ParameterSet&);
+    ~TotemRawDataGenerator();
+
+    virtual void analyze(const edm::Event &, const edm::EventSetup &) override;
+    virtual void endJob() override;
+
+  private:
+    std::string outputFile, truthFile;
+    unsigned int runNumber;
+    unsigned int firstTimestamp;
+    unsigned int eventsPerSecond;
+
+    RawDataGenerator::Parameters parameters;
+
+    edm::ESWatcher<TotemReadoutRcd> readoutWatcher;
+
+    std::unique_ptr<RawDataGenerator> generator;
+
+    SRSFileWriter writer;
+    std::ofstream truthStream;
+
+    unsigned int eventsWritten;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace edm;
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawDataGenerator::TotemRawDataGenerator(const edm::ParameterSet &conf):
+  outputFile(conf.getParameter<string>("outputFile")),
+  truthFile(conf.getParameter<string>("truthFile")),
+  runNumber(conf.getParameter<unsigned int>("runNumber")),
+  firstTimestamp(conf.getParameter<unsigned int>("firstTimestamp")),
+  eventsPerSecond(conf.getParameter<unsigned int>("eventsPerSecond")),
+  eventsWritten(0)
+{
+  parameters.fov = conf.getParameter<unsigned int>("fov");
+  parameters.rawModeFraction = conf.getParameter<double>("rawModeFraction");
+  parameters.clustersPerVFAT = conf.getParameter<double>("clustersPerVFAT");
+  parameters.clusterSizeMean = conf.getParameter<double>("clusterSizeMean");
+  parameters.clusterSizeMax = conf.getParameter<unsigned int>("clusterSizeMax");
+  parameters.ecJitterRate = conf.getParameter<double>("ecJitterRate");
+  parameters.bcJitterRate = conf.getParameter<double>("bcJitterRate");
+  parameters.crcCorruptionRate = conf.getParameter<double>("crcCorruptionRate");
+  parameters.missingRate = conf.getParameter<double>("missingRate");
+  parameters.seed = conf.getParameter<unsigned int>("seed");
+
+  if (parameters.fov != 1 && parameters.fov != 2)
+    throw cms::Exception("TotemRawDataGenerator") << "Unsupported FOV " << parameters.fov << ".";
+
+  if (writer.Open(outputFile, runNumber) != 0)
+    throw cms::Exception("TotemRawDataGenerator") << "Cannot open file `" << outputFile << "'.";
+
+  if (!truthFile.empty())
+  {
+    truthStream.open(truthFile);
+    if (!truthStream.good())
+      throw cms::Exception("TotemRawDataGenerator") << "Cannot open file `" << truthFile << "'.";
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawDataGenerator::~TotemRawDataGenerator()
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawDataGenerator::analyze(const edm::Event &, const edm::EventSetup &es)
+{
+  // the generator keeps its random state, it is thus only created with the first mapping
+  if (readoutWatcher.check(es) && !generator)
+  {
+    ESHandle<TotemDAQMapping> mapping;
+    es.get<TotemReadoutRcd>().get(mapping);
+
+    generator.reset(new RawDataGenerator(*mapping, parameters));
+  }
+
+  FEDRawDataCollection rawData;
+  RawDataGenerator::EventTruth truth;
+  generator->Generate(rawData, truth);
+
+  const unsigned int timestamp = firstTimestamp + ((eventsPerSecond > 0) ? eventsWritten / eventsPerSecond : 0);
+  if (writer.WriteEvent(truth.eventNumber, timestamp, rawData, generator->GetFEDIds()) != 0)
+    throw cms::Exception("TotemRawDataGenerator") << "Cannot write event " << truth.eventNumber << ".";
+
+  if (truthStream.is_open())
+    truth.Write(truthStream);
+
+  eventsWritten++;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawDataGenerator::endJob()
+{
+  writer.Close();
+
+  edm::LogInfo("Totem") << "TotemRawDataGenerator: " << eventsWritten << " events (" << writer.GetBytesWritten()
+    << " bytes) written to `" << outputFile << "'.";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+DEFINE_FWK_MODULE(TotemRawDataGenerator);
@@ -0,0 +1,36 @@
+import FWCore.ParameterSet.Config as cms
+
+totemRawDataGenerator = cms.EDAnalyzer("TotemRawDataGenerator",
+  # raw data (SRS format) are written to this file
+  outputFile = cms.string("synthetic.srs"),
+
+  # if not empty, the generator truth (per event and VFAT: flags and active channels) is written to this file
+  truthFile = cms.string(""),
+
+  runNumber = cms.uint32(1),
+
+  # timestamps of the events, in seconds
+  firstTimestamp = cms.uint32(0),
+  eventsPerSecond = cms.uint32(1000),
+
+  # OptoRx format: 1 = serial, 2 = parallel
+  fov = cms.uint32(2),
+
+  # parallel format only: fraction of VFAT blocks sent in raw mode, the rest is sent in cluster mode
+  rawModeFraction = cms.double(0.5),
+
+  # mean number of clusters per VFAT and event (Poisson distributed)
+  clustersPerVFAT = cms.double(0.5),
+
+  # cluster size: 1 + Poisson(clusterSizeMean - 1), cut at clusterSizeMax
+  clusterSizeMean = cms.double(2.),
+  clusterSizeMax = cms.uint32(8),
+
+  # corruption probabilities, per VFAT and event
+  ecJitterRate = cms.double(0.),
+  bcJitterRate = cms.double(0.),
+  crcCorruptionRate = cms.double(0.),
+  missingRate = cms.double(0.),
+
+  seed = cms.uint32(1)
+)
@@ -0,0 +1,320 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::EventTruth::Write(ostream &os) const
+{
+  os << "event " << eventNumber << " ec " << ec << " bc " << bc << endl;
+
+  for (const auto &v : vfats)
+  {
+    os << "  " << v.position << " missing " << v.missing << " crc " << v.crcCorrupted << " ec " << v.ecJitter
+      << " bc " << v.bcJitter << " cluster " << v.clusterMode << " channels";
+
+    for (unsigned int ch = 0; ch < 128; ++ch)
+      if (v.IsChannelActive(ch))
+        os << " " << ch;
+
+    os << endl;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+RawDataGenerator::RawDataGenerator(const TotemDAQMapping &mapping, const Parameters &_p) :
+  parameters(_p),
+  eventNumber(0),
+  rng(_p.seed),
+  uniform(0., 1.),
+  clusterCount((_p.clustersPerVFAT > 0.) ? _p.clustersPerVFAT : 1.),
+  clusterSize((_p.clusterSizeMean > 1.) ? _p.clusterSizeMean - 1. : 1.)
+{
+  map<unsigned int, unsigned int> fedIndices;
+  for (const auto &p : mapping.VFATMapping)
+  {
+    const unsigned int fedId = p.first.getFEDId();
+
+    auto it = fedIndices.find(fedId);
+    if (it == fedIndices.end())
+    {
+      it = fedIndices.insert({fedId, fedIds.size()}).first;
+      fedIds.push_back(fedId);
+      vfatsPerFED.push_back({});
+    }
+
+    vfatsPerFED[it->second].push_back({p.first, p.second.hwID});
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::Generate(FEDRawDataCollection &rawData, EventTruth &truth)
+{
+  eventNumber++;
+
+  truth.eventNumber = eventNumber;
+  truth.ec = eventNumber & 0xFF;
+  truth.bc = rng() % 3564;
+  truth.vfats.clear();
+
+  for (unsigned int fi = 0; fi < fedIds.size(); ++fi)
+  {
+    const auto &vfats = vfatsPerFED[fi];
+    const unsigned int first = truth.vfats.size();
+
+    truth.vfats.resize(first + vfats.size());
+    frames.resize(vfats.size());
+
+    for (unsigned int i = 0; i < vfats.size(); ++i)
+    {
+      truth.vfats[first + i].position = vfats[i].first;
+      GenerateVFAT(vfats[i].second, truth.ec, truth.bc, truth.vfats[first + i], frames[i]);
+    }
+
+    if (parameters.fov == 1)
+      MakeSerial(&truth.vfats[first], vfats.size());
+    else
+      MakeParallel(&truth.vfats[first], vfats.size());
+
+    Finish(fedIds[fi], truth.bc, rawData.FEDData(fedIds[fi]));
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::GenerateVFAT(unsigned int hwID, unsigned int ec, unsigned int bc, VFATTruth &truth,
+  VFATFrame &frame)
+{
+  VFATFrame::word *d = frame.getData();
+  memset(d, 0, 12 * sizeof(VFATFrame::word));
+
+  truth.channels[0] = truth.channels[1] = 0;
+  truth.missing = (uniform(rng) < parameters.missingRate);
+  truth.clusterMode = (parameters.fov == 2 && uniform(rng) >= parameters.rawModeFraction);
+  truth.crcCorrupted = truth.ecJitter = truth.bcJitter = false;
+
+  if (truth.missing)
+    return;
+
+  // clusters
+  const unsigned int clusters = (parameters.clustersPerVFAT > 0.) ? clusterCount(rng) : 0;
+  for (unsigned int i = 0; i < clusters; ++i)
+  {
+    unsigned int size = 1 + ((parameters.clusterSizeMean > 1.) ? clusterSize(rng) : 0);
+    size = max(1u, min(size, parameters.clusterSizeMax));
+
+    const unsigned int chMin = rng() % 128;
+    const unsigned int chMax = min(chMin + size - 1, 127u);
+    for (unsigned int ch = chMin; ch <= chMax; ++ch)
+      truth.channels[ch >> 6] |= uint64_t(1) << (ch & 0x3F);
+  }
+
+  // corruptions
+  truth.ecJitter = (uniform(rng) < parameters.ecJitterRate);
+  truth.bcJitter = (uniform(rng) < parameters.bcJitterRate);
+  truth.crcCorrupted = (!truth.clusterMode && uniform(rng) < parameters.crcCorruptionRate);
+
+  const unsigned int vfatEC = (truth.ecJitter) ? (ec + 1 + rng() % 255) & 0xFF : ec;
+  const unsigned int vfatBC = (truth.bcJitter) ? (bc + 1 + rng() % 4095) & 0xFFF : bc;
+
+  // the frame
+  d[11] = 0xA000 | vfatBC;
+  d[10] = 0xC000 | (vfatEC << 4);
+  d[9] = 0xE000 | (hwID & 0xFFF);
+
+  for (unsigned int i = 0; i < 8; ++i)
+    d[1 + i] = (truth.channels[i / 4] >> (16 * (i % 4))) & 0xFFFF;
+
+  d[0] = VFATFrameCRC::GetDefault().Calculate(d);
+  if (truth.crcCorrupted)
+    d[0] ^= 1 << (rng() % 16);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::MakeSerial(const VFATTruth *truth, unsigned int n)
+{
+  // a GOH is active if it has a VFAT in the mapping
+  unsigned int activeGOHs = 0;
+  for (unsigned int i = 0; i < n; ++i)
+    activeGOHs |= 1 << truth[i].position.getGOHId();
+
+  unsigned int rows = 0;
+  while ((activeGOHs >> (4 * rows)) != 0)
+    rows++;
+
+  words.assign(1 + 194 * rows, 0);
+
+  for (unsigned int r = 0; r < rows; ++r)
+  {
+    for (unsigned int c = 0; c < 4; ++c)
+    {
+      const unsigned int goh = 4 * r + c;
+      const unsigned int active = (activeGOHs >> goh) & 1;
+      words[1 + 194 * r] |= uint64_t(0x4000 | (goh << 8) | active) << (16 * c);
+      words[194 + 194 * r] |= uint64_t(0xB000 | (goh << 8)) << (16 * c);
+    }
+  }
+
+  // bit `idx' of word `i' of a GOH block is bit `15 - i%16' of data word `11 - i/16' of frame `idx'
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    const unsigned int goh = truth[i].position.getGOHId();
+    const unsigned int idx = truth[i].position.getIdxInFiber();
+    uint64_t *block = &words[2 + 194 * (goh / 4)];
+    const uint64_t bit = uint64_t(1) << (16 * (goh % 4) + idx);
+
+    const VFATFrame::word *d = frames[i].getData();
+    for (unsigned int k = 0; k < 12; ++k)
+    {
+      for (unsigned int w = d[k]; w; w &= w - 1)
+        block[16 * (11 - k) + 15 - __builtin_ctz(w)] |= bit;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::MakeParallel(const VFATTruth *truth, unsigned int n)
+{
+  payload.clear();
+
+  // orbit counter
+  payload.push_back(eventNumber & 0xFFFF);
+  payload.push_back((eventNumber >> 16) & 0xFFFF);
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    const VFATTruth &t = truth[i];
+    if (t.missing)
+      continue;
+
+    const VFATFrame::word *d = frames[i].getData();
+    const unsigned int start = payload.size();
+
+    const unsigned int mode = (t.clusterMode) ? RawDataUnpacker::vmCluster : RawDataUnpacker::vmRaw;
+    payload.push_back((mode << 8) | (t.position.getGOHId() << 4) | t.position.getIdxInFiber());
+    payload.push_back(d[11]);
+    payload.push_back(d[10]);
+    payload.push_back(d[9]);
+
+    if (t.clusterMode)
+    {
+      // number of clusters, then the clusters (runs of active channels) as (size, highest channel)
+      const unsigned int clStart = payload.size();
+      payload.push_back(0xD000);
+
+      for (unsigned int ch = 0; ch < 128;)
+      {
+        if (!t.IsChannelActive(ch))
+        {
+          ch++;
+          continue;
+        }
+
+        unsigned int size = 0;
+        while (ch < 128 && t.IsChannelActive(ch))
+        {
+          size++;
+          ch++;
+        }
+
+        payload.push_back(((size & 0x7F) << 8) | (ch - 1));
+      }
+
+      payload[clStart] |= payload.size() - clStart - 1;
+    } else {
+      for (unsigned int k = 8; k >= 1; --k)
+        payload.push_back(d[k]);
+      payload.push_back(d[0]);
+    }
+
+    payload.push_back(0xF000 | (payload.size() - start + 1));
+  }
+
+  // padding to whole 64-bit words
+  while (payload.size() % 4 != 0)
+    payload.push_back(0xFFFF);
+
+  words.assign(1 + payload.size() / 4, 0);
+  memcpy(&words[1], payload.data(), payload.size() * sizeof(uint16_t));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::Finish(unsigned int fedId, unsigned int bc, FEDRawData &data)
+{
+  words[0] = (uint64_t(5) << 60) | (uint64_t(eventNumber & 0xFFFFFF) << 32) | (uint64_t(bc) << 20)
+    | (uint64_t(fedId) << 8) | (uint64_t(parameters.fov) << 4);
+  words.push_back((uint64_t(10) << 60) | (uint64_t(words.size() + 1) << 32));
+
+  data.resize(words.size() * sizeof(uint64_t));
+  memcpy(data.data(), words.data(), words.size() * sizeof(uint64_t));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawDataGenerator::MakeRPMapping(const vector<unsigned int> &fedIds, TotemDAQMapping &mapping)
+{
+  // decimal RP ids: arm, station, pot
+  vector<unsigned int> pots;
+  for (unsigned int arm = 0; arm < 2; ++arm)
+    for (unsigned int st = 0; st < 3; ++st)
+      for (unsigned int rp = 0; rp < 6; ++rp)
+        pots.push_back(100*arm + 10*st + rp);
+
+  unsigned int potIdx = 0;
+  for (const auto &fedId : fedIds)
+  {
+    for (unsigned int p = 0; p < 3; ++p, ++potIdx)
+    {
+      const unsigned int pot = pots[potIdx % pots.size()];
+
+      // data VFATs: 4 per plane, planes 0-3 on the first GOH, 4-7 on the second, 8-9 on the third
+      for (unsigned int plane = 0; plane < 10; ++plane)
+      {
+        for (unsigned int chip = 0; chip < 4; ++chip)
+        {
+          const unsigned int k = 4 * plane + chip;
+          TotemFramePosition pos(0, 0, fedId, 3 * p + k / 16, k % 16);
+
+          TotemVFATInfo info;
+          info.type = TotemVFATInfo::data;
+          info.symbolicID.subSystem = TotemSymbID::RP;
+          info.symbolicID.symbolicID = (pot * 10 + plane) * 10 + chip;
+          info.hwID = ((info.symbolicID.symbolicID * 2654435761u) >> 16) & 0xFFFF;
+          mapping.insert(pos, info);
+        }
+      }
+
+      // trigger VFAT
+      TotemFramePosition pos(0, 0, fedId, 3 * p + 2, 8);
+
+      TotemVFATInfo info;
+      info.type = TotemVFATInfo::CC;
+      info.symbolicID.subSystem = TotemSymbID::RP;
+      info.symbolicID.symbolicID = pot;
+      info.hwID = (pot * 40503u) & 0xFFFF;
+      mapping.insert(pos, info);
+    }
+  }
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/event_3_14.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const uint32_t SRSFileWriter::paddingWord = 0xFAFAFAFA;
+
+//----------------------------------------------------------------------------------------------------
+
+SRSFileWriter::SRSFileWriter() : outfile(NULL), runNumber(0), bytesWritten(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+SRSFileWriter::~SRSFileWriter()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileWriter::Open(const string &fn, unsigned int _runNumber)
+{
+  Close();
+
+  outfile = fopen(fn.c_str(), "w");
+  if (outfile == NULL)
+  {
+    perror("Error while opening file in SRSFileWriter::Open");
+    return 1;
+  }
+
+  runNumber = _runNumber;
+  bytesWritten = 0;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void SRSFileWriter::Close()
+{
+  if (outfile)
+    fclose(outfile);
+
+  outfile = NULL;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileWriter::WriteEvent(uint32_t eventNumber, uint32_t timestamp, const FEDRawDataCollection &rawData,
+  const vector<unsigned int> &fedIds)
+{
+  if (outfile == NULL)
+  {
+    cerr << "Error in SRSFileWriter::WriteEvent > " << "No file open." << endl;
+    return 1;
+  }
+
+  const unsigned int headerSize = sizeof(eventHeaderStruct);
+
+  // GDC header, LDC header, equipments
+  unsigned int size = 2 * headerSize;
+  for (const auto &fedId : fedIds)
+  {
+    const unsigned int payloadSize = rawData.FEDData(fedId).size();
+    if (payloadSize > 0)
+      size += sizeof(equipmentHeaderStruct) + sizeof(paddingWord) + payloadSize;
+  }
+
+  buffer.assign(size, 0);
+  char *ptr = buffer.data();
+
+  // headers
+  for (unsigned int h = 0; h < 2; ++h)
+  {
+    eventHeaderStruct *header = (eventHeaderStruct *) (ptr + h * headerSize);
+    header->eventSize = size - h * headerSize;
+    header->eventMagic = EVENT_MAGIC_NUMBER;
+    header->eventHeadSize = headerSize;
+    header->eventVersion = EVENT_CURRENT_VERSION;
+    header->eventType = PHYSICS_EVENT;
+    header->eventRunNb = runNumber;
+    LOAD_RAW_EVENT_ID(header->eventId, eventNumber, 0, 0);
+    RESET_ATTRIBUTES(header->eventTypeAttribute);
+    if (h == 0)
+      SET_SYSTEM_ATTRIBUTE(header->eventTypeAttribute, ATTR_SUPER_EVENT);
+    header->eventTimestamp = timestamp;
+  }
+
+  // equipments
+  unsigned int offset = 2 * headerSize;
+  for (const auto &fedId : fedIds)
+  {
+    const FEDRawData &data = rawData.FEDData(fedId);
+    if (data.size() == 0)
+      continue;
+
+    equipmentHeaderStruct *eq = (equipmentHeaderStruct *) (ptr + offset);
+    eq->equipmentSize = sizeof(equipmentHeaderStruct) + sizeof(paddingWord) + data.size();
+    eq->equipmentType = SRSFileReader::etOptoRxSRS;
+    eq->equipmentId = fedId;
+    eq->equipmentBasicElementSize = 4;
+
+    char *payloadPtr = ptr + offset + sizeof(equipmentHeaderStruct);
+    memcpy(payloadPtr, &paddingWord, sizeof(paddingWord));
+    memcpy(payloadPtr + sizeof(paddingWord), data.data(), data.size());
+    offset += eq->equipmentSize;
+  }
+
+  if (fwrite(ptr, 1, size, outfile) != size)
+  {
+    perror("Error while writing file in SRSFileWriter::WriteEvent");
+    return 1;
+  }
+
+  bytesWritten += size;
+
+  return 0;
+}
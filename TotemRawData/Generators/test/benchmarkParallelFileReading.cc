@@ -0,0 +1,280 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/ParallelSRSFileReader.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// reader with an artificial latency per event, emulating a slow (e.g. network) file system
+class DelayedSRSFileReader : public SRSFileReader
+{
+  public:
+    DelayedSRSFileReader(unsigned int _latency) : latency(_latency) {}
+
+    using SRSFileReader::GetNextEvent;
+
+    virtual unsigned char GetNextEvent(uint64_t &timestamp, SharedRawEvent &event)
+    {
+      if (latency > 0)
+        this_thread::sleep_for(chrono::microseconds(latency));
+
+      return SRSFileReader::GetNextEvent(timestamp, event);
+    }
+
+  protected:
+    unsigned int latency;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkParallelFileReading [option]\n");
+  printf("Splits synthetic events into several files (streams of one run) and compares sequential reading\n");
+  printf("with the concurrent reading and ordered merge of ParallelSRSFileReader\n");
+  printf("OPTIONS:\n");
+  printf("    -h          print this help\n");
+  printf("    -e <int>    number of events (default 20000)\n");
+  printf("    -s <int>    number of files/streams (default 4)\n");
+  printf("    -l <int>    emulated file-system latency per event, in us (default 100)\n");
+  printf("    -q <int>    events read ahead per file (default 16)\n");
+  printf("    -m <int>    memory read ahead per file, in kB (default 0 = no limit)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+  unsigned long events = 0;
+  unsigned long long bytes = 0;
+  uint64_t checksum = 0;
+  bool ordered = true;
+  double time = 0.;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+void Account(uint64_t timestamp, uint32_t eventNumber, const FEDRawDataCollection &coll, Result &r,
+  uint64_t &lastTimestamp, uint32_t &lastEventNumber)
+{
+  if (r.events > 0 && (timestamp < lastTimestamp || (timestamp == lastTimestamp && eventNumber <= lastEventNumber)))
+    r.ordered = false;
+
+  lastTimestamp = timestamp;
+  lastEventNumber = eventNumber;
+
+  // the checksum depends on the order of the events
+  r.checksum = (r.checksum ^ eventNumber) * 1099511628211ULL;
+  for (int id = 0; id <= FEDNumbering::lastFEDId(); ++id)
+  {
+    const FEDRawData &d = coll.FEDData(id);
+    if (d.size() == 0)
+      continue;
+
+    r.bytes += d.size();
+
+    uint64_t w;
+    memcpy(&w, d.data() + d.size() - 16, sizeof(w));
+    r.checksum = (r.checksum ^ w ^ d.size()) * 1099511628211ULL;
+  }
+
+  r.events++;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 20000;
+  unsigned int streams = 4;
+  unsigned int latency = 100;
+  unsigned int queueEvents = 16;
+  unsigned int queueMemory = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) { streams = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) { latency = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) { queueEvents = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) { queueMemory = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  if (streams == 0)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  // generate the streams: each event goes to a random stream, 1000 events per second
+  vector<string> fileNames;
+  vector<unique_ptr<SRSFileWriter>> writers;
+  for (unsigned int i = 0; i < streams; ++i)
+  {
+    char fn[] = "/tmp/benchmarkParallelFileReadingXXXXXX";
+    const int fd = mkstemp(fn);
+    if (fd < 0)
+    {
+      perror("ERROR: cannot create temporary file");
+      return 1;
+    }
+    close(fd);
+
+    fileNames.push_back(fn);
+    writers.emplace_back(new SRSFileWriter());
+    if (writers.back()->Open(fn, 1) != 0)
+      return 1;
+  }
+
+  const vector<unsigned int> fedIds = { 578, 579, 580 };
+  TotemDAQMapping mapping;
+  RawDataGenerator::MakeRPMapping(fedIds, mapping);
+  RawDataGenerator generator(mapping, RawDataGenerator::Parameters());
+
+  mt19937 rng(1);
+  FEDRawDataCollection rawData;
+  RawDataGenerator::EventTruth truth;
+  unsigned long long fileBytes = 0;
+  for (unsigned int e = 0; e < events; ++e)
+  {
+    generator.Generate(rawData, truth);
+    writers[rng() % streams]->WriteEvent(truth.eventNumber, e / 1000, rawData, fedIds);
+  }
+
+  for (auto &w : writers)
+  {
+    w->Close();
+    fileBytes += w->GetBytesWritten();
+  }
+
+  printf("events: %u, streams: %u, file size: %.1f MB, latency: %u us/event\n\n", events, streams, fileBytes / 1E6,
+    latency);
+
+  // sequential reading, file after file
+  Result sequential;
+  {
+    auto start = chrono::steady_clock::now();
+
+    uint64_t lastTimestamp = 0;
+    uint32_t lastEventNumber = 0;
+    for (const auto &fn : fileNames)
+    {
+      DelayedSRSFileReader reader(latency);
+      if (reader.Open(fn) != 0)
+        return 1;
+
+      uint64_t timestamp;
+      FEDRawDataCollection coll;
+      while (reader.GetNextEvent(timestamp, coll) == 0)
+      {
+        Account(timestamp, reader.GetEventNumber(), coll, sequential, lastTimestamp, lastEventNumber);
+        coll = FEDRawDataCollection();
+      }
+    }
+
+    sequential.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  // concurrent reading with ordered merge, twice to check the determinism
+  Result merged[2];
+  for (auto &r : merged)
+  {
+    auto start = chrono::steady_clock::now();
+
+    vector<unique_ptr<DelayedSRSFileReader>> readers;
+    vector<SRSFileReader *> readerPointers;
+    for (const auto &fn : fileNames)
+    {
+      readers.emplace_back(new DelayedSRSFileReader(latency));
+      if (readers.back()->Open(fn) != 0)
+        return 1;
+      readerPointers.push_back(readers.back().get());
+    }
+
+    ParallelSRSFileReader parallelReader(readerPointers, queueEvents, size_t(queueMemory) * 1024);
+    parallelReader.Start();
+
+    uint64_t lastTimestamp = 0;
+    uint32_t lastEventNumber = 0;
+    ParallelSRSFileReader::Event ev;
+    while (parallelReader.GetNextEvent(ev))
+      Account(ev.timestamp, ev.eventNumber, *ev.data, r, lastTimestamp, lastEventNumber);
+
+    parallelReader.Stop();
+
+    r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  for (const auto &fn : fileNames)
+    unlink(fn.c_str());
+
+  // summary
+  printf("%12s %14s %14s %10s\n", "mode", "time (us/ev)", "MB/s", "ordered");
+  printf("%12s %14.2f %14.1f %10s\n", "sequential", sequential.time / sequential.events * 1E6,
+    sequential.bytes / sequential.time / 1E6, (sequential.ordered) ? "yes" : "no");
+  for (const auto &r : merged)
+    printf("%12s %14.2f %14.1f %10s\n", "merged", r.time / r.events * 1E6, r.bytes / r.time / 1E6,
+      (r.ordered) ? "yes" : "no");
+
+  printf("\nspeed-up: %.2f\n", sequential.time / merged[0].time);
+
+  bool ok = true;
+  for (const auto &r : merged)
+  {
+    if (r.events != events || r.bytes != sequential.bytes)
+    {
+      printf("ERROR: merged stream has %lu events (%llu B), expected %u (%llu B).\n", r.events, r.bytes, events,
+        sequential.bytes);
+      ok = false;
+    }
+
+    if (!r.ordered)
+    {
+      printf("ERROR: merged stream not ordered.\n");
+      ok = false;
+    }
+  }
+
+  if (merged[0].checksum != merged[1].checksum)
+  {
+    printf("ERROR: merged streams differ between runs.\n");
+    ok = false;
+  }
+
+  return (ok) ? 0 : 2;
+}
@@ -0,0 +1,274 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/RawCacheReader.h"
+#include "TotemRawData/Readers/interface/RawCacheWriter.h"
+#include "TotemRawData/Readers/interface/ParallelRawCacheReader.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkRawCache [option]\n");
+  printf("Converts a synthetic raw-data file to raw caches with different compressions and compares their size\n");
+  printf("and reading speed with those of the original file\n");
+  printf("OPTIONS:\n");
+  printf("    -h          print this help\n");
+  printf("    -e <int>    number of events (default 20000)\n");
+  printf("    -f <int>    OptoRx format: 1 = serial, 2 = parallel (default 2)\n");
+  printf("    -c <float>  mean number of clusters per VFAT and event (default 0.5)\n");
+  printf("    -b <int>    events per block (default 64)\n");
+  printf("    -l <int>    compression level (default 1)\n");
+  printf("    -t <int>    maximal number of decompression threads (default 4)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+uint64_t Digest(const FEDRawDataCollection &coll, unsigned long long &bytes)
+{
+  uint64_t digest = 14695981039346656037ULL;
+  for (int id = 0; id <= FEDNumbering::lastFEDId(); ++id)
+  {
+    const FEDRawData &d = coll.FEDData(id);
+    if (d.size() == 0)
+      continue;
+
+    bytes += d.size();
+
+    digest = (digest ^ id) * 1099511628211ULL;
+    for (size_t i = 0; i < d.size(); ++i)
+      digest = (digest ^ d.data()[i]) * 1099511628211ULL;
+  }
+
+  return digest;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 20000;
+  unsigned int fov = 2;
+  double clusters = 0.5;
+  unsigned int eventsPerBlock = 64;
+  int level = 1;
+  unsigned int maxThreads = 4;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fov = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) { clusters = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) { eventsPerBlock = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) { level = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) { maxThreads = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // generate the DATE file
+  char fn[] = "/tmp/benchmarkRawCacheXXXXXX";
+  const int fd = mkstemp(fn);
+  if (fd < 0)
+  {
+    perror("ERROR: cannot create temporary file");
+    return 1;
+  }
+  close(fd);
+
+  const vector<unsigned int> fedIds = { 578, 579, 580 };
+  TotemDAQMapping mapping;
+  RawDataGenerator::MakeRPMapping(fedIds, mapping);
+
+  RawDataGenerator::Parameters parameters;
+  parameters.fov = fov;
+  parameters.clustersPerVFAT = clusters;
+  RawDataGenerator generator(mapping, parameters);
+
+  SRSFileWriter srsWriter;
+  if (srsWriter.Open(fn, 1) != 0)
+    return 1;
+
+  FEDRawDataCollection rawData;
+  RawDataGenerator::EventTruth truth;
+  for (unsigned int e = 0; e < events; ++e)
+  {
+    generator.Generate(rawData, truth);
+    srsWriter.WriteEvent(truth.eventNumber, e / 1000, rawData, fedIds);
+  }
+  srsWriter.Close();
+
+  const unsigned long long dateSize = srsWriter.GetBytesWritten();
+
+  // read the DATE file, the reference digests
+  vector<uint64_t> referenceDigests;
+  unsigned long long payloadBytes = 0;
+  double dateTime = 0.;
+  {
+    SRSFileReader reader;
+    if (reader.Open(fn) != 0)
+      return 1;
+
+    auto start = chrono::steady_clock::now();
+
+    uint64_t timestamp;
+    FEDRawDataCollection coll;
+    while (reader.GetNextEvent(timestamp, coll) == 0)
+    {
+      referenceDigests.push_back(Digest(coll, payloadBytes));
+      coll = FEDRawDataCollection();
+    }
+
+    dateTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  printf("events: %u, FOV: %u, events per block: %u, compression level: %i\n\n", events, fov, eventsPerBlock, level);
+
+  printf("%8s %8s %12s %8s %14s %14s %14s\n", "format", "threads", "size (MB)", "ratio", "write (MB/s)",
+    "read (us/ev)", "read (MB/s)");
+  printf("%8s %8s %12.2f %8.2f %14s %14.2f %14.1f\n", "DATE", "-", dateSize / 1E6, 1., "-",
+    dateTime / events * 1E6, payloadBytes / dateTime / 1E6);
+
+  bool ok = true;
+
+  const RawCacheFormat::Codec codecs[] = { RawCacheFormat::cNone, RawCacheFormat::cZlib, RawCacheFormat::cLZMA };
+  for (const auto codec : codecs)
+  {
+    // convert DATE --> cache
+    const string cacheFileName = string(fn) + ".cache";
+
+    SRSFileReader reader;
+    if (reader.Open(fn) != 0)
+      return 1;
+
+    RawCacheWriter writer;
+    if (writer.Open(cacheFileName, codec, level, eventsPerBlock) != 0)
+      return 1;
+
+    double writeTime = 0.;
+    uint64_t timestamp;
+    FEDRawDataCollection coll;
+    for (unsigned int e = 0; reader.GetNextEvent(timestamp, coll) == 0; ++e)
+    {
+      auto start = chrono::steady_clock::now();
+      writer.WriteEvent(1, timestamp + 1, e + 1, timestamp, coll);
+      writeTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      coll = FEDRawDataCollection();
+    }
+
+    auto start = chrono::steady_clock::now();
+    if (writer.Close() != 0)
+      return 1;
+    writeTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // sequential reading with different number of threads
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+      RawCacheReader cacheReader;
+      if (cacheReader.Open(cacheFileName) != 0)
+        return 1;
+
+      auto start = chrono::steady_clock::now();
+
+      vector<unsigned int> blocks;
+      for (unsigned int b = 0; b < cacheReader.GetNumberOfBlocks(); ++b)
+        blocks.push_back(b);
+
+      ParallelRawCacheReader blockReader(cacheReader, blocks, threads, 2);
+      blockReader.Start();
+
+      unsigned long long bytes = 0;
+      unsigned long eventsRead = 0;
+      bool match = true;
+
+      RawCacheReader::Block block;
+      while (blockReader.GetNextBlock(block))
+      {
+        const RawCacheFormat::BlockInfo &info = cacheReader.GetBlockInfo(block.index);
+        for (uint64_t e = info.firstEvent; e < info.firstEvent + info.nEvents; ++e)
+        {
+          FEDRawDataCollection coll;
+          if (cacheReader.GetEvent(block, e, coll) != 0 || Digest(coll, bytes) != referenceDigests[e])
+            match = false;
+
+          eventsRead++;
+        }
+      }
+
+      blockReader.Stop();
+
+      const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      printf("%8s %8u %12.2f %8.2f %14.1f %14.2f %14.1f\n", RawCacheFormat::GetCodecName(codec), threads,
+        cacheReader.GetFileSize() / 1E6, double(dateSize) / cacheReader.GetFileSize(),
+        writer.GetUncompressedBytes() / writeTime / 1E6, time / eventsRead * 1E6, bytes / time / 1E6);
+
+      if (!match || eventsRead != events)
+      {
+        printf("ERROR: events read from the cache differ from the original.\n");
+        ok = false;
+      }
+    }
+
+    // random access
+    {
+      RawCacheReader cacheReader;
+      if (cacheReader.Open(cacheFileName) != 0)
+        return 1;
+
+      mt19937 rng(1);
+      RawCacheReader::Block block;
+      for (unsigned int i = 0; i < 100 && events > 0; ++i)
+      {
+        const uint64_t e = rng() % events;
+        FEDRawDataCollection coll;
+        unsigned long long bytes = 0;
+        if (cacheReader.ReadBlock(cacheReader.GetEventInfo(e).block, block) != 0
+            || cacheReader.GetEvent(block, e, coll) != 0 || Digest(coll, bytes) != referenceDigests[e])
+        {
+          printf("ERROR: random access to event %lu failed.\n", (unsigned long) e);
+          ok = false;
+          break;
+        }
+      }
+    }
+
+    unlink(cacheFileName.c_str());
+  }
+
+  unlink(fn);
+
+  return (ok) ? 0 : 2;
+}
@@ -0,0 +1,238 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/Common/interface/DetSetVector.h"
+#include "DataFormats/TotemDigi/interface/TotemRPDigi.h"
+#include "DataFormats/TotemDigi/interface/TotemVFATStatus.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkRawDataChain [option]\n");
+  printf("Generates synthetic raw data and measures the throughput of the raw -> digi chain, stage by stage\n");
+  printf("OPTIONS:\n");
+  printf("    -h          print this help\n");
+  printf("    -e <int>    number of events (default 5000)\n");
+  printf("    -f <int>    OptoRx format: 1 = serial, 2 = parallel (default 2)\n");
+  printf("    -n <int>    number of FEDs, 3 pots each (default 3)\n");
+  printf("    -c <float>  mean number of clusters per VFAT and event (default 0.5)\n");
+  printf("    -r <float>  rate of each corruption type (EC, BC, CRC, missing), per VFAT and event (default 0)\n");
+  printf("    -o <file>   raw-data file, kept after the run (default: temporary file, deleted)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+struct Stage
+{
+  const char *name;
+  double time;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 5000;
+  unsigned int fov = 2;
+  unsigned int feds = 3;
+  double clusters = 0.5;
+  double corruptionRate = 0.;
+  string fileName;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fov = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { feds = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) { clusters = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) { corruptionRate = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) { fileName = argv[++i]; continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  const bool temporaryFile = fileName.empty();
+  if (temporaryFile)
+  {
+    char fn[] = "/tmp/benchmarkRawDataChainXXXXXX";
+    const int fd = mkstemp(fn);
+    if (fd < 0)
+    {
+      perror("ERROR: cannot create temporary file");
+      return 1;
+    }
+    close(fd);
+    fileName = fn;
+  }
+
+  // mapping and generator
+  vector<unsigned int> fedIds;
+  for (unsigned int i = 0; i < feds; ++i)
+    fedIds.push_back(578 + i);
+
+  TotemDAQMapping mapping;
+  RawDataGenerator::MakeRPMapping(fedIds, mapping);
+  TotemAnalysisMask mask;
+
+  RawDataGenerator::Parameters parameters;
+  parameters.fov = fov;
+  parameters.clustersPerVFAT = clusters;
+  parameters.ecJitterRate = parameters.bcJitterRate = corruptionRate;
+  parameters.crcCorruptionRate = parameters.missingRate = corruptionRate;
+
+  RawDataGenerator generator(mapping, parameters);
+
+  // raw -> digi chain
+  ParameterSet ps;
+  ps.addUntrackedParameter<unsigned int>("verbosity", 0);
+  ps.addUntrackedParameter<unsigned int>("printErrorSummary", 0);
+  ps.addUntrackedParameter<unsigned int>("printUnknownFrameSummary", 0);
+  ps.addParameter<unsigned int>("testFootprint", 2);
+  ps.addParameter<unsigned int>("testCRC", 2);
+  ps.addParameter<unsigned int>("testID", 2);
+  ps.addParameter<unsigned int>("testECMostFrequent", 2);
+  ps.addParameter<unsigned int>("testBCMostFrequent", 2);
+
+  RawToDigiConverter converter(ps);
+  converter.SetMapping(mapping, mask);
+
+  RawDataUnpacker unpacker;
+
+  Stage generate = { "generate", 0. }, write = { "write", 0. }, read = { "read", 0. }, unpack = { "unpack", 0. },
+    convert = { "convert", 0. };
+
+  // generation and writing
+  SRSFileWriter writer;
+  if (writer.Open(fileName, 1) != 0)
+    return 1;
+
+  unsigned long long payloadBytes = 0;
+  FEDRawDataCollection generated;
+  RawDataGenerator::EventTruth truth;
+  for (unsigned int e = 0; e < events; ++e)
+  {
+    auto start = chrono::steady_clock::now();
+    generator.Generate(generated, truth);
+    auto mid = chrono::steady_clock::now();
+    writer.WriteEvent(truth.eventNumber, e / 1000, generated, generator.GetFEDIds());
+    auto end = chrono::steady_clock::now();
+
+    generate.time += chrono::duration<double>(mid - start).count();
+    write.time += chrono::duration<double>(end - mid).count();
+
+    for (const auto &fedId : fedIds)
+      payloadBytes += generated.FEDData(fedId).size();
+  }
+
+  writer.Close();
+  const unsigned long long fileBytes = writer.GetBytesWritten();
+
+  // reading, unpacking and conversion
+  SRSFileReader reader;
+  if (reader.Open(fileName) != 0)
+  {
+    printf("ERROR: cannot read back file `%s'.\n", fileName.c_str());
+    return 1;
+  }
+
+  FlatVFATFrameCollection frames;
+  unsigned int eventsRead = 0;
+  unsigned long digis = 0, badFrames = 0;
+  while (true)
+  {
+    uint64_t timestamp;
+    FEDRawDataCollection rawData;
+
+    auto t0 = chrono::steady_clock::now();
+    if (reader.GetNextEvent(timestamp, rawData) != 0)
+      break;
+    auto t1 = chrono::steady_clock::now();
+
+    frames.Clear();
+    vector<TotemFEDInfo> fedInfo;
+    for (const auto &fedId : fedIds)
+      unpacker.Run(fedId, rawData.FEDData(fedId), fedInfo, frames);
+    auto t2 = chrono::steady_clock::now();
+
+    DetSetVector<TotemRPDigi> digi;
+    DetSetVector<TotemVFATStatus> status;
+    converter.Run(frames, digi, status);
+    auto t3 = chrono::steady_clock::now();
+
+    read.time += chrono::duration<double>(t1 - t0).count();
+    unpack.time += chrono::duration<double>(t2 - t1).count();
+    convert.time += chrono::duration<double>(t3 - t2).count();
+
+    eventsRead++;
+    for (const auto &ds : digi)
+      digis += ds.size();
+    for (const auto &ds : status)
+      for (const auto &st : ds)
+        badFrames += !st.isOK();
+  }
+
+  reader.Close();
+
+  if (temporaryFile)
+    unlink(fileName.c_str());
+
+  // summary
+  printf("events: %u, FEDs: %u, FOV: %u, VFATs: %lu\n", events, feds, fov, mapping.VFATMapping.size());
+  printf("payload: %.1f kB/event, file: %.1f MB, digis: %.1f/event, bad frames: %.2f/event\n",
+    double(payloadBytes) / events / 1E3, double(fileBytes) / 1E6, double(digis) / eventsRead,
+    double(badFrames) / eventsRead);
+
+  if (eventsRead != events)
+  {
+    printf("ERROR: %u events written, %u read.\n", events, eventsRead);
+    return 2;
+  }
+
+  printf("\n%10s %14s %14s %14s\n", "stage", "time (us/ev)", "events/s", "MB/s");
+  for (const Stage &s : { generate, write, read, unpack, convert })
+    printf("%10s %14.2f %14.0f %14.1f\n", s.name, s.time / events * 1E6, events / s.time, payloadBytes / s.time / 1E6);
+
+  const double chainTime = read.time + unpack.time + convert.time;
+  printf("%10s %14.2f %14.0f %14.1f\n", "raw->digi", chainTime / events * 1E6, events / chainTime,
+    payloadBytes / chainTime / 1E6);
+
+  return 0;
+}
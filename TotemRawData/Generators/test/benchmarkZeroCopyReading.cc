@@ -0,0 +1,250 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/MappedSRSFileReader.h"
+#include "TotemRawData/Readers/interface/SharedRawEvent.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkZeroCopyReading [option]\n");
+  printf("Compares reading + unpacking of a synthetic raw-data file with payloads copied to FEDRawDataCollection\n");
+  printf("and with payloads viewed in the reader's buffer (SharedRawEvent)\n");
+  printf("OPTIONS:\n");
+  printf("    -h          print this help\n");
+  printf("    -e <int>    number of events (default 10000)\n");
+  printf("    -f <int>    OptoRx format: 1 = serial, 2 = parallel (default 2)\n");
+  printf("    -n <int>    number of FEDs, 3 pots each (default 3)\n");
+  printf("    -c <float>  mean number of clusters per VFAT and event (default 0.5)\n");
+  printf("    -k <int>    number of events held by the consumer in the `held' mode (default 8)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+  unsigned long events = 0;
+  unsigned long long bytes = 0;
+  unsigned long long bytesCopied = 0;
+  uint64_t digest = 0;
+  double time = 0.;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+void Digest(const FlatVFATFrameCollection &frames, uint64_t &digest)
+{
+  for (VFATFrameCollection::Iterator it(&frames); !it.IsEnd(); it.Next())
+  {
+    const VFATFrame::word *d = it.Data()->getData();
+    digest = (digest ^ it.Position().getRawPosition()) * 1099511628211ULL;
+    for (unsigned int i = 0; i < 12; ++i)
+      digest = (digest ^ d[i]) * 1099511628211ULL;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// mode 0: copies to FEDRawDataCollection, 1: SharedRawEvent, 2: SharedRawEvent, the last `held' events kept
+Result Run(SRSFileReader &reader, const string &fn, const vector<unsigned int> &fedIds, unsigned int mode,
+  unsigned int held)
+{
+  Result r;
+
+  if (reader.Open(fn) != 0)
+  {
+    printf("ERROR: cannot open file `%s'.\n", fn.c_str());
+    exit(1);
+  }
+
+  RawDataUnpacker unpacker;
+  FlatVFATFrameCollection frames;
+  vector<TotemFEDInfo> fedInfo;
+
+  FEDRawDataCollection coll;
+  SharedRawEvent event;
+  deque<SharedRawEvent> heldEvents;
+
+  const unsigned long long copiedBefore = reader.GetBytesCopied();
+
+  auto start = chrono::steady_clock::now();
+
+  while (true)
+  {
+    uint64_t timestamp;
+    frames.Clear();
+    fedInfo.clear();
+
+    if (mode == 0)
+    {
+      if (reader.GetNextEvent(timestamp, coll) != 0)
+        break;
+
+      for (const auto &fedId : fedIds)
+      {
+        const FEDRawData &data = coll.FEDData(fedId);
+        r.bytes += data.size();
+        unpacker.Run(fedId, data, fedInfo, frames);
+      }
+    } else {
+      if (reader.GetNextEvent(timestamp, event) != 0)
+        break;
+
+      for (const auto &fedId : fedIds)
+      {
+        const FEDRawDataView data = event.FEDData(fedId);
+        r.bytes += data.size();
+        unpacker.Run(fedId, data, fedInfo, frames);
+      }
+
+      // the consumer keeps the last events, e.g. in a prefetch queue
+      if (mode == 2)
+      {
+        heldEvents.push_back(event);
+        if (heldEvents.size() > held)
+          heldEvents.pop_front();
+      }
+    }
+
+    Digest(frames, r.digest);
+    r.events++;
+  }
+
+  r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  r.bytesCopied = reader.GetBytesCopied() - copiedBefore;
+
+  reader.Close();
+
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int events = 10000;
+  unsigned int fov = 2;
+  unsigned int feds = 3;
+  double clusters = 0.5;
+  unsigned int held = 8;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) { events = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) { fov = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) { feds = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) { clusters = atof(argv[++i]); continue; }
+    if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) { held = atoi(argv[++i]); continue; }
+
+    PrintUsage();
+    return 1;
+  }
+
+  // generate the input file
+  char fn[] = "/tmp/benchmarkZeroCopyReadingXXXXXX";
+  const int fd = mkstemp(fn);
+  if (fd < 0)
+  {
+    perror("ERROR: cannot create temporary file");
+    return 1;
+  }
+  close(fd);
+
+  vector<unsigned int> fedIds;
+  for (unsigned int i = 0; i < feds; ++i)
+    fedIds.push_back(578 + i);
+
+  TotemDAQMapping mapping;
+  RawDataGenerator::MakeRPMapping(fedIds, mapping);
+
+  RawDataGenerator::Parameters parameters;
+  parameters.fov = fov;
+  parameters.clustersPerVFAT = clusters;
+  RawDataGenerator generator(mapping, parameters);
+
+  SRSFileWriter writer;
+  if (writer.Open(fn, 1) != 0)
+    return 1;
+
+  FEDRawDataCollection rawData;
+  RawDataGenerator::EventTruth truth;
+  for (unsigned int e = 0; e < events; ++e)
+  {
+    generator.Generate(rawData, truth);
+    writer.WriteEvent(truth.eventNumber, e / 1000, rawData, fedIds);
+  }
+  writer.Close();
+
+  printf("events: %u, FEDs: %u, FOV: %u, file: %.1f MB\n\n", events, feds, fov, writer.GetBytesWritten() / 1E6);
+
+  // read and unpack
+  printf("%8s %16s %14s %14s %14s\n", "reader", "payloads", "time (us/ev)", "MB/s", "copied (B/ev)");
+
+  const char *modeNames[] = { "copied", "shared", "shared, held" };
+
+  bool ok = true;
+  uint64_t referenceDigest = 0;
+
+  for (unsigned int ri = 0; ri < 2; ++ri)
+  {
+    for (unsigned int mode = 0; mode < 3; ++mode)
+    {
+      unique_ptr<SRSFileReader> reader((ri == 0) ? new SRSFileReader() : new MappedSRSFileReader());
+      const Result r = Run(*reader, fn, fedIds, mode, held);
+
+      printf("%8s %16s %14.2f %14.1f %14.0f\n", (ri == 0) ? "buffered" : "mapped", modeNames[mode],
+        r.time / r.events * 1E6, r.bytes / r.time / 1E6, double(r.bytesCopied) / r.events);
+
+      if (r.events != events)
+      {
+        printf("ERROR: %lu events read from %u.\n", r.events, events);
+        ok = false;
+      }
+
+      if (ri == 0 && mode == 0)
+        referenceDigest = r.digest;
+      else if (r.digest != referenceDigest)
+      {
+        printf("ERROR: unpacked frames differ from the reference.\n");
+        ok = false;
+      }
+    }
+  }
+
+  unlink(fn);
+
+  return (ok) ? 0 : 2;
+}
@@ -0,0 +1,68 @@
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+
+process = cms.Process("GenerateRawData")
+
+# default options
+options = VarParsing.VarParsing ('analysis')
+options.outputFile = 'synthetic.srs'
+options.maxEvents = 1000
+
+options.register('mappingFiles', 'CondFormats/TotemReadoutObjects/xml/totem_rp_210far_220_mapping.xml',
+  VarParsing.VarParsing.multiplicity.list, VarParsing.VarParsing.varType.string, "DAQ mapping XML file(s)")
+options.register('truthFile', '', VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.string, "output file for the generator truth (empty = none)")
+options.register('fov', 2, VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.int, "OptoRx format: 1 = serial, 2 = parallel")
+options.register('clustersPerVFAT', 0.5, VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.float, "mean number of clusters per VFAT and event")
+options.register('ecJitterRate', 0., VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.float, "probability of a wrong EC, per VFAT and event")
+options.register('bcJitterRate', 0., VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.float, "probability of a wrong BC, per VFAT and event")
+options.register('crcCorruptionRate', 0., VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.float, "probability of a wrong CRC, per VFAT and event")
+options.register('missingRate', 0., VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.float, "probability of a missing frame, per VFAT and event")
+options.register('seed', 1, VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.int, "random seed")
+
+# parse command-line options
+options.parseArguments()
+
+# minimum of logs
+process.MessageLogger = cms.Service("MessageLogger",
+    statistics = cms.untracked.vstring(),
+    destinations = cms.untracked.vstring('cerr'),
+    cerr = cms.untracked.PSet(
+        threshold = cms.untracked.string('INFO')
+    )
+)
+
+# one raw event per framework event
+process.source = cms.Source("EmptySource")
+
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(options.maxEvents)
+)
+
+# DAQ mapping
+process.load('CondFormats.TotemReadoutObjects.TotemDAQMappingESSourceXML_cfi')
+process.TotemDAQMappingESSourceXML.mappingFileNames = options.mappingFiles
+
+# generator
+process.load('TotemRawData.Generators.totemRawDataGenerator_cfi')
+process.totemRawDataGenerator.outputFile = options.outputFile
+process.totemRawDataGenerator.truthFile = options.truthFile
+process.totemRawDataGenerator.fov = options.fov
+process.totemRawDataGenerator.clustersPerVFAT = options.clustersPerVFAT
+process.totemRawDataGenerator.ecJitterRate = options.ecJitterRate
+process.totemRawDataGenerator.bcJitterRate = options.bcJitterRate
+process.totemRawDataGenerator.crcCorruptionRate = options.crcCorruptionRate
+process.totemRawDataGenerator.missingRate = options.missingRate
+process.totemRawDataGenerator.seed = options.seed
+
+# execution configuration
+process.p = cms.Path(
+    process.totemRawDataGenerator
+)
@@ -0,0 +1,345 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/Common/interface/DetSetVector.h"
+#include "DataFormats/TotemDigi/interface/TotemRPDigi.h"
+#include "DataFormats/TotemDigi/interface/TotemVFATStatus.h"
+#include "DataFormats/TotemRPDetId/interface/TotemRPDetId.h"
+
+#include "CondFormats/TotemReadoutObjects/interface/TotemDAQMapping.h"
+#include "CondFormats/TotemReadoutObjects/interface/TotemAnalysisMask.h"
+
+#include "EventFilter/TotemRawToDigi/interface/FlatVFATFrameCollection.h"
+#include "EventFilter/TotemRawToDigi/interface/RawDataUnpacker.h"
+#include "EventFilter/TotemRawToDigi/interface/RawToDigiConverter.h"
+#include "EventFilter/TotemRawToDigi/interface/VFATFrameCRC.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+
+#include "TotemRawData/Generators/interface/RawDataGenerator.h"
+#include "TotemRawData/Generators/interface/SRSFileWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+/// status flags of one VFAT, as compared
+struct Flags
+{
+  bool missing, footprint, crc, id, ec, bc, fullMask, partialMask;
+
+  bool operator== (const Flags &o) const
+  {
+    return missing == o.missing && footprint == o.footprint && crc == o.crc && id == o.id && ec == o.ec
+      && bc == o.bc && fullMask == o.fullMask && partialMask == o.partialMask;
+  }
+};
+
+/// (detId, chip position) -> flags
+typedef map<pair<unsigned int, unsigned int>, Flags> StatusMap;
+
+/// detId -> strips
+typedef map<unsigned int, set<unsigned int>> DigiMap;
+
+//----------------------------------------------------------------------------------------------------
+
+/// masks every 7th data VFAT fully and every 5th partially (channels 0 to 31 and every 10th channel)
+void MakeMask(const TotemDAQMapping &mapping, TotemAnalysisMask &mask)
+{
+  for (const auto &p : mapping.VFATMapping)
+  {
+    if (p.second.type != TotemVFATInfo::data)
+      continue;
+
+    const unsigned int symbId = p.second.symbolicID.symbolicID;
+
+    TotemVFATAnalysisMask vm;
+    if (symbId % 7 == 0)
+      vm.fullMask = true;
+    else if (symbId % 5 == 0)
+    {
+      for (unsigned int ch = 0; ch < 128; ++ch)
+        if (ch < 32 || ch % 10 == 0)
+          vm.maskedChannels.insert(ch);
+    } else
+      continue;
+
+    mask.insert(p.second.symbolicID, vm);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// the converter output expected from the truth
+void MakeExpected(const RawDataGenerator::EventTruth &truth, unsigned int fov, const TotemDAQMapping &mapping,
+  const TotemAnalysisMask &mask, StatusMap &statuses, DigiMap &digis)
+{
+  for (const auto &v : truth.vfats)
+  {
+    const TotemVFATInfo &info = mapping.VFATMapping.find(v.position)->second;
+    if (info.type != TotemVFATInfo::data)
+      continue;
+
+    const unsigned int symbId = info.symbolicID.symbolicID;
+    const unsigned int detId = TotemRPDetId::decToRawId(symbId / 10);
+    const unsigned int chipPosition = symbId % 10;
+
+    // a missing serial frame arrives as an all-zero frame, which fails the footprint, CRC and ID tests;
+    // EC and BC are only tested for frames that pass the former tests
+    Flags f = { false, false, false, false, false, false, false, false };
+    if (v.missing)
+    {
+      if (fov == 1)
+      {
+        const VFATFrame::word zero[12] = { 0 };
+        f.footprint = true;
+        f.crc = (VFATFrameCRC::GetDefault().Calculate(zero) != 0);
+        f.id = ((info.hwID & 0xFFF) != 0);
+      } else
+        f.missing = true;
+    } else if (v.crcCorrupted)
+      f.crc = true;
+    else
+    {
+      f.ec = v.ecJitter;
+      f.bc = v.bcJitter;
+    }
+
+    const bool ok = !(f.missing || f.footprint || f.crc || f.id || f.ec || f.bc);
+
+    auto mit = mask.analysisMask.find(info.symbolicID);
+    const TotemVFATAnalysisMask *vm = (mit != mask.analysisMask.end()) ? &mit->second : NULL;
+
+    if (ok && vm)
+    {
+      f.fullMask = vm->fullMask;
+      f.partialMask = !vm->fullMask;
+    }
+
+    statuses[{detId, chipPosition}] = f;
+
+    if (!ok || (vm && vm->fullMask))
+      continue;
+
+    for (unsigned int ch = 0; ch < 128; ++ch)
+    {
+      if (v.IsChannelActive(ch) && (!vm || vm->maskedChannels.count(ch) == 0))
+        digis[detId].insert(chipPosition * 128 + ch);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void Convert(const DetSetVector<TotemRPDigi> &digi, const DetSetVector<TotemVFATStatus> &status,
+  StatusMap &statuses, DigiMap &digis)
+{
+  for (const auto &ds : status)
+  {
+    for (const auto &st : ds)
+    {
+      statuses[{ds.detId(), st.getChipPosition()}] = { st.isMissing(), st.isFootprintError(), st.isCRCError(),
+        st.isIDMismatch(), st.isECProgressError(), st.isBCProgressError(), st.isFullyMaskedOut(),
+        st.isPartiallyMaskedOut() };
+    }
+  }
+
+  for (const auto &ds : digi)
+  {
+    for (const auto &dg : ds)
+    {
+      if (!digis[ds.detId()].insert(dg.getStripNumber()).second)
+        printf("ERROR: duplicate strip %u in detector %u.\n", dg.getStripNumber(), ds.detId());
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// generates, writes, reads back, unpacks and converts `events' events, returns the number of failures
+unsigned int RunTest(const char *name, const RawDataGenerator::Parameters &parameters, bool useMask,
+  unsigned int events)
+{
+  TotemDAQMapping mapping;
+  RawDataGenerator::MakeRPMapping({ 578, 579, 580 }, mapping);
+
+  TotemAnalysisMask mask;
+  if (useMask)
+    MakeMask(mapping, mask);
+
+  // generation
+  char fn[] = "/tmp/testRawDataGeneratorXXXXXX";
+  const int fd = mkstemp(fn);
+  if (fd < 0)
+  {
+    perror("ERROR: cannot create temporary file");
+    return 1;
+  }
+  close(fd);
+
+  RawDataGenerator generator(mapping, parameters);
+  vector<RawDataGenerator::EventTruth> truths(events);
+  vector<FEDRawDataCollection> generated(events);
+
+  SRSFileWriter writer;
+  if (writer.Open(fn, 1) != 0)
+    return 1;
+
+  for (unsigned int e = 0; e < events; ++e)
+  {
+    generator.Generate(generated[e], truths[e]);
+    if (writer.WriteEvent(truths[e].eventNumber, e, generated[e], generator.GetFEDIds()) != 0)
+      return 1;
+  }
+
+  writer.Close();
+
+  // read back and convert
+  ParameterSet ps;
+  ps.addUntrackedParameter<unsigned int>("verbosity", 0);
+  ps.addUntrackedParameter<unsigned int>("printErrorSummary", 0);
+  ps.addUntrackedParameter<unsigned int>("printUnknownFrameSummary", 0);
+  ps.addParameter<unsigned int>("testFootprint", 2);
+  ps.addParameter<unsigned int>("testCRC", 2);
+  ps.addParameter<unsigned int>("testID", 2);
+  ps.addParameter<unsigned int>("testECMostFrequent", 2);
+  ps.addParameter<unsigned int>("testBCMostFrequent", 2);
+
+  RawToDigiConverter converter(ps);
+  converter.SetMapping(mapping, mask);
+
+  RawDataUnpacker unpacker;
+  FlatVFATFrameCollection frames;
+
+  SRSFileReader reader;
+  if (reader.Open(fn) != 0)
+  {
+    printf("ERROR in %s: cannot read back the file.\n", name);
+    unlink(fn);
+    return 1;
+  }
+
+  unsigned int failures = 0;
+  unsigned int e = 0;
+  unsigned long digiCount = 0, errorCount = 0;
+  for (; e < events; ++e)
+  {
+    uint64_t timestamp;
+    FEDRawDataCollection rawData;
+    if (reader.GetNextEvent(timestamp, rawData) != 0)
+    {
+      printf("ERROR in %s: only %u events read back.\n", name, e);
+      failures++;
+      break;
+    }
+
+    frames.Clear();
+    vector<TotemFEDInfo> fedInfo;
+    for (const auto &fedId : generator.GetFEDIds())
+    {
+      const FEDRawData &data = rawData.FEDData(fedId);
+      const FEDRawData &orig = generated[e].FEDData(fedId);
+      if (data.size() != orig.size() || memcmp(data.data(), orig.data(), data.size()) != 0)
+      {
+        printf("ERROR in %s: FED %u differs in event %u after the file round trip.\n", name, fedId, e);
+        failures++;
+      }
+
+      unpacker.Run(fedId, data, fedInfo, frames);
+    }
+
+    DetSetVector<TotemRPDigi> digi;
+    DetSetVector<TotemVFATStatus> status;
+    converter.Run(frames, digi, status);
+
+    StatusMap expectedStatuses, statuses;
+    DigiMap expectedDigis, digis;
+    MakeExpected(truths[e], parameters.fov, mapping, mask, expectedStatuses, expectedDigis);
+    Convert(digi, status, statuses, digis);
+
+    if (statuses != expectedStatuses)
+    {
+      printf("ERROR in %s: statuses differ in event %u.\n", name, e);
+      failures++;
+    }
+
+    if (digis != expectedDigis)
+    {
+      printf("ERROR in %s: digis differ in event %u.\n", name, e);
+      failures++;
+    }
+
+    for (const auto &p : expectedDigis)
+      digiCount += p.second.size();
+    for (const auto &p : expectedStatuses)
+      errorCount += (p.second.missing || p.second.footprint || p.second.crc || p.second.id || p.second.ec || p.second.bc);
+  }
+
+  reader.Close();
+  unlink(fn);
+
+  printf("%-24s %6u events, %8lu digis, %6lu corrupted frames: %s\n", name, e, digiCount, errorCount,
+    (failures == 0) ? "OK" : "FAILED");
+
+  return failures;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main()
+{
+  unsigned int failures = 0;
+
+  for (unsigned int fov = 1; fov <= 2; ++fov)
+  {
+    RawDataGenerator::Parameters clean;
+    clean.fov = fov;
+    clean.clustersPerVFAT = 1.5;
+    clean.seed = 10 + fov;
+
+    RawDataGenerator::Parameters corrupted = clean;
+    corrupted.ecJitterRate = 0.03;
+    corrupted.bcJitterRate = 0.03;
+    corrupted.crcCorruptionRate = 0.03;
+    corrupted.missingRate = 0.03;
+    corrupted.seed = 20 + fov;
+
+    RawDataGenerator::Parameters busy = clean;
+    busy.clustersPerVFAT = 6.;
+    busy.clusterSizeMean = 4.;
+    busy.clusterSizeMax = 20;
+    busy.seed = 30 + fov;
+
+    const string prefix = "FOV " + to_string(fov) + ", ";
+    failures += RunTest((prefix + "clean").c_str(), clean, false, 200);
+    failures += RunTest((prefix + "clean, masked").c_str(), clean, true, 200);
+    failures += RunTest((prefix + "corrupted").c_str(), corrupted, false, 200);
+    failures += RunTest((prefix + "corrupted, masked").c_str(), corrupted, true, 200);
+    failures += RunTest((prefix + "busy").c_str(), busy, true, 100);
+  }
+
+  if (failures > 0)
+  {
+    printf("%u failures\n", failures);
+    return 1;
+  }
+
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/SRSFileIndex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: totemBuildSRSFileIndex [option] <file> [<file> ...]\n");
+  printf("Builds the event index of the given raw files and saves it to <file>.idx.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -c              only check whether the existing indices are valid\n");
+  printf("    -f              rebuild the indices even if they are valid\n");
+  printf("    -v              print the index content\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  bool checkOnly = false;
+  bool force = false;
+  bool verbose = false;
+  vector<string> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-c") == 0) { checkOnly = true; continue; }
+    if (strcmp(argv[i], "-f") == 0) { force = true; continue; }
+    if (strcmp(argv[i], "-v") == 0) { verbose = true; continue; }
+
+    files.push_back(argv[i]);
+  }
+
+  if (files.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  int errors = 0;
+
+  for (const auto &fn : files)
+  {
+    const string indexFileName = SRSFileIndex::GetDefaultIndexFileName(fn);
+
+    SRSFileIndex index;
+    bool valid = (index.Load(indexFileName, fn) == 0);
+
+    if (checkOnly)
+    {
+      printf("%s: %s\n", indexFileName.c_str(), (valid) ? "valid" : "INVALID");
+      if (!valid)
+        errors++;
+      continue;
+    }
+
+    if (!valid || force)
+    {
+      if (index.Build(fn) != 0)
+      {
+        printf("ERROR: cannot build index of file `%s'.\n", fn.c_str());
+        errors++;
+        continue;
+      }
+
+      if (index.Save(indexFileName, fn) != 0)
+      {
+        printf("ERROR: cannot save index file `%s'.\n", indexFileName.c_str());
+        errors++;
+        continue;
+      }
+    }
+
+    const unsigned long N = index.GetNumberOfPhysicsEvents();
+    printf("%s: %lu events, %lu physics events", fn.c_str(), (unsigned long) index.GetEntries().size(), N);
+    if (N > 0)
+      printf(", luminosity blocks 1 to %u, timestamps %u to %u", index.GetLuminosityBlock(N - 1),
+        index.GetPhysicsEvent(0).timestamp, index.GetPhysicsEvent(N - 1).timestamp);
+    printf("\n");
+
+    if (verbose)
+    {
+      printf("%12s %12s %12s %6s\n", "offset", "event nb", "timestamp", "type");
+      for (const auto &e : index.GetEntries())
+        printf("%12llu %12u %12u %6u\n", (unsigned long long) e.offset, e.eventNumber, e.timestamp, e.eventType);
+    }
+  }
+
+  return (errors > 0) ? 1 : 0;
+}
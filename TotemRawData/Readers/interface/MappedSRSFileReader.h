@@ -0,0 +1,77 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_MappedSRSFileReader
+#define TotemRawData_Readers_MappedSRSFileReader
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+
+#include <cstddef>
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Reads a raw-data file in SRS format through a read-only memory mapping.
+ *
+ * The DATE headers are walked directly in the mapped region, hence no intermediate buffer
+ * is (re)allocated and no read syscall is made per event. The kernel is advised about the
+ * sequential access pattern and the region ahead of the current position is announced
+ * in windows of 'readAheadSize' bytes. Pages already processed are released, so that the
+ * resident memory stays bounded even for multi-GB files.
+ *
+ * A SharedRawEvent returned by this reader points into the mapping, which is kept (even after Close)
+ * until the last such event is released. Released pages are transparently read again if accessed.
+ **/
+class MappedSRSFileReader : public SRSFileReader
+{
+  public:
+    MappedSRSFileReader(size_t _readAheadSize = 64*1024*1024);
+
+    virtual ~MappedSRSFileReader();
+
+    virtual int Open(const std::string &);
+
+    virtual void Close();
+
+    using SRSFileReader::GetNextEvent;
+
+    virtual unsigned char GetNextEvent(uint64_t &timestamp, SharedRawEvent &);
+
+    virtual int SeekOffset(uint64_t offset);
+
+  protected:
+    /// size of the region to be announced ahead of the current position, in bytes
+    size_t readAheadSize;
+
+    /// file descriptor
+    int fd;
+
+    /// the mapped region, unmapped when the last reference is released
+    std::shared_ptr<const char> mapping;
+
+    /// beginning of the mapped region, NULL if nothing is mapped
+    const char *mapPtr;
+
+    /// size of the mapped region (i.e. the file size), in bytes
+    size_t mapSize;
+
+    /// offset of the next event header
+    size_t position;
+
+    /// end of the region already announced with MADV_WILLNEED
+    size_t adviceEnd;
+
+    /// end of the region already released with MADV_DONTNEED
+    size_t releaseEnd;
+
+    /// announces the next read-ahead window and releases the pages behind the current position
+    void UpdateAdvice();
+};
+
+#endif
@@ -0,0 +1,65 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_ParallelRawCacheReader
+#define TotemRawData_Readers_ParallelRawCacheReader
+
+#include "TotemRawData/Readers/interface/RawCacheReader.h"
+#include "TotemRawData/Readers/interface/PrefetchQueue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Reads and decompresses a list of raw-cache blocks in several threads, delivers them in the order of the list.
+ *
+ * The k-th block of the list is decompressed by thread k % nThreads, which pushes it to its own PrefetchQueue
+ * of depth 'blocksAhead'. The consumer pops the queues round robin, the order of the blocks is thus always
+ * the order of the list, regardless of the thread timing.
+ *
+ * An error of a thread is rethrown (as cms::Exception) by GetNextBlock once the blocks before it were consumed.
+ **/
+class ParallelRawCacheReader
+{
+  public:
+    /// The reader must be open; it is not owned.
+    ParallelRawCacheReader(const RawCacheReader &reader, const std::vector<unsigned int> &blocks,
+      unsigned int nThreads, unsigned int blocksAhead);
+
+    ~ParallelRawCacheReader();
+
+    /// starts the threads
+    void Start();
+
+    /// Gets the next block of the list, returns false at the end of the list.
+    bool GetNextBlock(RawCacheReader::Block &block);
+
+    /// stops the threads and waits for them
+    void Stop();
+
+  protected:
+    const RawCacheReader &reader;
+
+    std::vector<unsigned int> blocks;
+
+    unsigned int nThreads, blocksAhead;
+
+    std::vector<std::unique_ptr<PrefetchQueue<RawCacheReader::Block>>> queues;
+    std::vector<std::thread> threads;
+
+    /// position of the next block to deliver in the list
+    size_t nextBlock;
+
+    /// main function of the threads
+    void DecompressionLoop(unsigned int idx);
+};
+
+#endif
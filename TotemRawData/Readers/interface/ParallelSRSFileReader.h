@@ -0,0 +1,82 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_ParallelSRSFileReader
+#define TotemRawData_Readers_ParallelSRSFileReader
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/PrefetchQueue.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Reads several SRS files concurrently and merges their events into one ordered stream.
+ *
+ * Each file is read by its own thread into its own PrefetchQueue, which is limited to 'maxEvents' events
+ * and 'maxBytes' bytes of payload (0 = no limit). The consumer merges the queue heads by (timestamp, DATE
+ * event number, file index); since it always waits for the head of every unfinished file, the output
+ * order depends only on the file contents, never on the thread timing. Events within a file are expected
+ * in order, as written by the DAQ; the merge does not reorder them.
+ *
+ * An exception thrown by a reader is rethrown by GetNextEvent once the events before it were consumed.
+ **/
+class ParallelSRSFileReader
+{
+  public:
+    struct Event
+    {
+      unsigned int fileIdx;                           ///< index of the reader the event comes from
+      uint64_t timestamp;                             ///< UNIX timestamp
+      uint32_t eventNumber;                           ///< DATE event number (in run)
+      std::unique_ptr<FEDRawDataCollection> data;
+    };
+
+    /// The readers must be open and must not be used by anyone else until Stop; they are not owned.
+    ParallelSRSFileReader(const std::vector<SRSFileReader *> &readers, size_t maxEvents, size_t maxBytes = 0);
+
+    ~ParallelSRSFileReader();
+
+    /// starts the reader threads
+    void Start();
+
+    /// Gets the next event in the merged order, returns false at the end of all files.
+    bool GetNextEvent(Event &ev);
+
+    /// stops the reader threads and waits for them
+    void Stop();
+
+  protected:
+    std::vector<SRSFileReader *> readers;
+
+    size_t maxEvents, maxBytes;
+
+    std::vector<std::unique_ptr<PrefetchQueue<Event>>> queues;
+    std::vector<std::thread> threads;
+
+    /// the next event of each file, valid where `headValid' is set
+    std::vector<Event> heads;
+    std::vector<bool> headValid;
+
+    /// whether the heads have been loaded for the first time
+    bool started;
+
+    /// main function of the reader threads
+    void ReaderLoop(unsigned int idx);
+
+    /// loads the next event of file `idx' to its head
+    void LoadHead(unsigned int idx);
+};
+
+#endif
@@ -0,0 +1,149 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_PrefetchQueue
+#define TotemRawData_Readers_PrefetchQueue
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Bounded queue between a reader (producer) thread and a consumer.
+ *
+ * The queue holds at most 'maxItems' items and at most 'maxBytes' bytes (0 means no limit),
+ * the producer is blocked in Push while any of the limits is reached. An item larger than
+ * 'maxBytes' is still accepted when the queue is empty, so that the producer never gets stuck.
+ *
+ * The producer terminates the stream with Finish or, if it fails, with Fail - the exception is
+ * then rethrown in the consumer thread by Pop once all preceding items have been consumed.
+ * The consumer can stop the producer at any time with Close, which makes all pending and future
+ * Push calls return false.
+ **/
+template <typename T>
+class PrefetchQueue
+{
+  public:
+    PrefetchQueue(size_t _maxItems, size_t _maxBytes = 0) :
+      maxItems((_maxItems > 0) ? _maxItems : 1), maxBytes(_maxBytes), bytes(0), finished(false), closed(false)
+    {
+    }
+
+    /// inserts an item, blocks while the queue is full
+    /// returns false if the queue has been closed by the consumer (the item is dropped)
+    bool Push(T &&item, size_t size)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      notFull.wait(lock, [&] { return closed || !Full(size); });
+
+      if (closed)
+        return false;
+
+      queue.emplace_back(std::move(item), size);
+      bytes += size;
+
+      notEmpty.notify_one();
+      return true;
+    }
+
+    /// marks the regular end of the stream
+    void Finish()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      notEmpty.notify_all();
+    }
+
+    /// marks the end of the stream due to an exception, which will be rethrown by Pop
+    void Fail(std::exception_ptr e)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      exception = e;
+      finished = true;
+      notEmpty.notify_all();
+    }
+
+    /// retrieves the next item, blocks while the queue is empty
+    /// returns false at the end of the stream, rethrows the exception passed to Fail
+    bool Pop(T &item)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      notEmpty.wait(lock, [&] { return finished || closed || !queue.empty(); });
+
+      if (queue.empty())
+      {
+        if (exception)
+        {
+          std::exception_ptr e = exception;
+          exception = nullptr;
+          std::rethrow_exception(e);
+        }
+
+        return false;
+      }
+
+      item = std::move(queue.front().first);
+      bytes -= queue.front().second;
+      queue.pop_front();
+
+      notFull.notify_one();
+      return true;
+    }
+
+    /// stops the producer and discards the queued items
+    void Close()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+      queue.clear();
+      bytes = 0;
+      notFull.notify_all();
+      notEmpty.notify_all();
+    }
+
+    /// number of items currently in the queue
+    size_t Size() const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return queue.size();
+    }
+
+  protected:
+    const size_t maxItems;
+    const size_t maxBytes;
+
+    std::deque<std::pair<T, size_t>> queue;
+    size_t bytes;
+
+    bool finished;
+    bool closed;
+    std::exception_ptr exception;
+
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+    /// whether an item of the given size cannot be inserted now
+    bool Full(size_t size) const
+    {
+      if (queue.empty())
+        return false;
+
+      if (queue.size() >= maxItems)
+        return true;
+
+      return (maxBytes > 0 && bytes + size > maxBytes);
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_RawCacheFormat
+#define TotemRawData_Readers_RawCacheFormat
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Definition of the raw-cache file format, a compact alternative to the DATE files for repeated processing.
+ *
+ * The file holds FED payloads of already decoded (DATE-free) events, grouped in blocks which are compressed
+ * independently, and an index which allows to access any event without scanning the file. Layout (all numbers
+ * in the native byte order):
+ * \verbatim
+ * header:  magic (8 B), version (4 B), codec (4 B), number of events (8 B), number of blocks (8 B),
+ *          index offset (8 B), index checksum (8 B)
+ * blocks:  compressed block data, one after another
+ * index:   BlockInfo x number of blocks, EventInfo x number of events
+ * \endverbatim
+ * The header is rewritten with the final numbers when the file is closed, a file which was not closed
+ * properly is thus rejected. The uncompressed block data contain a record per event:
+ * \verbatim
+ * number of FEDs (4 B), reserved (4 B), then per FED: FED id (4 B), size (4 B), payload padded to 8 B
+ * \endverbatim
+ * so that all payloads are 8-byte aligned within the block.
+ **/
+class RawCacheFormat
+{
+  public:
+    enum Codec { cNone = 0, cZlib = 1, cLZMA = 2 };
+
+    static const char magic[8];
+    static const uint32_t version;
+
+    struct Header
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t codec;
+      uint64_t nEvents;
+      uint64_t nBlocks;
+      uint64_t indexOffset;
+      uint64_t indexChecksum;
+    };
+
+    struct BlockInfo
+    {
+      uint64_t offset;          ///< offset of the compressed data in the file
+      uint32_t compressedSize;  ///< size of the compressed data
+      uint32_t size;            ///< size of the uncompressed data
+      uint64_t firstEvent;      ///< index of the first event of the block
+      uint32_t nEvents;         ///< number of events in the block
+      uint32_t checksum;        ///< CRC-32 of the uncompressed data
+    };
+
+    struct EventInfo
+    {
+      uint32_t run;
+      uint32_t luminosityBlock;
+      uint64_t event;
+      uint64_t timestamp;       ///< UNIX timestamp
+      uint32_t block;           ///< block the event belongs to
+      uint32_t offset;          ///< offset of the event record within the uncompressed block
+    };
+
+    struct EventRecordHeader
+    {
+      uint32_t nFEDs;
+      uint32_t reserved;
+    };
+
+    struct FEDRecordHeader
+    {
+      uint32_t fedId;
+      uint32_t size;
+    };
+
+    /// payloads are padded to this size
+    static size_t PaddedSize(size_t size)
+    {
+      return (size + 7) & ~size_t(7);
+    }
+
+    /// converts codec name ("none", "zlib", "lzma") to codec, returns 0 on success
+    static int ParseCodec(const std::string &name, Codec &codec);
+
+    static const char* GetCodecName(uint32_t codec);
+
+    /// compresses `size' bytes from `in' to `out', returns 0 on success
+    static int Compress(Codec codec, int level, const char *in, size_t size, std::vector<char> &out);
+
+    /// decompresses `size' bytes from `in' to exactly `outSize' bytes at `out', returns 0 on success
+    static int Decompress(Codec codec, const char *in, size_t size, char *out, size_t outSize);
+
+    static uint32_t Checksum(const char *data, size_t size);
+
+    /// checksum of the index
+    static uint64_t IndexChecksum(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL);
+};
+
+#endif
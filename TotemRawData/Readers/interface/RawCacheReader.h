@@ -0,0 +1,97 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_RawCacheReader
+#define TotemRawData_Readers_RawCacheReader
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/RawCacheFormat.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Reads raw-cache files, see RawCacheFormat.
+ *
+ * The index is loaded in Open, afterwards any block can be read and decompressed by ReadBlock and the events
+ * extracted from it by GetEvent. ReadBlock does not change the state of the reader, it can be called from
+ * several threads at once.
+ **/
+class RawCacheReader
+{
+  public:
+    /// decompressed block
+    struct Block
+    {
+      unsigned int index;             ///< index of the block in the file
+      std::vector<uint64_t> data;     ///< uncompressed data, 8-byte aligned
+    };
+
+    RawCacheReader();
+    ~RawCacheReader();
+
+    /// opens the file and loads the index, returns 0 on success
+    int Open(const std::string &fileName);
+
+    void Close();
+
+    RawCacheFormat::Codec GetCodec() const
+    {
+      return RawCacheFormat::Codec(header.codec);
+    }
+
+    uint64_t GetNumberOfEvents() const
+    {
+      return events.size();
+    }
+
+    uint64_t GetNumberOfBlocks() const
+    {
+      return blocks.size();
+    }
+
+    const RawCacheFormat::EventInfo& GetEventInfo(uint64_t event) const
+    {
+      return events[event];
+    }
+
+    const RawCacheFormat::BlockInfo& GetBlockInfo(unsigned int block) const
+    {
+      return blocks[block];
+    }
+
+    /// size of the file, in bytes
+    unsigned long long GetFileSize() const
+    {
+      return fileSize;
+    }
+
+    /// reads, decompresses and verifies a block, returns 0 on success; thread safe
+    int ReadBlock(unsigned int index, Block &block) const;
+
+    /// extracts an event from its (decompressed) block, returns 0 on success
+    int GetEvent(const Block &block, uint64_t event, FEDRawDataCollection &data) const;
+
+  protected:
+    int fd;
+
+    unsigned long long fileSize;
+
+    RawCacheFormat::Header header;
+    std::vector<RawCacheFormat::BlockInfo> blocks;
+    std::vector<RawCacheFormat::EventInfo> events;
+
+    /// reads `size' bytes at `offset', returns 0 on success
+    int ReadAt(void *buffer, size_t size, uint64_t offset) const;
+};
+
+#endif
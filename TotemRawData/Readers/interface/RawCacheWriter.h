@@ -0,0 +1,84 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_RawCacheWriter
+#define TotemRawData_Readers_RawCacheWriter
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/RawCacheFormat.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Writes events to a raw-cache file, see RawCacheFormat.
+ *
+ * Events are collected in a block, which is compressed and written once it contains 'eventsPerBlock' events.
+ * Larger blocks compress better, smaller ones make the random access cheaper.
+ **/
+class RawCacheWriter
+{
+  public:
+    RawCacheWriter();
+    ~RawCacheWriter();
+
+    /// opens the file for writing, returns 0 on success
+    int Open(const std::string &fileName, RawCacheFormat::Codec codec = RawCacheFormat::cZlib, int level = 1,
+      unsigned int eventsPerBlock = 64);
+
+    /// writes the pending block and the index, returns 0 on success
+    int Close();
+
+    /// adds an event, all non-empty FEDs of the collection are stored; returns 0 on success
+    int WriteEvent(uint32_t run, uint32_t luminosityBlock, uint64_t event, uint64_t timestamp,
+      const FEDRawDataCollection &data);
+
+    /// total number of bytes written to the file
+    unsigned long long GetBytesWritten() const
+    {
+      return bytesWritten;
+    }
+
+    /// total size of the uncompressed blocks
+    unsigned long long GetUncompressedBytes() const
+    {
+      return uncompressedBytes;
+    }
+
+  protected:
+    FILE *outFile;
+
+    RawCacheFormat::Codec codec;
+    int level;
+    unsigned int eventsPerBlock;
+
+    /// uncompressed data of the current block
+    std::vector<char> block;
+    unsigned int blockEvents;
+
+    /// compression buffer
+    std::vector<char> compressed;
+
+    std::vector<RawCacheFormat::BlockInfo> blocks;
+    std::vector<RawCacheFormat::EventInfo> events;
+
+    unsigned long long bytesWritten, uncompressedBytes;
+
+    /// compresses and writes the current block, returns 0 on success
+    int FlushBlock();
+
+    /// writes data to the output, returns 0 on success
+    int Write(const void *data, size_t size);
+};
+
+#endif
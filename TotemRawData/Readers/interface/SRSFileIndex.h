@@ -0,0 +1,145 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_SRSFileIndex
+#define TotemRawData_Readers_SRSFileIndex
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Event-offset index of a raw-data file in SRS format.
+ *
+ * The index lists all DATE (super-)events of the file with their offset, type, DATE event number
+ * and timestamp. It can be built by a header-only scan of the file (payloads are skipped) and
+ * persisted in a sidecar file (by default `<raw file>.idx'). The sidecar has the following layout
+ * (all numbers in the native byte order):
+ * \verbatim
+ * header:  magic (8 B), version (4 B), entry size (4 B),
+ *          raw-file size (8 B), raw-file mtime (8 B), raw-file checksum (8 B),
+ *          number of entries (8 B), checksum of the entry block (8 B)
+ * entries: offset (8 B), DATE event number (4 B), timestamp (4 B), DATE event type (4 B), reserved (4 B)
+ * \endverbatim
+ * The raw-file checksum is calculated from the first and the last 64 kB of the file. Together with
+ * the size and mtime, it is used to detect stale indices. The entry checksum detects corrupted ones.
+ *
+ * Physics events are additionally numbered by their ordinal (counted from 0) and assigned luminosity
+ * blocks in the same way as TotemStandaloneRawDataSource does: a new block starts whenever the
+ * timestamp (1 s resolution) changes, the first block has number 1.
+ **/
+class SRSFileIndex
+{
+  public:
+    struct Entry
+    {
+      uint64_t offset;        ///< offset of the DATE event header in the raw file
+      uint32_t eventNumber;   ///< DATE event number in run
+      uint32_t timestamp;     ///< UNIX timestamp
+      uint32_t eventType;     ///< DATE event type
+      uint32_t reserved;
+    };
+
+    SRSFileIndex() : timestampsOrdered(true) {}
+
+    /// returns the default name of the sidecar index file
+    static std::string GetDefaultIndexFileName(const std::string &dataFileName)
+    {
+      return dataFileName + ".idx";
+    }
+
+    /// builds the index by scanning the headers of the raw file, returns 0 on success
+    int Build(const std::string &dataFileName);
+
+    /// loads the index from a sidecar file and validates it against the raw file, returns 0 on success
+    int Load(const std::string &indexFileName, const std::string &dataFileName);
+
+    /// saves the index to a sidecar file, returns 0 on success
+    int Save(const std::string &indexFileName, const std::string &dataFileName) const;
+
+    /// loads the index from the default sidecar file, if that fails builds it and tries to save it
+    /// returns 0 on success
+    int LoadOrBuild(const std::string &dataFileName, unsigned int verbosity = 0);
+
+    const std::vector<Entry>& GetEntries() const
+    {
+      return entries;
+    }
+
+    unsigned long GetNumberOfPhysicsEvents() const
+    {
+      return physicsEntries.size();
+    }
+
+    /// returns the physics event with the given ordinal
+    const Entry& GetPhysicsEvent(unsigned long n) const
+    {
+      return entries[physicsEntries[n]];
+    }
+
+    /// returns the luminosity block of the physics event with the given ordinal
+    unsigned int GetLuminosityBlock(unsigned long n) const
+    {
+      return luminosityBlocks[n];
+    }
+
+    /// returns the ordinal of the first physics event with timestamp >= ts
+    /// or the number of physics events if there is no such event
+    unsigned long FindTimestamp(uint64_t ts) const;
+
+    /// returns the ordinal of the first physics event with luminosity block >= lumi
+    /// or the number of physics events if there is no such event
+    unsigned long FindLuminosityBlock(unsigned int lumi) const;
+
+  protected:
+    static const char magic[8];
+    static const uint32_t version;
+
+    struct Header
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t entrySize;
+      uint64_t fileSize;
+      int64_t fileMTime;
+      uint64_t fileChecksum;
+      uint64_t nEntries;
+      uint64_t entriesChecksum;
+    };
+
+    /// properties of the raw file used to detect stale indices
+    struct Stamp
+    {
+      uint64_t size;
+      int64_t mtime;
+      uint64_t checksum;
+    };
+
+    /// all DATE events in the file, in the order of appearance
+    std::vector<Entry> entries;
+
+    /// physics-event ordinal --> index in entries
+    std::vector<unsigned long> physicsEntries;
+
+    /// physics-event ordinal --> luminosity block
+    std::vector<unsigned int> luminosityBlocks;
+
+    /// whether the physics-event timestamps are non-decreasing (allows binary search)
+    bool timestampsOrdered;
+
+    /// fills physicsEntries, luminosityBlocks and timestampsOrdered from entries
+    void MakeDerivedData();
+
+    static int MakeStamp(const std::string &dataFileName, Stamp &stamp);
+
+    static uint64_t Checksum(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL);
+};
+
+#endif
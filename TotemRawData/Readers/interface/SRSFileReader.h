@@ -11,15 +11,22 @@
 
 #include "EventFilter/TotemRawToDigi/interface/SimpleVFATFrameCollection.h"
 
+#include "TotemRawData/Readers/interface/SRSFileIndex.h"
+#include "TotemRawData/Readers/interface/SharedRawEvent.h"
+
 #include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
 
 #include <vector>
 #include <cstdio>
+#include <memory>
 
 //----------------------------------------------------------------------------------------------------
 
 /**
  * Reads a raw-data file in SRS format.
+ *
+ * The events can be obtained as FEDRawDataCollection (the payloads are copied) or as SharedRawEvent, whose
+ * slices point directly into the reader's event buffer.
  **/ 
 class SRSFileReader
 {
@@ -37,26 +44,67 @@ public:
 
     virtual void Close();
 
+    /// Reads the next physics event and copies its payloads to the collection, returns 0 on success.
     virtual unsigned char GetNextEvent(uint64_t &timestamp, FEDRawDataCollection &);
 
+    /// Reads the next physics event without copying the payloads, returns 0 on success.
+    /// The event is cleared first; if its buffer is still held elsewhere, a new buffer is used.
+    virtual unsigned char GetNextEvent(uint64_t &timestamp, SharedRawEvent &);
+
+    /// DATE event number (in run) of the last event read
+    uint32_t GetEventNumber() const
+    {
+      return eventNumber;
+    }
+
+    /// number of payload bytes copied so far (to FEDRawDataCollection or to realign a payload)
+    unsigned long long GetBytesCopied() const
+    {
+      return bytesCopied;
+    }
+
+    /// Sets the index used for random access, the ownership is NOT transferred.
+    void SetIndex(const SRSFileIndex *_index)
+    {
+      index = _index;
+    }
+
+    /// Moves the reader to the given file offset, which must point to a DATE event header.
+    /// Returns 0 on success.
+    virtual int SeekOffset(uint64_t offset);
+
+    /// Moves the reader to the physics event with the given ordinal (counted from 0).
+    /// Requires an index, returns 0 on success.
+    int SeekEvent(unsigned long n);
+
+    /// Moves the reader to the first physics event with timestamp >= ts.
+    /// Requires an index, returns 0 on success.
+    int SeekTimestamp(uint64_t ts);
+
 protected:
     static const unsigned int eventHeaderSize;
 
     /// Processes one DATE super-event (GDC).
     /// returns the number of GOH blocks that failed consistency checks
-    unsigned int ProcessDATESuperEvent(char *ptr, uint64_t &timestamp, FEDRawDataCollection &dataColl);
+    unsigned int ProcessDATESuperEvent(const char *ptr, uint64_t &timestamp, SharedRawEvent &event);
 
     /// Processes one DATE event (LDC).
     /// returns the number of GOH blocks that failed consistency checks
-    unsigned int ProcessDATEEvent(char *ptr, uint64_t &timestamp, FEDRawDataCollection &dataColl);
+    unsigned int ProcessDATEEvent(const char *ptr, uint64_t &timestamp, SharedRawEvent &event);
 
     /// reads 'bytesToRead' bytes from the file to buffer, starting at the given offset
     virtual unsigned char ReadToBuffer(unsigned int bytesToRead, unsigned int offset);
 
-    /// Inserts FEDRawData for each OptoRx.
-    void MakeFEDRawData(uint64_t *payloadPtr, unsigned int payloadSize, FEDRawDataCollection &dataColl);
+    /// Adds the payload of one OptoRx to the event.
+    void AddFEDData(const char *payloadPtr, unsigned int payloadSize, SharedRawEvent &event);
+
+    /// event index for random access, NULL if not available
+    const SRSFileIndex *index;
+
+    /// the event buffer, reallocated only when too small or still held by a SharedRawEvent
+    std::shared_ptr<char> buffer;
 
-    /// data pointer, to be allocated one time only
+    /// data pointer, equal to buffer.get()
     char *dataPtr;
  
  	/// data buffer size
@@ -64,6 +112,14 @@ protected:
  
  	/// input file pointer
  	FILE *infile;
+
+    /// used by GetNextEvent with FEDRawDataCollection
+    SharedRawEvent scratchEvent;
+
+    unsigned long long bytesCopied;
+
+    /// see GetEventNumber
+    uint32_t eventNumber;
 };
 
 #endif
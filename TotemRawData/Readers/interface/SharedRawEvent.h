@@ -0,0 +1,75 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#ifndef TotemRawData_Readers_SharedRawEvent
+#define TotemRawData_Readers_SharedRawEvent
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "EventFilter/TotemRawToDigi/interface/FEDRawDataView.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * FED payloads of one raw event, given as slices of a reader's buffer.
+ *
+ * The buffer (an event buffer or a memory-mapped file) is reference counted: it stays valid as long as
+ * this object or any of its copies holds it. A reader whose buffer is still held when the next event is
+ * requested reads into a new buffer, so the slices are never overwritten. Payloads which cannot be viewed
+ * in place (not aligned to 8 bytes) are copied to a buffer owned by this object.
+**/
+class SharedRawEvent
+{
+  public:
+    SharedRawEvent() {}
+
+    /// removes all FEDs and releases the buffer
+    void Clear();
+
+    /// sets the buffer into which the slices point
+    void SetBuffer(const std::shared_ptr<const char> &_buffer)
+    {
+      buffer = _buffer;
+    }
+
+    /// adds a FED payload, which must be part of the buffer; returns the number of bytes copied
+    size_t Add(unsigned int fedId, const char *ptr, size_t size);
+
+    /// returns an empty view if the FED is not present, the last payload if it is present more times
+    FEDRawDataView FEDData(unsigned int fedId) const;
+
+    /// the FEDs present, in the order of the file
+    std::vector<unsigned int> GetFEDIds() const;
+
+    /// copies all payloads to the collection, returns the number of bytes copied
+    size_t CopyTo(FEDRawDataCollection &coll) const;
+
+  protected:
+    struct Slice
+    {
+      unsigned int fedId;
+      bool copied;      ///< whether the data are in `copies' instead of the buffer
+      size_t offset;    ///< in bytes
+      size_t size;      ///< in bytes
+    };
+
+    std::shared_ptr<const char> buffer;
+
+    /// payloads which could not be viewed in place, in 64-bit words
+    std::vector<uint64_t> copies;
+
+    std::vector<Slice> slices;
+
+    FEDRawDataView GetView(const Slice &s) const;
+};
+
+#endif
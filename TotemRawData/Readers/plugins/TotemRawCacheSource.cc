@@ -0,0 +1,395 @@
+/****************************************************************************
+ *
+ * This is a part of TOTEM offline software.
+ * Authors:
+ *   Jan Kašpar (jan.kaspar@gmail.com)
+ *
+ ****************************************************************************/
+
+// this is dirty trick, see TotemStandaloneRawDataSource
+#include "TotemRawData/Readers/plugins/Event_hacked.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Framework/interface/InputSourceMacros.h"
+#include "FWCore/Framework/interface/EventPrincipal.h"
+#include "FWCore/Framework/interface/InputSource.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "DataFormats/Provenance/interface/RunAuxiliary.h"
+#include "DataFormats/Provenance/interface/LuminosityBlockAuxiliary.h"
+#include "DataFormats/Provenance/interface/LuminosityBlockID.h"
+#include "DataFormats/Provenance/interface/EventAuxiliary.h"
+#include "DataFormats/Provenance/interface/ProcessHistoryRegistry.h"
+#include "DataFormats/Provenance/interface/EventRange.h"
+#include "DataFormats/Provenance/interface/LuminosityBlockRange.h"
+
+#include "TotemRawData/Readers/interface/RawCacheReader.h"
+#include "TotemRawData/Readers/interface/ParallelRawCacheReader.h"
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include <cstdio>
+#include <iostream>
+#include <deque>
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Reads raw-cache files (see RawCacheFormat), as written by TotemRawCacheWriter.
+ *
+ * The run, luminosity-block and event numbers are those stored in the cache. The events are selected with
+ * the index only, the blocks without any selected event are neither read nor decompressed. The selected
+ * blocks are decompressed by 'decompressionThreads' threads ahead of the processing.
+ **/
+class TotemRawCacheSource : public edm::InputSource
+{
+  public:
+    TotemRawCacheSource(const edm::ParameterSet &, const edm::InputSourceDescription&);
+    virtual ~TotemRawCacheSource();
+    virtual void beginJob();
+    virtual void endJob();
+
+  protected:
+    unsigned int verbosity;
+
+    std::vector<std::string> fileNames;                     ///< vector of raw-cache files names
+    unsigned int printProgressFrequency;                    ///< frequency with which the progress (i.e. event number) is to be printed
+
+    unsigned int skipEvents;                                ///< number of (selected) events to skip at the beginning
+    std::vector<edm::EventRange> eventsToProcess;           ///< if not empty, only these events are processed
+    std::vector<edm::LuminosityBlockRange> lumisToProcess;  ///< if not empty, only these lumi blocks are processed
+
+    unsigned int decompressionThreads;                      ///< number of threads decompressing the blocks
+    unsigned int blocksAhead;                               ///< number of blocks decompressed ahead, per thread
+
+    struct FileInfo
+    {
+      std::string fileName;
+      RawCacheReader *reader;
+      std::vector<uint64_t> selection;                      ///< indices of the selected events, ascending
+    };
+
+    std::vector<FileInfo> files;
+
+  private:
+    /// list of the next state items
+    std::deque<ItemType> items;
+
+    /// index of the current file and of the next event in its selection
+    unsigned int fileIdx;
+    size_t selectionIdx;
+
+    /// decompresses the blocks of the current file
+    std::unique_ptr<ParallelRawCacheReader> blockReader;
+
+    /// the block the current event comes from
+    RawCacheReader::Block currentBlock;
+    bool currentBlockValid;
+
+    /// prepares the lists of selected events from skipEvents, eventsToProcess and lumisToProcess
+    void MakeSelection();
+
+    /// starts decompression of the selected blocks of file fileIdx
+    void StartFile();
+
+    /// tries to load a next raw event and updates the list of next states 'items'
+    void LoadRawDataEvent();
+
+    virtual ItemType getNextItemType();
+    virtual std::shared_ptr<edm::RunAuxiliary> readRunAuxiliary_();
+    virtual std::shared_ptr<edm::LuminosityBlockAuxiliary> readLuminosityBlockAuxiliary_();
+    virtual void readEvent_(edm::EventPrincipal& eventPrincipal);
+
+    /// pre-loaded raw event
+    uint64_t currentTimestamp;
+    std::auto_ptr<FEDRawDataCollection> currentFEDCollection;
+
+    /// ID of the current (next) event
+    edm::EventID eventID;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+using namespace edm;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawCacheSource::TotemRawCacheSource(const edm::ParameterSet& pSet, const edm::InputSourceDescription& desc) :
+  InputSource(pSet, desc),
+  verbosity(pSet.getUntrackedParameter<unsigned int>("verbosity", 0)),
+  fileNames(pSet.getUntrackedParameter<vector<string> >("fileNames")),
+  printProgressFrequency(pSet.getUntrackedParameter<unsigned int>("printProgressFrequency", 0)),
+  skipEvents(pSet.getUntrackedParameter<unsigned int>("skipEvents", 0)),
+  eventsToProcess(pSet.getUntrackedParameter<vector<EventRange> >("eventsToProcess", vector<EventRange>())),
+  lumisToProcess(pSet.getUntrackedParameter<vector<LuminosityBlockRange> >("lumisToProcess", vector<LuminosityBlockRange>())),
+  decompressionThreads(pSet.getUntrackedParameter<unsigned int>("decompressionThreads", 2)),
+  blocksAhead(pSet.getUntrackedParameter<unsigned int>("blocksAhead", 2)),
+  fileIdx(0),
+  selectionIdx(0),
+  currentBlockValid(false),
+  currentTimestamp(0),
+  eventID(0, 0, 0)
+{
+  produces<FEDRawDataCollection>();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawCacheSource::~TotemRawCacheSource()
+{
+  // the threads must not outlive the readers
+  blockReader.reset();
+
+  for (auto &fi : files)
+    delete fi.reader;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+std::shared_ptr<RunAuxiliary> TotemRawCacheSource::readRunAuxiliary_()
+{
+  Timestamp ts_beg(currentTimestamp << 32);
+  Timestamp ts_end(Timestamp::endOfTime().value() - 0);
+
+  return std::shared_ptr<RunAuxiliary>(new RunAuxiliary(eventID.run(), ts_beg, ts_end));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+std::shared_ptr<LuminosityBlockAuxiliary> TotemRawCacheSource::readLuminosityBlockAuxiliary_()
+{
+  Timestamp ts_beg(currentTimestamp << 32);
+  Timestamp ts_end(((currentTimestamp + 1) << 32) - 1);
+
+  return std::shared_ptr<LuminosityBlockAuxiliary>(new LuminosityBlockAuxiliary(eventID.run(),
+    eventID.luminosityBlock(), ts_beg, ts_end));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::readEvent_(EventPrincipal& eventPrincipal)
+{
+  Timestamp ts(currentTimestamp << 32);
+  bool isRealData = true;
+  EventAuxiliary::ExperimentType expType(EventAuxiliary::Undefined);
+  EventAuxiliary aux(eventID, processGUID(), ts, isRealData, expType);
+
+  ProcessHistoryRegistry phr;
+  eventPrincipal.fillEventPrincipal(aux, phr);
+  ModuleCallingContext const* mcc = NULL;
+  Event e(eventPrincipal, moduleDescription(), mcc);
+
+  e.put(currentFEDCollection);
+  e.commit_();
+
+  if (printProgressFrequency > 0 && (eventID.event() % printProgressFrequency) == 0)
+    cout << "\033[25Devent " << eventID.run() << ":" << eventID.event();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::MakeSelection()
+{
+  unsigned long toSkip = skipEvents;
+
+  for (auto &fi : files)
+  {
+    const uint64_t N = fi.reader->GetNumberOfEvents();
+
+    fi.selection.clear();
+    for (uint64_t i = 0; i < N; ++i)
+    {
+      const RawCacheFormat::EventInfo &info = fi.reader->GetEventInfo(i);
+
+      if (!eventsToProcess.empty())
+      {
+        const EventID id(info.run, info.luminosityBlock, info.event);
+
+        bool selected = false;
+        for (const auto &r : eventsToProcess)
+        {
+          if (contains(r, id))
+          {
+            selected = true;
+            break;
+          }
+        }
+
+        if (!selected)
+          continue;
+      }
+
+      if (!lumisToProcess.empty())
+      {
+        const LuminosityBlockID id(info.run, info.luminosityBlock);
+
+        bool selected = false;
+        for (const auto &r : lumisToProcess)
+        {
+          if (contains(r, id))
+          {
+            selected = true;
+            break;
+          }
+        }
+
+        if (!selected)
+          continue;
+      }
+
+      if (toSkip > 0)
+      {
+        toSkip--;
+        continue;
+      }
+
+      fi.selection.push_back(i);
+    }
+
+    if (verbosity > 0)
+      printf(">> TotemRawCacheSource::MakeSelection > %s: %lu of %lu events selected.\n", fi.fileName.c_str(),
+        (unsigned long) fi.selection.size(), (unsigned long) N);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::StartFile()
+{
+  const FileInfo &fi = files[fileIdx];
+
+  // the blocks of the selected events, the selection is ascending and so are the blocks
+  vector<unsigned int> blocks;
+  for (const auto &e : fi.selection)
+  {
+    const unsigned int b = fi.reader->GetEventInfo(e).block;
+    if (blocks.empty() || blocks.back() != b)
+      blocks.push_back(b);
+  }
+
+  blockReader.reset(new ParallelRawCacheReader(*fi.reader, blocks, decompressionThreads, blocksAhead));
+  blockReader->Start();
+
+  currentBlockValid = false;
+  selectionIdx = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::LoadRawDataEvent()
+{
+  // find the next selected event, move to the next file if needed
+  while (fileIdx < files.size() && selectionIdx >= files[fileIdx].selection.size())
+  {
+    blockReader.reset();
+    fileIdx++;
+
+    if (fileIdx < files.size())
+      StartFile();
+  }
+
+  if (fileIdx >= files.size())
+  {
+    items.push_back(IsStop);
+    return;
+  }
+
+  const FileInfo &fi = files[fileIdx];
+  const uint64_t event = fi.selection[selectionIdx++];
+  const RawCacheFormat::EventInfo &info = fi.reader->GetEventInfo(event);
+
+  if (!currentBlockValid || currentBlock.index != info.block)
+  {
+    if (!blockReader->GetNextBlock(currentBlock) || currentBlock.index != info.block)
+      throw cms::Exception("TotemRawCacheSource") << "Cannot get block " << info.block << " of file "
+        << fi.fileName << "." << std::endl;
+
+    currentBlockValid = true;
+  }
+
+  currentFEDCollection.reset(new FEDRawDataCollection);
+  if (fi.reader->GetEvent(currentBlock, event, *currentFEDCollection) != 0)
+    throw cms::Exception("TotemRawCacheSource") << "Corrupted event " << event << " in file " << fi.fileName
+      << "." << std::endl;
+
+  currentTimestamp = info.timestamp;
+
+  const EventID newEventID(info.run, info.luminosityBlock, info.event);
+
+  const bool beginning = (eventID.run() == 0);
+  if (beginning || newEventID.run() != eventID.run())
+  {
+    items.push_back(IsRun);
+    items.push_back(IsLumi);
+  } else {
+    if (newEventID.luminosityBlock() != eventID.luminosityBlock())
+      items.push_back(IsLumi);
+  }
+
+  items.push_back(IsEvent);
+
+  eventID = newEventID;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+InputSource::ItemType TotemRawCacheSource::getNextItemType()
+{
+  if (items.empty())
+    LoadRawDataEvent();
+
+  ItemType item = items.front();
+  items.pop_front();
+
+  return item;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::beginJob()
+{
+  for (const auto &fn : fileNames)
+  {
+    if (verbosity)
+      printf(">> TotemRawCacheSource::beginJob > Opening file `%s'.\n", fn.c_str());
+
+    FileInfo fi;
+    fi.fileName = fn;
+    fi.reader = new RawCacheReader();
+
+    if (fi.reader->Open(fn) != 0)
+    {
+      delete fi.reader;
+      throw cms::Exception("TotemRawCacheSource") << "Cannot open file " << fn << std::endl;
+    }
+
+    if (verbosity)
+      printf("\t%lu events in %lu blocks, codec %s\n", (unsigned long) fi.reader->GetNumberOfEvents(),
+        (unsigned long) fi.reader->GetNumberOfBlocks(), RawCacheFormat::GetCodecName(fi.reader->GetCodec()));
+
+    files.push_back(fi);
+  }
+
+  if (!files.size())
+    throw cms::Exception("TotemRawCacheSource") << "No files to read." << std::endl;
+
+  MakeSelection();
+
+  fileIdx = 0;
+  StartFile();
+
+  items.push_back(IsFile);  // needed for the logic in InputSource::nextItemType
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheSource::endJob()
+{
+  blockReader.reset();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+DEFINE_FWK_INPUT_SOURCE(TotemRawCacheSource);
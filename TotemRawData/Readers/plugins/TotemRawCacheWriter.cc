@@ -0,0 +1,106 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*   Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/RawCacheWriter.h"
+
+#include <string>
+
+//----------------------------------------------------------------------------------------------------
+
+/**
+ * Writes the raw data of each event, e.g. as read by TotemStandaloneRawDataSource, to a raw-cache file
+ * (see RawCacheFormat), which can be read back by TotemRawCacheSource.
+**/
+class TotemRawCacheWriter : public edm::one::EDAnalyzer<>
+{
+  public:
+    explicit TotemRawCacheWriter(const edm::ParameterSet&);
+    ~TotemRawCacheWriter();
+
+    virtual void analyze(const edm::Event &, const edm::EventSetup &) override;
+    virtual void endJob() override;
+
+  private:
+    std::string outputFile;
+
+    edm::EDGetTokenT<FEDRawDataCollection> fedDataToken;
+
+    RawCacheWriter writer;
+
+    unsigned int eventsWritten;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace edm;
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawCacheWriter::TotemRawCacheWriter(const edm::ParameterSet &conf):
+  outputFile(conf.getParameter<string>("outputFile")),
+  eventsWritten(0)
+{
+  fedDataToken = consumes<FEDRawDataCollection>(conf.getParameter<edm::InputTag>("rawDataTag"));
+
+  const string codecName = conf.getParameter<string>("compression");
+  RawCacheFormat::Codec codec;
+  if (RawCacheFormat::ParseCodec(codecName, codec) != 0)
+    throw cms::Exception("TotemRawCacheWriter") << "Unknown compression `" << codecName << "'.";
+
+  if (writer.Open(outputFile, codec, conf.getParameter<int>("compressionLevel"),
+      conf.getParameter<unsigned int>("eventsPerBlock")) != 0)
+    throw cms::Exception("TotemRawCacheWriter") << "Cannot open file `" << outputFile << "'.";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+TotemRawCacheWriter::~TotemRawCacheWriter()
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheWriter::analyze(const edm::Event &event, const edm::EventSetup &)
+{
+  Handle<FEDRawDataCollection> rawData;
+  event.getByToken(fedDataToken, rawData);
+
+  // conversion to UNIX timestamp: see DataFormats/Provenance/interface/Timestamp.h
+  const uint64_t timestamp = event.time().value() >> 32;
+
+  if (writer.WriteEvent(event.id().run(), event.id().luminosityBlock(), event.id().event(), timestamp, *rawData) != 0)
+    throw cms::Exception("TotemRawCacheWriter") << "Cannot write event " << event.id() << ".";
+
+  eventsWritten++;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemRawCacheWriter::endJob()
+{
+  if (writer.Close() != 0)
+    throw cms::Exception("TotemRawCacheWriter") << "Cannot close file `" << outputFile << "'.";
+
+  edm::LogInfo("Totem") << "TotemRawCacheWriter: " << eventsWritten << " events (" << writer.GetUncompressedBytes()
+    << " bytes of raw data, " << writer.GetBytesWritten() << " bytes of file) written to `" << outputFile << "'.";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+DEFINE_FWK_MODULE(TotemRawCacheWriter);
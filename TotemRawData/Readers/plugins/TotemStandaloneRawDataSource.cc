@@ -18,25 +18,43 @@
 #include "DataFormats/Provenance/interface/LuminosityBlockAuxiliary.h"
 #include "DataFormats/Provenance/interface/EventAuxiliary.h"
 #include "DataFormats/Provenance/interface/ProcessHistoryRegistry.h"
+#include "DataFormats/Provenance/interface/EventRange.h"
+#include "DataFormats/Provenance/interface/LuminosityBlockRange.h"
 
 #include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/MappedSRSFileReader.h"
+#include "TotemRawData/Readers/interface/SRSFileIndex.h"
+#include "TotemRawData/Readers/interface/PrefetchQueue.h"
+#include "TotemRawData/Readers/interface/ParallelSRSFileReader.h"
 
 #include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
 
 #include <iostream>
 #include <iomanip>
 #include <deque>
+#include <algorithm>
+#include <memory>
+#include <thread>
 
 //----------------------------------------------------------------------------------------------------
 
 class TotemStandaloneRawDataSource : public edm::InputSource
 {
   public:
+    /// interval of physics-event ordinals [first, second)
+    typedef std::pair<unsigned long, unsigned long> Interval;
+
     struct FileInfo
 	{
       std::string fileName;         ///< path to the file
       SRSFileReader *file;          ///< instance of reader class
       edm::RunNumber_t runNumber;   ///< associated run number
+      SRSFileIndex *index;          ///< event index, NULL if not used
+
+      std::vector<Interval> selection;  ///< selected physics events (only with index)
+      unsigned int intervalIdx;         ///< current interval in selection
+      unsigned long nextEvent;          ///< ordinal of the physics event the reader points to
     };
 
     TotemStandaloneRawDataSource(const edm::ParameterSet &, const edm::InputSourceDescription&);
@@ -50,17 +68,66 @@ class TotemStandaloneRawDataSource : public edm::InputSource
     std::vector<std::string> fileNames;                     ///< vector of raw data files names
     unsigned int printProgressFrequency;                    ///< frequency with which the progress (i.e. event number) is to be printed
 
+    bool useMemoryMapping;                                  ///< whether the files are read through memory mapping instead of fread
+    unsigned int readAheadSize;                             ///< size of the read-ahead window for memory-mapped files, in MB
+
+    bool useIndex;                                          ///< whether event indices are used for random access
+    unsigned int skipEvents;                                ///< number of (selected) events to skip at the beginning
+    std::vector<edm::EventRange> eventsToProcess;           ///< if not empty, only these events are processed
+    std::vector<edm::LuminosityBlockRange> lumisToProcess;  ///< if not empty, only these lumi blocks are processed
+
+    unsigned int prefetchEvents;                            ///< depth of the prefetch queue in events, 0 = no reader thread
+    unsigned int prefetchMemory;                            ///< maximal size of the prefetched data in MB, 0 = no limit
+
+    bool parallelReading;                                   ///< whether all files are read concurrently and merged
+    unsigned int readerQueueEvents;                         ///< with parallelReading: events read ahead per file
+    unsigned int readerQueueMemory;                         ///< with parallelReading: MB read ahead per file, 0 = no limit
+
     unsigned int fileIdx;                                   ///< current file index (within files), counted from 0
 
     std::vector<FileInfo> files;                            ///< to keep information about opened files
 
   private:
+    /// raw event as delivered by the reading part of the source
+    struct RawEvent
+    {
+      unsigned int fileIdx;                           ///< index of the file the event comes from
+      unsigned long ordinal;                          ///< physics-event ordinal, only set when indices are used
+      uint64_t timestamp;                             ///< UNIX timestamp
+      std::unique_ptr<FEDRawDataCollection> data;
+    };
+
     /// list of the next state items
     std::deque<ItemType> items;
     
     /// tries to load a next raw event and updates the list of next states 'items'
     void LoadRawDataEvent();
 
+    /// reads the next raw event from the files, returns false if there are no more events
+    /// runs in the reader thread when prefetching is enabled, otherwise in the framework thread
+    bool ReadRawEvent(RawEvent &);
+
+    /// as ReadRawEvent, but uses the indices to jump directly to the selected events
+    bool ReadIndexedRawEvent(RawEvent &);
+
+    /// main function of the reader thread, fills the prefetch queue
+    void ReaderLoop();
+
+    /// stops the reader thread (if running) and waits for it
+    void StopReader();
+
+    /// queue of prefetched events, NULL if prefetching is disabled
+    std::unique_ptr<PrefetchQueue<RawEvent>> prefetchQueue;
+
+    /// the reader thread
+    std::thread readerThread;
+
+    /// reads and merges all files concurrently, NULL if parallelReading is disabled
+    std::unique_ptr<ParallelSRSFileReader> parallelReader;
+
+    /// prepares the lists of selected events from skipEvents, eventsToProcess and lumisToProcess
+    void MakeSelection();
+
     /// called by the framework to determine the next state (run, lumi, event, stop, ...)
     /// here it simply returns the popped state from the 'items' queue
     virtual ItemType getNextItemType();
@@ -79,6 +146,9 @@ class TotemStandaloneRawDataSource : public edm::InputSource
     uint64_t currentTimestamp;
     std::auto_ptr<FEDRawDataCollection> currentFEDCollection;
 
+    /// file index of the current (next) event
+    unsigned int eventFileIdx;
+
     /// ID of the current (next) event
     edm::EventID eventID;
 
@@ -102,7 +172,19 @@ TotemStandaloneRawDataSource::TotemStandaloneRawDataSource(const edm::ParameterS
   verbosity(pSet.getUntrackedParameter<unsigned int>("verbosity", 0)),
   fileNames(pSet.getUntrackedParameter<vector<string> >("fileNames")),
   printProgressFrequency(pSet.getUntrackedParameter<unsigned int>("printProgressFrequency", 0)),
+  useMemoryMapping(pSet.getUntrackedParameter<bool>("useMemoryMapping", false)),
+  readAheadSize(pSet.getUntrackedParameter<unsigned int>("readAheadSize", 64)),
+  useIndex(pSet.getUntrackedParameter<bool>("useIndex", false)),
+  skipEvents(pSet.getUntrackedParameter<unsigned int>("skipEvents", 0)),
+  eventsToProcess(pSet.getUntrackedParameter<vector<EventRange> >("eventsToProcess", vector<EventRange>())),
+  lumisToProcess(pSet.getUntrackedParameter<vector<LuminosityBlockRange> >("lumisToProcess", vector<LuminosityBlockRange>())),
+  prefetchEvents(pSet.getUntrackedParameter<unsigned int>("prefetchEvents", 0)),
+  prefetchMemory(pSet.getUntrackedParameter<unsigned int>("prefetchMemory", 0)),
+  parallelReading(pSet.getUntrackedParameter<bool>("parallelReading", false)),
+  readerQueueEvents(pSet.getUntrackedParameter<unsigned int>("readerQueueEvents", 16)),
+  readerQueueMemory(pSet.getUntrackedParameter<unsigned int>("readerQueueMemory", 0)),
   currentTimestamp(0),
+  eventFileIdx(0),
   eventID(0, 0, 0),
   previousTimestamp(0)
 {
@@ -110,6 +192,20 @@ TotemStandaloneRawDataSource::TotemStandaloneRawDataSource(const edm::ParameterS
   cout << ">> TotemStandaloneRawDataSource::TotemStandaloneRawDataSource" << endl;
 #endif
 
+  // event selection is only possible with indices
+  if (skipEvents > 0 || !eventsToProcess.empty() || !lumisToProcess.empty())
+    useIndex = true;
+
+  // the selection works with per-file event ordinals, which lose their meaning in a merged stream
+  if (parallelReading && useIndex)
+    throw cms::Exception("TotemStandaloneRawDataSource") << "parallelReading cannot be combined with useIndex"
+      << " or event selection." << std::endl;
+
+  // with parallelReading the read-ahead is done per file (readerQueueEvents), a second queue would be ignored
+  if (parallelReading && prefetchEvents > 0)
+    throw cms::Exception("TotemStandaloneRawDataSource") << "parallelReading cannot be combined with prefetchEvents,"
+      << " use readerQueueEvents instead." << std::endl;
+
   produces<FEDRawDataCollection>();
 }
 
@@ -117,6 +213,14 @@ TotemStandaloneRawDataSource::TotemStandaloneRawDataSource(const edm::ParameterS
 
 TotemStandaloneRawDataSource::~TotemStandaloneRawDataSource()
 {
+  // the reader thread must not outlive the readers
+  StopReader();
+
+  for (auto &fi : files)
+  {
+    delete fi.file;
+    delete fi.index;
+  }
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -184,32 +288,57 @@ void TotemStandaloneRawDataSource::LoadRawDataEvent()
   printf(">> TotemStandaloneRawDataSource::LoadRawDataEvent\n");
 #endif
 
-  // prepare structure for the raw event
-  currentFEDCollection = auto_ptr<FEDRawDataCollection>(new FEDRawDataCollection);
-
-  // load next raw event
-  bool newFile = false;
-  while (true)
+  // get next raw event, either from the reader thread(s) or directly from the files
+  RawEvent ev;
+  bool available = false;
+  if (parallelReader)
+  {
+    ParallelSRSFileReader::Event pev;
+    available = parallelReader->GetNextEvent(pev);
+
+    ev.fileIdx = pev.fileIdx;
+    ev.ordinal = 0;
+    ev.timestamp = pev.timestamp;
+    ev.data = std::move(pev.data);
+  } else
+    available = (prefetchQueue) ? prefetchQueue->Pop(ev) : ReadRawEvent(ev);
+
+  // stop if there are no more events
+  if (!available)
   {
-    unsigned int result = files[fileIdx].file->GetNextEvent(currentTimestamp, *currentFEDCollection);
+    items.push_back(IsStop);
+    return;
+  }
 
-    if (result == 0)
-      break;
-    else {
-      // try moving to next file
-      fileIdx++;
-      newFile = true;
+  currentTimestamp = ev.timestamp;
+  currentFEDCollection = auto_ptr<FEDRawDataCollection>(ev.data.release());
 
-      // stop if there are no more files
-      if (fileIdx >= files.size())
-      {
-        items.push_back(IsStop);
-        return;
-      }
+  bool beginning = (eventID.run() == 0);
+  bool newFile = (ev.fileIdx != eventFileIdx && !parallelReading);  // merged files form a single run
+  eventFileIdx = ev.fileIdx;
+
+  // event and lumi numbers are taken from the index, so that they do not depend on the selection
+  if (useIndex)
+  {
+    const FileInfo &fi = files[ev.fileIdx];
+    EventID newEventID(fi.runNumber, fi.index->GetLuminosityBlock(ev.ordinal), ev.ordinal + 1);
+
+    if (newFile || beginning)
+    {
+      items.push_back(IsRun);
+      items.push_back(IsLumi);
+    } else {
+      if (newEventID.luminosityBlock() != eventID.luminosityBlock())
+        items.push_back(IsLumi);
     }
-  }
 
-  bool beginning = (eventID.run() == 0);
+    items.push_back(IsEvent);
+
+    eventID = newEventID;
+    previousTimestamp = currentTimestamp;
+
+    return;
+  }
 
   if (newFile || beginning)
   {
@@ -217,7 +346,7 @@ void TotemStandaloneRawDataSource::LoadRawDataEvent()
     items.push_back(IsLumi);
     items.push_back(IsEvent);
 
-    eventID = EventID(files[fileIdx].runNumber, 1, 1);
+    eventID = EventID(files[ev.fileIdx].runNumber, 1, 1);
 
     previousTimestamp = currentTimestamp;
 
@@ -239,6 +368,251 @@ void TotemStandaloneRawDataSource::LoadRawDataEvent()
 
 //----------------------------------------------------------------------------------------------------
 
+bool TotemStandaloneRawDataSource::ReadRawEvent(RawEvent &ev)
+{
+  if (useIndex)
+    return ReadIndexedRawEvent(ev);
+
+  // prepare structure for the raw event
+  ev.data.reset(new FEDRawDataCollection);
+  ev.ordinal = 0;
+
+  // load next raw event, try moving to next file if needed
+  for (; fileIdx < files.size(); fileIdx++)
+  {
+    if (files[fileIdx].file->GetNextEvent(ev.timestamp, *ev.data) == 0)
+    {
+      ev.fileIdx = fileIdx;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool TotemStandaloneRawDataSource::ReadIndexedRawEvent(RawEvent &ev)
+{
+  // prepare structure for the raw event
+  ev.data.reset(new FEDRawDataCollection);
+
+  // find and load the next selected event
+  while (fileIdx < files.size())
+  {
+    FileInfo &fi = files[fileIdx];
+
+    // move to the next file when all intervals have been processed
+    if (fi.intervalIdx >= fi.selection.size())
+    {
+      fileIdx++;
+      continue;
+    }
+
+    const Interval &interval = fi.selection[fi.intervalIdx];
+    if (fi.nextEvent >= interval.second)
+    {
+      fi.intervalIdx++;
+      continue;
+    }
+
+    // jump to the beginning of the interval if needed
+    if (fi.nextEvent < interval.first)
+    {
+      if (fi.file->SeekEvent(interval.first) != 0)
+      {
+        fi.intervalIdx = fi.selection.size();
+        continue;
+      }
+
+      fi.nextEvent = interval.first;
+    }
+
+    if (fi.file->GetNextEvent(ev.timestamp, *ev.data) != 0)
+    {
+      fi.intervalIdx = fi.selection.size();
+      continue;
+    }
+
+    ev.fileIdx = fileIdx;
+    ev.ordinal = fi.nextEvent++;
+    return true;
+  }
+
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemStandaloneRawDataSource::ReaderLoop()
+{
+  try {
+    while (true)
+    {
+      RawEvent ev;
+      if (!ReadRawEvent(ev))
+        break;
+
+      // the size only matters when the memory is limited
+      size_t size = 0;
+      if (prefetchMemory > 0)
+      {
+        for (int fedId = 0; fedId <= FEDNumbering::lastFEDId(); fedId++)
+          size += ev.data->FEDData(fedId).size();
+      }
+
+      // false = closed by the consumer
+      if (!prefetchQueue->Push(std::move(ev), size))
+        return;
+    }
+
+    prefetchQueue->Finish();
+  }
+  catch (...)
+  {
+    prefetchQueue->Fail(std::current_exception());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemStandaloneRawDataSource::StopReader()
+{
+  if (parallelReader)
+    parallelReader->Stop();
+
+  if (prefetchQueue)
+    prefetchQueue->Close();
+
+  if (readerThread.joinable())
+    readerThread.join();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// intersection of two sorted lists of disjoint intervals
+static vector<TotemStandaloneRawDataSource::Interval> IntersectIntervals(
+  const vector<TotemStandaloneRawDataSource::Interval> &a, const vector<TotemStandaloneRawDataSource::Interval> &b)
+{
+  vector<TotemStandaloneRawDataSource::Interval> result;
+
+  for (unsigned int i = 0, j = 0; i < a.size() && j < b.size();)
+  {
+    unsigned long first = max(a[i].first, b[j].first);
+    unsigned long second = min(a[i].second, b[j].second);
+    if (first < second)
+      result.push_back({first, second});
+
+    if (a[i].second < b[j].second)
+      i++;
+    else
+      j++;
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// sorts the intervals and merges the overlapping ones
+static void NormalizeIntervals(vector<TotemStandaloneRawDataSource::Interval> &v)
+{
+  sort(v.begin(), v.end());
+
+  vector<TotemStandaloneRawDataSource::Interval> result;
+  for (const auto &i : v)
+  {
+    if (i.first >= i.second)
+      continue;
+
+    if (!result.empty() && i.first <= result.back().second)
+      result.back().second = max(result.back().second, i.second);
+    else
+      result.push_back(i);
+  }
+
+  v.swap(result);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void TotemStandaloneRawDataSource::MakeSelection()
+{
+  unsigned long toSkip = skipEvents;
+
+  for (auto &fi : files)
+  {
+    const unsigned long N = fi.index->GetNumberOfPhysicsEvents();
+    const RunNumber_t run = fi.runNumber;
+
+    fi.selection.clear();
+    fi.selection.push_back({0, N});
+
+    // events: the ranges are interpreted as run:event, lumi numbers are ignored
+    if (!eventsToProcess.empty())
+    {
+      vector<Interval> v;
+      for (const auto &r : eventsToProcess)
+      {
+        if (r.startRun() > run || r.endRun() < run)
+          continue;
+
+        unsigned long first = (r.startRun() < run || r.startEvent() == 0) ? 0 : r.startEvent() - 1;
+        unsigned long second = (r.endRun() > run || r.endEvent() == 0) ? N : min<unsigned long>(N, r.endEvent());
+        v.push_back({first, second});
+      }
+
+      NormalizeIntervals(v);
+      fi.selection = IntersectIntervals(fi.selection, v);
+    }
+
+    // luminosity blocks
+    if (!lumisToProcess.empty())
+    {
+      vector<Interval> v;
+      for (const auto &r : lumisToProcess)
+      {
+        if (r.startRun() > run || r.endRun() < run)
+          continue;
+
+        unsigned long first = (r.startRun() < run) ? 0 : fi.index->FindLuminosityBlock(r.startLumi());
+        unsigned long second = (r.endRun() > run || r.endLumi() == 0) ? N : fi.index->FindLuminosityBlock(r.endLumi() + 1);
+        v.push_back({first, second});
+      }
+
+      NormalizeIntervals(v);
+      fi.selection = IntersectIntervals(fi.selection, v);
+    }
+
+    // skip the requested number of selected events
+    while (toSkip > 0 && !fi.selection.empty())
+    {
+      Interval &i = fi.selection.front();
+      unsigned long n = min(toSkip, i.second - i.first);
+      i.first += n;
+      toSkip -= n;
+
+      if (i.first >= i.second)
+        fi.selection.erase(fi.selection.begin());
+    }
+
+    fi.intervalIdx = 0;
+    fi.nextEvent = 0;
+
+    if (verbosity > 0)
+    {
+      unsigned long selected = 0;
+      for (const auto &i : fi.selection)
+        selected += i.second - i.first;
+
+      printf(">> TotemStandaloneRawDataSource::MakeSelection > %s: %lu of %lu physics events selected.\n",
+        fi.fileName.c_str(), selected, N);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
 #ifdef DEBUG
 InputSource::ItemType prevItem = InputSource::ItemType::IsInvalid;
 #endif
@@ -278,13 +652,20 @@ void TotemStandaloneRawDataSource::beginJob()
         printf(">> TotemStandaloneRawDataSource::beginJob > Opening file `%s'.\n", fileNames[i].c_str());
 	}
 
-    // run number
+    // run number, merged files are streams of the same run
     FileInfo fi;
     fi.fileName = fileNames[i];
-    fi.runNumber = i + 10001;
+    fi.runNumber = (parallelReading) ? 10001 : i + 10001;
+    fi.index = NULL;
+    fi.intervalIdx = 0;
+    fi.nextEvent = 0;
 
     // open file
-    fi.file = new SRSFileReader();
+    if (useMemoryMapping)
+      fi.file = new MappedSRSFileReader(size_t(readAheadSize) * 1024 * 1024);
+    else
+      fi.file = new SRSFileReader();
+
     if (fi.file->Open(fi.fileName) != 0)
     {
       delete fi.file;
@@ -292,6 +673,20 @@ void TotemStandaloneRawDataSource::beginJob()
       throw cms::Exception("TotemStandaloneRawDataSource") << "Cannot open file " << fileNames[i] << std::endl;
     }
 
+    // load or build index
+    if (useIndex)
+    {
+      fi.index = new SRSFileIndex();
+      if (fi.index->LoadOrBuild(fi.fileName, verbosity) != 0)
+      {
+        delete fi.file;
+        delete fi.index;
+        throw cms::Exception("TotemStandaloneRawDataSource") << "Cannot index file " << fileNames[i] << std::endl;
+      }
+
+      fi.file->SetIndex(fi.index);
+    }
+
     files.push_back(fi);
   }
 
@@ -309,6 +704,24 @@ void TotemStandaloneRawDataSource::beginJob()
   // initialize the state of reader
   fileIdx = 0;
 
+  if (useIndex)
+    MakeSelection();
+
+  // start reading ahead, with parallelReading every file has its own reader thread
+  if (parallelReading)
+  {
+    vector<SRSFileReader *> readers;
+    for (const auto &fi : files)
+      readers.push_back(fi.file);
+
+    parallelReader.reset(new ParallelSRSFileReader(readers, readerQueueEvents, size_t(readerQueueMemory) * 1024 * 1024));
+    parallelReader->Start();
+  } else if (prefetchEvents > 0)
+  {
+    prefetchQueue.reset(new PrefetchQueue<RawEvent>(prefetchEvents, size_t(prefetchMemory) * 1024 * 1024));
+    readerThread = std::thread(&TotemStandaloneRawDataSource::ReaderLoop, this);
+  }
+
   items.push_back(IsFile);  // needed for the logic in InputSource::nextItemType 
 }
 
@@ -319,6 +732,8 @@ void TotemStandaloneRawDataSource::endJob()
 #ifdef DEBUG
   printf(">> TotemStandaloneRawDataSource::endJob\n");
 #endif
+
+  StopReader();
 }
 
 //----------------------------------------------------------------------------------------------------
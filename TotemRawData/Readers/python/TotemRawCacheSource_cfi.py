@@ -0,0 +1,28 @@
+import FWCore.ParameterSet.Config as cms
+
+source = cms.Source("TotemRawCacheSource",
+    # if non-zero, prints a file summary in the beginning
+    verbosity = cms.untracked.uint32(1),
+
+    # event number will be printed every 'printProgressFrequency' events,
+    # nothing printed if 0
+    printProgressFrequency = cms.untracked.uint32(0),
+
+    # number of events (passing the selection below) to skip at the beginning
+    skipEvents = cms.untracked.uint32(0),
+
+    # if not empty, only these events are processed, the run and event numbers are those stored in the cache
+    eventsToProcess = cms.untracked.VEventRange(),
+
+    # if not empty, only these luminosity blocks are processed, format "run:lumi-run:lumi"
+    lumisToProcess = cms.untracked.VLuminosityBlockRange(),
+
+    # number of threads decompressing the blocks of events ahead of the processing
+    decompressionThreads = cms.untracked.uint32(2),
+
+    # number of blocks each of the threads decompresses ahead
+    blocksAhead = cms.untracked.uint32(2),
+
+    # the list of raw-cache files to be processed
+    fileNames = cms.untracked.vstring()
+)
@@ -8,6 +8,44 @@ source = cms.Source("TotemStandaloneRawDataSource",
     # nothing printed if 0
     printProgressFrequency = cms.untracked.uint32(0),
 
+    # if True, the files are memory-mapped and the DATE structures are decoded directly
+    # in the mapped region, otherwise they are read event by event with fread
+    useMemoryMapping = cms.untracked.bool(False),
+
+    # size (in MB) of the region announced to the kernel for read-ahead, only used with memory mapping
+    readAheadSize = cms.untracked.uint32(64),
+
+    # if True, an event index is loaded from (or built and saved to) the sidecar file <file name>.idx
+    # and used to jump directly to the selected events; it is switched on automatically when
+    # any of the selection parameters below is used
+    useIndex = cms.untracked.bool(False),
+
+    # number of events (passing the selection below) to skip at the beginning
+    skipEvents = cms.untracked.uint32(0),
+
+    # if not empty, only these events are processed; the files have run numbers 10001, 10002, ...
+    # in the order of fileNames, events are numbered from 1 in each file, format "run:event-run:event"
+    eventsToProcess = cms.untracked.VEventRange(),
+
+    # if not empty, only these luminosity blocks are processed, format "run:lumi-run:lumi"
+    lumisToProcess = cms.untracked.VLuminosityBlockRange(),
+
+    # if non-zero, a separate thread reads up to this number of events ahead of the processing
+    prefetchEvents = cms.untracked.uint32(0),
+
+    # maximal size (in MB) of the events read ahead, 0 = no limit; only used with prefetchEvents > 0
+    prefetchMemory = cms.untracked.uint32(0),
+
+    # if True, all files are read concurrently (one thread per file) and their events are merged by
+    # timestamp and event number; the files are taken as streams of one run (run number 10001);
+    # cannot be combined with useIndex, the event selection or prefetchEvents > 0 (the read ahead is set
+    # per file by readerQueueEvents and readerQueueMemory)
+    parallelReading = cms.untracked.bool(False),
+
+    # with parallelReading: number of events and memory (in MB, 0 = no limit) read ahead per file
+    readerQueueEvents = cms.untracked.uint32(16),
+    readerQueueMemory = cms.untracked.uint32(0),
+
     # the list of files to be processed
     fileNames = cms.untracked.vstring()
 )
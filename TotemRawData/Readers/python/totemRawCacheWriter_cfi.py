@@ -0,0 +1,17 @@
+import FWCore.ParameterSet.Config as cms
+
+totemRawCacheWriter = cms.EDAnalyzer("TotemRawCacheWriter",
+  rawDataTag = cms.InputTag("source"),
+
+  # raw cache is written to this file, it can be read by TotemRawCacheSource
+  outputFile = cms.string("raw.cache"),
+
+  # compression of the blocks: "none", "zlib" or "lzma"
+  compression = cms.string("zlib"),
+
+  # compression level: 0 - 9 for both zlib and lzma, the higher the slower
+  compressionLevel = cms.int32(1),
+
+  # number of events per block; larger blocks compress better, smaller ones make random access cheaper
+  eventsPerBlock = cms.uint32(64)
+)
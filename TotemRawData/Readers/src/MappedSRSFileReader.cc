@@ -0,0 +1,207 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/MappedSRSFileReader.h"
+#include "TotemRawData/Readers/interface/event_3_14.h"
+
+#include <iostream>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+MappedSRSFileReader::MappedSRSFileReader(size_t _readAheadSize) : readAheadSize(_readAheadSize),
+  fd(-1), mapPtr(NULL), mapSize(0), position(0), adviceEnd(0), releaseEnd(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+MappedSRSFileReader::~MappedSRSFileReader()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int MappedSRSFileReader::Open(const std::string &fn)
+{
+  fd = open(fn.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    perror("Error while opening file in MappedSRSFileReader::Open");
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    perror("Error while getting file size in MappedSRSFileReader::Open");
+    Close();
+    return 1;
+  }
+
+  mapSize = st.st_size;
+  position = adviceEnd = releaseEnd = 0;
+
+  // nothing to map in an empty file
+  if (mapSize == 0)
+    return 0;
+
+  void *p = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED)
+  {
+    perror("Error while mapping file in MappedSRSFileReader::Open");
+    Close();
+    return 1;
+  }
+
+  const size_t size = mapSize;
+  mapping.reset((const char *) p, [size](const char *ptr) { munmap((void *) ptr, size); });
+  mapPtr = mapping.get();
+
+  madvise(p, mapSize, MADV_SEQUENTIAL);
+  UpdateAdvice();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void MappedSRSFileReader::Close()
+{
+  mapping.reset();
+
+  if (fd >= 0)
+    close(fd);
+
+  mapPtr = NULL;
+  mapSize = 0;
+  fd = -1;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int MappedSRSFileReader::SeekOffset(uint64_t offset)
+{
+  if (offset > mapSize)
+  {
+    cerr << "Error in MappedSRSFileReader::SeekOffset > " << "Offset " << offset << " beyond the end of the file ("
+      << mapSize << " B)." << endl;
+    return 1;
+  }
+
+  position = offset;
+
+  // restart the read-ahead logic from the new position
+  const size_t pageSize = sysconf(_SC_PAGESIZE);
+  releaseEnd = min(releaseEnd, (position / pageSize) * pageSize);
+  adviceEnd = position;
+  UpdateAdvice();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void MappedSRSFileReader::UpdateAdvice()
+{
+  if (!mapPtr || readAheadSize == 0)
+    return;
+
+  const size_t pageSize = sysconf(_SC_PAGESIZE);
+
+  // announce the next window once the current position gets closer than half a window to its end
+  if (adviceEnd < mapSize && position + readAheadSize / 2 >= adviceEnd)
+  {
+    size_t begin = (position / pageSize) * pageSize;
+    size_t end = min(mapSize, position + readAheadSize);
+    madvise((void *) (mapPtr + begin), end - begin, MADV_WILLNEED);
+    adviceEnd = end;
+  }
+
+  // release the pages which are more than one window behind the current position
+  if (position > releaseEnd + 2 * readAheadSize)
+  {
+    size_t end = ((position - readAheadSize) / pageSize) * pageSize;
+    madvise((void *) (mapPtr + releaseEnd), end - releaseEnd, MADV_DONTNEED);
+    releaseEnd = end;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned char MappedSRSFileReader::GetNextEvent(uint64_t &timestamp, SharedRawEvent &event)
+{
+  event.Clear();
+
+  while (true)
+  {
+    // check if the end of the file has been reached
+    if (position >= mapSize)
+      return 1;
+
+    if (mapSize - position < eventHeaderSize)
+    {
+      cerr << "Error in MappedSRSFileReader::GetNextEvent > " << "Truncated event header at offset "
+        << position << " (" << mapSize - position << " B left)." << endl;
+      return 10;
+    }
+
+    const eventHeaderStruct *eventHeader = (const eventHeaderStruct *) (mapPtr + position);
+
+    // check the sanity of header data
+    if (eventHeader->eventMagic != EVENT_MAGIC_NUMBER)
+    {
+      cerr << "Error in MappedSRSFileReader::GetNextEvent > " << "Event magic check failed (" << hex
+        << eventHeader->eventMagic << "!=" << EVENT_MAGIC_NUMBER << dec << "). Exiting." << endl;
+      return 1;
+    }
+
+    unsigned int N = eventHeader->eventSize;
+    if (N < eventHeaderSize)
+    {
+      cerr << "Error in MappedSRSFileReader::GetNextEvent > " << "Event size (" << N
+        << ") smaller than header size (" << eventHeaderSize << "). Exiting." << endl;
+      return 1;
+    }
+
+    if (N > mapSize - position)
+    {
+      cerr << "Error in MappedSRSFileReader::GetNextEvent > " << "Truncated event at offset " << position
+        << ": only " << mapSize - position << " B available from " << N << " B." << endl;
+      return 10;
+    }
+
+    const char *eventPtr = mapPtr + position;
+    position += N;
+
+    UpdateAdvice();
+
+    // skip non physics events
+    if (eventHeader->eventType != PHYSICS_EVENT)
+      continue;
+
+    // process the event directly in the mapped region
+    event.SetBuffer(mapping);
+    unsigned int errorCounter = ProcessDATESuperEvent(eventPtr, timestamp, event);
+
+    if (errorCounter > 0)
+      cerr << "Error in MappedSRSFileReader::GetNextEvent > " << errorCounter << " GOH blocks have failed consistency checks." << endl;
+
+    return 0;
+  }
+}
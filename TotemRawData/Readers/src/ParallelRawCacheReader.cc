@@ -0,0 +1,100 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/ParallelRawCacheReader.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+ParallelRawCacheReader::ParallelRawCacheReader(const RawCacheReader &_reader, const vector<unsigned int> &_blocks,
+  unsigned int _nThreads, unsigned int _blocksAhead) :
+  reader(_reader), blocks(_blocks), nThreads((_nThreads > 0) ? _nThreads : 1), blocksAhead(_blocksAhead),
+  nextBlock(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+ParallelRawCacheReader::~ParallelRawCacheReader()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelRawCacheReader::Start()
+{
+  for (unsigned int i = 0; i < nThreads; ++i)
+    queues.emplace_back(new PrefetchQueue<RawCacheReader::Block>(blocksAhead));
+
+  for (unsigned int i = 0; i < nThreads; ++i)
+    threads.emplace_back(&ParallelRawCacheReader::DecompressionLoop, this, i);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelRawCacheReader::Stop()
+{
+  for (auto &q : queues)
+    q->Close();
+
+  for (auto &t : threads)
+  {
+    if (t.joinable())
+      t.join();
+  }
+
+  threads.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelRawCacheReader::DecompressionLoop(unsigned int idx)
+{
+  PrefetchQueue<RawCacheReader::Block> &queue = *queues[idx];
+
+  try {
+    for (size_t k = idx; k < blocks.size(); k += nThreads)
+    {
+      RawCacheReader::Block block;
+      if (reader.ReadBlock(blocks[k], block) != 0)
+        throw cms::Exception("ParallelRawCacheReader") << "Cannot read block " << blocks[k] << ".";
+
+      // false = closed by the consumer
+      if (!queue.Push(std::move(block), 0))
+        return;
+    }
+
+    queue.Finish();
+  }
+  catch (...)
+  {
+    queue.Fail(std::current_exception());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool ParallelRawCacheReader::GetNextBlock(RawCacheReader::Block &block)
+{
+  if (nextBlock >= blocks.size())
+    return false;
+
+  // Pop may rethrow an exception of the thread
+  if (!queues[nextBlock % nThreads]->Pop(block))
+    return false;
+
+  nextBlock++;
+
+  return true;
+}
@@ -0,0 +1,141 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/ParallelSRSFileReader.h"
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+
+#include <tuple>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+ParallelSRSFileReader::ParallelSRSFileReader(const vector<SRSFileReader *> &_readers, size_t _maxEvents,
+  size_t _maxBytes) :
+  readers(_readers), maxEvents(_maxEvents), maxBytes(_maxBytes), heads(_readers.size()),
+  headValid(_readers.size(), false), started(false)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+ParallelSRSFileReader::~ParallelSRSFileReader()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelSRSFileReader::Start()
+{
+  for (unsigned int i = 0; i < readers.size(); ++i)
+    queues.emplace_back(new PrefetchQueue<Event>(maxEvents, maxBytes));
+
+  for (unsigned int i = 0; i < readers.size(); ++i)
+    threads.emplace_back(&ParallelSRSFileReader::ReaderLoop, this, i);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelSRSFileReader::Stop()
+{
+  for (auto &q : queues)
+    q->Close();
+
+  for (auto &t : threads)
+  {
+    if (t.joinable())
+      t.join();
+  }
+
+  threads.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelSRSFileReader::ReaderLoop(unsigned int idx)
+{
+  PrefetchQueue<Event> &queue = *queues[idx];
+
+  try {
+    while (true)
+    {
+      Event ev;
+      ev.fileIdx = idx;
+      ev.data.reset(new FEDRawDataCollection);
+
+      if (readers[idx]->GetNextEvent(ev.timestamp, *ev.data) != 0)
+        break;
+
+      ev.eventNumber = readers[idx]->GetEventNumber();
+
+      // the size only matters when the memory is limited
+      size_t size = 0;
+      if (maxBytes > 0)
+      {
+        for (int fedId = 0; fedId <= FEDNumbering::lastFEDId(); fedId++)
+          size += ev.data->FEDData(fedId).size();
+      }
+
+      // false = closed by the consumer
+      if (!queue.Push(std::move(ev), size))
+        return;
+    }
+
+    queue.Finish();
+  }
+  catch (...)
+  {
+    queue.Fail(std::current_exception());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void ParallelSRSFileReader::LoadHead(unsigned int idx)
+{
+  // Pop may rethrow an exception of the reader thread
+  headValid[idx] = false;
+  headValid[idx] = queues[idx]->Pop(heads[idx]);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+bool ParallelSRSFileReader::GetNextEvent(Event &ev)
+{
+  if (!started)
+  {
+    for (unsigned int i = 0; i < readers.size(); ++i)
+      LoadHead(i);
+
+    started = true;
+  }
+
+  // the smallest head, ties are resolved by the file index
+  int best = -1;
+  for (unsigned int i = 0; i < readers.size(); ++i)
+  {
+    if (!headValid[i])
+      continue;
+
+    if (best < 0 || make_tuple(heads[i].timestamp, heads[i].eventNumber)
+        < make_tuple(heads[best].timestamp, heads[best].eventNumber))
+      best = i;
+  }
+
+  if (best < 0)
+    return false;
+
+  ev = std::move(heads[best]);
+  LoadHead(best);
+
+  return true;
+}
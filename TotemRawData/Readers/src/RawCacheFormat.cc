@@ -0,0 +1,141 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/RawCacheFormat.h"
+
+#include <cstring>
+
+#include <zlib.h>
+#include <lzma.h>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const char RawCacheFormat::magic[8] = { 'T', 'O', 'T', 'R', 'A', 'W', 'C', 'A' };
+
+const uint32_t RawCacheFormat::version = 1;
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheFormat::ParseCodec(const string &name, Codec &codec)
+{
+  if (name == "none") { codec = cNone; return 0; }
+  if (name == "zlib") { codec = cZlib; return 0; }
+  if (name == "lzma") { codec = cLZMA; return 0; }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+const char* RawCacheFormat::GetCodecName(uint32_t codec)
+{
+  switch (codec)
+  {
+    case cNone: return "none";
+    case cZlib: return "zlib";
+    case cLZMA: return "lzma";
+  }
+
+  return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheFormat::Compress(Codec codec, int level, const char *in, size_t size, vector<char> &out)
+{
+  if (codec == cNone)
+  {
+    out.assign(in, in + size);
+    return 0;
+  }
+
+  if (codec == cZlib)
+  {
+    uLongf outSize = compressBound(size);
+    out.resize(outSize);
+    if (compress2((Bytef *) out.data(), &outSize, (const Bytef *) in, size, level) != Z_OK)
+      return 1;
+
+    out.resize(outSize);
+    return 0;
+  }
+
+  if (codec == cLZMA)
+  {
+    size_t outSize = 0;
+    out.resize(lzma_stream_buffer_bound(size));
+    if (lzma_easy_buffer_encode(level, LZMA_CHECK_NONE, NULL, (const uint8_t *) in, size, (uint8_t *) out.data(),
+        &outSize, out.size()) != LZMA_OK)
+      return 1;
+
+    out.resize(outSize);
+    return 0;
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheFormat::Decompress(Codec codec, const char *in, size_t size, char *out, size_t outSize)
+{
+  if (codec == cNone)
+  {
+    if (size != outSize)
+      return 1;
+
+    memcpy(out, in, size);
+    return 0;
+  }
+
+  if (codec == cZlib)
+  {
+    uLongf n = outSize;
+    if (uncompress((Bytef *) out, &n, (const Bytef *) in, size) != Z_OK || n != outSize)
+      return 1;
+
+    return 0;
+  }
+
+  if (codec == cLZMA)
+  {
+    uint64_t memLimit = UINT64_MAX;
+    size_t inPos = 0, outPos = 0;
+    if (lzma_stream_buffer_decode(&memLimit, 0, NULL, (const uint8_t *) in, &inPos, size, (uint8_t *) out, &outPos,
+        outSize) != LZMA_OK || outPos != outSize)
+      return 1;
+
+    return 0;
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+uint32_t RawCacheFormat::Checksum(const char *data, size_t size)
+{
+  return crc32(crc32(0, NULL, 0), (const Bytef *) data, size);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+uint64_t RawCacheFormat::IndexChecksum(const void *data, size_t size, uint64_t seed)
+{
+  // FNV-1a
+  const unsigned char *p = (const unsigned char *) data;
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i)
+    h = (h ^ p[i]) * 1099511628211ULL;
+
+  return h;
+}
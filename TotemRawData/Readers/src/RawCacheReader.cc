@@ -0,0 +1,229 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/RawCacheReader.h"
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+RawCacheReader::RawCacheReader() : fd(-1), fileSize(0)
+{
+  memset(&header, 0, sizeof(header));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+RawCacheReader::~RawCacheReader()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void RawCacheReader::Close()
+{
+  if (fd >= 0)
+    close(fd);
+
+  fd = -1;
+  blocks.clear();
+  events.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheReader::ReadAt(void *buffer, size_t size, uint64_t offset) const
+{
+  char *ptr = (char *) buffer;
+  while (size > 0)
+  {
+    const ssize_t n = pread(fd, ptr, size, offset);
+    if (n <= 0)
+      return 1;
+
+    ptr += n;
+    size -= n;
+    offset += n;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheReader::Open(const string &fn)
+{
+  Close();
+
+  fd = open(fn.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    perror("Error while opening file in RawCacheReader::Open");
+    return 1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    perror("Error in RawCacheReader::Open");
+    Close();
+    return 1;
+  }
+  fileSize = st.st_size;
+
+  // header
+  if (fileSize < sizeof(header) || ReadAt(&header, sizeof(header), 0) != 0
+      || memcmp(header.magic, RawCacheFormat::magic, sizeof(header.magic)) != 0)
+  {
+    cerr << "Error in RawCacheReader::Open > " << "File `" << fn << "' is not a raw cache or was not closed properly."
+      << endl;
+    Close();
+    return 1;
+  }
+
+  if (header.version != RawCacheFormat::version)
+  {
+    cerr << "Error in RawCacheReader::Open > " << "Unsupported version " << header.version << " of file `" << fn
+      << "'." << endl;
+    Close();
+    return 1;
+  }
+
+  // index
+  const uint64_t indexSize = header.nBlocks * sizeof(RawCacheFormat::BlockInfo)
+    + header.nEvents * sizeof(RawCacheFormat::EventInfo);
+
+  if (header.indexOffset > fileSize || fileSize - header.indexOffset != indexSize)
+  {
+    cerr << "Error in RawCacheReader::Open > " << "Inconsistent index size in file `" << fn << "'." << endl;
+    Close();
+    return 1;
+  }
+
+  blocks.resize(header.nBlocks);
+  events.resize(header.nEvents);
+
+  if (ReadAt(blocks.data(), blocks.size() * sizeof(RawCacheFormat::BlockInfo), header.indexOffset) != 0
+      || ReadAt(events.data(), events.size() * sizeof(RawCacheFormat::EventInfo),
+        header.indexOffset + blocks.size() * sizeof(RawCacheFormat::BlockInfo)) != 0)
+  {
+    perror("Error while reading file in RawCacheReader::Open");
+    Close();
+    return 1;
+  }
+
+  uint64_t checksum = RawCacheFormat::IndexChecksum(blocks.data(), blocks.size() * sizeof(RawCacheFormat::BlockInfo));
+  checksum = RawCacheFormat::IndexChecksum(events.data(), events.size() * sizeof(RawCacheFormat::EventInfo), checksum);
+  if (checksum != header.indexChecksum)
+  {
+    cerr << "Error in RawCacheReader::Open > " << "Corrupted index in file `" << fn << "'." << endl;
+    Close();
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheReader::ReadBlock(unsigned int index, Block &block) const
+{
+  if (index >= blocks.size())
+    return 1;
+
+  const RawCacheFormat::BlockInfo &info = blocks[index];
+
+  block.index = index;
+  block.data.resize((info.size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+
+  char *out = (char *) block.data.data();
+
+  // uncompressed blocks are read directly to the destination
+  if (header.codec == RawCacheFormat::cNone)
+  {
+    if (info.compressedSize != info.size || ReadAt(out, info.size, info.offset) != 0)
+    {
+      cerr << "Error in RawCacheReader::ReadBlock > " << "Cannot read block " << index << "." << endl;
+      return 1;
+    }
+  } else {
+    vector<char> compressed(info.compressedSize);
+    if (ReadAt(compressed.data(), compressed.size(), info.offset) != 0)
+    {
+      cerr << "Error in RawCacheReader::ReadBlock > " << "Cannot read block " << index << "." << endl;
+      return 1;
+    }
+
+    if (RawCacheFormat::Decompress(GetCodec(), compressed.data(), compressed.size(), out, info.size) != 0)
+    {
+      cerr << "Error in RawCacheReader::ReadBlock > " << "Cannot decompress block " << index << "." << endl;
+      return 1;
+    }
+  }
+
+  if (RawCacheFormat::Checksum(out, info.size) != info.checksum)
+  {
+    cerr << "Error in RawCacheReader::ReadBlock > " << "Checksum mismatch in block " << index << "." << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheReader::GetEvent(const Block &block, uint64_t event, FEDRawDataCollection &data) const
+{
+  if (event >= events.size() || events[event].block != block.index)
+    return 1;
+
+  const RawCacheFormat::BlockInfo &blockInfo = blocks[block.index];
+  const char *base = (const char *) block.data.data();
+  size_t offset = events[event].offset;
+
+  RawCacheFormat::EventRecordHeader eventHeader;
+  if (offset + sizeof(eventHeader) > blockInfo.size)
+    return 1;
+
+  memcpy(&eventHeader, base + offset, sizeof(eventHeader));
+  offset += sizeof(eventHeader);
+
+  for (unsigned int i = 0; i < eventHeader.nFEDs; ++i)
+  {
+    RawCacheFormat::FEDRecordHeader fedHeader;
+    if (offset + sizeof(fedHeader) > blockInfo.size)
+      return 1;
+
+    memcpy(&fedHeader, base + offset, sizeof(fedHeader));
+    offset += sizeof(fedHeader);
+
+    if (offset + fedHeader.size > blockInfo.size || fedHeader.fedId > (uint32_t) FEDNumbering::lastFEDId())
+      return 1;
+
+    FEDRawData &fedData = data.FEDData(fedHeader.fedId);
+    fedData.resize(fedHeader.size);
+    memcpy(fedData.data(), base + offset, fedHeader.size);
+
+    offset += RawCacheFormat::PaddedSize(fedHeader.size);
+  }
+
+  return 0;
+}
@@ -0,0 +1,214 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/RawCacheWriter.h"
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+RawCacheWriter::RawCacheWriter() : outFile(NULL), codec(RawCacheFormat::cNone), level(0), eventsPerBlock(1),
+  blockEvents(0), bytesWritten(0), uncompressedBytes(0)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+
+RawCacheWriter::~RawCacheWriter()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheWriter::Open(const string &fn, RawCacheFormat::Codec _codec, int _level, unsigned int _eventsPerBlock)
+{
+  Close();
+
+  outFile = fopen(fn.c_str(), "w");
+  if (outFile == NULL)
+  {
+    perror("Error while opening file in RawCacheWriter::Open");
+    return 1;
+  }
+
+  codec = _codec;
+  level = _level;
+  eventsPerBlock = (_eventsPerBlock > 0) ? _eventsPerBlock : 1;
+
+  block.clear();
+  blockEvents = 0;
+  blocks.clear();
+  events.clear();
+  bytesWritten = 0;
+  uncompressedBytes = 0;
+
+  // placeholder, the header is rewritten in Close
+  RawCacheFormat::Header header;
+  memset(&header, 0, sizeof(header));
+
+  return Write(&header, sizeof(header));
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheWriter::Write(const void *data, size_t size)
+{
+  if (fwrite(data, 1, size, outFile) != size)
+  {
+    perror("Error while writing file in RawCacheWriter::Write");
+    return 1;
+  }
+
+  bytesWritten += size;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheWriter::WriteEvent(uint32_t run, uint32_t luminosityBlock, uint64_t event, uint64_t timestamp,
+  const FEDRawDataCollection &data)
+{
+  if (outFile == NULL)
+  {
+    cerr << "Error in RawCacheWriter::WriteEvent > " << "No file open." << endl;
+    return 1;
+  }
+
+  const size_t offset = block.size();
+
+  RawCacheFormat::EventRecordHeader eventHeader = { 0, 0 };
+  block.resize(offset + sizeof(eventHeader));
+
+  for (int fedId = 0; fedId <= FEDNumbering::lastFEDId(); ++fedId)
+  {
+    const FEDRawData &fedData = data.FEDData(fedId);
+    if (fedData.size() == 0)
+      continue;
+
+    const RawCacheFormat::FEDRecordHeader fedHeader = { uint32_t(fedId), uint32_t(fedData.size()) };
+
+    const size_t fedOffset = block.size();
+    block.resize(fedOffset + sizeof(fedHeader) + RawCacheFormat::PaddedSize(fedData.size()), 0);
+    memcpy(block.data() + fedOffset, &fedHeader, sizeof(fedHeader));
+    memcpy(block.data() + fedOffset + sizeof(fedHeader), fedData.data(), fedData.size());
+
+    eventHeader.nFEDs++;
+  }
+
+  memcpy(block.data() + offset, &eventHeader, sizeof(eventHeader));
+
+  if (block.size() > numeric_limits<uint32_t>::max())
+  {
+    cerr << "Error in RawCacheWriter::WriteEvent > " << "Block too large, reduce the number of events per block."
+      << endl;
+    return 1;
+  }
+
+  RawCacheFormat::EventInfo info;
+  info.run = run;
+  info.luminosityBlock = luminosityBlock;
+  info.event = event;
+  info.timestamp = timestamp;
+  info.block = blocks.size();
+  info.offset = offset;
+  events.push_back(info);
+
+  blockEvents++;
+  if (blockEvents >= eventsPerBlock)
+    return FlushBlock();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheWriter::FlushBlock()
+{
+  if (blockEvents == 0)
+    return 0;
+
+  if (RawCacheFormat::Compress(codec, level, block.data(), block.size(), compressed) != 0)
+  {
+    cerr << "Error in RawCacheWriter::FlushBlock > " << "Compression failed." << endl;
+    return 1;
+  }
+
+  RawCacheFormat::BlockInfo info;
+  info.offset = bytesWritten;
+  info.compressedSize = compressed.size();
+  info.size = block.size();
+  info.firstEvent = events.size() - blockEvents;
+  info.nEvents = blockEvents;
+  info.checksum = RawCacheFormat::Checksum(block.data(), block.size());
+  blocks.push_back(info);
+
+  uncompressedBytes += block.size();
+
+  block.clear();
+  blockEvents = 0;
+
+  return Write(compressed.data(), compressed.size());
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int RawCacheWriter::Close()
+{
+  if (outFile == NULL)
+    return 0;
+
+  int result = FlushBlock();
+
+  // index
+  RawCacheFormat::Header header;
+  memcpy(header.magic, RawCacheFormat::magic, sizeof(header.magic));
+  header.version = RawCacheFormat::version;
+  header.codec = codec;
+  header.nEvents = events.size();
+  header.nBlocks = blocks.size();
+  header.indexOffset = bytesWritten;
+  header.indexChecksum = RawCacheFormat::IndexChecksum(blocks.data(), blocks.size() * sizeof(RawCacheFormat::BlockInfo));
+  header.indexChecksum = RawCacheFormat::IndexChecksum(events.data(), events.size() * sizeof(RawCacheFormat::EventInfo),
+    header.indexChecksum);
+
+  if (result == 0)
+    result = Write(blocks.data(), blocks.size() * sizeof(RawCacheFormat::BlockInfo));
+
+  if (result == 0)
+    result = Write(events.data(), events.size() * sizeof(RawCacheFormat::EventInfo));
+
+  // final header, only when everything before succeeded
+  if (result == 0)
+  {
+    if (fseeko(outFile, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, outFile) != 1)
+    {
+      perror("Error while writing file in RawCacheWriter::Close");
+      result = 1;
+    }
+  }
+
+  if (fclose(outFile) != 0)
+  {
+    perror("Error while closing file in RawCacheWriter::Close");
+    result = 1;
+  }
+
+  outFile = NULL;
+
+  return result;
+}
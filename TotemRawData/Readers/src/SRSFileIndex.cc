@@ -0,0 +1,310 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/SRSFileIndex.h"
+#include "TotemRawData/Readers/interface/event_3_14.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <sys/stat.h>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+const char SRSFileIndex::magic[8] = { 'S', 'R', 'S', 'I', 'N', 'D', 'E', 'X' };
+
+const uint32_t SRSFileIndex::version = 1;
+
+//----------------------------------------------------------------------------------------------------
+
+uint64_t SRSFileIndex::Checksum(const void *data, size_t size, uint64_t seed)
+{
+  // FNV-1a
+  const unsigned char *p = (const unsigned char *) data;
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i)
+    h = (h ^ p[i]) * 1099511628211ULL;
+
+  return h;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileIndex::MakeStamp(const std::string &fn, Stamp &stamp)
+{
+  struct stat st;
+  if (stat(fn.c_str(), &st) != 0)
+    return 1;
+
+  stamp.size = st.st_size;
+  stamp.mtime = st.st_mtime;
+
+  FILE *f = fopen(fn.c_str(), "r");
+  if (!f)
+    return 1;
+
+  // checksum of the first and the last block
+  const size_t blockSize = 64*1024;
+  vector<char> buffer(blockSize);
+
+  size_t n = fread(buffer.data(), 1, blockSize, f);
+  stamp.checksum = Checksum(buffer.data(), n);
+
+  if (stamp.size > blockSize)
+  {
+    fseeko(f, -off_t(blockSize), SEEK_END);
+    n = fread(buffer.data(), 1, blockSize, f);
+    stamp.checksum = Checksum(buffer.data(), n, stamp.checksum);
+  }
+
+  fclose(f);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void SRSFileIndex::MakeDerivedData()
+{
+  physicsEntries.clear();
+  luminosityBlocks.clear();
+  timestampsOrdered = true;
+
+  unsigned int lumi = 0;
+  uint32_t prevTimestamp = 0;
+
+  for (unsigned long i = 0; i < entries.size(); ++i)
+  {
+    const Entry &e = entries[i];
+    if (e.eventType != PHYSICS_EVENT)
+      continue;
+
+    if (physicsEntries.empty() || e.timestamp != prevTimestamp)
+      lumi++;
+
+    if (!physicsEntries.empty() && e.timestamp < prevTimestamp)
+      timestampsOrdered = false;
+
+    physicsEntries.push_back(i);
+    luminosityBlocks.push_back(lumi);
+    prevTimestamp = e.timestamp;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileIndex::Build(const std::string &fn)
+{
+  entries.clear();
+
+  FILE *f = fopen(fn.c_str(), "r");
+  if (!f)
+  {
+    perror("Error while opening file in SRSFileIndex::Build");
+    return 1;
+  }
+
+  uint64_t offset = 0;
+  eventHeaderStruct header;
+  while (fread(&header, sizeof(header), 1, f) == 1)
+  {
+    if (header.eventMagic != EVENT_MAGIC_NUMBER)
+    {
+      cerr << "Error in SRSFileIndex::Build > " << "Event magic check failed at offset " << offset
+        << " in file " << fn << "." << endl;
+      fclose(f);
+      return 2;
+    }
+
+    if (header.eventSize < sizeof(header))
+    {
+      cerr << "Error in SRSFileIndex::Build > " << "Event size (" << header.eventSize
+        << ") smaller than header size at offset " << offset << " in file " << fn << "." << endl;
+      fclose(f);
+      return 2;
+    }
+
+    Entry e;
+    e.offset = offset;
+    e.eventNumber = EVENT_ID_GET_NB_IN_RUN(header.eventId);
+    e.timestamp = header.eventTimestamp;
+    e.eventType = header.eventType;
+    e.reserved = 0;
+    entries.push_back(e);
+
+    // skip the payload
+    offset += header.eventSize;
+    if (fseeko(f, offset, SEEK_SET) != 0)
+      break;
+  }
+
+  // the last event may be truncated, it is not readable in that case
+  fseeko(f, 0, SEEK_END);
+  uint64_t fileSize = ftello(f);
+  if (!entries.empty() && offset > fileSize)
+  {
+    cerr << "Error in SRSFileIndex::Build > " << "The last event in file " << fn << " is truncated. Not indexed." << endl;
+    entries.pop_back();
+  }
+
+  fclose(f);
+
+  MakeDerivedData();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileIndex::Save(const std::string &indexFileName, const std::string &dataFileName) const
+{
+  Stamp stamp;
+  if (MakeStamp(dataFileName, stamp) != 0)
+  {
+    cerr << "Error in SRSFileIndex::Save > " << "Cannot access file " << dataFileName << "." << endl;
+    return 1;
+  }
+
+  Header h;
+  memcpy(h.magic, magic, sizeof(magic));
+  h.version = version;
+  h.entrySize = sizeof(Entry);
+  h.fileSize = stamp.size;
+  h.fileMTime = stamp.mtime;
+  h.fileChecksum = stamp.checksum;
+  h.nEntries = entries.size();
+  h.entriesChecksum = Checksum(entries.data(), entries.size() * sizeof(Entry));
+
+  // write to a temporary file first, so that concurrent readers never see a partial index
+  string tmpFileName = indexFileName + ".tmp";
+  FILE *f = fopen(tmpFileName.c_str(), "w");
+  if (!f)
+    return 1;
+
+  bool ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+  if (ok && !entries.empty())
+    ok = (fwrite(entries.data(), sizeof(Entry), entries.size(), f) == entries.size());
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok || rename(tmpFileName.c_str(), indexFileName.c_str()) != 0)
+  {
+    remove(tmpFileName.c_str());
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileIndex::Load(const std::string &indexFileName, const std::string &dataFileName)
+{
+  entries.clear();
+
+  FILE *f = fopen(indexFileName.c_str(), "r");
+  if (!f)
+    return 1;
+
+  Header h;
+  if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, magic, sizeof(magic)) != 0
+    || h.version != version || h.entrySize != sizeof(Entry))
+  {
+    cerr << "Error in SRSFileIndex::Load > " << "Index file " << indexFileName << " has an unknown format." << endl;
+    fclose(f);
+    return 2;
+  }
+
+  Stamp stamp;
+  if (MakeStamp(dataFileName, stamp) != 0 || stamp.size != h.fileSize || stamp.mtime != h.fileMTime
+    || stamp.checksum != h.fileChecksum)
+  {
+    cerr << "Error in SRSFileIndex::Load > " << "Index file " << indexFileName << " is stale (does not match "
+      << dataFileName << ")." << endl;
+    fclose(f);
+    return 3;
+  }
+
+  entries.resize(h.nEntries);
+  bool ok = (h.nEntries == 0) || (fread(entries.data(), sizeof(Entry), h.nEntries, f) == h.nEntries);
+  fclose(f);
+
+  if (!ok || Checksum(entries.data(), entries.size() * sizeof(Entry)) != h.entriesChecksum)
+  {
+    cerr << "Error in SRSFileIndex::Load > " << "Index file " << indexFileName << " is corrupted." << endl;
+    entries.clear();
+    return 4;
+  }
+
+  MakeDerivedData();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileIndex::LoadOrBuild(const std::string &dataFileName, unsigned int verbosity)
+{
+  const string indexFileName = GetDefaultIndexFileName(dataFileName);
+
+  if (Load(indexFileName, dataFileName) == 0)
+    return 0;
+
+  if (verbosity)
+    printf(">> SRSFileIndex::LoadOrBuild > Building index for file `%s'.\n", dataFileName.c_str());
+
+  int result = Build(dataFileName);
+  if (result != 0)
+    return result;
+
+  // failing to save (e.g. read-only directory) is not fatal, the index is kept in memory
+  if (Save(indexFileName, dataFileName) != 0 && verbosity)
+    printf(">> SRSFileIndex::LoadOrBuild > Cannot save index file `%s'.\n", indexFileName.c_str());
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long SRSFileIndex::FindTimestamp(uint64_t ts) const
+{
+  if (timestampsOrdered)
+  {
+    unsigned long lo = 0, hi = physicsEntries.size();
+    while (lo < hi)
+    {
+      unsigned long mid = (lo + hi) / 2;
+      if (GetPhysicsEvent(mid).timestamp < ts)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    return lo;
+  }
+
+  for (unsigned long n = 0; n < physicsEntries.size(); ++n)
+  {
+    if (GetPhysicsEvent(n).timestamp >= ts)
+      return n;
+  }
+
+  return physicsEntries.size();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned long SRSFileIndex::FindLuminosityBlock(unsigned int lumi) const
+{
+  return lower_bound(luminosityBlocks.begin(), luminosityBlocks.end(), lumi) - luminosityBlocks.begin();
+}
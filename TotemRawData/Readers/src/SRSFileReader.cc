@@ -12,6 +12,7 @@
 #include "TotemRawData/Readers/interface/event_3_14.h"
 
 #include <cmath>
+#include <cstring>
 
 //----------------------------------------------------------------------------------------------------
 
@@ -23,7 +24,7 @@ const unsigned int SRSFileReader::eventHeaderSize = sizeof(eventHeaderStruct);
 
 //----------------------------------------------------------------------------------------------------
 
-SRSFileReader::SRSFileReader() : dataPtr(NULL), dataPtrSize(0), infile(NULL)
+SRSFileReader::SRSFileReader() : index(NULL), dataPtr(NULL), dataPtrSize(0), infile(NULL), bytesCopied(0), eventNumber(0)
 {
 }
 
@@ -32,9 +33,6 @@ SRSFileReader::SRSFileReader() : dataPtr(NULL), dataPtrSize(0), infile(NULL)
 SRSFileReader::~SRSFileReader()
 {
   Close();
-
-  if (dataPtr != NULL)
-    delete [] dataPtr;
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -64,6 +62,61 @@ void SRSFileReader::Close()
 
 //----------------------------------------------------------------------------------------------------
 
+int SRSFileReader::SeekOffset(uint64_t offset)
+{
+  if (infile == NULL)
+    return 1;
+
+  clearerr(infile);
+
+  if (fseeko(infile, offset, SEEK_SET) != 0)
+  {
+    perror("Error while seeking in SRSFileReader::SeekOffset");
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileReader::SeekEvent(unsigned long n)
+{
+  if (index == NULL)
+  {
+    cerr << "Error in SRSFileReader::SeekEvent > " << "No index available." << endl;
+    return 1;
+  }
+
+  if (n >= index->GetNumberOfPhysicsEvents())
+  {
+    cerr << "Error in SRSFileReader::SeekEvent > " << "Event " << n << " out of range (" 
+      << index->GetNumberOfPhysicsEvents() << " physics events in the index)." << endl;
+    return 1;
+  }
+
+  return SeekOffset(index->GetPhysicsEvent(n).offset);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int SRSFileReader::SeekTimestamp(uint64_t ts)
+{
+  if (index == NULL)
+  {
+    cerr << "Error in SRSFileReader::SeekTimestamp > " << "No index available." << endl;
+    return 1;
+  }
+
+  unsigned long n = index->FindTimestamp(ts);
+  if (n >= index->GetNumberOfPhysicsEvents())
+    return 1;
+
+  return SeekOffset(index->GetPhysicsEvent(n).offset);
+}
+
+//----------------------------------------------------------------------------------------------------
+
 unsigned char SRSFileReader::ReadToBuffer(unsigned int bytesToRead, unsigned int offset)
 {
 #ifdef DEBUG
@@ -71,12 +124,20 @@ unsigned char SRSFileReader::ReadToBuffer(unsigned int bytesToRead, unsigned int
       bytesToRead, offset, (void*) this, dataPtr, dataPtrSize);
 #endif
 
+  // a new event must not overwrite the buffer if it is still held by a SharedRawEvent
+  if (offset == 0 && buffer.use_count() > 1)
+  {
+    buffer.reset();
+    dataPtr = NULL;
+    dataPtrSize = 0;
+  }
+
   // allocate new memory block if current one is too small
   if (dataPtrSize < bytesToRead+offset)
   {
-    char *newPtr = NULL;
+    shared_ptr<char> newBuffer;
     try {
-      newPtr = new char[bytesToRead+offset];
+      newBuffer.reset(new char[bytesToRead+offset], default_delete<char[]>());
     }
     catch (bad_alloc& ba)
     {
@@ -84,14 +145,14 @@ unsigned char SRSFileReader::ReadToBuffer(unsigned int bytesToRead, unsigned int
       return 2;
     }
 
-    if (dataPtr)
+    if (dataPtr && offset > 0)
     {
-      if (offset > 0)
-        memcpy(newPtr, dataPtr, offset);
-      delete [] dataPtr;
+      memcpy(newBuffer.get(), dataPtr, offset);
+      bytesCopied += offset;
     }
 
-    dataPtr = newPtr;
+    buffer = newBuffer;
+    dataPtr = buffer.get();
     dataPtrSize = bytesToRead+offset;
   }
 
@@ -112,6 +173,22 @@ unsigned char SRSFileReader::ReadToBuffer(unsigned int bytesToRead, unsigned int
 
 unsigned char SRSFileReader::GetNextEvent(uint64_t &timestamp, FEDRawDataCollection &dataColl)
 {
+  unsigned char result = GetNextEvent(timestamp, scratchEvent);
+
+  if (result == 0)
+    bytesCopied += scratchEvent.CopyTo(dataColl);
+
+  // release the buffer, so that it is reused for the next event
+  scratchEvent.Clear();
+
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+unsigned char SRSFileReader::GetNextEvent(uint64_t &timestamp, SharedRawEvent &event)
+{
+  event.Clear();
 #ifdef DEBUG
   printf(">> SRSFileReader::GetNextEvent, this = %p\n", (void*)this);
   printf("\teventHeaderSize = %u\n", eventHeaderSize);
@@ -125,6 +202,10 @@ unsigned char SRSFileReader::GetNextEvent(uint64_t &timestamp, FEDRawDataCollect
     if (ReadToBuffer(eventHeaderSize, 0) != 0)
       return 10;
 
+    // nothing read: the end of the file (the buffer may be a new one, without a valid header)
+    if (feof(infile))
+      return 1;
+
     eventHeader = (eventHeaderStruct *) dataPtr;
 
     // check the sanity of header data
@@ -162,7 +243,8 @@ unsigned char SRSFileReader::GetNextEvent(uint64_t &timestamp, FEDRawDataCollect
     return 1;
 
   // process the buffer
-  unsigned int errorCounter = ProcessDATESuperEvent(dataPtr, timestamp, dataColl);
+  event.SetBuffer(buffer);
+  unsigned int errorCounter = ProcessDATESuperEvent(dataPtr, timestamp, event);
 
 #ifdef DEBUG
   printf("* %u, %u, %u\n",
@@ -180,9 +262,9 @@ unsigned char SRSFileReader::GetNextEvent(uint64_t &timestamp, FEDRawDataCollect
 
 //----------------------------------------------------------------------------------------------------
 
-unsigned int SRSFileReader::ProcessDATESuperEvent(char *ptr, uint64_t &timestamp, FEDRawDataCollection &dataColl)
+unsigned int SRSFileReader::ProcessDATESuperEvent(const char *ptr, uint64_t &timestamp, SharedRawEvent &event)
 {
-  eventHeaderStruct *eventHeader = (eventHeaderStruct *) ptr;
+  const eventHeaderStruct *eventHeader = (const eventHeaderStruct *) ptr;
   bool superEvent = TEST_ANY_ATTRIBUTE(eventHeader->eventTypeAttribute, ATTR_SUPER_EVENT);
 
 #ifdef DEBUG
@@ -208,6 +290,7 @@ unsigned int SRSFileReader::ProcessDATESuperEvent(char *ptr, uint64_t &timestamp
 
   // store important GDC data
   timestamp = eventHeader->eventTimestamp;
+  eventNumber = EVENT_ID_GET_NB_IN_RUN(eventHeader->eventId);
 
   eventSizeType eventSize = eventHeader->eventSize;
   eventHeadSizeType headSize = eventHeader->eventHeadSize;
@@ -222,10 +305,10 @@ unsigned int SRSFileReader::ProcessDATESuperEvent(char *ptr, uint64_t &timestamp
 #ifdef DEBUG 
       printf("\t> offset before %i\n", offset);
 #endif
-      eventStruct *subEvPtr = (eventStruct *) (ptr + offset); 
+      const eventStruct *subEvPtr = (const eventStruct *) (ptr + offset); 
       eventSizeType subEvSize = subEvPtr->eventHeader.eventSize;
 
-      errorCounter += ProcessDATEEvent(ptr + offset, timestamp, dataColl);
+      errorCounter += ProcessDATEEvent(ptr + offset, timestamp, event);
 
       offset += subEvSize;
 #ifdef DEBUG 
@@ -233,16 +316,16 @@ unsigned int SRSFileReader::ProcessDATESuperEvent(char *ptr, uint64_t &timestamp
 #endif
     }
   } else
-    errorCounter += ProcessDATEEvent(ptr, timestamp, dataColl);
+    errorCounter += ProcessDATEEvent(ptr, timestamp, event);
 
   return errorCounter;
 }
 
 //----------------------------------------------------------------------------------------------------
 
-unsigned int SRSFileReader::ProcessDATEEvent(char *ptr, uint64_t &timestamp, FEDRawDataCollection &dataColl)
+unsigned int SRSFileReader::ProcessDATEEvent(const char *ptr, uint64_t &timestamp, SharedRawEvent &event)
 {
-  eventHeaderStruct *eventHeader = (eventHeaderStruct *) ptr;
+  const eventHeaderStruct *eventHeader = (const eventHeaderStruct *) ptr;
 
 #ifdef DEBUG 
   printf("\t\t>> ProcessDATEEvent\n");
@@ -275,15 +358,17 @@ unsigned int SRSFileReader::ProcessDATEEvent(char *ptr, uint64_t &timestamp, FED
     printf("\t\toffset (before) %lu\n", offset);
 #endif
     
-    equipmentHeaderStruct *eq = (equipmentHeaderStruct *) (ptr + offset);
+    const equipmentHeaderStruct *eq = (const equipmentHeaderStruct *) (ptr + offset);
     equipmentSizeType equipmentHeaderStructSize = sizeof(equipmentHeaderStruct);
     unsigned int payloadSize = eq->equipmentSize - equipmentHeaderStructSize;
 
     // check for presence of the "0xFAFAFAFA" word (32 bits)
-    uint64_t *payloadPtr = (uint64_t *)(ptr + offset + equipmentHeaderStructSize);
-    if ((*payloadPtr & 0xFFFFFFFF) == 0xFAFAFAFA)
+    const char *payloadPtr = ptr + offset + equipmentHeaderStructSize;
+    uint32_t firstWord;
+    memcpy(&firstWord, payloadPtr, sizeof(firstWord));
+    if (firstWord == 0xFAFAFAFA)
     {
-      payloadPtr = (uint64_t *)(ptr + offset + equipmentHeaderStructSize + 4);
+      payloadPtr += 4;
       payloadSize -= 4;
     }
 
@@ -303,7 +388,7 @@ unsigned int SRSFileReader::ProcessDATEEvent(char *ptr, uint64_t &timestamp, FED
       {
         case etOptoRxVME:
         case etOptoRxSRS:
-            MakeFEDRawData(payloadPtr, payloadSize, dataColl);
+            AddFEDData(payloadPtr, payloadSize, event);
           break;
 
         default:
@@ -323,15 +408,11 @@ unsigned int SRSFileReader::ProcessDATEEvent(char *ptr, uint64_t &timestamp, FED
 
 //----------------------------------------------------------------------------------------------------
 
-void SRSFileReader::MakeFEDRawData(uint64_t *payloadPtr, unsigned int payloadSize, FEDRawDataCollection &dataColl)
+void SRSFileReader::AddFEDData(const char *payloadPtr, unsigned int payloadSize, SharedRawEvent &event)
 {
-  uint64_t head = payloadPtr[0];
+  uint64_t head;
+  memcpy(&head, payloadPtr, sizeof(head));
   unsigned int optoRxId = (head >> 8) & 0xFFF;
-  FEDRawData &rd = dataColl.FEDData(optoRxId);
-
-  unsigned int fedSize = payloadSize;
-  rd.resize(fedSize);
 
-  unsigned char *buffer = rd.data();
-  memcpy(buffer, payloadPtr, payloadSize);
+  bytesCopied += event.Add(optoRxId, payloadPtr, payloadSize);
 }
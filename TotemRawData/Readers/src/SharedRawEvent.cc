@@ -0,0 +1,95 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "TotemRawData/Readers/interface/SharedRawEvent.h"
+
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+void SharedRawEvent::Clear()
+{
+  buffer.reset();
+  copies.clear();
+  slices.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+size_t SharedRawEvent::Add(unsigned int fedId, const char *ptr, size_t size)
+{
+  if ((reinterpret_cast<uintptr_t>(ptr) & 0x7) == 0)
+  {
+    slices.push_back({fedId, false, size_t(ptr - buffer.get()), size});
+    return 0;
+  }
+
+  // misaligned payload: copy to whole words
+  const size_t offset = copies.size() * sizeof(uint64_t);
+  copies.resize(copies.size() + (size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  memcpy((char *) copies.data() + offset, ptr, size);
+
+  slices.push_back({fedId, true, offset, size});
+  return size;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+FEDRawDataView SharedRawEvent::GetView(const Slice &s) const
+{
+  const char *base = (s.copied) ? (const char *) copies.data() : buffer.get();
+  return FEDRawDataView((const unsigned char *) base + s.offset, s.size);
+}
+
+//----------------------------------------------------------------------------------------------------
+
+FEDRawDataView SharedRawEvent::FEDData(unsigned int fedId) const
+{
+  for (auto it = slices.rbegin(); it != slices.rend(); ++it)
+  {
+    if (it->fedId == fedId)
+      return GetView(*it);
+  }
+
+  return FEDRawDataView();
+}
+
+//----------------------------------------------------------------------------------------------------
+
+vector<unsigned int> SharedRawEvent::GetFEDIds() const
+{
+  vector<unsigned int> fedIds;
+  for (const auto &s : slices)
+    fedIds.push_back(s.fedId);
+
+  return fedIds;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+size_t SharedRawEvent::CopyTo(FEDRawDataCollection &coll) const
+{
+  size_t bytes = 0;
+
+  for (const auto &s : slices)
+  {
+    const FEDRawDataView view = GetView(s);
+
+    FEDRawData &rd = coll.FEDData(s.fedId);
+    rd.resize(view.size());
+    memcpy(rd.data(), view.data(), view.size());
+
+    bytes += view.size();
+  }
+
+  return bytes;
+}
@@ -0,0 +1,237 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/PrefetchQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+/// reader with an artificial latency per event, emulating a slow (e.g. network) file system
+class DelayedSRSFileReader : public SRSFileReader
+{
+  public:
+    DelayedSRSFileReader(unsigned int _latency) : latency(_latency) {}
+
+    virtual unsigned char GetNextEvent(uint64_t &timestamp, FEDRawDataCollection &coll)
+    {
+      this_thread::sleep_for(chrono::microseconds(latency));
+      return SRSFileReader::GetNextEvent(timestamp, coll);
+    }
+
+  protected:
+    unsigned int latency;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+  unsigned long events = 0;
+  uint64_t checksum = 0;
+  double time = 0.;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+/// emulates the processing of an event: busy loop of the given length, plus a checksum of the payloads
+void Process(const FEDRawDataCollection &coll, unsigned int processingTime, Result &r)
+{
+  auto end = chrono::steady_clock::now() + chrono::microseconds(processingTime);
+  while (chrono::steady_clock::now() < end)
+  {
+  }
+
+  r.events++;
+
+  for (int id = 0; id <= FEDNumbering::lastFEDId(); ++id)
+  {
+    const FEDRawData &d = coll.FEDData(id);
+    if (d.size() == 0)
+      continue;
+
+    uint64_t w;
+    memcpy(&w, d.data(), sizeof(w));
+    r.checksum = (r.checksum ^ w ^ d.size()) * 1099511628211ULL;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// reads and processes the files in one thread
+Result RunSerial(const vector<string> &files, unsigned int latency, unsigned int processingTime)
+{
+  Result r;
+  auto start = chrono::steady_clock::now();
+
+  for (const auto &fn : files)
+  {
+    DelayedSRSFileReader reader(latency);
+    if (reader.Open(fn) != 0)
+    {
+      printf("ERROR: cannot open file `%s'.\n", fn.c_str());
+      exit(1);
+    }
+
+    while (true)
+    {
+      uint64_t timestamp;
+      FEDRawDataCollection coll;
+      if (reader.GetNextEvent(timestamp, coll) != 0)
+        break;
+
+      Process(coll, processingTime, r);
+    }
+  }
+
+  r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+/// reads the files in a separate thread and processes the events taken from the prefetch queue
+Result RunPrefetched(const vector<string> &files, unsigned int latency, unsigned int processingTime,
+  unsigned int depth, unsigned int memory)
+{
+  Result r;
+  auto start = chrono::steady_clock::now();
+
+  PrefetchQueue<unique_ptr<FEDRawDataCollection>> queue(depth, size_t(memory) * 1024 * 1024);
+
+  thread reader([&]
+  {
+    try {
+      for (const auto &fn : files)
+      {
+        DelayedSRSFileReader reader(latency);
+        if (reader.Open(fn) != 0)
+          throw runtime_error("cannot open file " + fn);
+
+        while (true)
+        {
+          uint64_t timestamp;
+          unique_ptr<FEDRawDataCollection> coll(new FEDRawDataCollection);
+          if (reader.GetNextEvent(timestamp, *coll) != 0)
+            break;
+
+          size_t size = 0;
+          for (int id = 0; id <= FEDNumbering::lastFEDId(); ++id)
+            size += coll->FEDData(id).size();
+
+          if (!queue.Push(std::move(coll), size))
+            return;
+        }
+      }
+
+      queue.Finish();
+    }
+    catch (...)
+    {
+      queue.Fail(current_exception());
+    }
+  });
+
+  try {
+    unique_ptr<FEDRawDataCollection> coll;
+    while (queue.Pop(coll))
+      Process(*coll, processingTime, r);
+  }
+  catch (const exception &e)
+  {
+    printf("ERROR: %s\n", e.what());
+    queue.Close();
+    reader.join();
+    exit(1);
+  }
+
+  reader.join();
+
+  r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkPrefetchQueue [option] <file> [<file> ...]\n");
+  printf("Compares serial reading with reading through a prefetch thread.\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -l <us>         artificial I/O latency per event, in us (default 100)\n");
+  printf("    -p <us>         emulated processing time per event, in us (default 100)\n");
+  printf("    -d <number>     depth of the prefetch queue, in events (default 16)\n");
+  printf("    -m <size>       memory limit of the prefetch queue, in MB (default 0 = no limit)\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int latency = 100;
+  unsigned int processingTime = 100;
+  unsigned int depth = 16;
+  unsigned int memory = 0;
+  vector<string> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) { latency = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) { processingTime = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) { depth = atoi(argv[++i]); continue; }
+    if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) { memory = atoi(argv[++i]); continue; }
+
+    files.push_back(argv[i]);
+  }
+
+  if (files.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  printf("latency = %u us/event, processing = %u us/event, depth = %u events, memory limit = %u MB\n",
+    latency, processingTime, depth, memory);
+
+  Result s = RunSerial(files, latency, processingTime);
+  Result p = RunPrefetched(files, latency, processingTime, depth, memory);
+
+  printf("%-10s %10s %10s %12s\n", "mode", "events", "time (s)", "events/s");
+  printf("%-10s %10lu %10.3f %12.1f\n", "serial", s.events, s.time, s.events / s.time);
+  printf("%-10s %10lu %10.3f %12.1f\n", "prefetch", p.events, p.time, p.events / p.time);
+  printf("speed-up: %.2f\n", s.time / p.time);
+
+  if (s.events != p.events || s.checksum != p.checksum)
+  {
+    printf("ERROR: the two modes processed different data.\n");
+    return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+/****************************************************************************
+*
+* This is a part of the TOTEM offline software.
+* Authors:
+*  Jan Kašpar (jan.kaspar@gmail.com)
+*
+****************************************************************************/
+
+#include "DataFormats/FEDRawData/interface/FEDNumbering.h"
+#include "DataFormats/FEDRawData/interface/FEDRawDataCollection.h"
+
+#include "TotemRawData/Readers/interface/SRSFileReader.h"
+#include "TotemRawData/Readers/interface/MappedSRSFileReader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------
+
+struct Result
+{
+  unsigned long events = 0;
+  unsigned long long bytes = 0;
+  uint64_t checksum = 0;
+  double time = 0.;
+};
+
+//----------------------------------------------------------------------------------------------------
+
+Result RunReader(SRSFileReader *reader, const vector<string> &files)
+{
+  Result r;
+
+  auto start = chrono::steady_clock::now();
+
+  for (const auto &fn : files)
+  {
+    if (reader->Open(fn) != 0)
+    {
+      printf("ERROR: cannot open file `%s'.\n", fn.c_str());
+      exit(1);
+    }
+
+    while (true)
+    {
+      uint64_t timestamp;
+      FEDRawDataCollection coll;
+      if (reader->GetNextEvent(timestamp, coll) != 0)
+        break;
+
+      r.events++;
+
+      // touch the payloads (FNV-1a over the first word), so that both readers do comparable work
+      for (int id = 0; id <= FEDNumbering::lastFEDId(); ++id)
+      {
+        const FEDRawData &d = coll.FEDData(id);
+        if (d.size() == 0)
+          continue;
+
+        r.bytes += d.size();
+
+        uint64_t w;
+        memcpy(&w, d.data(), sizeof(w));
+        r.checksum = (r.checksum ^ w ^ d.size()) * 1099511628211ULL;
+      }
+    }
+
+    reader->Close();
+  }
+
+  r.time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  return r;
+}
+
+//----------------------------------------------------------------------------------------------------
+
+void PrintUsage()
+{
+  printf("USAGE: benchmarkSRSFileReader [option] <file> [<file> ...]\n");
+  printf("OPTIONS:\n");
+  printf("    -h              print this help\n");
+  printf("    -r <number>     number of repetitions (default 1)\n");
+  printf("    -a <size>       read-ahead window of the memory-mapped reader, in MB (default 64)\n");
+  printf("NOTE: for cold-cache numbers, drop the page cache before every repetition.\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+
+int main(int argc, const char **argv)
+{
+  unsigned int repetitions = 1;
+  unsigned int readAhead = 64;
+  vector<string> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage();
+      return 0;
+    }
+
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = atoi(argv[++i]);
+      continue;
+    }
+
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+    {
+      readAhead = atoi(argv[++i]);
+      continue;
+    }
+
+    files.push_back(argv[i]);
+  }
+
+  if (files.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  printf("%-8s %4s %10s %12s %10s %10s %12s\n", "reader", "rep", "events", "MB", "time (s)", "MB/s", "events/s");
+
+  Result ref;
+  for (unsigned int rep = 0; rep < repetitions; ++rep)
+  {
+    for (unsigned int m = 0; m < 2; ++m)
+    {
+      unique_ptr<SRSFileReader> reader;
+      if (m == 0)
+        reader.reset(new SRSFileReader());
+      else
+        reader.reset(new MappedSRSFileReader(size_t(readAhead) * 1024 * 1024));
+
+      Result r = RunReader(reader.get(), files);
+
+      double mb = r.bytes / 1024. / 1024.;
+      printf("%-8s %4u %10lu %12.1f %10.3f %10.1f %12.1f\n", (m == 0) ? "fread" : "mmap", rep, r.events, mb, r.time,
+        mb / r.time, r.events / r.time);
+
+      if (m == 0 && rep == 0)
+        ref = r;
+      else if (r.events != ref.events || r.bytes != ref.bytes || r.checksum != ref.checksum)
+      {
+        printf("ERROR: the readers produced different data.\n");
+        return 2;
+      }
+    }
+  }
+
+  return 0;
+}
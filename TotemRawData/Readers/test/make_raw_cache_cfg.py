@@ -0,0 +1,47 @@
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+
+process = cms.Process("MakeRawCache")
+
+# default options
+options = VarParsing.VarParsing ('analysis')
+options.outputFile = 'raw.cache'
+
+options.register('compression', 'zlib', VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.string, "compression: none, zlib or lzma")
+options.register('compressionLevel', 1, VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.int, "compression level, 0 - 9")
+options.register('eventsPerBlock', 64, VarParsing.VarParsing.multiplicity.singleton,
+  VarParsing.VarParsing.varType.int, "number of events per compressed block")
+
+# parse command-line options
+options.parseArguments()
+
+# minimum of logs
+process.MessageLogger = cms.Service("MessageLogger",
+    statistics = cms.untracked.vstring(),
+    destinations = cms.untracked.vstring('cerr'),
+    cerr = cms.untracked.PSet(
+        threshold = cms.untracked.string('INFO')
+    )
+)
+
+# raw data source
+process.load('TotemRawData.Readers.TotemStandaloneRawDataSource_cfi')
+process.source.fileNames = options.inputFiles
+
+process.maxEvents = cms.untracked.PSet(
+    input = cms.untracked.int32(options.maxEvents)
+)
+
+# raw-cache writer
+process.load('TotemRawData.Readers.totemRawCacheWriter_cfi')
+process.totemRawCacheWriter.outputFile = options.outputFile
+process.totemRawCacheWriter.compression = options.compression
+process.totemRawCacheWriter.compressionLevel = options.compressionLevel
+process.totemRawCacheWriter.eventsPerBlock = options.eventsPerBlock
+
+# execution configuration
+process.p = cms.Path(
+    process.totemRawCacheWriter
+)